@@ -237,20 +237,40 @@ void RTR::D3DCommandList::BindDescriptorHeaps(ID3D12DescriptorHeap* heap1, ID3D1
     m_ptrList->SetDescriptorHeaps(heap2 ? 2 : 1, heaps);
 }
 
-void RTR::D3DCommandList::Draw(unsigned int vertexOrIndexCount, unsigned int instanceCount)
+void RTR::D3DCommandList::Draw(unsigned int vertexOrIndexCount, unsigned int instanceCount, unsigned int startVertexOrIndex, int baseVertex, unsigned int startInstance)
 {
     if (m_hasIndexBuffer)
     {
         // Draw indexed
-        m_ptrList->DrawIndexedInstanced(vertexOrIndexCount, instanceCount, 0, 0, 0);
+        m_ptrList->DrawIndexedInstanced(vertexOrIndexCount, instanceCount, startVertexOrIndex, baseVertex, startInstance);
     }
     else
     {
         // Draw vertex
-        m_ptrList->DrawInstanced(vertexOrIndexCount, instanceCount, 0, 0);
+        m_ptrList->DrawInstanced(vertexOrIndexCount, instanceCount, startVertexOrIndex, startInstance);
     }
 }
 
+void RTR::D3DCommandList::ExecuteIndirect(D3DCommandSignature& signature, unsigned int maxCommandCount, ID3D12Resource* ptrArguments, UINT64 argumentOffset, ID3D12Resource* ptrCount, UINT64 countOffset)
+{
+    m_ptrList->ExecuteIndirect(signature, maxCommandCount, ptrArguments, argumentOffset, ptrCount, countOffset);
+}
+
+void RTR::D3DCommandList::DispatchMesh(unsigned int groupCountX, unsigned int groupCountY, unsigned int groupCountZ)
+{
+    m_ptrList->DispatchMesh(groupCountX, groupCountY, groupCountZ);
+}
+
+void RTR::D3DCommandList::Dispatch(unsigned int groupCountX, unsigned int groupCountY, unsigned int groupCountZ)
+{
+    m_ptrList->Dispatch(groupCountX, groupCountY, groupCountZ);
+}
+
+void RTR::D3DCommandList::CopyBufferRegion(ID3D12Resource* ptrDestination, UINT64 destinationOffset, ID3D12Resource* ptrSource, UINT64 sourceOffset, UINT64 size)
+{
+    m_ptrList->CopyBufferRegion(ptrDestination, destinationOffset, ptrSource, sourceOffset, size);
+}
+
 void RTR::D3DCommandList::ExecutSync()
 {
     // Flush pending barriers
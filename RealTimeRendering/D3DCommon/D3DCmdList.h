@@ -7,6 +7,7 @@
 #include <D3DCommon/D3DQueue.h>
 #include <D3DCommon/D3DRootConfiguration.h>
 #include <D3DCommon/D3DPipelineState.h>
+#include <D3DCommon/D3DCommandSignature.h>
 
 namespace RTR
 {
@@ -80,12 +81,29 @@ namespace RTR
             // Bind descriptor heaps
             void BindDescriptorHeaps(ID3D12DescriptorHeap* heap1, ID3D12DescriptorHeap* heap2 = nullptr);
 
-            // Draws instanced (1 by default) with or without index buffer (determined by last call to IAPrepare)
-            void Draw(unsigned int vertexOrIndexCount, unsigned int instanceCount = 1);
+            // Draws instanced (1 by default) with or without index buffer (determined by last call to IAPrepare).
+            // Offsets select a part of the bound buffers (baseVertex is added to every index and ignored without index buffer).
+            void Draw(unsigned int vertexOrIndexCount, unsigned int instanceCount = 1, unsigned int startVertexOrIndex = 0, int baseVertex = 0, unsigned int startInstance = 0);
+            // Execute up to maxCommandCount commands of signature from ptrArguments (the count is read from ptrCount when given).
+            // The signature has to be prepared for the bound pipeline state.
+            void ExecuteIndirect(D3DCommandSignature& signature, unsigned int maxCommandCount, ID3D12Resource* ptrArguments, UINT64 argumentOffset = 0, ID3D12Resource* ptrCount = nullptr, UINT64 countOffset = 0);
+            // Launch amplification / mesh shader thread groups (requires a mesh shader pipeline state)
+            void DispatchMesh(unsigned int groupCountX, unsigned int groupCountY = 1, unsigned int groupCountZ = 1);
+            // Launch compute shader thread groups (requires a compute pipeline state)
+            void Dispatch(unsigned int groupCountX, unsigned int groupCountY = 1, unsigned int groupCountZ = 1);
+
+            // Copy size bytes between buffers (resources must be in COPY_SOURCE / COPY_DEST or promotable to it)
+            void CopyBufferRegion(ID3D12Resource* ptrDestination, UINT64 destinationOffset, ID3D12Resource* ptrSource, UINT64 sourceOffset, UINT64 size);
 
             // Execute command list
             void ExecutSync();
 
+            // Queue the list executes on
+            inline D3DQueue& GetQueue() noexcept
+            {
+                return *m_ptrQueue;
+            }
+
             // Allow external command list access
             inline explicit operator ID3D12GraphicsCommandList* ()
             {
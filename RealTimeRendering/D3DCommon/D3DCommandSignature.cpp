@@ -0,0 +1,44 @@
+#include "D3DCommandSignature.h"
+
+RTR::D3DCommandSignature::D3DCommandSignature(UINT rootParameterIndex, UINT rootConstantCount) :
+    m_rootParameterIndex(rootParameterIndex),
+    m_rootConstantCount(rootConstantCount)
+{}
+
+bool RTR::D3DCommandSignature::Prepare(ID3D12RootSignature* ptrRootSignature)
+{
+    if (!ptrRootSignature)
+        return false;
+    if (m_ptrSignature && m_ptrRootSignature == ptrRootSignature)
+        return true;
+
+    // Root constants followed by the draw
+    D3D12_INDIRECT_ARGUMENT_DESC arguments[2] = {};
+    UINT argumentCount = 0;
+    if (m_rootConstantCount)
+    {
+        arguments[argumentCount].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+        arguments[argumentCount].Constant.RootParameterIndex = m_rootParameterIndex;
+        arguments[argumentCount].Constant.DestOffsetIn32BitValues = 0;
+        arguments[argumentCount].Constant.Num32BitValuesToSet = m_rootConstantCount;
+        argumentCount++;
+    }
+    arguments[argumentCount++].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+    // Describe signature
+    D3D12_COMMAND_SIGNATURE_DESC desc;
+    desc.ByteStride = GetStride();
+    desc.NumArgumentDescs = argumentCount;
+    desc.pArgumentDescs = arguments;
+    desc.NodeMask = 0;
+
+    // Create signature (the root signature is only required when root arguments change)
+    m_ptrSignature.release();
+    RTR_CHECK_HRESULT(
+        "Creating command signature",
+        GetD3D12DevicePtr()->CreateCommandSignature(&desc, m_rootConstantCount ? ptrRootSignature : nullptr, IID_PPV_ARGS(&m_ptrSignature))
+    );
+    m_ptrRootSignature = ptrRootSignature;
+
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <WinInclude.h>
+#include <Util/ComPointer.h>
+#include <Util/HrException.h>
+#include <D3DCommon/D3DInstance.h>
+
+namespace RTR
+{
+    // Command signature for ExecuteIndirect: every command is a set of 32 bit root constants followed by
+    // D3D12_DRAW_INDEXED_ARGUMENTS (the layout written by IndirectDrawBuilder)
+    class D3DCommandSignature
+    {
+        public:
+            // Construct (rootConstantCount constants at root parameter rootParameterIndex, 0 for plain draws)
+            D3DCommandSignature() = delete;
+            D3DCommandSignature(const D3DCommandSignature&) = delete;
+            D3DCommandSignature(UINT rootParameterIndex, UINT rootConstantCount);
+
+            // Assign
+            D3DCommandSignature& operator=(const D3DCommandSignature&) = delete;
+
+            // Create the signature for a root signature (see D3DPipelineState::GetRootSignature). Only recreated when
+            // the root signature changed, e.g. after a shader reload. Returns false without a root signature.
+            bool Prepare(ID3D12RootSignature* ptrRootSignature);
+
+            // Bytes per command
+            inline UINT GetStride() const noexcept
+            {
+                return m_rootConstantCount * sizeof(UINT) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+            }
+
+            // Castable
+            inline operator ID3D12CommandSignature*()
+            {
+                return m_ptrSignature;
+            }
+
+        private:
+            // Layout
+            UINT m_rootParameterIndex;
+            UINT m_rootConstantCount;
+
+            // Root signature the command signature was created for (referenced so its address can not be reused)
+            ComPointer<ID3D12RootSignature> m_ptrRootSignature;
+            ComPointer<ID3D12CommandSignature> m_ptrSignature;
+    };
+}
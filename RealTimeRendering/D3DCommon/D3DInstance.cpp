@@ -78,6 +78,14 @@ IDXGIFactory7* RTR::GetDXGIFactoryPtr()
     return __global__d3dinstance_ptrGIFactory;
 }
 
+bool RTR::D3D12SupportsMeshShaders()
+{
+    D3D12_FEATURE_DATA_D3D12_OPTIONS7 options = {};
+    return 
+        SUCCEEDED(__global__d3dinstance_ptrDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS7, &options, sizeof(options))) &&
+        options.MeshShaderTier != D3D12_MESH_SHADER_TIER_NOT_SUPPORTED;
+}
+
 const D3D12_HEAP_PROPERTIES* RTR::GetD3D12DefaultHeapProperites()
 {
     static D3D12_HEAP_PROPERTIES prop = {D3D12_HEAP_TYPE_DEFAULT, D3D12_CPU_PAGE_PROPERTY_UNKNOWN, D3D12_MEMORY_POOL_UNKNOWN, NULL, NULL};
@@ -18,6 +18,9 @@ namespace RTR
     const D3D12_HEAP_PROPERTIES* GetD3D12UploadHeapProperites();
     const D3D12_HEAP_PROPERTIES* GetD3D12ReadbackHeapProperites();
 
+    // Feature support
+    bool D3D12SupportsMeshShaders();
+
     // Handle increment
     UINT GetD3D12HandleIncrement(D3D12_DESCRIPTOR_HEAP_TYPE heapType);
 }
@@ -268,11 +268,11 @@ void RTR::GfxPsoManipulator::DepthStenciSetFaces(bool frontFaces, D3D12_STENCIL_
     ptrStencilOp->StencilFunc = stencilComparisonFunc;
 }
 
-void RTR::GfxPsoManipulator::IAAddElement(const char* name, DXGI_FORMAT format)
+void RTR::GfxPsoManipulator::IAAddElement(const char* name, DXGI_FORMAT format, UINT semanticIndex)
 {
     auto* ptrElement = m_ptrInputElements->PeekAndPushNext();
     ptrElement->SemanticName = name;
-    ptrElement->SemanticIndex = 0;
+    ptrElement->SemanticIndex = semanticIndex;
     ptrElement->Format = format;
     ptrElement->InputSlot = 0;
     ptrElement->AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
@@ -315,6 +315,34 @@ void RTR::CsPsoManipulator::BindShader(ShaderType type, Shader* ptrShader)
     }
 }
 
+namespace RTR
+{
+    // Subobject of a pipeline state stream (pointer aligned like the d3dx12 helpers)
+    template<typename T, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE Type>
+    struct alignas(void*) PsoStreamSubobject
+    {
+        D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type = Type;
+        T data = {};
+    };
+
+    // Pipeline state stream of a mesh shader pso
+    struct MeshPsoStream
+    {
+        PsoStreamSubobject<ID3D12RootSignature*, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE> rootSignature;
+        PsoStreamSubobject<D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS> as;
+        PsoStreamSubobject<D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS> ms;
+        PsoStreamSubobject<D3D12_SHADER_BYTECODE, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS> ps;
+        PsoStreamSubobject<D3D12_BLEND_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND> blend;
+        PsoStreamSubobject<UINT, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK> sampleMask;
+        PsoStreamSubobject<D3D12_RASTERIZER_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER> rasterizer;
+        PsoStreamSubobject<D3D12_DEPTH_STENCIL_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL> depthStencil;
+        PsoStreamSubobject<D3D12_RT_FORMAT_ARRAY, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS> renderTargets;
+        PsoStreamSubobject<DXGI_FORMAT, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT> depthStencilFormat;
+        PsoStreamSubobject<DXGI_SAMPLE_DESC, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC> sampleDesc;
+        PsoStreamSubobject<D3D12_PIPELINE_STATE_FLAGS, D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS> flags;
+    };
+}
+
 RTR::D3DPipelineState::D3DPipelineState(PipelineStateType type) :
     m_type(type)
 {}
@@ -352,8 +380,8 @@ bool RTR::D3DPipelineState::Bind(ID3D12GraphicsCommandList * ptrCmdList)
         if (m_ptrHSShader && m_ptrHSShader->GetShaderData()) reloadPso = m_ptrHSShader->Refresh() || reloadPso;
         if (m_ptrGSShader && m_ptrGSShader->GetShaderData()) reloadPso = m_ptrGSShader->Refresh() || reloadPso;
         if (m_ptrPSShader && m_ptrPSShader->GetShaderData()) reloadPso = m_ptrPSShader->Refresh() || reloadPso;
-        //if (m_ptrMSShader && m_ptrMSShader->GetShaderData()) reloadPso = m_ptrMSShader->Refresh() || reloadPso;
-        //if (m_ptrASShader && m_ptrASShader->GetShaderData()) reloadPso = m_ptrASShader->Refresh() || reloadPso;
+        if (m_ptrMSShader && m_ptrMSShader->GetShaderData()) reloadPso = m_ptrMSShader->Refresh() || reloadPso;
+        if (m_ptrASShader && m_ptrASShader->GetShaderData()) reloadPso = m_ptrASShader->Refresh() || reloadPso;
     }
 
     // Reload if required
@@ -370,8 +398,8 @@ bool RTR::D3DPipelineState::Bind(ID3D12GraphicsCommandList * ptrCmdList)
             if (m_ptrHSShader && !m_ptrHSShader->GetShaderData()) loadFailed = m_ptrHSShader->Load() || loadFailed;
             if (m_ptrGSShader && !m_ptrGSShader->GetShaderData()) loadFailed = m_ptrGSShader->Load() || loadFailed;
             if (m_ptrPSShader && !m_ptrPSShader->GetShaderData()) loadFailed = m_ptrPSShader->Load() || loadFailed;
-            //if (m_ptrMSShader && !m_ptrMSShader->GetShaderData()) loadFailed = m_ptrMSShader->Load() || loadFailed;
-            //if (m_ptrASShader && !m_ptrASShader->GetShaderData()) loadFailed = m_ptrASShader->Load() || loadFailed;
+            if (m_ptrMSShader && !m_ptrMSShader->GetShaderData()) loadFailed = m_ptrMSShader->Load() || loadFailed;
+            if (m_ptrASShader && !m_ptrASShader->GetShaderData()) loadFailed = m_ptrASShader->Load() || loadFailed;
 
             // Update shader links
             m_psoDescGfx.VS.BytecodeLength = m_ptrVSShader ? m_ptrVSShader->GetShaderSize() : 0;
@@ -384,10 +412,7 @@ bool RTR::D3DPipelineState::Bind(ID3D12GraphicsCommandList * ptrCmdList)
             m_psoDescGfx.GS.pShaderBytecode = m_ptrGSShader ? m_ptrGSShader->GetShaderData() : nullptr;
             m_psoDescGfx.PS.BytecodeLength = m_ptrPSShader ? m_ptrPSShader->GetShaderSize() : 0;
             m_psoDescGfx.PS.pShaderBytecode = m_ptrPSShader ? m_ptrPSShader->GetShaderData() : nullptr;
-            //m_psoDescGfx.MS.BytecodeLength = m_ptrMSShader ? m_ptrMSShader->GetShaderSize() : 0;              STILL NOT IN THE REGUALAR WINDOWS SDK?!  
-            //m_psoDescGfx.MS.pShaderBytecode = m_ptrMSShader ? m_ptrMSShader->GetShaderData() : nullptr;       IT IS BUT IN D3DX12_MESH_SHADER_PIPELINE_STATE_DESC lol no regular d3d12.h construct?!
-            //m_psoDescGfx.AS.BytecodeLength = m_ptrASShader ? m_ptrASShader->GetShaderSize() : 0;
-            //m_psoDescGfx.AS.pShaderBytecode = m_ptrASShader ? m_ptrASShader->GetShaderData() : nullptr;
+            // MS / AS are not part of D3D12_GRAPHICS_PIPELINE_STATE_DESC they are linked when building the pso stream
 
             // Update and build pso
             m_psoDescGfx.NodeMask = 0;
@@ -402,17 +427,49 @@ bool RTR::D3DPipelineState::Bind(ID3D12GraphicsCommandList * ptrCmdList)
                 m_ptrPso.release();
                 m_ptrRootSignature.release();
 
-                // Build new objects
+                // Build new objects (mesh shader pipelines take the root signature from the mesh shader)
+                Shader* ptrRootShader = m_ptrMSShader ? m_ptrMSShader : m_ptrVSShader;
                 RTR_CHECK_HRESULT(
                     "Creating root signature",
-                    GetD3D12DevicePtr()->CreateRootSignature(0, m_ptrVSShader->GetShaderRootData(), m_ptrVSShader->GetShaderRootSize(), IID_PPV_ARGS(&m_ptrRootSignature))
+                    GetD3D12DevicePtr()->CreateRootSignature(0, ptrRootShader->GetShaderRootData(), ptrRootShader->GetShaderRootSize(), IID_PPV_ARGS(&m_ptrRootSignature))
                 );
                 m_psoDescCompute.pRootSignature = m_ptrRootSignature;
 
-                RTR_CHECK_HRESULT(
-                    "Creating GFX pso",
-                    GetD3D12DevicePtr()->CreateGraphicsPipelineState(&m_psoDescGfx, IID_PPV_ARGS(&m_ptrPso))
-                );
+                if (m_ptrMSShader)
+                {
+                    // Mesh shader pipelines can only be created from a stream
+                    MeshPsoStream stream;
+                    stream.rootSignature.data = m_ptrRootSignature;
+                    stream.as.data.BytecodeLength = m_ptrASShader ? m_ptrASShader->GetShaderSize() : 0;
+                    stream.as.data.pShaderBytecode = m_ptrASShader ? m_ptrASShader->GetShaderData() : nullptr;
+                    stream.ms.data.BytecodeLength = m_ptrMSShader->GetShaderSize();
+                    stream.ms.data.pShaderBytecode = m_ptrMSShader->GetShaderData();
+                    stream.ps.data = m_psoDescGfx.PS;
+                    stream.blend.data = m_psoDescGfx.BlendState;
+                    stream.sampleMask.data = m_psoDescGfx.SampleMask;
+                    stream.rasterizer.data = m_psoDescGfx.RasterizerState;
+                    stream.depthStencil.data = m_psoDescGfx.DepthStencilState;
+                    stream.renderTargets.data.NumRenderTargets = m_psoDescGfx.NumRenderTargets;
+                    memcpy(stream.renderTargets.data.RTFormats, m_psoDescGfx.RTVFormats, sizeof(m_psoDescGfx.RTVFormats));
+                    stream.depthStencilFormat.data = m_psoDescGfx.DSVFormat;
+                    stream.sampleDesc.data = m_psoDescGfx.SampleDesc;
+                    stream.flags.data = m_psoDescGfx.Flags;
+
+                    D3D12_PIPELINE_STATE_STREAM_DESC streamDesc;
+                    streamDesc.SizeInBytes = sizeof(stream);
+                    streamDesc.pPipelineStateSubobjectStream = &stream;
+                    RTR_CHECK_HRESULT(
+                        "Creating mesh shader pso",
+                        GetD3D12DevicePtr()->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&m_ptrPso))
+                    );
+                }
+                else
+                {
+                    RTR_CHECK_HRESULT(
+                        "Creating GFX pso",
+                        GetD3D12DevicePtr()->CreateGraphicsPipelineState(&m_psoDescGfx, IID_PPV_ARGS(&m_ptrPso))
+                    );
+                }
             }
         }
         else
@@ -166,7 +166,7 @@ namespace RTR
                 D3D12_STENCIL_OP stencilPassDepthFail, D3D12_STENCIL_OP stencilPassDepthPass, 
                 D3D12_COMPARISON_FUNC stencilComparisonFunc);
             // Add a per vertex auto offset input element at slot 1
-            void IAAddElement(const char* name, DXGI_FORMAT format);
+            void IAAddElement(const char* name, DXGI_FORMAT format, UINT semanticIndex = 0);
             // Enable strip cut (by default 32bit max if parameter false 16bit max)
             void IAEnableIndexBufferStripeCut(bool is32bitWide = true);
             // Set the type of the primitive topology
@@ -224,6 +224,12 @@ namespace RTR
             // Bind functions
             bool Bind(ID3D12GraphicsCommandList* ptrCmdList);
 
+            // Root signature of the pso (created on the first Bind, replaced when the shaders reload)
+            inline ID3D12RootSignature* GetRootSignature()
+            {
+                return m_ptrRootSignature;
+            }
+
         protected:
             // === Functions that can / must be updated by implementation ===
             
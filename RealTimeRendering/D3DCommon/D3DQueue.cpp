@@ -76,3 +76,8 @@ bool RTR::D3DQueue::IsFinished(UINT64 mark)
 {
     return m_ptrFence->GetCompletedValue() >= mark;
 }
+
+UINT64 RTR::D3DQueue::GetCompletedValue()
+{
+    return m_ptrFence->GetCompletedValue();
+}
@@ -26,6 +26,13 @@ namespace RTR
             void Flush(UINT count = 1);
             bool IsFinished(UINT64 mark);
 
+            // Fence values (work up to GetCompletedValue is done on the gpu)
+            UINT64 GetCompletedValue();
+            inline UINT64 GetLastSignaledValue() const noexcept
+            {
+                return m_lastSignaledValue;
+            }
+
             // Inline get type
             D3D12_COMMAND_LIST_TYPE GetQueueType() const noexcept
             {
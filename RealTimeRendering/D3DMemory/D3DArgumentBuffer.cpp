@@ -0,0 +1,43 @@
+#include "D3DArgumentBuffer.h"
+
+RTR::D3DArgumentBuffer::D3DArgumentBuffer(UINT64 argumentSize) :
+    m_argumentSize((argumentSize + 3) & ~3ULL)
+{
+    // Describe resource (commands and count)
+    D3D12_RESOURCE_DESC desc;
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    desc.Width = m_argumentSize + sizeof(UINT);
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    // Create resource
+    RTR_CHECK_HRESULT(
+        "Argument buffer resource creation",
+        GetD3D12DevicePtr()->CreateCommittedResource(GetD3D12DefaultHeapProperites(), D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&m_ptrResource))
+    );
+}
+
+bool RTR::D3DArgumentBuffer::ResetCount(D3DCommandList& cmdList, D3DConstantRing& constantRing)
+{
+    // Zero in the ring
+    const UINT zero = 0;
+    const D3D12_GPU_VIRTUAL_ADDRESS source = constantRing.Push(zero);
+    if (!source)
+        return false;
+
+    // Buffers decay to COMMON when the list that used them last finished
+    SetResourceState(D3D12_RESOURCE_STATE_COMMON);
+
+    // Copy over the count
+    EnsureResourceState(cmdList, D3D12_RESOURCE_STATE_COPY_DEST);
+    cmdList.ResourceBarrierFlush();
+    cmdList.CopyBufferRegion(m_ptrResource, GetCountOffset(), constantRing, source - constantRing.GetAddress(), sizeof(UINT));
+    return true;
+}
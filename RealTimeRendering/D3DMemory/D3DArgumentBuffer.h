@@ -0,0 +1,51 @@
+#pragma once
+
+#include <WinInclude.h>
+
+#include <Util/ComPointer.h>
+#include <Util/HrException.h>
+
+#include <D3DCommon/D3DInstance.h>
+#include <D3DCommon/D3DCmdList.h>
+#include <D3DMemory/D3DResource.h>
+#include <D3DMemory/D3DConstantRing.h>
+
+namespace RTR
+{
+    // Default heap buffer that is written by a compute pass (UAV) and consumed by ExecuteIndirect: the commands
+    // followed by a 32 bit command count
+    class D3DArgumentBuffer : public D3DResource
+    {
+        public:
+            // Construct (argumentSize bytes of commands)
+            D3DArgumentBuffer() = delete;
+            D3DArgumentBuffer(const D3DArgumentBuffer&) = delete;
+            D3DArgumentBuffer(UINT64 argumentSize);
+
+            // No copy
+            D3DArgumentBuffer& operator=(const D3DArgumentBuffer&) = delete;
+
+            // Record setting the count to zero (copied from constantRing, leaves the buffer in COPY_DEST). Starts the use of the
+            // buffer in a command list, call it once per list.
+            bool ResetCount(D3DCommandList& cmdList, D3DConstantRing& constantRing);
+
+            // Bytes available for commands
+            inline UINT64 GetArgumentSize() const noexcept
+            {
+                return m_argumentSize;
+            }
+            // Offset of the count
+            inline UINT64 GetCountOffset() const noexcept
+            {
+                return m_argumentSize;
+            }
+            // Address of the count (e.g. for a root UAV)
+            inline D3D12_GPU_VIRTUAL_ADDRESS GetCountAddress()
+            {
+                return GetAddress() + m_argumentSize;
+            }
+
+        private:
+            UINT64 m_argumentSize;
+    };
+}
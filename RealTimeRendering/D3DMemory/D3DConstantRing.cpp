@@ -0,0 +1,85 @@
+#include "D3DConstantRing.h"
+
+RTR::D3DConstantRing::D3DConstantRing(D3DQueue& queue, UINT64 size) :
+    m_queue(queue),
+    m_allocator(size)
+{
+    // Describe heap for uploading
+    D3D12_HEAP_PROPERTIES uploadHeapProps;
+    uploadHeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+    uploadHeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    uploadHeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    uploadHeapProps.CreationNodeMask = NULL;
+    uploadHeapProps.VisibleNodeMask = NULL;
+
+    // Describe the resource itself
+    D3D12_RESOURCE_DESC bufferDesc;
+    bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufferDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    bufferDesc.Width = size;
+    bufferDesc.Height = 1;
+    bufferDesc.DepthOrArraySize = 1;
+    bufferDesc.MipLevels = 1;
+    bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufferDesc.SampleDesc.Count = 1;
+    bufferDesc.SampleDesc.Quality = 0;
+    bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    bufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    // Create upload resource (upload heaps stay in GENERIC_READ)
+    RTR_CHECK_HRESULT(
+        "Creating constant ring buffer",
+        GetD3D12DevicePtr()->CreateCommittedResource(&uploadHeapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_ptrResource))
+    );
+    m_resourceState = D3D12_RESOURCE_STATE_GENERIC_READ;
+
+    // Map once for the whole lifetime
+    RTR_CHECK_HRESULT(
+        "Mapping constant ring buffer into CPU write area",
+        m_ptrResource->Map(NULL, nullptr, (void**)&m_ptrMappedData)
+    );
+}
+
+RTR::D3DConstantRing::~D3DConstantRing()
+{
+    // Unmap buffer
+    if (m_ptrMappedData && m_ptrResource)
+    {
+        m_ptrResource->Unmap(NULL, nullptr);
+        m_ptrMappedData = nullptr;
+    }
+
+    m_ptrResource.release();
+}
+
+RTR::D3DConstantAllocation RTR::D3DConstantRing::Allocate(UINT64 size)
+{
+    D3DConstantAllocation allocation;
+    Retire();
+
+    // Wait for the oldest frame until the allocation fits
+    UINT64 offset;
+    while (!m_allocator.Allocate(size, Alignment, &offset))
+    {
+        UINT64 fence;
+        if (!m_allocator.GetOldestFence(&fence))
+            return allocation;
+
+        m_queue.Wait(fence);
+        m_allocator.Retire(fence);
+    }
+
+    allocation.ptrData = m_ptrMappedData + offset;
+    allocation.address = GetAddress() + offset;
+    return allocation;
+}
+
+void RTR::D3DConstantRing::EndFrame(UINT64 fenceValue)
+{
+    m_allocator.FinishFrame(fenceValue);
+}
+
+void RTR::D3DConstantRing::Retire()
+{
+    m_allocator.Retire(m_queue.GetCompletedValue());
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <WinInclude.h>
+
+#include <Util/ComPointer.h>
+#include <Util/HrException.h>
+#include <Util/RingAllocator.h>
+
+#include <D3DCommon/D3DInstance.h>
+#include <D3DCommon/D3DQueue.h>
+#include <D3DMemory/D3DResource.h>
+
+#include <cstring>
+
+namespace RTR
+{
+    // Constant memory of the current frame
+    struct D3DConstantAllocation
+    {
+        // Write combined cpu pointer (write only, nullptr when the allocation failed)
+        void* ptrData = nullptr;
+        // Address for RootConfigurationEntry::MakeConstantBufferView
+        D3D12_GPU_VIRTUAL_ADDRESS address = 0;
+    };
+
+    // Persistently mapped upload heap ring for per frame constant buffers. Constants are written in place and read by the gpu
+    // from the upload heap (no copy and no sync). Every frame in flight owns the region it allocated until its fence completed.
+    class D3DConstantRing : public D3DResource
+    {
+        public:
+            // Placement alignment of constant buffer views
+            static constexpr UINT64 Alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+        public:
+            // Construct and destruct (size should hold all frames in flight)
+            D3DConstantRing() = delete;
+            D3DConstantRing(D3DQueue& queue, UINT64 size);
+            D3DConstantRing(const D3DConstantRing&) = delete;
+            ~D3DConstantRing();
+
+            // No copy
+            D3DConstantRing& operator=(const D3DConstantRing&) = delete;
+
+            // Allocate constant memory for the current frame (256 byte aligned). Retires finished frames first and waits for
+            // the oldest frame when the ring is full. Fails only when the current frame alone does not fit.
+            D3DConstantAllocation Allocate(UINT64 size);
+            // Allocate and write data (0 on failure)
+            template<typename T>
+            D3D12_GPU_VIRTUAL_ADDRESS Push(const T& data)
+            {
+                D3DConstantAllocation allocation = Allocate(sizeof(T));
+                if (allocation.ptrData)
+                    memcpy(allocation.ptrData, &data, sizeof(T));
+                return allocation.address;
+            }
+
+            // Close the current frame. Its memory is in use until the queue reached fenceValue (by default the last signaled value).
+            void EndFrame(UINT64 fenceValue);
+            inline void EndFrame()
+            {
+                EndFrame(m_queue.GetLastSignaledValue());
+            }
+
+            // Release the memory of all frames the gpu finished
+            void Retire();
+
+            // Bookkeeping
+            inline const RingAllocator& GetAllocator() const
+            {
+                return m_allocator;
+            }
+
+        private:
+            // Queue that executes the frames
+            D3DQueue& m_queue;
+
+            // Mapped memory and its ring
+            unsigned char* m_ptrMappedData = nullptr;
+            RingAllocator m_allocator;
+    };
+}
@@ -1,20 +1,22 @@
 #include "D3DUploadBuffer.h"
 
-RTR::D3DUploadBuffer::D3DUploadBuffer(UINT64 bufferSize) :
-    m_uploadQueue(D3D12_COMMAND_LIST_TYPE_COPY)
+namespace
 {
-    // Create command list and allocator pair
-    RTR_CHECK_HRESULT(
-        "Creating command allocator for upload command list",
-        GetD3D12DevicePtr()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&m_uploadCommandAllocator))
-    );
-
-    // Create command list
-    RTR_CHECK_HRESULT(
-        "Creating command list for data uploading",
-        GetD3D12DevicePtr()->CreateCommandList(NULL, D3D12_COMMAND_LIST_TYPE_COPY, m_uploadCommandAllocator, nullptr, IID_PPV_ARGS(&m_uploadCommandList))
-    );
+    // Recorder of the calling thread in the upload buffer it recorded to last (instance ids are never reused)
+    struct RecorderCache
+    {
+        UINT64 instanceId = 0;
+        void* ptrRecorder = nullptr;
+    };
+    thread_local RecorderCache t_recorderCache;
+    std::atomic<UINT64> s_nextInstanceId = 1;
+}
 
+RTR::D3DUploadBuffer::D3DUploadBuffer(UINT64 bufferSize, UploadBufferMode mode) :
+    m_mode(mode),
+    m_uploadQueue(D3D12_COMMAND_LIST_TYPE_COPY),
+    m_instanceId(s_nextInstanceId.fetch_add(1))
+{
     // Describe heap for uploading
     D3D12_HEAP_PROPERTIES uploadHeapProps;
     uploadHeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
@@ -43,7 +45,7 @@ RTR::D3DUploadBuffer::D3DUploadBuffer(UINT64 bufferSize) :
         GetD3D12DevicePtr()->CreateCommittedResource(&uploadHeapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_d3dResource))
     );
 
-    // Map buffer
+    // Map buffer (for the whole lifetime in ring mode)
     RTR_CHECK_HRESULT(
         "Mapping upload buffer into CPU read/write area",
         m_d3dResource->Map(NULL, nullptr, (void**)&m_ptrMappedData)
@@ -51,6 +53,10 @@ RTR::D3DUploadBuffer::D3DUploadBuffer(UINT64 bufferSize) :
 
     // Set size
     m_bufferSize = bufferSize;
+    if (m_mode == UploadBufferMode::Ring)
+        m_ring.Reset(bufferSize);
+    else
+        m_bufferUsage.Reset(bufferSize);
 }
 
 RTR::D3DUploadBuffer::~D3DUploadBuffer()
@@ -66,28 +72,40 @@ RTR::D3DUploadBuffer::~D3DUploadBuffer()
     if(m_uploadQueue)
         m_uploadQueue.Flush();
     m_uploadQueue.~D3DQueue();
-    m_uploadCommandList.release();
-    m_uploadCommandAllocator.release();
+    m_recorders.clear();
+    m_submissions.clear();
+    m_freeAllocators.clear();
 
     // Rollback resource
     m_d3dResource.release();
 }
 
-void* RTR::D3DUploadBuffer::ReserverUploadMemory(UINT64 reservationSize)
+void* RTR::D3DUploadBuffer::ReserverUploadMemory(UINT64 reservationSize, UINT64 alignment)
 {
-    unsigned char* ptrReservation = m_ptrMappedData;
-    size_t bufferMemoryLeft = m_bufferSize - m_bufferUsage;
+    // Ring: space of finished executions is reclaimed first (fence bookkeeping is serialized)
+    if (m_mode == UploadBufferMode::Ring)
+    {
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        retire();
+        UINT64 offset;
+        if (!m_ring.Allocate(reservationSize, alignment, &offset))
+            return nullptr;
+
+        m_openMemoryReservations.fetch_add(1, std::memory_order_relaxed);
+        return m_ptrMappedData + offset;
+    }
 
-    // Only on valid mapping point and enough space
-    if (m_ptrMappedData && bufferMemoryLeft >= reservationSize)
+    unsigned char* ptrReservation = nullptr;
+    UINT64 offset;
+
+    // Only on valid mapping point and enough space (one atomic add)
+    if (m_ptrMappedData && m_bufferUsage.Allocate(reservationSize, alignment, &offset))
     {
         // Set pointer
-        ptrReservation += m_bufferUsage;
-        // Increment usage
-        m_bufferUsage += reservationSize;
+        ptrReservation = m_ptrMappedData + offset;
 
         // Count open reservations
-        m_openMemoryReservations++;
+        m_openMemoryReservations.fetch_add(1, std::memory_order_relaxed);
     }
 
     return ptrReservation;
@@ -98,11 +116,13 @@ bool RTR::D3DUploadBuffer::CommitBufferCopy(void* ptrLocalMemory, UINT64 localMe
     bool canCopy = !m_isExecuting;
     if (canCopy)
     {
-        // Copy a buffer region
-        m_uploadCommandList->CopyBufferRegion(ptrTargetResource, targetOffset, m_d3dResource, ((unsigned char*)ptrLocalMemory) - m_ptrMappedData, localMemorySize);
+        // Defer the buffer region copy
+        Recorder& recorder = getRecorder();
+        recorder.pendingCopies.push_back({ ptrTargetResource, targetOffset, (UINT64)(((unsigned char*)ptrLocalMemory) - m_ptrMappedData), localMemorySize });
+        recorder.copies++;
 
         // Count open reservations
-        m_openMemoryReservations--;
+        m_openMemoryReservations.fetch_sub(1, std::memory_order_relaxed);
     }
 
     return canCopy;
@@ -140,10 +160,12 @@ bool RTR::D3DUploadBuffer::CommitTextureCopy(void* ptrLocalMemory, DXGI_FORMAT f
         copyBox.back = depth;
 
         // Copy a texture region
-        m_uploadCommandList->CopyTextureRegion(&destLocation, destX, destY, destZ, &srcLocation, &copyBox);
+        Recorder& recorder = getRecorder();
+        recorder.ptrList->CopyTextureRegion(&destLocation, destX, destY, destZ, &srcLocation, &copyBox);
+        recorder.copies++;
 
         // Count open reservations
-        m_openMemoryReservations--;
+        m_openMemoryReservations.fetch_sub(1, std::memory_order_relaxed);
     }
 
     return canCopy;
@@ -165,8 +187,8 @@ bool RTR::D3DUploadBuffer::CopyBufferData(void* ptrLocalMemory, UINT64 localMemo
     void* ptrMemory = ReserverUploadMemory(localMemorySize);
     if (ptrMemory)
     {
-        // Copy to upload buffer
-        memcpy(ptrMemory, ptrLocalMemory, localMemorySize);
+        // Copy to upload buffer (write combined)
+        StreamCopy(ptrMemory, ptrLocalMemory, localMemorySize);
 
         // Post copy
         success = CommitBufferCopy(ptrMemory, localMemorySize, ptrTargetResource, targetOffset);
@@ -183,21 +205,22 @@ bool RTR::D3DUploadBuffer::CopyTextureData(void* ptrLocalMemory, DXGI_FORMAT for
     UINT requiredRowStride = GetRequiredImageRowStride(width, rowStride / width);
 
     // Allocate memory
-    unsigned char* ptrMemory = (unsigned char*)ReserverUploadMemory(requiredRowStride * height * depth);
+    unsigned char* ptrMemory = (unsigned char*)ReserverUploadMemory(requiredRowStride * height * depth, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
     if (ptrMemory)
     {
         // Copy how required
         if (requiredRowStride == rowStride)
         {
             // Copy full texture
-            memcpy(ptrMemory, ptrLocalMemory, rowStride * height * depth);
+            StreamCopy(ptrMemory, ptrLocalMemory, (size_t)rowStride * height * depth);
         }
         else
         {
-            // Copy each row 
+            // Copy each row (only the bytes of the source row, the padding of the last one would read past the source)
+            const UINT rowBytes = std::min(rowStride, requiredRowStride);
             for (UINT64 i = 0; i < height * depth; i++)
             {
-                memcpy(&ptrMemory[requiredRowStride * i], &((unsigned char*)ptrLocalMemory)[rowStride * i], requiredRowStride);
+                StreamCopy(&ptrMemory[requiredRowStride * i], &((unsigned char*)ptrLocalMemory)[rowStride * i], rowBytes);
             }
         }
 
@@ -208,35 +231,154 @@ bool RTR::D3DUploadBuffer::CopyTextureData(void* ptrLocalMemory, DXGI_FORMAT for
     return success;
 }
 
+bool RTR::D3DUploadBuffer::StreamBufferData(UINT64 size, const UploadProducer& producer, ID3D12Resource* ptrTargetResource, UINT64 targetOffset, UINT64 chunkSize)
+{
+    const bool ring = m_mode == UploadBufferMode::Ring;
+    UINT64 streamed = 0;
+    while (streamed < size)
+    {
+        const StreamChunk chunk = PlanStreamChunk(size, streamed, chunkSize, m_bufferSize, ring ? 0 : GetFreeMemory(), GetOpenReservationsCount(), ring);
+        if (!chunk.size)
+            return false;
+
+        // Flush a full linear buffer, ring mode makes room by waiting for the oldest chunk in flight
+        if (chunk.flushBefore)
+            ExecuteSync();
+        void* ptrChunk = nullptr;
+        while (!(ptrChunk = ReserverUploadMemory(chunk.size)))
+        {
+            if (!ring)
+                return false;
+            Execute();
+            if (!waitOldestExecution())
+                return false;
+        }
+
+        // Produce straight into staging memory
+        if (!producer(ptrChunk, chunk.offset, chunk.size))
+        {
+            m_openMemoryReservations.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        CommitBufferCopy(ptrChunk, chunk.size, ptrTargetResource, targetOffset + chunk.offset);
+        streamed += chunk.size;
+
+        // Let the gpu copy this chunk while the next one is produced
+        if (chunk.executeAfter)
+            Execute();
+    }
+
+    return true;
+}
+
 void RTR::D3DUploadBuffer::Execute()
 {
+    // Threads may still create their recorder (getRecorder appends to m_recorders)
+    std::lock_guard<std::mutex> recorderLock(m_recorderMutex);
+
+    // Close the lists of all threads that recorded copies
+    std::vector<ID3D12CommandList*> lists;
+    std::vector<ComPointer<ID3D12CommandAllocator>> allocators;
+    if (m_mode == UploadBufferMode::Ring || !m_isExecuting)
+    {
+        for (Recorder& recorder : m_recorders)
+        {
+            if (recorder.copies && !recorder.submitted)
+            {
+                recordPendingCopies(recorder);
+                recorder.ptrList->Close();
+                lists.push_back(recorder.ptrList);
+                allocators.push_back(recorder.ptrAllocator);
+            }
+        }
+    }
+
+    if (m_mode == UploadBufferMode::Ring)
+    {
+        // Nothing to submit (a frame kept open by reservations closes with the last submission once they are gone)
+        if (lists.empty())
+        {
+            std::lock_guard<std::mutex> lock(m_ringMutex);
+            if (!GetOpenReservationsCount() && m_ring.GetOpenFrameSize())
+                m_ring.FinishFrame(m_uploadQueue.GetLastSignaledValue());
+            retire();
+            return;
+        }
+
+        // Submit all lists at once and tag the region of this execution with its fence. Memory of reservations that are not
+        // committed yet is part of the open frame, so it stays open and a later execution (with a later fence) closes it.
+        const UINT64 fenceValue = m_uploadQueue.Execute(lists.data(), (unsigned int)lists.size());
+        {
+            std::lock_guard<std::mutex> lock(m_ringMutex);
+            if (!GetOpenReservationsCount())
+                m_ring.FinishFrame(fenceValue);
+            m_submissions.push_back({ std::move(allocators), fenceValue });
+            m_submittedExecutions++;
+            retire();
+        }
+
+        // Continue recording on allocators the gpu is done with
+        for (Recorder& recorder : m_recorders)
+        {
+            if (recorder.copies)
+            {
+                recorder.ptrAllocator = acquireAllocator();
+                recorder.ptrList->Reset(recorder.ptrAllocator, nullptr);
+                recorder.copies = 0;
+            }
+        }
+        return;
+    }
+
     if (!m_isExecuting)
     {
         // Unmap
         m_d3dResource->Unmap(0, nullptr);
         m_ptrMappedData = nullptr;
 
-        // Dispatch command list on queue
-        m_uploadCommandList->Close();
-        m_queueWaitValue = m_uploadQueue.Execute(m_uploadCommandList);
+        // Dispatch command lists on queue (without copies only the fence is waited for)
+        m_queueWaitValue = lists.empty() ? m_uploadQueue.GetLastSignaledValue() : m_uploadQueue.Execute(lists.data(), (unsigned int)lists.size());
+        for (Recorder& recorder : m_recorders)
+            recorder.submitted = recorder.copies != 0;
+        m_submittedExecutions++;
 
         // Set
         m_isExecuting = true;
 
         // All reservations are closed now
-        m_openMemoryReservations = 0;
+        m_openMemoryReservations.store(0, std::memory_order_relaxed);
     }
 }
 
 void RTR::D3DUploadBuffer::Wait()
 {
+    // Ring: wait for the last execution (the buffer stays mapped)
+    if (m_mode == UploadBufferMode::Ring)
+    {
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        if (!m_submissions.empty())
+            m_uploadQueue.Wait(m_submissions.back().fenceValue);
+        retire();
+        return;
+    }
+
     // Blocking wait
     m_uploadQueue.Wait(m_queueWaitValue);
     
-    // Reset
-    m_uploadCommandAllocator->Reset();
-    m_uploadCommandList->Reset(m_uploadCommandAllocator, nullptr);
-    m_bufferUsage = 0;
+    // Reset the submitted lists
+    for (Recorder& recorder : m_recorders)
+    {
+        if (recorder.submitted)
+        {
+            recorder.ptrAllocator->Reset();
+            recorder.ptrList->Reset(recorder.ptrAllocator, nullptr);
+            recorder.copies = 0;
+            recorder.submitted = false;
+        }
+    }
+    m_bufferUsage.Reset();
+    if (m_isExecuting)
+        m_finishedExecutions++;
     m_isExecuting = false;
 
     // Remap resource
@@ -248,6 +390,13 @@ void RTR::D3DUploadBuffer::Wait()
 
 bool RTR::D3DUploadBuffer::CheckFinished()
 {
+    if (m_mode == UploadBufferMode::Ring)
+    {
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        retire();
+        return m_submissions.empty();
+    }
+
     // Check finished state
     bool finished = m_uploadQueue.IsFinished(m_queueWaitValue);
     if (finished)
@@ -258,3 +407,121 @@ bool RTR::D3DUploadBuffer::CheckFinished()
 
     return finished;
 }
+
+UINT64 RTR::D3DUploadBuffer::GetFreeMemory()
+{
+    if (m_mode == UploadBufferMode::Ring)
+    {
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        retire();
+        return m_ring.GetContiguousFreeSize();
+    }
+
+    return m_isExecuting || !m_ptrMappedData ? 0 : m_bufferUsage.GetFreeSize();
+}
+
+bool RTR::D3DUploadBuffer::GetExecutionState()
+{
+    if (m_mode == UploadBufferMode::Ring)
+    {
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        return !m_submissions.empty();
+    }
+
+    return m_isExecuting;
+}
+
+RTR::D3DUploadBuffer::Recorder& RTR::D3DUploadBuffer::getRecorder()
+{
+    // Fast path without locking
+    if (t_recorderCache.instanceId == m_instanceId)
+        return *(Recorder*)t_recorderCache.ptrRecorder;
+
+    std::lock_guard<std::mutex> lock(m_recorderMutex);
+    Recorder*& ptrRecorder = m_threadRecorders[std::this_thread::get_id()];
+    if (!ptrRecorder)
+    {
+        // New list for this thread
+        Recorder& recorder = m_recorders.emplace_back();
+        recorder.ptrAllocator = acquireAllocator();
+        RTR_CHECK_HRESULT(
+            "Creating command list for data uploading",
+            GetD3D12DevicePtr()->CreateCommandList(NULL, D3D12_COMMAND_LIST_TYPE_COPY, recorder.ptrAllocator, nullptr, IID_PPV_ARGS(&recorder.ptrList))
+        );
+        ptrRecorder = &recorder;
+    }
+
+    t_recorderCache.instanceId = m_instanceId;
+    t_recorderCache.ptrRecorder = ptrRecorder;
+    return *ptrRecorder;
+}
+
+void RTR::D3DUploadBuffer::recordPendingCopies(Recorder& recorder)
+{
+    // Sorted by target with contiguous copies merged
+    auto& copies = recorder.pendingCopies;
+    m_mergedCopies += CoalesceBufferCopies(copies);
+    for (const BufferCopy& copy : copies)
+        recorder.ptrList->CopyBufferRegion((ID3D12Resource*)copy.ptrTarget, copy.targetOffset, m_d3dResource, copy.sourceOffset, copy.size);
+
+    copies.clear();
+}
+
+bool RTR::D3DUploadBuffer::waitOldestExecution()
+{
+    UINT64 fenceValue;
+    {
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        if (m_submissions.empty())
+            return false;
+        fenceValue = m_submissions.front().fenceValue;
+    }
+
+    m_uploadQueue.Wait(fenceValue);
+
+    std::lock_guard<std::mutex> lock(m_ringMutex);
+    retire();
+    return true;
+}
+
+ComPointer<ID3D12CommandAllocator> RTR::D3DUploadBuffer::acquireAllocator()
+{
+    ComPointer<ID3D12CommandAllocator> ptrAllocator;
+    {
+        std::lock_guard<std::mutex> lock(m_ringMutex);
+        if (!m_freeAllocators.empty())
+        {
+            ptrAllocator = m_freeAllocators.back();
+            m_freeAllocators.pop_back();
+        }
+    }
+
+    if (ptrAllocator)
+    {
+        ptrAllocator->Reset();
+    }
+    else
+    {
+        RTR_CHECK_HRESULT(
+            "Creating command allocator for upload command list",
+            GetD3D12DevicePtr()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&ptrAllocator))
+        );
+    }
+
+    return ptrAllocator;
+}
+
+void RTR::D3DUploadBuffer::retire()
+{
+    const UINT64 completedValue = m_uploadQueue.GetCompletedValue();
+    m_ring.Retire(completedValue);
+
+    // Executions finish in submission order
+    while (!m_submissions.empty() && m_submissions.front().fenceValue <= completedValue)
+    {
+        for (auto& ptrAllocator : m_submissions.front().allocators)
+            m_freeAllocators.push_back(ptrAllocator);
+        m_submissions.pop_front();
+        m_finishedExecutions++;
+    }
+}
@@ -5,19 +5,46 @@
 #include <Util/ComPointer.h>
 #include <Util/HrException.h>
 #include <Util/Memory.h>
+#include <Util/RingAllocator.h>
+#include <Util/AtomicBumpAllocator.h>
+#include <Util/StreamCopy.h>
+#include <Util/StreamChunking.h>
+#include <Util/CopyCoalescing.h>
 
 #include <D3DCommon/D3DInstance.h>
 #include <D3DCommon/D3DQueue.h>
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 namespace RTR
 {
-    // Self managed upload buffer
+    // How a D3DUploadBuffer reuses its memory
+    enum class UploadBufferMode
+    {
+        // Arena that is unmapped while executing and reset by Wait
+        Linear = 0,
+        // Persistently mapped ring, every execution owns its region until its fence completed (Execute never blocks)
+        Ring,
+    };
+
+    // Fills ptrChunk with size bytes of the source starting at sourceOffset (false aborts the upload)
+    using UploadProducer = std::function<bool(void* ptrChunk, UINT64 sourceOffset, UINT64 size)>;
+
+    // Self managed upload buffer. Reservations and commits may come from many threads at once (every thread records to its own
+    // copy command list), Execute / Wait / CheckFinished must not overlap with them.
     class D3DUploadBuffer
     {
         public:
             // Construct and destruct
             D3DUploadBuffer() = delete;
-            D3DUploadBuffer(UINT64 bufferSize);
+            D3DUploadBuffer(UINT64 bufferSize, UploadBufferMode mode = UploadBufferMode::Linear);
             D3DUploadBuffer(const D3DUploadBuffer&) = delete;
             ~D3DUploadBuffer();
 
@@ -25,10 +52,12 @@ namespace RTR
             D3DUploadBuffer& operator=(const D3DUploadBuffer&) = delete;
             D3DUploadBuffer& operator=(D3DUploadBuffer&&) = default;
 
-            // Upload memory reservation function
-            void* ReserverUploadMemory(UINT64 reservationSize);
+            // Upload memory reservation function, lock free in linear mode (nullptr when the memory is used up or still in use).
+            // Reservations have to be committed before the next Execute (ring mode: open ones keep the memory of the executions
+            // since their reservation in use until an Execute without open reservations).
+            void* ReserverUploadMemory(UINT64 reservationSize, UINT64 alignment = 1);
 
-            // Post memory copy executions
+            // Post memory copy executions (buffer copies are deferred to Execute and merged when contiguous in source and target)
             bool CommitBufferCopy(void* ptrLocalMemory, UINT64 localMemorySize, ID3D12Resource* ptrTargetResource, UINT64 targetOffset = 0);
             bool CommitTextureCopy(void* ptrLocalMemory, DXGI_FORMAT format, UINT width, UINT height, UINT depth, UINT rowStride, ID3D12Resource* ptrTargetTexture, UINT destX = 0, UINT destY = 0, UINT destZ = 0, UINT subresourceIndex = 0);
 
@@ -39,7 +68,14 @@ namespace RTR
             bool CopyBufferData(void* ptrLocalMemory, UINT64 localMemorySize, ID3D12Resource* ptrTargetResource, UINT64 targetOffset = 0);
             bool CopyTextureData(void* ptrLocalMemory, DXGI_FORMAT format, UINT width, UINT height, UINT depth, UINT rowStride, ID3D12Resource* ptrTargetTexture, UINT destX = 0, UINT destY = 0, UINT destZ = 0, UINT subresourceIndex = 0);
 
-            // Execution and wait
+            // Upload size bytes of any size in chunks of at most chunkSize (0: a quarter of the buffer) the producer writes straight into
+            // staging memory. Calls Execute between chunks (same rules as Execute), in ring mode the gpu copies a chunk while the next one
+            // is produced, linear mode waits for every full buffer. Linear mode fails instead when the buffer is full while other
+            // reservations are open, as waiting would reset them (see PlanStreamChunk). The last chunk goes out with the next Execute.
+            bool StreamBufferData(UINT64 size, const UploadProducer& producer, ID3D12Resource* ptrTargetResource, UINT64 targetOffset = 0, UINT64 chunkSize = 0);
+
+            // Execution and wait. Execute submits the lists of all threads with one ExecuteCommandLists (ring mode: and continues
+            // recording right away, Wait blocks until all executions finished and CheckFinished reclaims the memory of finished ones)
             void Execute();
             void Wait();
             bool CheckFinished();
@@ -52,19 +88,64 @@ namespace RTR
             }
 
             // Get execution state
-            inline bool GetExecutionState()
+            bool GetExecutionState();
+            inline UINT64 GetOpenReservationsCount()
             {
-                return m_isExecuting;
+                return m_openMemoryReservations.load(std::memory_order_relaxed);
             }
-            inline UINT64 GetOpenReservationsCount()
+
+            // Largest reservation that fits right now (0 while executing in linear mode)
+            UINT64 GetFreeMemory();
+            // Count of executions that have finished. Copies recorded now are done once this reached GetRecordingExecution().
+            inline UINT64 GetFinishedExecutionCount()
             {
-                return m_openMemoryReservations;
+                return m_finishedExecutions.load(std::memory_order_acquire);
+            }
+            // Execution the copies recorded now belong to (1 based)
+            inline UINT64 GetRecordingExecution()
+            {
+                return m_submittedExecutions + 1;
+            }
+            // Buffer copies saved by merging them with their neighbour (since creation)
+            inline UINT64 GetMergedCopyCount()
+            {
+                return m_mergedCopies;
             }
 
         private:
+            // Copy command list of one recording thread
+            struct Recorder
+            {
+                ComPointer<ID3D12CommandAllocator> ptrAllocator;
+                ComPointer<ID3D12GraphicsCommandList> ptrList;
+                // Buffer copies waiting for Execute (targets are ID3D12Resource pointers)
+                std::vector<BufferCopy> pendingCopies;
+                // Copies since the list was reset and whether it waits for Wait (linear mode)
+                UINT64 copies = 0;
+                bool submitted = false;
+            };
+
+            // Recorder of the calling thread (created on its first copy)
+            Recorder& getRecorder();
+            // Sort the pending buffer copies by target, merge contiguous ones and record them
+            void recordPendingCopies(Recorder& recorder);
+            // Block until the oldest execution in flight finished (ring mode, false if none is)
+            bool waitOldestExecution();
+            // Allocator for the next list of a recorder (reuses ones of finished executions)
+            ComPointer<ID3D12CommandAllocator> acquireAllocator();
+            // Release the memory and allocators of finished executions (ring mode, m_ringMutex held)
+            void retire();
+
+        private:
+            // Memory reuse
+            UploadBufferMode m_mode;
+
             // Execution state
             bool m_isExecuting = 0;
             UINT64 m_queueWaitValue = 0;
+            UINT64 m_submittedExecutions = 0;
+            UINT64 m_mergedCopies = 0;
+            std::atomic<UINT64> m_finishedExecutions = 0;
 
             // D3D Buffer resource
             ComPointer<ID3D12Resource> m_d3dResource;
@@ -72,16 +153,29 @@ namespace RTR
             // Mapped pointer
             unsigned char* m_ptrMappedData = nullptr;
 
-            // Command queue, list and allocator that will be used for upload commands
+            // Command queue and the lists of all recording threads (deque keeps the addresses stable)
             D3DQueue m_uploadQueue;
-            ComPointer<ID3D12CommandAllocator> m_uploadCommandAllocator;
-            ComPointer<ID3D12GraphicsCommandList> m_uploadCommandList;
+            std::mutex m_recorderMutex;
+            std::deque<Recorder> m_recorders;
+            std::unordered_map<std::thread::id, Recorder*> m_threadRecorders;
+            UINT64 m_instanceId;
 
-            // Buffer size and usage details
+            // Buffer size and usage details (linear mode)
             UINT64 m_bufferSize = 0;
-            UINT64 m_bufferUsage = 0;
+            AtomicBumpAllocator m_bufferUsage;
 
             // Open memory reservations
-            UINT64 m_openMemoryReservations = 0;
+            std::atomic<UINT64> m_openMemoryReservations = 0;
+
+            // Ring mode: regions per execution and the allocators of executions in flight
+            struct Submission
+            {
+                std::vector<ComPointer<ID3D12CommandAllocator>> allocators;
+                UINT64 fenceValue;
+            };
+            std::mutex m_ringMutex;
+            RingAllocator m_ring;
+            std::deque<Submission> m_submissions;
+            std::vector<ComPointer<ID3D12CommandAllocator>> m_freeAllocators;
     };
 }
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+struct ID3D12Resource;
+
+namespace RTR
+{
+    // Target of streamed copies (implemented by ModelStreamUploader, replaceable by fakes that never touch the gpu)
+    class IModelStreamUploader
+    {
+        public:
+            virtual ~IModelStreamUploader() = default;
+
+            // Bytes that can be uploaded right now
+            virtual uint64_t GetFreeMemory() = 0;
+            // Record a copy of size bytes from ptrData to target at targetOffset (size never exceeds GetFreeMemory())
+            virtual bool UploadBufferData(const void* ptrData, uint64_t size, ID3D12Resource* ptrTarget, uint64_t targetOffset) = 0;
+            // Batch the copies recorded now are executed with (increasing, 1 based)
+            virtual uint64_t GetRecordingBatch() = 0;
+            // Count of finished batches, the copies of batch N are complete once this is at least N
+            virtual uint64_t GetFinishedBatchCount() = 0;
+    };
+}
@@ -0,0 +1,52 @@
+#include "IndirectDrawBuilder.h"
+
+#include <Util/StreamCopy.h>
+
+#include <cstring>
+
+RTR::IndirectDrawBuilder::IndirectDrawBuilder(uint32_t rootConstantCount) :
+    m_rootConstantCount(rootConstantCount),
+    m_commandValues(rootConstantCount + sizeof(IndirectDrawArguments) / sizeof(uint32_t))
+{}
+
+void RTR::IndirectDrawBuilder::Clear()
+{
+    m_commands.clear();
+}
+
+uint32_t RTR::IndirectDrawBuilder::Add(const IndirectDrawArguments& draw, const uint32_t* ptrRootConstants)
+{
+    const uint32_t index = (uint32_t)GetDrawCount();
+
+    // Root constants followed by the arguments
+    const size_t base = m_commands.size();
+    m_commands.resize(base + m_commandValues);
+    if (m_rootConstantCount)
+        memcpy(&m_commands[base], ptrRootConstants, m_rootConstantCount * sizeof(uint32_t));
+    memcpy(&m_commands[base + m_rootConstantCount], &draw, sizeof(IndirectDrawArguments));
+
+    return index;
+}
+
+size_t RTR::IndirectDrawBuilder::Build(const uint32_t* visible, size_t visibleCount, void* ptrOut) const
+{
+    // Sequential writes only (the output is usually write combined upload memory)
+    const size_t stride = GetStride();
+    unsigned char* ptrTarget = (unsigned char*)ptrOut;
+    const uint32_t* ptrCommands = m_commands.data();
+    for (size_t i = 0; i < visibleCount; i++)
+    {
+        memcpy(ptrTarget, ptrCommands + (size_t)visible[i] * m_commandValues, stride);
+        ptrTarget += stride;
+    }
+
+    return visibleCount * stride;
+}
+
+size_t RTR::IndirectDrawBuilder::BuildAll(void* ptrOut) const
+{
+    // One streaming copy of the pre packed commands
+    const size_t size = m_commands.size() * sizeof(uint32_t);
+    StreamCopy(ptrOut, m_commands.data(), size);
+    return size;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RTR
+{
+    // Indexed draw of one command (D3D12_DRAW_INDEXED_ARGUMENTS layout)
+    struct IndirectDrawArguments
+    {
+        uint32_t indexCountPerInstance;
+        uint32_t instanceCount;
+        uint32_t startIndexLocation;
+        int32_t baseVertexLocation;
+        uint32_t startInstanceLocation;
+    };
+    static_assert(sizeof(IndirectDrawArguments) == 20, "IndirectDrawArguments must match D3D12_DRAW_INDEXED_ARGUMENTS");
+
+    // Builds ExecuteIndirect argument buffers from visibility results. Every drawable is stored pre packed as one command
+    // (rootConstantCount 32 bit root constants followed by its IndirectDrawArguments, the D3DCommandSignature layout), so
+    // building is a gather of the visible commands. The records are plain 32 bit values: a compute pass can fill the same buffer
+    // from the same table and a visibility list on the gpu.
+    class IndirectDrawBuilder
+    {
+        public:
+            // Construct for commands with rootConstantCount root constants
+            IndirectDrawBuilder(uint32_t rootConstantCount = 0);
+
+            // Drop all drawables (keeps the memory)
+            void Clear();
+            // Register a drawable (ptrRootConstants holds rootConstantCount values), returns its index for the visibility list
+            uint32_t Add(const IndirectDrawArguments& draw, const uint32_t* ptrRootConstants = nullptr);
+
+            // Write one command per visible drawable (indices into the registered drawables) to ptrOut, which needs room for
+            // visibleCount * GetStride() bytes. Returns the bytes written.
+            size_t Build(const uint32_t* visible, size_t visibleCount, void* ptrOut) const;
+            // Write the commands of all drawables
+            size_t BuildAll(void* ptrOut) const;
+
+            // Bytes per command (ByteStride of the command signature)
+            inline uint32_t GetStride() const noexcept
+            {
+                return m_commandValues * sizeof(uint32_t);
+            }
+            // Count of registered drawables
+            inline size_t GetDrawCount() const noexcept
+            {
+                return m_commands.size() / m_commandValues;
+            }
+            // Packed commands of all drawables (GetDrawCount() * GetStride() bytes, e.g. to upload the table for a compute pass)
+            inline const uint32_t* GetCommands() const noexcept
+            {
+                return m_commands.data();
+            }
+
+        private:
+            // Layout
+            uint32_t m_rootConstantCount;
+            uint32_t m_commandValues;
+
+            // Commands of all drawables
+            std::vector<uint32_t> m_commands;
+    };
+}
@@ -0,0 +1,67 @@
+#include "InstanceBatcher.h"
+
+#include <cstring>
+
+void RTR::InstanceBatcher::Clear()
+{
+    m_batchLookup.clear();
+    m_batches.clear();
+    m_instanceBatch.clear();
+    m_instanceMatrix.clear();
+    m_instanceMaterial.clear();
+}
+
+void RTR::InstanceBatcher::Add(uint64_t meshKey, uint32_t matrixOffset, uint32_t materialIndex)
+{
+    // Repeated meshes usually come in runs, so check the last batch before the lookup
+    uint32_t batch;
+    if (!m_batches.empty() && m_batches.back().meshKey == meshKey)
+    {
+        batch = (uint32_t)m_batches.size() - 1;
+    }
+    else
+    {
+        auto it = m_batchLookup.find(meshKey);
+        if (it == m_batchLookup.end())
+        {
+            batch = (uint32_t)m_batches.size();
+            m_batchLookup.emplace(meshKey, batch);
+            m_batches.push_back({ meshKey, 0, 0 });
+        }
+        else
+        {
+            batch = it->second;
+        }
+    }
+
+    m_batches[batch].instanceCount++;
+    m_instanceBatch.push_back(batch);
+    m_instanceMatrix.push_back(matrixOffset);
+    m_instanceMaterial.push_back(materialIndex);
+}
+
+void RTR::InstanceBatcher::Build(const float* ptrMatrices, size_t matrixFloats, InstanceData* ptrOut, uint32_t* ptrSourcesOut)
+{
+    // Batch ranges (prefix sum of the counts)
+    uint32_t first = 0;
+    m_cursors.resize(m_batches.size());
+    for (size_t b = 0; b < m_batches.size(); b++)
+    {
+        m_batches[b].firstInstance = first;
+        m_cursors[b] = first;
+        first += m_batches[b].instanceCount;
+    }
+
+    // Scatter every instance to its batch (the first 12 floats are the same for 3x4 and 4x4 storage)
+    for (size_t i = 0; i < m_instanceBatch.size(); i++)
+    {
+        const uint32_t slot = m_cursors[m_instanceBatch[i]]++;
+        if (ptrSourcesOut)
+            ptrSourcesOut[slot] = (uint32_t)i;
+
+        InstanceData& instance = ptrOut[slot];
+        memcpy(instance.world, ptrMatrices + (size_t)m_instanceMatrix[i] * matrixFloats, sizeof(instance.world));
+        instance.materialIndex = m_instanceMaterial[i];
+        instance.padding[0] = instance.padding[1] = instance.padding[2] = 0;
+    }
+}
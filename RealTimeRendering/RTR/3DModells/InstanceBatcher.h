@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace RTR
+{
+    // Per instance data as read by the instanced shaders (Instance in Instanced.hlsli, 64 bytes)
+    struct InstanceData
+    {
+        // Transposed world matrix without the constant last row (MatrixStorage::Float3x4 layout)
+        float world[12];
+        uint32_t materialIndex;
+        uint32_t padding[3];
+    };
+    static_assert(sizeof(InstanceData) == 64, "InstanceData must match the hlsl layout");
+
+    // Instances of one mesh that are drawn with one instanced draw call
+    struct InstanceBatch
+    {
+        // Mesh identifier given to InstanceBatcher::Add (e.g. a ModelStreamHandle)
+        uint64_t meshKey;
+        // Range in the packed instance stream
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    // Collects instances of many meshes and packs them grouped by mesh, so repeated meshes collapse into one draw.
+    // Bookkeeping and packing only, the stream memory is given by the caller (e.g. a D3DConstantRing allocation).
+    class InstanceBatcher
+    {
+        public:
+            // Drop all instances (keeps the memory)
+            void Clear();
+            // Queue an instance of meshKey with the world matrix at matrixOffset of a MatrixBuffer
+            void Add(uint64_t meshKey, uint32_t matrixOffset, uint32_t materialIndex);
+
+            // Pack all instances to ptrOut (GetInstanceCount() elements). Batches keep the order meshes were first added in,
+            // instances keep their order inside a batch. ptrMatrices is the cpu matrix data with matrixFloats (12 or 16) per matrix.
+            // ptrSourcesOut optionally receives the index (order of Add) of every packed instance.
+            void Build(const float* ptrMatrices, size_t matrixFloats, InstanceData* ptrOut, uint32_t* ptrSourcesOut = nullptr);
+
+            // Batches (ranges valid after Build)
+            inline const std::vector<InstanceBatch>& GetBatches() const
+            {
+                return m_batches;
+            }
+            // Count of queued instances
+            inline size_t GetInstanceCount() const
+            {
+                return m_instanceBatch.size();
+            }
+
+        private:
+            // Batch index of every mesh
+            std::unordered_map<uint64_t, uint32_t> m_batchLookup;
+            std::vector<InstanceBatch> m_batches;
+
+            // Queued instances
+            std::vector<uint32_t> m_instanceBatch;
+            std::vector<uint32_t> m_instanceMatrix;
+            std::vector<uint32_t> m_instanceMaterial;
+
+            // Write cursor per batch
+            std::vector<uint32_t> m_cursors;
+    };
+}
@@ -1,15 +1,21 @@
 #include "MatrixBuffer.h"
 
-RTR::MatrixBuffer::MatrixBuffer(UINT count)
+#include <algorithm>
+#include <cstring>
+
+RTR::MatrixBuffer::MatrixBuffer(UINT count, MatrixStorage storage) :
+    m_storage(storage),
+    m_matrixFloats(storage == MatrixStorage::Float3x4 ? 12 : 16),
+    m_handles(count)
 {
     // Allocate cpu sided buffer
-    m_matricies = (DirectX::XMMATRIX*)_aligned_malloc(count * sizeof(DirectX::XMMATRIX), 16);
+    m_matricies = (float*)_aligned_malloc(count * GetMatrixSize(), 16);
 
     // Describe d3d12 resource
     D3D12_RESOURCE_DESC desc;
     desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
     desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-    desc.Width = sizeof(DirectX::XMMATRIX) * count;
+    desc.Width = (UINT64)GetMatrixSize() * count;
     desc.Height = 1;
     desc.DepthOrArraySize = 1;
     desc.MipLevels = 1;
@@ -27,29 +33,167 @@ RTR::MatrixBuffer::MatrixBuffer(UINT count)
 
     // Set count
     m_count = count;
+    m_dirtyBits.resize((count + 63) / 64);
 }
 
 RTR::Matrix RTR::MatrixBuffer::GetMatrix()
 {
-    // Invalid matrix
+    // Invalid matrix when the buffer is full (reuses freed offsets, lowest first)
     Matrix m;
     m.offset = -1;
+    m.handle = m_handles.Allocate(&m.offset);
+    return m;
+}
+
+bool RTR::MatrixBuffer::FreeMatrix(Matrix& mat)
+{
+    // Invalidates all copies of the handle
+    if (!m_handles.Free(mat.handle))
+        return false;
+
+    mat.handle = 0;
+    mat.offset = -1;
+    return true;
+}
 
-    // Check if possible
-    if (m_usage < m_count)
+bool RTR::MatrixBuffer::UpdateCPU(Matrix& mat)
+{
+    const UINT offset = m_handles.GetOffset(mat.handle);
+    if (offset == m_handles.InvalidOffset)
+        return false;
+
+    mat.offset = offset;
+
+    // Transposed for the gpu (3x4 storage drops the constant last row)
+    DirectX::XMFLOAT4X4 transposed;
+    DirectX::XMStoreFloat4x4(&transposed, DirectX::XMMatrixTranspose(mat.M));
+    memcpy(&m_matricies[(size_t)mat.offset * m_matrixFloats], &transposed, GetMatrixSize());
+    MarkDirty(mat.offset);
+    return true;
+}
+
+void RTR::MatrixBuffer::UpdateCPU(const TransformBatch& batch, const UINT* offsets, size_t count, WorkerPool* ptrWorkers)
+{
+    static_assert(sizeof(UINT) == sizeof(uint32_t), "Offsets are passed as uint32_t");
+
+    // Compose on the workers (every transform writes its own matrix)
+    const size_t chunks = (count + BatchChunkSize - 1) / BatchChunkSize;
+    if (ptrWorkers && chunks > 1)
+    {
+        ptrWorkers->ParallelFor(chunks, [&](size_t chunk)
+            {
+                const size_t begin = chunk * BatchChunkSize;
+                TransformBatchCompose(batch, begin, std::min(begin + BatchChunkSize, count), (const uint32_t*)offsets, m_matricies, m_matrixFloats);
+            }
+        );
+    }
+    else
     {
-        m.offset = m_usage++;
+        TransformBatchCompose(batch, 0, count, (const uint32_t*)offsets, m_matricies, m_matrixFloats);
     }
 
-    return m;
+    for (size_t i = 0; i < count; i++)
+        MarkDirty(offsets[i]);
 }
 
-void RTR::MatrixBuffer::UpdateCPU(Matrix& mat)
+void RTR::MatrixBuffer::ConcatenateCPU(DirectX::FXMMATRIX viewProjection, const UINT* offsets, size_t count, DirectX::XMFLOAT4X4* ptrOut, WorkerPool* ptrWorkers) const
 {
-    m_matricies[mat.offset] = DirectX::XMMatrixTranspose(mat.M);
+    DirectX::XMFLOAT4X4 vp;
+    DirectX::XMStoreFloat4x4(&vp, viewProjection);
+
+    // Every object writes its own output matrix
+    const size_t chunks = (count + BatchChunkSize - 1) / BatchChunkSize;
+    if (ptrWorkers && chunks > 1)
+    {
+        ptrWorkers->ParallelFor(chunks, [&](size_t chunk)
+            {
+                const size_t begin = chunk * BatchChunkSize;
+                TransformBatchConcatenate(m_matricies, m_matrixFloats, (const uint32_t*)offsets, begin, std::min(begin + BatchChunkSize, count), &vp._11, &ptrOut->_11);
+            }
+        );
+    }
+    else
+    {
+        TransformBatchConcatenate(m_matricies, m_matrixFloats, (const uint32_t*)offsets, 0, count, &vp._11, &ptrOut->_11);
+    }
 }
 
 bool RTR::MatrixBuffer::UpdateGPU(D3DUploadBuffer& uploader)
 {
-    return uploader.CopyBufferData(m_matricies, sizeof(DirectX::XMMATRIX) * m_count, Get());
+    m_uploadStats = MatrixUploadStats();
+
+    // Nothing above the used range is read
+    m_dirtyEnd = std::min(m_dirtyEnd, m_handles.GetUsage());
+
+    UINT idx = m_dirtyBegin;
+    while (idx < m_dirtyEnd)
+    {
+        // Next merged range (empty when the rest is clean)
+        const DirtyRange range = FindDirtyRange(m_dirtyBits.data(), idx, m_dirtyEnd, MergeGap);
+        if (range.begin == range.end)
+            break;
+
+        // Upload the range (the rest stays dirty when the upload buffer is full)
+        const UINT64 size = (UINT64)GetMatrixSize() * (range.end - range.begin);
+        if (!uploader.CopyBufferData(&m_matricies[(size_t)range.begin * m_matrixFloats], size, Get(), (UINT64)GetMatrixSize() * range.begin))
+        {
+            m_dirtyBegin = range.begin;
+            return false;
+        }
+        m_uploadStats.dirtyMatrices += ClearDirtyRange(m_dirtyBits.data(), range);
+        m_uploadStats.bytesUploaded += size;
+        m_uploadStats.copyCount++;
+
+        idx = range.end;
+    }
+
+    m_dirtyBegin = m_dirtyEnd = 0;
+    return true;
+}
+
+UINT RTR::MatrixBuffer::Compact()
+{
+    // Slide live matrices down over the freed offsets
+    const UINT usage = m_handles.GetUsage();
+    const UINT moved = m_handles.Compact([this](UINT from, UINT to)
+        {
+            memcpy(&m_matricies[(size_t)to * m_matrixFloats], &m_matricies[(size_t)from * m_matrixFloats], GetMatrixSize());
+            MarkDirty(to);
+        }
+    );
+
+    // Everything above is free (and never uploaded)
+    ClearDirtyRange(m_dirtyBits.data(), { m_handles.GetUsage(), usage });
+    return moved;
+}
+
+bool RTR::MatrixBuffer::IsValid(MatrixHandle handle) const
+{
+    return m_handles.IsValid(handle);
+}
+
+UINT RTR::MatrixBuffer::GetOffset(MatrixHandle handle) const
+{
+    return m_handles.GetOffset(handle);
+}
+
+void RTR::MatrixBuffer::MarkAllDirty()
+{
+    for (UINT i = 0; i < m_count; i++)
+        MarkDirty(i);
+}
+
+void RTR::MatrixBuffer::MarkDirty(UINT idx)
+{
+    m_dirtyBits[idx / 64] |= 1ULL << (idx % 64);
+    if (m_dirtyBegin == m_dirtyEnd)
+    {
+        m_dirtyBegin = idx;
+        m_dirtyEnd = idx + 1;
+    }
+    else
+    {
+        m_dirtyBegin = std::min(m_dirtyBegin, idx);
+        m_dirtyEnd = std::max(m_dirtyEnd, idx + 1);
+    }
 }
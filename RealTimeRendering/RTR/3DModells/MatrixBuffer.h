@@ -1,21 +1,48 @@
 #pragma once
 
 #include <Util/ComPointer.h>
+#include <Util/DirtyRanges.h>
 #include <D3DMemory/D3DResource.h>
 #include <D3DMemory/D3DUploadBuffer.h>
+#include <RTR/3DModells/SlotHandleTable.h>
+#include <RTR/3DModells/TransformBatch.h>
+#include <Util/WorkerPool.h>
 
 #include <DirectXMath.h>
+#include <vector>
 
 namespace RTR
 {
+    // Slot and generation of a matrix (0 is invalid, stale after FreeMatrix, see SlotHandleTable)
+    typedef UINT64 MatrixHandle;
+
     // View of a model part (vertices / indices / ...)
     struct Matrix
     {
         // User modifiable matrix copy (will be translated on UpdateCPU call)
         DirectX::XMMATRIX M;
 
-        // Local offset
+        // Local offset (refreshed by UpdateCPU, changes on Compact)
         UINT offset = 0;
+        MatrixHandle handle = 0;
+    };
+
+    // Gpu layout of the matrices in a MatrixBuffer
+    enum class MatrixStorage : UINT
+    {
+        // Transposed 4x4 (64 bytes, float4x4 in hlsl)
+        Float4x4 = 0,
+        // Transposed 4x4 without the constant last row (48 bytes, three float4 rows in hlsl)
+        Float3x4,
+    };
+
+    // Result of the last MatrixBuffer::UpdateGPU call
+    struct MatrixUploadStats
+    {
+        UINT64 bytesUploaded = 0;
+        // Changed matrices and the merged copies that uploaded them
+        UINT dirtyMatrices = 0;
+        UINT copyCount = 0;
     };
 
     // Big stack that can hold model data (vertices and indices)
@@ -25,24 +52,98 @@ namespace RTR
             // Construct
             MatrixBuffer() = delete;
             MatrixBuffer(const MatrixBuffer&) = delete;
-            MatrixBuffer(UINT count);
+            MatrixBuffer(UINT count, MatrixStorage storage = MatrixStorage::Float4x4);
 
             // Copy
             MatrixBuffer& operator=(const MatrixBuffer&) = delete;
 
-            // Allocate a fresh new matrix
+            // Allocate a fresh new matrix (reuses freed offsets, lowest first)
             Matrix GetMatrix();
-            // Updates a change cpu matrix
-            void UpdateCPU(Matrix& mat);
-            // Update all matrix data to the gpu
+            // Release a matrix (its handle becomes stale)
+            bool FreeMatrix(Matrix& mat);
+            // Updates a change cpu matrix (false for stale handles)
+            bool UpdateCPU(Matrix& mat);
+            // Build count world matrices from SoA transforms straight into the gpu copy (transform i goes to offsets[i], see GetOffset).
+            // Large batches are split across ptrWorkers when given.
+            void UpdateCPU(const TransformBatch& batch, const UINT* offsets, size_t count, WorkerPool* ptrWorkers = nullptr);
+            // Concatenate the matrices at offsets with viewProjection: ptrOut[i] = transpose(matrix * viewProjection) as a 4x4 for
+            // constant buffers and root constants (once per object instead of per vertex). Large batches are split across ptrWorkers.
+            void ConcatenateCPU(DirectX::FXMMATRIX viewProjection, const UINT* offsets, size_t count, DirectX::XMFLOAT4X4* ptrOut, WorkerPool* ptrWorkers = nullptr) const;
+            // Upload the matrices changed since the last call as merged ranges (ranges that did not fit stay dirty).
+            // Only needed when shaders read this buffer: the demo passes its matrices through D3DConstantRing and never calls it.
             bool UpdateGPU(D3DUploadBuffer& uploader);
+            // Upload everything on the next UpdateGPU
+            void MarkAllDirty();
+
+            // Move live matrices down into freed offsets (keeps their order). Offsets of moved matrices change,
+            // matrices that were never freed around stay where they are. Returns the count of moved matrices.
+            // Callers that keep offsets have to refresh them with GetOffset. Library only: the demo allocates its
+            // matrices once and never frees one, so it has nothing to compact.
+            UINT Compact();
+
+            // Handle access
+            bool IsValid(MatrixHandle handle) const;
+            // Current offset of a matrix (-1 for stale handles)
+            UINT GetOffset(MatrixHandle handle) const;
+
+            // Gpu layout and bytes per matrix
+            inline MatrixStorage GetStorage() const
+            {
+                return m_storage;
+            }
+            inline UINT GetMatrixSize() const
+            {
+                return m_matrixFloats * sizeof(float);
+            }
+
+            // Cpu copy of the matrix at offset in gpu layout (GetMatrixSize() bytes)
+            inline const float* GetCPUMatrix(UINT offset) const
+            {
+                return &m_matricies[(size_t)offset * m_matrixFloats];
+            }
+
+            // Offsets in use (end of the used range) and live matrices
+            inline UINT GetUsage() const
+            {
+                return m_handles.GetUsage();
+            }
+            inline UINT GetLiveCount() const
+            {
+                return m_handles.GetLiveCount();
+            }
+
+            // Statistics of the last UpdateGPU
+            inline const MatrixUploadStats& GetUploadStats() const
+            {
+                return m_uploadStats;
+            }
 
         private:
-            // List of gpu read matrices
-            DirectX::XMMATRIX* m_matricies = nullptr;
+            // Transforms per work item of a batch update
+            static constexpr size_t BatchChunkSize = 2048;
+
+            // Dirty ranges closer than this many clean matrices are uploaded as one copy (see FindDirtyRange)
+            static constexpr UINT MergeGap = 4;
+
+            // Dirty flags
+            void MarkDirty(UINT idx);
 
-            // Total count and current usage of the buffer
+        private:
+            // List of gpu read matrices (m_matrixFloats floats each)
+            float* m_matricies = nullptr;
+            MatrixStorage m_storage = MatrixStorage::Float4x4;
+            UINT m_matrixFloats = 16;
+
+            // Total count of the buffer
             UINT m_count = 0;
-            UINT m_usage = 0;
+
+            // Handles and offsets in use
+            SlotHandleTable<> m_handles;
+
+            // One bit per matrix and the range that contains all set bits
+            std::vector<uint64_t> m_dirtyBits;
+            UINT m_dirtyBegin = 0;
+            UINT m_dirtyEnd = 0;
+            MatrixUploadStats m_uploadStats;
     };
 }
@@ -0,0 +1,220 @@
+#include "MeshCache.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+
+bool RTR::MeshCacheFile::Open(const char* filePath, const MeshCacheKey& expectedKey)
+{
+    Close();
+
+    // Map file and check minimal size
+    if (!m_file.Open(filePath) || m_file.GetSize() < sizeof(MeshCacheHeader))
+        return false;
+
+    // Validate header and key
+    const MeshCacheHeader* ptrHeader = (const MeshCacheHeader*)m_file.GetData();
+    const bool sourceStampMatch = ptrHeader->key.sourceSize == expectedKey.sourceSize && ptrHeader->key.sourceWriteTime == expectedKey.sourceWriteTime;
+    const bool sourceHashMatch = expectedKey.sourceHash && ptrHeader->key.sourceHash == expectedKey.sourceHash;
+    if (
+        ptrHeader->magic != Magic || ptrHeader->version != Version ||
+        (!sourceStampMatch && !sourceHashMatch) ||
+        ptrHeader->key.vertexLayout != expectedKey.vertexLayout ||
+        ptrHeader->key.importOptions != expectedKey.importOptions ||
+        ptrHeader->key.importFlags != expectedKey.importFlags ||
+        ptrHeader->key.vertexSize != expectedKey.vertexSize
+        )
+    {
+        m_file.Close();
+        return false;
+    }
+
+    // Validate table and blob bounds (a truncated file must never be read past its end)
+    const uint64_t fileSize = m_file.GetSize();
+    const uint64_t tableEnd = sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * (uint64_t)ptrHeader->meshCount;
+    bool valid = tableEnd <= fileSize;
+    const MeshCacheEntry* ptrEntries = (const MeshCacheEntry*)(m_file.GetData() + sizeof(MeshCacheHeader));
+    for (uint32_t i = 0; valid && i < ptrHeader->meshCount; i++)
+    {
+        const MeshCacheEntry& e = ptrEntries[i];
+        valid = e.nameOffset <= fileSize && e.nameLength <= fileSize - e.nameOffset;
+        for (uint32_t b = 0; valid && b < (uint32_t)MeshCacheBlob::Count; b++)
+        {
+            valid = e.blobOffset[b] <= fileSize && e.blobBytes[b] <= fileSize - e.blobOffset[b];
+        }
+
+        // Sizes must match the counts
+        valid = valid &&
+            e.blobBytes[(uint32_t)MeshCacheBlob::Vertices] == (uint64_t)e.vertexCount * ptrHeader->key.vertexSize &&
+            (e.indexSize == 2 || e.indexSize == 4) &&
+            e.blobBytes[(uint32_t)MeshCacheBlob::Indices] == (uint64_t)e.indexCount * e.indexSize &&
+            e.blobBytes[(uint32_t)MeshCacheBlob::Meshlets] == (uint64_t)e.meshletCount * sizeof(Meshlet) &&
+            e.blobBytes[(uint32_t)MeshCacheBlob::MeshletBounds] == (uint64_t)e.meshletCount * sizeof(MeshletBounds) &&
+            e.blobBytes[(uint32_t)MeshCacheBlob::Lods] % sizeof(MeshLodRange) == 0;
+
+        // Lod ranges must stay inside the lod indices
+        const MeshLodRange* ptrLods = (const MeshLodRange*)(m_file.GetData() + e.blobOffset[(uint32_t)MeshCacheBlob::Lods]);
+        for (uint64_t l = 0; valid && l < e.blobBytes[(uint32_t)MeshCacheBlob::Lods] / sizeof(MeshLodRange); l++)
+        {
+            valid = ((uint64_t)ptrLods[l].indexOffset + ptrLods[l].indexCount) * e.indexSize <= e.blobBytes[(uint32_t)MeshCacheBlob::LodIndices];
+        }
+    }
+
+    if (!valid)
+    {
+        m_file.Close();
+        return false;
+    }
+
+    // File is good
+    m_ptrHeader = ptrHeader;
+    m_ptrEntries = ptrEntries;
+    return true;
+}
+
+void RTR::MeshCacheFile::Close()
+{
+    m_ptrHeader = nullptr;
+    m_ptrEntries = nullptr;
+    m_file.Close();
+}
+
+bool RTR::MeshCacheFile::StampSourceFile(const char* filePath, MeshCacheKey* ptrKeyOut)
+{
+    std::error_code error;
+    const uint64_t size = std::filesystem::file_size(filePath, error);
+    if (error)
+        return false;
+    const auto writeTime = std::filesystem::last_write_time(filePath, error);
+    if (error)
+        return false;
+
+    ptrKeyOut->sourceSize = size;
+    ptrKeyOut->sourceWriteTime = (int64_t)writeTime.time_since_epoch().count();
+    return true;
+}
+
+bool RTR::MeshCacheFile::HashSourceFile(const char* filePath, uint64_t* ptrHashOut)
+{
+    MappedFile file;
+    if (file.Open(filePath))
+    {
+        // 0 means "not hashed" in a key
+        *ptrHashOut = std::max<uint64_t>(HashFnv1aWide(file.GetData(), (size_t)file.GetSize()), 1);
+        return true;
+    }
+
+    return false;
+}
+
+bool RTR::MeshCacheFile::RestampFile(const char* filePath, const MeshCacheKey& key)
+{
+    FILE* ptrFile = fopen(filePath, "r+b");
+    if (!ptrFile)
+        return false;
+
+    bool success = fseek(ptrFile, (long)offsetof(MeshCacheHeader, key), SEEK_SET) == 0 && fwrite(&key, sizeof(key), 1, ptrFile) == 1;
+    success = fclose(ptrFile) == 0 && success;
+    return success;
+}
+
+void RTR::MeshCacheWriter::AddMesh(const MeshCacheMeshDesc& desc)
+{
+    m_meshes.push_back(desc);
+}
+
+bool RTR::MeshCacheWriter::Write(const char* filePath, const MeshCacheKey& key)
+{
+    // Blobs are 16 byte aligned in the file
+    auto alignUp = [](uint64_t value) { return (value + 15) & ~15ULL; };
+
+    // Build header and table
+    MeshCacheHeader header = {};
+    header.magic = MeshCacheFile::Magic;
+    header.version = MeshCacheFile::Version;
+    header.key = key;
+    header.meshCount = (uint32_t)m_meshes.size();
+
+    std::vector<MeshCacheEntry> entries(m_meshes.size());
+    uint64_t offset = sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * entries.size();
+    for (size_t i = 0; i < m_meshes.size(); i++)
+    {
+        const MeshCacheMeshDesc& mesh = m_meshes[i];
+        MeshCacheEntry& e = entries[i];
+        e = {};
+
+        e.nameOffset = offset;
+        e.nameLength = (uint32_t)mesh.name.size();
+        offset = alignUp(offset + e.nameLength);
+
+        for (uint32_t b = 0; b < (uint32_t)MeshCacheBlob::Count; b++)
+        {
+            e.blobOffset[b] = offset;
+            e.blobBytes[b] = mesh.blobBytes[b];
+            offset = alignUp(offset + e.blobBytes[b]);
+        }
+
+        e.vertexCount = mesh.vertexCount;
+        e.indexCount = mesh.indexCount;
+        e.meshletCount = mesh.meshletCount;
+        e.indexSize = mesh.indexSize;
+        e.contentHash = mesh.contentHash;
+        e.contentCheck = mesh.contentCheck;
+        e.cacheStatsBefore = mesh.cacheStatsBefore;
+        e.cacheStatsAfter = mesh.cacheStatsAfter;
+        e.dequantization = mesh.dequantization;
+        e.bounds = mesh.bounds;
+    }
+
+    // Write to a temporary file first so a crash never leaves a half written cache behind
+    std::string tempPath = std::string(filePath) + ".tmp";
+    FILE* ptrFile = fopen(tempPath.c_str(), "wb");
+    if (!ptrFile)
+        return false;
+
+    uint64_t written = 0;
+    bool success = true;
+    auto writeBlock = [&](const void* data, uint64_t size)
+    {
+        success = success && fwrite(data, 1, (size_t)size, ptrFile) == size;
+        written += size;
+    };
+    auto padTo = [&](uint64_t target)
+    {
+        static const unsigned char zeros[16] = {};
+        if (target > written)
+            writeBlock(zeros, target - written);
+    };
+
+    writeBlock(&header, sizeof(header));
+    writeBlock(entries.data(), sizeof(MeshCacheEntry) * entries.size());
+    for (size_t i = 0; i < m_meshes.size(); i++)
+    {
+        padTo(entries[i].nameOffset);
+        writeBlock(m_meshes[i].name.data(), entries[i].nameLength);
+        for (uint32_t b = 0; b < (uint32_t)MeshCacheBlob::Count; b++)
+        {
+            padTo(entries[i].blobOffset[b]);
+            writeBlock(m_meshes[i].blobData[b], entries[i].blobBytes[b]);
+        }
+    }
+    padTo(offset);
+
+    success = fclose(ptrFile) == 0 && success;
+
+    // Replace old cache
+    if (success)
+    {
+        #ifdef _WIN32
+        success = MoveFileExA(tempPath.c_str(), filePath, MOVEFILE_REPLACE_EXISTING);
+        #else
+        success = rename(tempPath.c_str(), filePath) == 0;
+        #endif
+    }
+    if (!success)
+    {
+        remove(tempPath.c_str());
+    }
+
+    return success;
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <Util/Hash.h>
+#include <Util/MappedFile.h>
+#include <RTR/3DModells/MeshOptimizer.h>
+#include <RTR/3DModells/MeshletBuilder.h>
+#include <RTR/3DModells/VertexQuantization.h>
+#include <RTR/Culling/Bounds.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Extension appended to the source path of a baked mesh file
+#define RTR_MESH_CACHE_EXTENSION ".rtrmesh"
+
+namespace RTR
+{
+    // Everything a baked file depends on (a mismatch in any field invalidates the file)
+    struct MeshCacheKey
+    {
+        // Size and last write time of the source file (a match skips hashing the source)
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        // Hash of the source file content (0 when not computed)
+        uint64_t sourceHash = 0;
+        // User identifier of the vertex layout (the callback itself can not be hashed)
+        uint64_t vertexLayout = 0;
+        // Hash of the ModelImportOptions
+        uint64_t importOptions = 0;
+        // Assimp post process flags
+        uint32_t importFlags = 0;
+        // Size of one vertex
+        uint32_t vertexSize = 0;
+    };
+
+    // Data blobs stored per mesh
+    enum class MeshCacheBlob : uint32_t
+    {
+        Vertices = 0,
+        Indices,
+        Meshlets,
+        MeshletBounds,
+        MeshletVertices,
+        MeshletPrimitives,
+        LodIndices,
+        // Table of MeshLodRange (CPU only)
+        Lods,
+
+        // Count of blob types
+        Count,
+    };
+
+    // Blobs that are uploaded to the gpu
+    inline bool MeshCacheBlobOnGpu(MeshCacheBlob blob)
+    {
+        return blob != MeshCacheBlob::Lods;
+    }
+
+    // Level of detail inside the LodIndices blob
+    struct MeshLodRange
+    {
+        uint32_t indexOffset;
+        uint32_t indexCount;
+        // Geometric error in model units
+        float error;
+        uint32_t reserved;
+    };
+
+    // File header
+    struct MeshCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        MeshCacheKey key;
+        uint32_t meshCount;
+        uint32_t reserved;
+    };
+
+    // Per mesh table entry (offsets are relative to the file start)
+    struct MeshCacheEntry
+    {
+        uint64_t nameOffset;
+        uint32_t nameLength;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t meshletCount;
+        // Size of one index (2 or 4)
+        uint32_t indexSize;
+        uint64_t blobOffset[(uint32_t)MeshCacheBlob::Count];
+        uint64_t blobBytes[(uint32_t)MeshCacheBlob::Count];
+        // Hash of all blobs (identifies identical meshes across files) and an independent check hash
+        uint64_t contentHash;
+        uint64_t contentCheck;
+        VertexCacheStats cacheStatsBefore;
+        VertexCacheStats cacheStatsAfter;
+        VertexDequantization dequantization;
+        MeshBounds bounds;
+    };
+
+    // Description of a mesh to be written
+    struct MeshCacheMeshDesc
+    {
+        std::string name;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        uint32_t meshletCount = 0;
+        uint32_t indexSize = sizeof(unsigned int);
+        const void* blobData[(uint32_t)MeshCacheBlob::Count] = {};
+        uint64_t blobBytes[(uint32_t)MeshCacheBlob::Count] = {};
+        uint64_t contentHash = 0;
+        uint64_t contentCheck = 0;
+        VertexCacheStats cacheStatsBefore;
+        VertexCacheStats cacheStatsAfter;
+        VertexDequantization dequantization;
+        MeshBounds bounds;
+    };
+
+    // Memory mapped baked mesh file
+    class MeshCacheFile
+    {
+        public:
+            // File identification
+            static constexpr uint32_t Magic = 0x48534D52; // "RMSH"
+            static constexpr uint32_t Version = 7;
+
+        public:
+            // Construct
+            MeshCacheFile() = default;
+            MeshCacheFile(const MeshCacheFile&) = delete;
+
+            // Assign
+            MeshCacheFile& operator=(const MeshCacheFile&) = delete;
+
+            // Open and validate a file against the expected key (the source matches by size and write time or by a non zero hash)
+            bool Open(const char* filePath, const MeshCacheKey& expectedKey);
+            // Unmap the file
+            void Close();
+
+            // Mesh access
+            inline uint32_t GetMeshCount() const noexcept
+            {
+                return m_ptrHeader ? m_ptrHeader->meshCount : 0;
+            }
+            inline const MeshCacheEntry& GetEntry(uint32_t idx) const noexcept
+            {
+                return m_ptrEntries[idx];
+            }
+            inline const void* GetBlob(uint32_t idx, MeshCacheBlob blob) const noexcept
+            {
+                return m_file.GetData() + m_ptrEntries[idx].blobOffset[(uint32_t)blob];
+            }
+            inline uint64_t GetBlobSize(uint32_t idx, MeshCacheBlob blob) const noexcept
+            {
+                return m_ptrEntries[idx].blobBytes[(uint32_t)blob];
+            }
+            inline std::string GetName(uint32_t idx) const
+            {
+                return std::string((const char*)m_file.GetData() + m_ptrEntries[idx].nameOffset, m_ptrEntries[idx].nameLength);
+            }
+
+            // Size and last write time of a (source) file
+            static bool StampSourceFile(const char* filePath, MeshCacheKey* ptrKeyOut);
+            // Hash the content of a (source) file
+            static bool HashSourceFile(const char* filePath, uint64_t* ptrHashOut);
+            // Replace the key of an existing (closed) file in place
+            static bool RestampFile(const char* filePath, const MeshCacheKey& key);
+
+        private:
+            // Mapping
+            MappedFile m_file;
+
+            // Pointers into the mapping
+            const MeshCacheHeader* m_ptrHeader = nullptr;
+            const MeshCacheEntry* m_ptrEntries = nullptr;
+    };
+
+    // Writes a baked mesh file
+    class MeshCacheWriter
+    {
+        public:
+            // Add a mesh (blob data must stay valid until Write is called)
+            void AddMesh(const MeshCacheMeshDesc& desc);
+
+            // Write all meshes to disk
+            bool Write(const char* filePath, const MeshCacheKey& key);
+
+        private:
+            // Meshes to be written
+            std::vector<MeshCacheMeshDesc> m_meshes;
+    };
+}
@@ -0,0 +1,312 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+RTR::VertexCacheStats RTR::MeshAnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStats stats;
+    if (!indexCount || !vertexCount)
+        return stats;
+
+    // FIFO cache as time stamps (a vertex is cached while it was inserted less than cacheSize misses ago)
+    std::vector<size_t> cacheTime(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    size_t misses = 0, uniqueVertices = 0;
+    size_t timeStamp = cacheSize + 1;
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t v = indices[i];
+        if (timeStamp - cacheTime[v] > cacheSize)
+        {
+            cacheTime[v] = timeStamp++;
+            misses++;
+        }
+        if (!referenced[v])
+        {
+            referenced[v] = true;
+            uniqueVertices++;
+        }
+    }
+
+    stats.acmr = (float)misses / (float)(indexCount / 3);
+    stats.atvr = (float)misses / (float)uniqueVertices;
+    return stats;
+}
+
+void RTR::MeshOptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize, std::vector<uint32_t>* ptrClustersOut)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (!triangleCount || !vertexCount)
+        return;
+
+    // Vertex -> triangle adjacency
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacencyOffset[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffset[v + 1] += adjacencyOffset[v];
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    // Live triangles per vertex
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        liveTriangles[v] = adjacencyOffset[v + 1] - adjacencyOffset[v];
+
+    // Algorithm state
+    std::vector<size_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    size_t timeStamp = cacheSize + 1;
+    size_t cursor = 0;
+    size_t outTriangles = 0;
+
+    // Find the next vertex with live triangles from the dead end stack or the input order
+    auto skipDeadEnd = [&]() -> int64_t
+    {
+        while (!deadEnd.empty())
+        {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v])
+                return v;
+        }
+        while (cursor < vertexCount)
+        {
+            if (liveTriangles[cursor])
+                return (int64_t)cursor;
+            cursor++;
+        }
+        return -1;
+    };
+
+    int64_t fanning = skipDeadEnd();
+    if (ptrClustersOut && fanning >= 0)
+        ptrClustersOut->push_back(0);
+
+    while (fanning >= 0)
+    {
+        // Emit all live triangles of the fanning vertex
+        candidates.clear();
+        for (uint32_t a = adjacencyOffset[fanning]; a < adjacencyOffset[fanning + 1]; a++)
+        {
+            uint32_t t = adjacency[a];
+            if (emitted[t])
+                continue;
+
+            for (unsigned int c = 0; c < 3; c++)
+            {
+                uint32_t v = indices[t * 3 + c];
+                destination[outTriangles * 3 + c] = v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (timeStamp - cacheTime[v] > cacheSize)
+                    cacheTime[v] = timeStamp++;
+            }
+            emitted[t] = true;
+            outTriangles++;
+        }
+
+        // Pick the candidate that stays in cache after fanning (oldest first)
+        int64_t next = -1;
+        size_t bestPriority = 0;
+        bool hasPriority = false;
+        for (uint32_t v : candidates)
+        {
+            if (liveTriangles[v])
+            {
+                size_t priority = 0;
+                if (timeStamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                    priority = timeStamp - cacheTime[v];
+                if (!hasPriority || priority > bestPriority)
+                {
+                    hasPriority = true;
+                    bestPriority = priority;
+                    next = v;
+                }
+            }
+        }
+
+        // Dead end: start a new hard cluster
+        if (next < 0)
+        {
+            next = skipDeadEnd();
+            if (ptrClustersOut && next >= 0)
+                ptrClustersOut->push_back((uint32_t)outTriangles);
+        }
+
+        fanning = next;
+    }
+}
+
+void RTR::MeshOptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount, const std::vector<uint32_t>& clusters, unsigned int cacheSize, float threshold)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (!triangleCount || !vertexCount)
+        return;
+
+    auto position = [&](uint32_t v) { return (const float*)((const unsigned char*)positions + positionStride * v); };
+
+    // Split hard clusters into soft clusters
+    std::vector<uint32_t> softClusters;
+    {
+        std::vector<size_t> cacheTime(vertexCount, 0);
+        size_t timeStamp = cacheSize + 1;
+
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            const size_t begin = clusters[c];
+            const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+            // ACMR of the full cluster
+            size_t clusterMisses = 0;
+            timeStamp += cacheSize + 1;
+            for (size_t i = begin * 3; i < end * 3; i++)
+            {
+                if (timeStamp - cacheTime[indices[i]] > cacheSize)
+                {
+                    cacheTime[indices[i]] = timeStamp++;
+                    clusterMisses++;
+                }
+            }
+            const float clusterAcmr = (float)clusterMisses / (float)(end - begin);
+
+            // Start a new soft cluster whenever the running ACMR is close enough to the cluster ACMR
+            softClusters.push_back((uint32_t)begin);
+            size_t runStart = begin, runMisses = 0;
+            timeStamp += cacheSize + 1;
+            for (size_t t = begin; t < end; t++)
+            {
+                for (unsigned int k = 0; k < 3; k++)
+                {
+                    uint32_t v = indices[t * 3 + k];
+                    if (timeStamp - cacheTime[v] > cacheSize)
+                    {
+                        cacheTime[v] = timeStamp++;
+                        runMisses++;
+                    }
+                }
+
+                const float runAcmr = (float)runMisses / (float)(t + 1 - runStart);
+                if (t + 1 < end && runAcmr <= clusterAcmr * threshold)
+                {
+                    softClusters.push_back((uint32_t)(t + 1));
+                    runStart = t + 1;
+                    runMisses = 0;
+                    timeStamp += cacheSize + 1;
+                }
+            }
+        }
+    }
+
+    // Mesh centroid
+    float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        const float* p = position((uint32_t)v);
+        meshCenter[0] += p[0];
+        meshCenter[1] += p[1];
+        meshCenter[2] += p[2];
+    }
+    for (unsigned int k = 0; k < 3; k++)
+        meshCenter[k] /= (float)vertexCount;
+
+    // Sort key per cluster: how far the cluster faces away from the mesh center
+    struct ClusterKey
+    {
+        float sortKey;
+        uint32_t cluster;
+    };
+    std::vector<ClusterKey> keys(softClusters.size());
+    for (size_t c = 0; c < softClusters.size(); c++)
+    {
+        const size_t begin = softClusters[c];
+        const size_t end = c + 1 < softClusters.size() ? softClusters[c + 1] : triangleCount;
+
+        // Area weighted centroid and normal
+        float center[3] = { 0.0f, 0.0f, 0.0f }, normal[3] = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+        for (size_t t = begin; t < end; t++)
+        {
+            const float* p0 = position(indices[t * 3 + 0]);
+            const float* p1 = position(indices[t * 3 + 1]);
+            const float* p2 = position(indices[t * 3 + 2]);
+
+            const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            const float a = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (unsigned int k = 0; k < 3; k++)
+            {
+                center[k] += (p0[k] + p1[k] + p2[k]) * (a / 3.0f);
+                normal[k] += n[k];
+            }
+            area += a;
+        }
+
+        float sortKey = 0.0f;
+        const float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area > 0.0f && normalLength > 0.0f)
+        {
+            for (unsigned int k = 0; k < 3; k++)
+                sortKey += (center[k] / area - meshCenter[k]) * (normal[k] / normalLength);
+        }
+
+        keys[c] = { sortKey, (uint32_t)c };
+    }
+
+    // Outward facing clusters first
+    std::stable_sort(keys.begin(), keys.end(), [](const ClusterKey& a, const ClusterKey& b) { return a.sortKey > b.sortKey; });
+
+    // Emit clusters (source may alias destination)
+    std::vector<uint32_t> source(indices, indices + triangleCount * 3);
+    size_t out = 0;
+    for (const ClusterKey& key : keys)
+    {
+        const size_t begin = softClusters[key.cluster];
+        const size_t end = key.cluster + 1 < softClusters.size() ? softClusters[key.cluster + 1] : triangleCount;
+        for (size_t i = begin * 3; i < end * 3; i++)
+            destination[out++] = source[i];
+    }
+}
+
+size_t RTR::MeshOptimizeVertexFetch(uint32_t* remapOut, uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    const uint32_t unassigned = ~0U;
+    std::vector<uint32_t> oldToNew(vertexCount, unassigned);
+
+    // Assign in order of first use
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t& target = oldToNew[indices[i]];
+        if (target == unassigned)
+        {
+            remapOut[next] = indices[i];
+            target = next++;
+        }
+        indices[i] = target;
+    }
+    const size_t referenced = next;
+
+    // Keep unreferenced vertices at the end
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        if (oldToNew[v] == unassigned)
+        {
+            remapOut[next] = (uint32_t)v;
+            oldToNew[v] = next++;
+        }
+    }
+
+    return referenced;
+}
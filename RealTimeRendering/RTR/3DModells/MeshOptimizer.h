@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RTR
+{
+    // Post transform cache efficiency of an index buffer
+    struct VertexCacheStats
+    {
+        // Average cache miss ratio (transformed vertices per triangle, 0.5 ... 3.0)
+        float acmr = 0.0f;
+        // Average transform to vertex ratio (transformed vertices per referenced vertex, 1.0 is optimal)
+        float atvr = 0.0f;
+    };
+
+    // Simulate a FIFO post transform cache of cacheSize entries
+    VertexCacheStats MeshAnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+
+    // Reorder triangles for the post transform cache (Tipsify, Sander et al. 2007).
+    // The start triangle of every hard cluster (dead end / cache flush) is appended to ptrClustersOut (optional).
+    void MeshOptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16, std::vector<uint32_t>* ptrClustersOut = nullptr);
+
+    // Sort clusters of a vertex cache optimized index buffer so outward facing clusters are drawn first (reduces overdraw).
+    // Hard clusters are split further while their running ACMR stays below threshold * cluster ACMR.
+    void MeshOptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount,
+        const std::vector<uint32_t>& clusters, unsigned int cacheSize = 16, float threshold = 1.05f);
+
+    // Reorder vertices by first use. Indices are remapped in place, remapOut receives the old index for every new vertex.
+    // Returns the count of referenced vertices (unreferenced ones are kept at the end).
+    size_t MeshOptimizeVertexFetch(uint32_t* remapOut, uint32_t* indices, size_t indexCount, size_t vertexCount);
+}
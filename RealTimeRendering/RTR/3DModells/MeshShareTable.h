@@ -0,0 +1,120 @@
+#pragma once
+
+#include <RTR/3DModells/MeshCache.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace RTR
+{
+    // Everything that has to match before two meshes share their gpu data (the content hash alone could collide)
+    struct MeshShareKey
+    {
+        // Hash of all blobs (0 never shares) and an independent check hash of the same data
+        uint64_t contentHash = 0;
+        uint64_t contentCheck = 0;
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        size_t meshletCount = 0;
+        uint32_t indexSize = 0;
+        uint64_t blobBytes[(size_t)MeshCacheBlob::Count] = {};
+
+        // Same content
+        inline bool Matches(const MeshShareKey& other) const
+        {
+            bool identical = contentHash == other.contentHash && contentCheck == other.contentCheck && vertexCount == other.vertexCount &&
+                indexCount == other.indexCount && meshletCount == other.meshletCount && indexSize == other.indexSize;
+            for (size_t b = 0; identical && b < (size_t)MeshCacheBlob::Count; b++)
+                identical = blobBytes[b] == other.blobBytes[b];
+            return identical;
+        }
+    };
+
+    // Refcounted data of meshes by content (the sharing bookkeeping of ModelContext, TData holds the gpu views).
+    // Every user of an entry keeps its content hash and releases it by that hash.
+    template<typename TData>
+    class MeshShareTable
+    {
+        public:
+            // Reference the data of an identical mesh (nullptr when there is none). A different mesh under the same hash
+            // sets ptrCollisionOut, that mesh has to stay unshared (content hash 0) so releasing it never touches the entry.
+            TData* Acquire(const MeshShareKey& key, bool* ptrCollisionOut = nullptr)
+            {
+                if (ptrCollisionOut)
+                    *ptrCollisionOut = false;
+                auto it = key.contentHash ? m_entries.find(key.contentHash) : m_entries.end();
+                if (it == m_entries.end())
+                    return nullptr;
+
+                if (!it->second.key.Matches(key))
+                {
+                    if (ptrCollisionOut)
+                        *ptrCollisionOut = true;
+                    return nullptr;
+                }
+
+                it->second.refCount++;
+                return &it->second.data;
+            }
+            // Register data for a key without an entry (content hash not 0) with one reference
+            TData& Insert(const MeshShareKey& key)
+            {
+                Entry& entry = m_entries[key.contentHash];
+                entry.key = key;
+                entry.refCount = 1;
+                entry.data = TData();
+                return entry.data;
+            }
+            // Drop a reference. True when the data has no other user and has to be freed (always for unshared meshes).
+            bool Release(uint64_t contentHash)
+            {
+                auto it = contentHash ? m_entries.find(contentHash) : m_entries.end();
+                if (it == m_entries.end())
+                    return true;
+                if (--it->second.refCount)
+                    return false;
+
+                m_entries.erase(it);
+                return true;
+            }
+
+            // Data of an entry (nullptr when there is none)
+            TData* Find(uint64_t contentHash)
+            {
+                auto it = contentHash ? m_entries.find(contentHash) : m_entries.end();
+                return it != m_entries.end() ? &it->second.data : nullptr;
+            }
+            // References of an entry (0 when there is none)
+            uint32_t GetRefCount(uint64_t contentHash) const
+            {
+                auto it = m_entries.find(contentHash);
+                return it != m_entries.end() ? it->second.refCount : 0;
+            }
+            // Count of entries
+            inline size_t GetCount() const
+            {
+                return m_entries.size();
+            }
+
+            // Call func(TData&) for every entry
+            template<typename F>
+            void ForEach(F&& func)
+            {
+                for (auto& entry : m_entries)
+                    func(entry.second.data);
+            }
+
+        private:
+            // One shared mesh
+            struct Entry
+            {
+                MeshShareKey key;
+                uint32_t refCount = 0;
+                TData data;
+            };
+
+        private:
+            std::unordered_map<uint64_t, Entry> m_entries;
+    };
+}
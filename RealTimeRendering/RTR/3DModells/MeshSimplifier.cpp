@@ -0,0 +1,402 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+namespace RTR
+{
+    // Symmetric 4x4 error quadric (Q(p) = p'Ap + 2b'p + c) with the area it was accumulated from
+    struct SimplifierQuadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0;
+
+        // Add the quadric of plane n'p + d = 0
+        inline void AddPlane(double nx, double ny, double nz, double d, double planeWeight)
+        {
+            a00 += nx * nx * planeWeight; a01 += nx * ny * planeWeight; a02 += nx * nz * planeWeight;
+            a11 += ny * ny * planeWeight; a12 += ny * nz * planeWeight; a22 += nz * nz * planeWeight;
+            b0 += nx * d * planeWeight; b1 += ny * d * planeWeight; b2 += nz * d * planeWeight;
+            c += d * d * planeWeight;
+            weight += planeWeight;
+        }
+
+        // Accumulate
+        inline void Add(const SimplifierQuadric& other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        // Weighted squared distance of p to all planes
+        inline double Evaluate(const float* p) const
+        {
+            const double x = p[0], y = p[1], z = p[2];
+            double error =
+                a00 * x * x + a11 * y * y + a22 * z * z +
+                2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return std::max(error, 0.0);
+        }
+    };
+
+    // Collapse candidate u -> v
+    struct SimplifierCollapse
+    {
+        float cost;
+        uint32_t u, v;
+        uint32_t versionU, versionV;
+
+        inline bool operator>(const SimplifierCollapse& other) const noexcept
+        {
+            return cost > other.cost;
+        }
+    };
+}
+
+size_t RTR::MeshSimplify(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount,
+    const float* attributes, size_t attributeStride, const float* attributeWeights, size_t attributeCount,
+    size_t targetIndexCount, float targetError, float* ptrErrorOut)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (ptrErrorOut)
+        *ptrErrorOut = 0.0f;
+
+    // Working copy of the triangles (the source may alias the destination)
+    std::vector<uint32_t> triangles(indices, indices + triangleCount * 3);
+    if (!triangleCount || !vertexCount || triangleCount * 3 <= targetIndexCount)
+    {
+        std::copy(triangles.begin(), triangles.end(), destination);
+        return triangles.size();
+    }
+
+    auto position = [&](uint32_t v) { return (const float*)((const unsigned char*)positions + positionStride * v); };
+    auto attribute = [&](uint32_t v) { return (const float*)((const unsigned char*)attributes + attributeStride * v); };
+    auto edgeKey = [](uint32_t a, uint32_t b) { return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a; };
+
+    // Vertex classification
+    enum VertexKind : uint8_t
+    {
+        Manifold = 0,
+        Border,
+        Locked,
+    };
+    std::vector<uint8_t> kind(vertexCount, Manifold);
+
+    // Seams: vertices that share their position with another vertex
+    {
+        std::vector<uint32_t> order(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++)
+            order[v] = v;
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return memcmp(position(a), position(b), sizeof(float) * 3) < 0; });
+        for (size_t i = 1; i < vertexCount; i++)
+        {
+            if (memcmp(position(order[i - 1]), position(order[i]), sizeof(float) * 3) == 0)
+            {
+                kind[order[i - 1]] = Locked;
+                kind[order[i]] = Locked;
+            }
+        }
+    }
+
+    // Edge use counts (border: one triangle, non manifold: more than two)
+    std::unordered_map<uint64_t, uint32_t> edgeUse;
+    edgeUse.reserve(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        edgeUse[edgeKey(triangles[i], triangles[i - i % 3 + (i + 1) % 3])]++;
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        const uint32_t a = triangles[i], b = triangles[i - i % 3 + (i + 1) % 3];
+        const uint32_t use = edgeUse[edgeKey(a, b)];
+        if (use != 2)
+        {
+            const uint8_t edgeKind = use == 1 ? Border : Locked;
+            kind[a] = std::max(kind[a], edgeKind);
+            kind[b] = std::max(kind[b], edgeKind);
+        }
+    }
+
+    // Quadrics from triangle planes (area weighted) and border planes
+    const double borderWeight = 10.0;
+    std::vector<SimplifierQuadric> quadrics(vertexCount);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const float* p0 = position(triangles[t * 3 + 0]);
+        const float* p1 = position(triangles[t * 3 + 1]);
+        const float* p2 = position(triangles[t * 3 + 2]);
+        const double e1[3] = { (double)p1[0] - p0[0], (double)p1[1] - p0[1], (double)p1[2] - p0[2] };
+        const double e2[3] = { (double)p2[0] - p0[0], (double)p2[1] - p0[1], (double)p2[2] - p0[2] };
+        double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0)
+            continue;
+        n[0] /= length; n[1] /= length; n[2] /= length;
+
+        SimplifierQuadric q;
+        q.AddPlane(n[0], n[1], n[2], -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]), length * 0.5);
+        for (unsigned int k = 0; k < 3; k++)
+            quadrics[triangles[t * 3 + k]].Add(q);
+
+        // Planes perpendicular to border edges keep the outline in place
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            const uint32_t a = triangles[t * 3 + k], b = triangles[t * 3 + (k + 1) % 3];
+            if (edgeUse[edgeKey(a, b)] != 1)
+                continue;
+
+            const float* pa = position(a);
+            const float* pb = position(b);
+            const double e[3] = { (double)pb[0] - pa[0], (double)pb[1] - pa[1], (double)pb[2] - pa[2] };
+            double en[3] = { e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2], e[0] * n[1] - e[1] * n[0] };
+            const double enLength = std::sqrt(en[0] * en[0] + en[1] * en[1] + en[2] * en[2]);
+            if (enLength <= 0.0)
+                continue;
+            en[0] /= enLength; en[1] /= enLength; en[2] /= enLength;
+
+            SimplifierQuadric bq;
+            bq.AddPlane(en[0], en[1], en[2], -(en[0] * pa[0] + en[1] * pa[1] + en[2] * pa[2]), (e[0] * e[0] + e[1] * e[1] + e[2] * e[2]) * borderWeight);
+            quadrics[a].Add(bq);
+            quadrics[b].Add(bq);
+        }
+    }
+    edgeUse.clear();
+
+    // Attribute differences are measured relative to the mesh size
+    const double extent = MeshComputeExtent(positions, positionStride, vertexCount);
+    const double attributeScale = extent * extent;
+
+    // Vertex -> triangle adjacency (grows as triangles are moved onto the collapse target)
+    std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        vertexTriangles[triangles[i]].push_back((uint32_t)(i / 3));
+
+    std::vector<bool> triangleDead(triangleCount, false);
+    std::vector<uint32_t> version(vertexCount, 0);
+    size_t liveTriangles = triangleCount;
+
+    // Cost of collapsing u onto v (squared distance plus attribute penalty)
+    auto collapseCost = [&](uint32_t u, uint32_t v) -> double
+    {
+        SimplifierQuadric q = quadrics[u];
+        q.Add(quadrics[v]);
+        double cost = q.weight > 0.0 ? q.Evaluate(position(v)) / q.weight : 0.0;
+        if (attributes)
+        {
+            const float* au = attribute(u);
+            const float* av = attribute(v);
+            for (size_t k = 0; k < attributeCount; k++)
+            {
+                const double d = (double)au[k] - av[k];
+                cost += attributeWeights[k] * d * d * attributeScale;
+            }
+        }
+        return cost;
+    };
+
+    // Border vertices may only slide along their border, locked ones never move
+    auto sharedTriangles = [&](uint32_t u, uint32_t v) -> unsigned int
+    {
+        unsigned int count = 0;
+        for (uint32_t t : vertexTriangles[u])
+        {
+            if (!triangleDead[t] && (triangles[t * 3 + 0] == v || triangles[t * 3 + 1] == v || triangles[t * 3 + 2] == v))
+                count++;
+        }
+        return count;
+    };
+    auto canCollapse = [&](uint32_t u, uint32_t v) -> bool
+    {
+        if (u == v || kind[u] == Locked)
+            return false;
+        if (kind[u] == Border)
+            return kind[v] != Manifold && sharedTriangles(u, v) == 1;
+        return true;
+    };
+
+    // Seed the queue with all directed edges
+    std::priority_queue<SimplifierCollapse, std::vector<SimplifierCollapse>, std::greater<SimplifierCollapse>> queue;
+    auto pushCollapse = [&](uint32_t u, uint32_t v)
+    {
+        if (canCollapse(u, v))
+            queue.push({ (float)collapseCost(u, v), u, v, version[u], version[v] });
+    };
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            const uint32_t a = triangles[t * 3 + k], b = triangles[t * 3 + (k + 1) % 3];
+            pushCollapse(a, b);
+            pushCollapse(b, a);
+        }
+    }
+
+    // Scratch for the link condition
+    std::vector<uint32_t> neighborsU, neighborsV;
+    auto gatherNeighbors = [&](uint32_t v, std::vector<uint32_t>& out)
+    {
+        out.clear();
+        for (uint32_t t : vertexTriangles[v])
+        {
+            if (!triangleDead[t])
+                out.insert(out.end(), &triangles[t * 3], &triangles[t * 3 + 3]);
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    };
+
+    // Collapse cheapest edges first
+    const double maxCost = (double)targetError * targetError;
+    double largestCost = 0.0;
+    while (!queue.empty() && liveTriangles * 3 > targetIndexCount)
+    {
+        const SimplifierCollapse collapse = queue.top();
+        queue.pop();
+
+        const uint32_t u = collapse.u, v = collapse.v;
+        if (version[u] != collapse.versionU || version[v] != collapse.versionV || vertexTriangles[u].empty())
+            continue;
+        if (collapse.cost > maxCost)
+            break;
+
+        // Edge must still exist and the collapse must keep the surface manifold (link condition)
+        const unsigned int shared = sharedTriangles(u, v);
+        if (!shared || !canCollapse(u, v))
+            continue;
+        gatherNeighbors(u, neighborsU);
+        gatherNeighbors(v, neighborsV);
+        unsigned int commonNeighbors = 0;
+        for (size_t i = 0, j = 0; i < neighborsU.size() && j < neighborsV.size();)
+        {
+            if (neighborsU[i] < neighborsV[j]) i++;
+            else if (neighborsU[i] > neighborsV[j]) j++;
+            else
+            {
+                if (neighborsU[i] != u && neighborsU[i] != v)
+                    commonNeighbors++;
+                i++;
+                j++;
+            }
+        }
+        if (commonNeighbors != shared)
+            continue;
+
+        // Reject collapses that flip or degenerate a remaining triangle
+        bool flips = false;
+        const float* pv = position(v);
+        for (uint32_t t : vertexTriangles[u])
+        {
+            const uint32_t* tri = &triangles[t * 3];
+            if (triangleDead[t] || tri[0] == v || tri[1] == v || tri[2] == v)
+                continue;
+
+            const float* p[3] = { position(tri[0]), position(tri[1]), position(tri[2]) };
+            float moved[3][3];
+            for (unsigned int k = 0; k < 3; k++)
+                memcpy(moved[k], tri[k] == u ? pv : p[k], sizeof(float) * 3);
+
+            auto normal = [](const float* a, const float* b, const float* c, double* out)
+            {
+                const double e1[3] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+                const double e2[3] = { (double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2] };
+                out[0] = e1[1] * e2[2] - e1[2] * e2[1];
+                out[1] = e1[2] * e2[0] - e1[0] * e2[2];
+                out[2] = e1[0] * e2[1] - e1[1] * e2[0];
+            };
+            double nOld[3], nNew[3];
+            normal(p[0], p[1], p[2], nOld);
+            normal(moved[0], moved[1], moved[2], nNew);
+            const double dot = nOld[0] * nNew[0] + nOld[1] * nNew[1] + nOld[2] * nNew[2];
+            const double lengths = std::sqrt(nOld[0] * nOld[0] + nOld[1] * nOld[1] + nOld[2] * nOld[2]) * std::sqrt(nNew[0] * nNew[0] + nNew[1] * nNew[1] + nNew[2] * nNew[2]);
+            if (lengths <= 0.0 || dot <= 1e-2 * lengths)
+            {
+                flips = true;
+                break;
+            }
+        }
+        if (flips)
+            continue;
+
+        // Collapse: triangles on the edge die, all others move to v
+        for (uint32_t t : vertexTriangles[u])
+        {
+            if (triangleDead[t])
+                continue;
+
+            uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == v || tri[1] == v || tri[2] == v)
+            {
+                triangleDead[t] = true;
+                liveTriangles--;
+            }
+            else
+            {
+                for (unsigned int k = 0; k < 3; k++)
+                    if (tri[k] == u) tri[k] = v;
+                vertexTriangles[v].push_back(t);
+            }
+        }
+        vertexTriangles[u].clear();
+        vertexTriangles[u].shrink_to_fit();
+        quadrics[v].Add(quadrics[u]);
+        version[u]++;
+        version[v]++;
+        largestCost = std::max(largestCost, (double)collapse.cost);
+
+        // Drop dead triangles from v and requeue its edges
+        auto& trianglesV = vertexTriangles[v];
+        trianglesV.erase(std::remove_if(trianglesV.begin(), trianglesV.end(), [&](uint32_t t) { return triangleDead[t]; }), trianglesV.end());
+        gatherNeighbors(v, neighborsV);
+        for (uint32_t n : neighborsV)
+        {
+            if (n != v)
+            {
+                pushCollapse(v, n);
+                pushCollapse(n, v);
+            }
+        }
+    }
+
+    // Emit remaining triangles
+    size_t out = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        if (!triangleDead[t])
+        {
+            destination[out++] = triangles[t * 3 + 0];
+            destination[out++] = triangles[t * 3 + 1];
+            destination[out++] = triangles[t * 3 + 2];
+        }
+    }
+
+    if (ptrErrorOut)
+        *ptrErrorOut = (float)std::sqrt(largestCost);
+    return out;
+}
+
+float RTR::MeshComputeExtent(const float* positions, size_t positionStride, size_t vertexCount)
+{
+    if (!vertexCount)
+        return 0.0f;
+
+    float minimum[3] = { positions[0], positions[1], positions[2] };
+    float maximum[3] = { positions[0], positions[1], positions[2] };
+    for (size_t v = 1; v < vertexCount; v++)
+    {
+        const float* p = (const float*)((const unsigned char*)positions + positionStride * v);
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            minimum[k] = std::min(minimum[k], p[k]);
+            maximum[k] = std::max(maximum[k], p[k]);
+        }
+    }
+
+    return std::max(maximum[0] - minimum[0], std::max(maximum[1] - minimum[1], maximum[2] - minimum[2]));
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RTR
+{
+    // Reduce a triangle list by quadric error edge collapses (Garland & Heckbert 1997).
+    // Vertices are only ever collapsed onto other existing vertices, so the result indexes the unchanged vertex buffer.
+    // Vertices that share a position with another vertex (attribute seams) or sit on non manifold edges are never moved,
+    // open borders only collapse along themselves.
+    // attributes (optional) holds attributeCount floats per vertex. Their squared difference is weighted by attributeWeights
+    // and scaled by the squared mesh extent before it is added to the collapse cost.
+    // Collapsing stops when the index count is at or below targetIndexCount or the next collapse exceeds targetError (in position units).
+    // Returns the new index count. destination must hold indexCount indices and may alias indices. ptrErrorOut (optional) receives the
+    // largest geometric error of all performed collapses.
+    size_t MeshSimplify(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount,
+        const float* attributes, size_t attributeStride, const float* attributeWeights, size_t attributeCount,
+        size_t targetIndexCount, float targetError, float* ptrErrorOut = nullptr);
+
+    // Largest axis extent of the bounding box of all positions
+    float MeshComputeExtent(const float* positions, size_t positionStride, size_t vertexCount);
+
+    // Size of a world space error in pixels at distance (projectionScale = viewportHeight / (2 * tan(fovY / 2)))
+    inline float MeshProjectError(float error, float distance, float projectionScale)
+    {
+        return distance > 0.0f ? error * projectionScale / distance : 3.402823466e+38F;
+    }
+}
@@ -0,0 +1,205 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+void RTR::MeshBuildMeshlets(MeshletData& dataOut, const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount, unsigned int maxVertices, unsigned int maxPrimitives)
+{
+    // Clamp to what fits into the packing
+    maxVertices = std::min(std::max(maxVertices, 3U), MeshletMaxVerticesLimit);
+    maxPrimitives = std::min(std::max(maxPrimitives, 1U), MeshletMaxPrimitivesLimit);
+
+    dataOut.meshlets.clear();
+    dataOut.bounds.clear();
+    dataOut.vertices.clear();
+    dataOut.primitives.clear();
+
+    // Local index of every mesh vertex in the current meshlet
+    const uint32_t notInMeshlet = ~0U;
+    std::vector<uint32_t> localIndex(vertexCount, notInMeshlet);
+
+    // Triangles of the current meshlet (mesh indices, for bounds)
+    std::vector<uint32_t> meshletTriangles;
+    meshletTriangles.reserve(maxPrimitives * 3);
+
+    Meshlet current = { 0, 0, 0, 0 };
+    auto flush = [&]()
+    {
+        if (current.primitiveCount)
+        {
+            // Reset local mapping
+            for (uint32_t i = 0; i < current.vertexCount; i++)
+                localIndex[dataOut.vertices[current.vertexOffset + i]] = notInMeshlet;
+
+            dataOut.meshlets.push_back(current);
+            dataOut.bounds.push_back(MeshComputeClusterBounds(meshletTriangles.data(), meshletTriangles.size(), positions, positionStride));
+        }
+
+        current.vertexOffset = (uint32_t)dataOut.vertices.size();
+        current.vertexCount = 0;
+        current.primitiveOffset = (uint32_t)dataOut.primitives.size();
+        current.primitiveCount = 0;
+        meshletTriangles.clear();
+    };
+
+    for (size_t t = 0; t + 2 < indexCount; t += 3)
+    {
+        const uint32_t* tri = &indices[t];
+
+        // Count new vertices of this triangle
+        unsigned int newVertices = 0;
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            bool duplicate = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            if (localIndex[tri[k]] == notInMeshlet && !duplicate)
+                newVertices++;
+        }
+
+        // Start a new meshlet when a limit would be exceeded
+        if (current.vertexCount + newVertices > maxVertices || current.primitiveCount + 1 > maxPrimitives)
+            flush();
+
+        // Add triangle
+        uint32_t local[3];
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            if (localIndex[tri[k]] == notInMeshlet)
+            {
+                localIndex[tri[k]] = current.vertexCount++;
+                dataOut.vertices.push_back(tri[k]);
+            }
+            local[k] = localIndex[tri[k]];
+            meshletTriangles.push_back(tri[k]);
+        }
+        dataOut.primitives.push_back(MeshletPackPrimitive(local[0], local[1], local[2]));
+        current.primitiveCount++;
+    }
+    flush();
+}
+
+RTR::MeshletBounds RTR::MeshComputeClusterBounds(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride)
+{
+    MeshletBounds bounds = {};
+    bounds.coneCutoff = 2.0f; // Above any dot product: never culled by default
+
+    const size_t triangleCount = indexCount / 3;
+    if (!triangleCount)
+        return bounds;
+
+    auto position = [&](uint32_t v) { return (const float*)((const unsigned char*)positions + positionStride * v); };
+    auto distanceSq = [](const float* a, const float* b) { float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2]; return dx * dx + dy * dy + dz * dz; };
+
+    // Ritter bounding sphere: most distant point from the first, then the most distant from that one
+    const float* p0 = position(indices[0]);
+    const float* pA = p0;
+    for (size_t i = 0; i < indexCount; i++)
+        if (distanceSq(position(indices[i]), p0) > distanceSq(pA, p0)) pA = position(indices[i]);
+    const float* pB = pA;
+    for (size_t i = 0; i < indexCount; i++)
+        if (distanceSq(position(indices[i]), pA) > distanceSq(pB, pA)) pB = position(indices[i]);
+
+    float center[3] = { (pA[0] + pB[0]) * 0.5f, (pA[1] + pB[1]) * 0.5f, (pA[2] + pB[2]) * 0.5f };
+    float radius = std::sqrt(distanceSq(pA, pB)) * 0.5f;
+
+    // Grow to enclose all points
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        const float* p = position(indices[i]);
+        float d = std::sqrt(distanceSq(p, center));
+        if (d > radius)
+        {
+            float newRadius = (radius + d) * 0.5f;
+            float k = (newRadius - radius) / d;
+            for (unsigned int c = 0; c < 3; c++)
+                center[c] += (p[c] - center[c]) * k;
+            radius = newRadius;
+        }
+    }
+
+    bounds.center[0] = center[0];
+    bounds.center[1] = center[1];
+    bounds.center[2] = center[2];
+    bounds.radius = radius;
+
+    // Triangle normals
+    std::vector<float> normals(triangleCount * 3, 0.0f);
+    std::vector<bool> valid(triangleCount, false);
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const float* a = position(indices[t * 3 + 0]);
+        const float* b = position(indices[t * 3 + 1]);
+        const float* c = position(indices[t * 3 + 2]);
+        const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 0.0f)
+        {
+            for (unsigned int k = 0; k < 3; k++)
+            {
+                normals[t * 3 + k] = n[k] / length;
+                axis[k] += normals[t * 3 + k];
+            }
+            valid[t] = true;
+        }
+    }
+
+    // Cone axis
+    float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if (axisLength <= 0.0f)
+        return bounds;
+    for (unsigned int k = 0; k < 3; k++)
+        axis[k] /= axisLength;
+
+    // Widest normal deviation
+    float minDot = 1.0f;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        if (valid[t])
+            minDot = std::min(minDot, axis[0] * normals[t * 3 + 0] + axis[1] * normals[t * 3 + 1] + axis[2] * normals[t * 3 + 2]);
+    }
+
+    // Cone wider than ~90 degrees can never be culled
+    bounds.coneAxis[0] = axis[0];
+    bounds.coneAxis[1] = axis[1];
+    bounds.coneAxis[2] = axis[2];
+    if (minDot <= 0.1f)
+    {
+        bounds.coneApex[0] = center[0];
+        bounds.coneApex[1] = center[1];
+        bounds.coneApex[2] = center[2];
+        return bounds;
+    }
+
+    // Move the apex back along the axis until it is behind every triangle plane
+    float maxT = 0.0f;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        if (!valid[t])
+            continue;
+
+        const float* a = position(indices[t * 3 + 0]);
+        const float* n = &normals[t * 3];
+        float bc = (center[0] - a[0]) * n[0] + (center[1] - a[1]) * n[1] + (center[2] - a[2]) * n[2];
+        float dc = axis[0] * n[0] + axis[1] * n[1] + axis[2] * n[2];
+        maxT = std::max(maxT, bc / dc);
+    }
+
+    for (unsigned int k = 0; k < 3; k++)
+        bounds.coneApex[k] = center[k] - axis[k] * maxT;
+    bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+
+    return bounds;
+}
+
+bool RTR::MeshletIsBackfacing(const MeshletBounds& bounds, const float* cameraPosition)
+{
+    float view[3] = { bounds.coneApex[0] - cameraPosition[0], bounds.coneApex[1] - cameraPosition[1], bounds.coneApex[2] - cameraPosition[2] };
+    float length = std::sqrt(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]);
+    if (length <= 0.0f)
+        return false;
+
+    float d = (view[0] * bounds.coneAxis[0] + view[1] * bounds.coneAxis[1] + view[2] * bounds.coneAxis[2]) / length;
+    return d >= bounds.coneCutoff;
+}
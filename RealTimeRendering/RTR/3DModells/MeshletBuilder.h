@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RTR
+{
+    // One meshlet (layout matches the HLSL side)
+    struct Meshlet
+    {
+        // Range in the meshlet vertex list (indices into the mesh vertex buffer)
+        uint32_t vertexOffset;
+        uint32_t vertexCount;
+        // Range in the meshlet primitive list (10:10:10 packed local vertex indices)
+        uint32_t primitiveOffset;
+        uint32_t primitiveCount;
+    };
+
+    // Culling data of one meshlet (layout matches the HLSL side)
+    struct MeshletBounds
+    {
+        // Bounding sphere
+        float center[3];
+        float radius;
+
+        // Normal cone: the meshlet is backfacing when dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff
+        float coneApex[3];
+        float coneCutoff;
+        float coneAxis[3];
+        float padding;
+    };
+
+    // All meshlets of a mesh
+    struct MeshletData
+    {
+        std::vector<Meshlet> meshlets;
+        std::vector<MeshletBounds> bounds;
+        std::vector<uint32_t> vertices;
+        std::vector<uint32_t> primitives;
+    };
+
+    // Limits of the builder (primitives are packed with 10 bits per local index)
+    constexpr unsigned int MeshletMaxVerticesLimit = 256;
+    constexpr unsigned int MeshletMaxPrimitivesLimit = 256;
+
+    // Split a triangle list into meshlets (in triangle order, so run a vertex cache optimization first for tight clusters)
+    void MeshBuildMeshlets(MeshletData& dataOut, const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount,
+        unsigned int maxVertices = 64, unsigned int maxPrimitives = 124);
+
+    // Compute sphere and normal cone of a set of triangles
+    MeshletBounds MeshComputeClusterBounds(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride);
+
+    // Pack / unpack a meshlet primitive
+    inline uint32_t MeshletPackPrimitive(uint32_t i0, uint32_t i1, uint32_t i2)
+    {
+        return (i0 & 0x3FF) | ((i1 & 0x3FF) << 10) | ((i2 & 0x3FF) << 20);
+    }
+    inline void MeshletUnpackPrimitive(uint32_t primitive, uint32_t* ptrIndicesOut)
+    {
+        ptrIndicesOut[0] = primitive & 0x3FF;
+        ptrIndicesOut[1] = (primitive >> 10) & 0x3FF;
+        ptrIndicesOut[2] = (primitive >> 20) & 0x3FF;
+    }
+
+    // CPU version of the cone test (true when the meshlet can be culled)
+    bool MeshletIsBackfacing(const MeshletBounds& bounds, const float* cameraPosition);
+}
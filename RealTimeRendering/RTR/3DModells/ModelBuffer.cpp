@@ -42,26 +42,31 @@ RTR::ModelBuffer::ModelBuffer(UINT64 size)
     SetResourceState(D3D12_RESOURCE_STATE_COMMON);
 
     // Set size
-    m_size = size;
+    m_allocator.Reset(size);
 }
 
-bool RTR::ModelBuffer::Alloc(UINT64 size, ModelPartView* ptrViewOut)
+bool RTR::ModelBuffer::Alloc(UINT64 size, ModelPartView* ptrViewOut, UINT64 alignment)
 {
-    bool canAlloc = m_size - m_usage >= size;
+    // Empty parts never occupy memory
+    UINT64 offset = 0;
+    bool canAlloc = !size || m_allocator.Allocate(size, alignment, &offset);
     if (canAlloc)
     {
         // Set details
-        ptrViewOut->Offset = m_usage;
+        ptrViewOut->Offset = offset;
         ptrViewOut->Size = size;
         ptrViewOut->ptrBuffer = this;
-
-        // Increment usage
-        m_usage += size;
     }
 
     return canAlloc;
 }
 
+void RTR::ModelBuffer::Free(const ModelPartView& view)
+{
+    if (view.Size && view.ptrBuffer == this)
+        m_allocator.Free(view.Offset);
+}
+
 bool RTR::ModelBuffer::Upload(ModelPartView& view, UINT64 offset, UINT64 size, void* data, D3DUploadBuffer& uploader)
 {
     bool canUpload = offset + size <= view.Size;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Util/ComPointer.h>
+#include <Util/TlsfAllocator.h>
 #include <D3DMemory/D3DResource.h>
 #include <D3DMemory/D3DUploadBuffer.h>
 
@@ -9,16 +10,22 @@ namespace RTR
     // View of a model part (vertices / indices / ...)
     struct ModelPartView
     {
-        D3DResource* ptrBuffer;
-        UINT64 Offset;
-        UINT64 Size;
+        D3DResource* ptrBuffer = nullptr;
+        UINT64 Offset = 0;
+        UINT64 Size = 0;
 
         // Helper functions
         D3D12_VERTEX_BUFFER_VIEW CreateVertexBufferView(UINT64 sizeofVertex);
         D3D12_INDEX_BUFFER_VIEW CreateIndexBufferView(UINT64 sizeofIndex);
+
+        // Index of the first element in a view of the whole buffer (Offset must be a multiple of elementSize)
+        inline UINT GetFirstElement(UINT64 elementSize) const
+        {
+            return (UINT)(Offset / elementSize);
+        }
     };
 
-    // Big stack that can hold model data (vertices and indices)
+    // Big buffer that can hold model data (vertices and indices), sub allocated by a TlsfAllocator
     class ModelBuffer : public D3DResource
     {
         public:
@@ -30,14 +37,34 @@ namespace RTR
             // Copy
             ModelBuffer& operator=(const ModelBuffer&) = delete;
 
-            // Allocate space on the buffer
-            bool Alloc(UINT64 size, ModelPartView* ptrViewOut);
+            // Allocate space on the buffer at a multiple of alignment (any value, e.g. a vertex stride; views need a multiple of 4)
+            bool Alloc(UINT64 size, ModelPartView* ptrViewOut, UINT64 alignment = 4);
+            // Release an allocated part
+            void Free(const ModelPartView& view);
             // Upload data to an allocated are
             static bool Upload(ModelPartView& view, UINT64 offset, UINT64 size, void* data, D3DUploadBuffer& uploader);
 
+            // View of the whole buffer (bind once and draw parts by their first element)
+            inline ModelPartView GetWholeView()
+            {
+                ModelPartView view;
+                view.ptrBuffer = this;
+                view.Size = m_allocator.GetSize();
+                return view;
+            }
+
+            // Allocator of the buffer range (relocation and statistics)
+            inline TlsfAllocator& GetAllocator()
+            {
+                return m_allocator;
+            }
+            inline const TlsfAllocator& GetAllocator() const
+            {
+                return m_allocator;
+            }
+
         private:
-            // Size and current usage of the buffer
-            UINT64 m_size = 0;
-            UINT64 m_usage = 0;
+            // Free and used ranges of the buffer
+            TlsfAllocator m_allocator;
     };
 }
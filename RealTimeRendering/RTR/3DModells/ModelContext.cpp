@@ -1,97 +1,392 @@
 #include "ModelContext.h"
 
-RTR::ModelContext::ModelContext(UINT64 memoryBudget) :
+#include <algorithm>
+#include <cstdio>
+#include <unordered_set>
+
+// Assimp post processing used for every import (part of the mesh cache key)
+#define RTR_MODEL_IMPORT_FLAGS (aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType)
+
+RTR::ModelContext::ModelContext(UINT64 memoryBudget, unsigned int importThreadCount) :
+    m_importWorkers(importThreadCount),
     m_geometryDataBuffer(memoryBudget) // For now give all memory to the geometry data
-{ }
+{ 
+    // Background importer for LoadModelAsync
+    m_streamThread = std::thread(&ModelContext::StreamThreadMain, this);
+}
+
+RTR::ModelContext::~ModelContext()
+{
+    // Stop the background importer (queued requests are dropped)
+    {
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        m_streamShutdown = true;
+    }
+    m_streamCv.notify_all();
+    if (m_streamThread.joinable())
+        m_streamThread.join();
+}
+
+size_t RTR::MeshInfo::SelectLod(float distance, float projectionScale, float pixelError) const
+{
+    // Errors grow with the level, so search from the coarsest one down
+    for (size_t l = lods.size(); l > 1; l--)
+    {
+        if (MeshProjectError(lods[l - 1].error, distance, projectionScale) <= pixelError)
+            return l - 1;
+    }
+    return 0;
+}
 
-RTR::ModelInfo RTR::ModelContext::LoadModel(const char* filePath, D3DUploadBuffer& uploader, size_t vertexSize, FModelVertexCallback callback)
+RTR::VertexStreams RTR::ModelVertexStreams(const aiMesh* ptrMesh)
+{
+    VertexStreams streams;
+    auto set = [&streams](VertexSource source, const void* ptrData, UINT stride)
+    {
+        streams.ptrData[(UINT)source] = (const float*)ptrData;
+        streams.stride[(UINT)source] = ptrData ? stride : 0;
+    };
+
+    set(VertexSource::Position, ptrMesh->mVertices, sizeof(aiVector3D));
+    set(VertexSource::Normal, ptrMesh->mNormals, sizeof(aiVector3D));
+    set(VertexSource::Tangent, ptrMesh->mTangents, sizeof(aiVector3D));
+    set(VertexSource::Bitangent, ptrMesh->mBitangents, sizeof(aiVector3D));
+    set(VertexSource::TexCoord0, ptrMesh->mTextureCoords[0], sizeof(aiVector3D));
+    set(VertexSource::TexCoord1, ptrMesh->mTextureCoords[1], sizeof(aiVector3D));
+    set(VertexSource::Color0, ptrMesh->mColors[0], sizeof(aiColor4D));
+    return streams;
+}
+
+RTR::ModelInfo RTR::ModelContext::LoadModel(const char* filePath, D3DUploadBuffer& uploader, size_t vertexSize, FModelVertexCallback callback, UINT64 vertexLayout, const ModelImportOptions& options)
+{
+    return LoadModelInternal(filePath, uploader, vertexSize, callback, nullptr, vertexLayout, options);
+}
+
+RTR::ModelInfo RTR::ModelContext::LoadModelInternal(const char* filePath, D3DUploadBuffer& uploader, size_t vertexSize, FModelVertexCallback callback, FModelVertexBatchCallback batchCallback, UINT64 vertexLayout, const ModelImportOptions& options)
 {
     // Start with an info with valid index and invalid size
     ModelInfo infoOut;
     infoOut.idx = m_sets.size();
     infoOut.count = 0;
 
+    // The loader assembles compressed vertices itself
+    if (options.quantizeVertices)
+    {
+        vertexSize = sizeof(QuantizedVertex);
+    }
+
+    // Try the baked mesh cache first
+    MeshCacheKey cacheKey;
+    std::string cachePath = std::string(filePath) + RTR_MESH_CACHE_EXTENSION;
+    const bool useCache = MakeCacheKey(filePath, vertexSize, vertexLayout, options, &cacheKey);
+    if (useCache)
+    {
+        MeshCacheFile cache;
+        if (OpenCache(cache, filePath, cachePath.c_str(), cacheKey))
+        {
+            return LoadModelFromCache(cache, uploader);
+        }
+    }
+
     // Open an assimp scene
     Assimp::Importer asImport;
-    const aiScene* asScene = asImport.ReadFile(filePath,
-        aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType
-    );
+    const aiScene* asScene = asImport.ReadFile(filePath, RTR_MODEL_IMPORT_FLAGS);
 
     // Process data form scene
     if (asScene)
     {
-        // We need to load multiple meshes
-        infoOut.count = asScene->mNumMeshes;
+        // Gather and optimize indices of all meshes
+        std::vector<MeshImportJob> candidates(asScene->mNumMeshes);
+        m_importWorkers.ParallelFor(candidates.size(), [&](size_t idx)
+            {
+                candidates[idx].ptrMesh = asScene->mMeshes[idx];
+                PrepareMesh(candidates[idx], options);
+            }
+        );
+
+        // Assemble vertices (and hash the result) on the workers
+        m_importWorkers.ParallelFor(candidates.size(), [&](size_t idx)
+            {
+                AssembleMesh(candidates[idx], vertexSize, callback, batchCallback);
+            }
+        );
 
-        // Load the meshes
-        for (size_t i = 0; i < infoOut.count; i++)
+        // Bake every imported mesh for the next launch (also the ones that do not fit into gpu memory now)
+        if (useCache)
         {
-            const aiMesh* asMesh = asScene->mMeshes[i];
+            BakeModel(candidates, cachePath.c_str(), cacheKey);
+        }
 
-            // Get global count
-            size_t indexCount = 0, vertexCount = 0;
-            vertexCount = asMesh->mNumVertices;
-            for (size_t i = 0; i < asMesh->mNumFaces; i++)
-                indexCount += asMesh->mFaces->mNumIndices;
+        // Allocate gpu memory (or share identical meshes) and upload reservations in mesh order (uploader and buffer are not thread safe)
+        std::vector<MeshImportJob> jobs;
+        jobs.reserve(candidates.size());
+        for (auto& job : candidates)
+        {
+            if (AllocateMesh(job))
+            {
+                ReserveMesh(job, uploader);
+                ReportMesh(job, options);
+                jobs.push_back(std::move(job));
+            }
+        }
 
-            // Compute required size
-            size_t memorySizeVertices = vertexSize * vertexCount;
-            size_t memorySizeIndices = sizeof(unsigned int) * indexCount;
+        // Fan the upload copies out to the workers
+        m_importWorkers.ParallelFor(jobs.size(), [&](size_t idx)
+            {
+                UploadMesh(jobs[idx]);
+            }
+        );
 
-            // Allocate memory buffers on gpu buffer
-            ModelPartView vertexPart, indexPart;
-            if (
-                m_geometryDataBuffer.Alloc(memorySizeVertices, &vertexPart) &&
-                m_geometryDataBuffer.Alloc(memorySizeIndices, &indexPart)
-                )
+        // Commit uploads in mesh order
+        for (auto& job : jobs)
+        {
+            CommitMesh(job, uploader);
+        }
+
+        // Blobs larger than the free upload memory go out in chunks (only meshes that got memory and were uploaded are part of the model)
+        infoOut.count = StreamModel(jobs, infoOut.idx, uploader);
+    }
+
+    return infoOut;
+}
+
+RTR::ModelStreamHandle RTR::ModelContext::LoadModelAsync(const char* filePath, size_t vertexSize, FModelVertexCallback callback, UINT64 vertexLayout, const ModelImportOptions& options)
+{
+    return LoadModelAsyncInternal(filePath, vertexSize, callback, nullptr, vertexLayout, options);
+}
+
+RTR::ModelStreamHandle RTR::ModelContext::LoadModelAsyncInternal(const char* filePath, size_t vertexSize, FModelVertexCallback callback, FModelVertexBatchCallback batchCallback, UINT64 vertexLayout, const ModelImportOptions& options)
+{
+    // Describe the request
+    auto request = std::make_shared<StreamRequest>();
+    request->handle = ++m_lastStreamHandle;
+    request->filePath = filePath;
+    request->vertexSize = options.quantizeVertices ? sizeof(QuantizedVertex) : vertexSize;
+    request->callback = callback;
+    request->batchCallback = batchCallback;
+    request->vertexLayout = vertexLayout;
+    request->options = options;
+    m_streams.emplace(request->handle, request);
+
+    // Hand it to the background importer
+    {
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        m_streamQueue.push_back(request);
+    }
+    m_streamCv.notify_one();
+
+    return request->handle;
+}
+
+RTR::ModelStreamStats RTR::ModelContext::UpdateStreaming(IModelStreamUploader& uploader, const ModelStreamBudget& budget)
+{
+    for (auto& entry : m_streams)
+    {
+        // Imported: allocate all meshes at once (sets of a model are contiguous) and queue their blobs
+        StreamRequest& request = *entry.second;
+        if (request.state == ModelStreamState::Uploading && !request.allocated)
+        {
+            request.allocated = true;
+            request.info.idx = m_sets.size();
+            for (auto& job : request.jobs)
             {
-                // Create set
-                MeshInfo set;
-                set.name = asMesh->mName.C_Str();
-                set.vertexBuffer = vertexPart;
-                set.indexBuffer = indexPart;
-                set.indexCount = indexCount;
-
-                // Upload vertex data
-                unsigned char* vertexData = (unsigned char*)uploader.ReserverUploadMemory(memorySizeVertices);
-                if (vertexData)
+                if (AllocateMesh(job))
                 {
-                    size_t offset = 0;
-                    for (size_t i = 0; i < asMesh->mNumVertices; i++)
+                    // Shared meshes wait for the model that uploads them
+                    SharedMesh* ptrShared = m_sharedMeshes.Find(job.contentHash);
+                    if (job.isShared)
                     {
-                        // Set this be handled by the callback
-                        callback(&vertexData[offset], i, asMesh);
-                        offset += vertexSize;
+                        request.dependencies.push_back(ptrShared->uploadOwner);
                     }
-
-                    // Commit upload
-                    uploader.CommitBufferCopy(vertexData, memorySizeVertices, vertexPart.ptrBuffer->Get(), vertexPart.Offset);
-                }
-
-                // Upload index data
-                unsigned char* indexData = (unsigned char*)uploader.ReserverUploadMemory(memorySizeIndices);
-                if (indexData)
-                {
-                    // Copy all faces
-                    size_t offset = 0;
-                    for (size_t i = 0; i < asMesh->mNumFaces; i++)
+                    else
                     {
-                        size_t copySize = sizeof(unsigned int) * asMesh->mFaces[i].mNumIndices;
-                        memcpy(&indexData[offset], asMesh->mFaces[i].mIndices, copySize);
-                        offset += copySize;
+                        if (ptrShared)
+                            ptrShared->uploadOwner = request.handle;
+                        for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+                        {
+                            if (MeshCacheBlobOnGpu((MeshCacheBlob)b))
+                                m_streamer.Enqueue(request.handle, job.blobData[b], job.blobBytes[b], job.blobPart[b].ptrBuffer->Get(), job.blobPart[b].Offset);
+                        }
                     }
-
-                    // Commit upload
-                    uploader.CommitBufferCopy(indexData, memorySizeIndices, indexPart.ptrBuffer->Get(), indexPart.Offset);
+                    request.info.count++;
                 }
-
-                // Store set
-                m_sets.push_back(std::move(set));
             }
         }
     }
 
-    return infoOut;
+    // Issue copies within the budget
+    ModelStreamStats stats = m_streamer.Update(uploader, budget);
+
+    // Models are resident once their last copy finished
+    for (auto& entry : m_streams)
+    {
+        StreamRequest& request = *entry.second;
+        if (request.state == ModelStreamState::Uploading && request.allocated && m_streamer.IsComplete(request.handle, uploader) &&
+            std::all_of(request.dependencies.begin(), request.dependencies.end(), [&](ModelStreamHandle owner) { return m_streamer.IsComplete(owner, uploader); }))
+        {
+            // CPU data is no longer required
+            request.jobs.clear();
+            request.jobs.shrink_to_fit();
+            request.cache.reset();
+            request.state = request.info.count ? ModelStreamState::Ready : ModelStreamState::Failed;
+        }
+    }
+
+    return stats;
+}
+
+RTR::ModelStreamState RTR::ModelContext::GetModelStreamState(ModelStreamHandle handle)
+{
+    auto it = m_streams.find(handle);
+    return it != m_streams.end() ? it->second->state.load() : ModelStreamState::Failed;
+}
+
+bool RTR::ModelContext::IsModelReady(ModelStreamHandle handle, ModelInfo* ptrInfoOut)
+{
+    auto it = m_streams.find(handle);
+    const bool ready = it != m_streams.end() && it->second->state == ModelStreamState::Ready;
+    if (ready && ptrInfoOut)
+        *ptrInfoOut = it->second->info;
+    return ready;
+}
+
+void RTR::ModelContext::UnloadModel(ModelInfo& modelInfo)
+{
+    for (size_t i = 0; i < modelInfo.count; i++)
+    {
+        // Keep the slot so other models keep their indices
+        MeshInfo& set = m_sets[modelInfo.idx + i];
+        ReleaseSet(set);
+        set = MeshInfo();
+    }
+
+    modelInfo.count = 0;
+}
+
+void RTR::ModelContext::ReleaseSet(MeshInfo& set)
+{
+    // Release every allocated part with the last user of shared data (levels of detail are views into lodIndexBuffer)
+    if (m_sharedMeshes.Release(set.contentHash))
+    {
+        const ModelPartView* parts[] = { &set.vertexBuffer, &set.indexBuffer, &set.lodIndexBuffer,
+            &set.meshletBuffer, &set.meshletBoundsBuffer, &set.meshletVertexBuffer, &set.meshletPrimitiveBuffer };
+        for (const ModelPartView* ptrPart : parts)
+            m_geometryDataBuffer.Free(*ptrPart);
+        m_defragmentPending = true;
+    }
+}
+
+UINT64 RTR::ModelContext::Defragment(D3DCommandList& cmdList, UINT64 maxBytes)
+{
+    // Streamed copies target fixed offsets
+    if (m_streamer.GetPendingCopyCount())
+        return 0;
+    for (auto& entry : m_streams)
+    {
+        if (entry.second->state == ModelStreamState::Uploading)
+            return 0;
+    }
+
+    // Move the highest allocations to lower free blocks
+    struct Move
+    {
+        UINT64 from, to, size, staged;
+    };
+    std::vector<Move> moves;
+    UINT64 stagedBytes = 0;
+    TlsfAllocator& allocator = m_geometryDataBuffer.GetAllocator();
+    std::vector<TlsfAllocator::Allocation> allocations;
+    allocator.GetAllocations(allocations);
+    for (auto it = allocations.rbegin(); it != allocations.rend(); it++)
+    {
+        UINT64 newOffset;
+        if (stagedBytes + it->size <= maxBytes && allocator.Relocate(it->offset, &newOffset))
+        {
+            moves.push_back({ it->offset, newOffset, it->size, stagedBytes });
+            stagedBytes += it->size;
+        }
+    }
+    if (moves.empty())
+    {
+        // Nothing moves until more memory is freed
+        m_defragmentPending = false;
+        return 0;
+    }
+
+    // Staging buffer (the regions of one buffer can not be source and destination in the same state).
+    // A smaller one was last used by the previous call, whose list has been submitted by now, so it lives until the queue passed that submission.
+    D3DQueue& queue = cmdList.GetQueue();
+    m_retiredDefragStaging.erase(
+        std::remove_if(m_retiredDefragStaging.begin(), m_retiredDefragStaging.end(), [&](const RetiredStaging& retired) { return queue.IsFinished(retired.fenceValue); }),
+        m_retiredDefragStaging.end()
+    );
+    if (!m_defragStaging || m_defragStaging->GetAllocator().GetSize() < maxBytes)
+    {
+        if (m_defragStaging)
+            m_retiredDefragStaging.push_back({ queue.GetLastSignaledValue(), std::move(m_defragStaging) });
+        m_defragStaging = std::make_unique<ModelBuffer>(maxBytes);
+    }
+    ID3D12GraphicsCommandList* ptrCmdList = (ID3D12GraphicsCommandList*)cmdList;
+
+    // Old ranges to staging
+    m_geometryDataBuffer.EnsureResourceState(cmdList, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    m_defragStaging->EnsureResourceState(cmdList, D3D12_RESOURCE_STATE_COPY_DEST);
+    cmdList.ResourceBarrierFlush();
+    for (const auto& move : moves)
+        ptrCmdList->CopyBufferRegion(m_defragStaging->Get(), move.staged, m_geometryDataBuffer.Get(), move.from, move.size);
+
+    // Staging to new ranges
+    m_geometryDataBuffer.EnsureResourceState(cmdList, D3D12_RESOURCE_STATE_COPY_DEST);
+    m_defragStaging->EnsureResourceState(cmdList, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    cmdList.ResourceBarrierFlush();
+    for (const auto& move : moves)
+        ptrCmdList->CopyBufferRegion(m_geometryDataBuffer.Get(), move.to, m_defragStaging->Get(), move.staged, move.size);
+
+    // Back to implicit promotion
+    m_geometryDataBuffer.EnsureResourceState(cmdList, D3D12_RESOURCE_STATE_COMMON);
+    m_defragStaging->EnsureResourceState(cmdList, D3D12_RESOURCE_STATE_COMMON);
+    cmdList.ResourceBarrierFlush();
+
+    // Release the old ranges and patch every view that lies inside a moved range
+    std::sort(moves.begin(), moves.end(), [](const Move& a, const Move& b) { return a.from < b.from; });
+    for (const auto& move : moves)
+        allocator.Free(move.from);
+    auto patch = [&](ModelPartView& view)
+    {
+        if (!view.Size || view.ptrBuffer != &m_geometryDataBuffer)
+            return;
+        auto it = std::upper_bound(moves.begin(), moves.end(), view.Offset, [](UINT64 offset, const Move& move) { return offset < move.from; });
+        if (it == moves.begin())
+            return;
+        const Move& move = *(it - 1);
+        if (view.Offset < move.from + move.size)
+            view.Offset = view.Offset - move.from + move.to;
+    };
+    for (auto& set : m_sets)
+    {
+        patch(set.vertexBuffer);
+        patch(set.indexBuffer);
+        patch(set.lodIndexBuffer);
+        patch(set.meshletBuffer);
+        patch(set.meshletBoundsBuffer);
+        patch(set.meshletVertexBuffer);
+        patch(set.meshletPrimitiveBuffer);
+        for (auto& lod : set.lods)
+            patch(lod.indexBuffer);
+    }
+    m_sharedMeshes.ForEach([&](SharedMesh& shared)
+        {
+            for (auto& part : shared.parts)
+                patch(part);
+        }
+    );
+
+    return stagedBytes;
+}
+
+bool RTR::ModelContext::NeedsDefragment(double fragmentationThreshold) const
+{
+    return m_defragmentPending && m_geometryDataBuffer.GetAllocator().GetFragmentation() > fragmentationThreshold;
 }
 
 RTR::MeshInfo RTR::ModelContext::GetMeshInfo(ModelInfo& modelInfo, size_t idx)
@@ -101,3 +396,647 @@ RTR::MeshInfo RTR::ModelContext::GetMeshInfo(ModelInfo& modelInfo, size_t idx)
         throw std::exception("Mesh index out of bounds");
     return m_sets[modelInfo.idx + idx];
 }
+
+void RTR::ModelContext::StreamThreadMain()
+{
+    while (true)
+    {
+        // Wait for the next request
+        std::shared_ptr<StreamRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(m_streamMutex);
+            m_streamCv.wait(lock, [this]() { return m_streamShutdown || !m_streamQueue.empty(); });
+            if (m_streamShutdown)
+                return;
+
+            request = std::move(m_streamQueue.front());
+            m_streamQueue.pop_front();
+        }
+
+        // Import into CPU memory (the render thread picks it up in UpdateStreaming)
+        request->state = ImportModel(*request) ? ModelStreamState::Uploading : ModelStreamState::Failed;
+    }
+}
+
+bool RTR::ModelContext::ImportModel(StreamRequest& request)
+{
+    // Try the baked mesh cache first (blobs are uploaded straight from the mapping)
+    MeshCacheKey cacheKey;
+    std::string cachePath = request.filePath + RTR_MESH_CACHE_EXTENSION;
+    const bool useCache = MakeCacheKey(request.filePath.c_str(), request.vertexSize, request.vertexLayout, request.options, &cacheKey);
+    if (useCache)
+    {
+        request.cache = std::make_unique<MeshCacheFile>();
+        if (OpenCache(*request.cache, request.filePath.c_str(), cachePath.c_str(), cacheKey))
+        {
+            LoadJobsFromCache(*request.cache, request.jobs);
+            return true;
+        }
+        request.cache.reset();
+    }
+
+    // Open an assimp scene
+    Assimp::Importer asImport;
+    const aiScene* asScene = asImport.ReadFile(request.filePath.c_str(), RTR_MODEL_IMPORT_FLAGS);
+    if (!asScene)
+        return false;
+
+    // Prepare and assemble every mesh into CPU memory
+    request.jobs.resize(asScene->mNumMeshes);
+    m_importWorkers.ParallelFor(request.jobs.size(), [&](size_t idx)
+        {
+            MeshImportJob& job = request.jobs[idx];
+            job.ptrMesh = asScene->mMeshes[idx];
+            PrepareMesh(job, request.options);
+            AssembleMesh(job, request.vertexSize, request.callback, request.batchCallback);
+
+            // The scene dies with the importer
+            job.ptrMesh = nullptr;
+        }
+    );
+    for (auto& job : request.jobs)
+    {
+        ReportMesh(job, request.options);
+    }
+
+    // Bake for the next launch
+    if (useCache)
+    {
+        BakeModel(request.jobs, cachePath.c_str(), cacheKey);
+    }
+
+    return true;
+}
+
+bool RTR::ModelContext::MakeCacheKey(const char* filePath, size_t vertexSize, UINT64 vertexLayout, const ModelImportOptions& options, MeshCacheKey* ptrKeyOut)
+{
+    const bool useCache = vertexLayout && MeshCacheFile::StampSourceFile(filePath, ptrKeyOut);
+    if (useCache)
+    {
+        ptrKeyOut->vertexLayout = vertexLayout;
+        ptrKeyOut->importOptions = options.Hash();
+        ptrKeyOut->importFlags = RTR_MODEL_IMPORT_FLAGS;
+        ptrKeyOut->vertexSize = (UINT)vertexSize;
+    }
+
+    return useCache;
+}
+
+bool RTR::ModelContext::OpenCache(MeshCacheFile& cache, const char* filePath, const char* cachePath, MeshCacheKey& key)
+{
+    // Unchanged size and write time: the source is not read at all
+    if (cache.Open(cachePath, key))
+        return true;
+
+    // Otherwise hash the content (a touched or copied source may still match)
+    if (!MeshCacheFile::HashSourceFile(filePath, &key.sourceHash) || !cache.Open(cachePath, key))
+        return false;
+
+    // Same content: store the new stamp so the next launch skips the hash again
+    cache.Close();
+    MeshCacheFile::RestampFile(cachePath, key);
+    return cache.Open(cachePath, key);
+}
+
+void RTR::ModelContext::BakeModel(const std::vector<MeshImportJob>& jobs, const char* cachePath, const MeshCacheKey& cacheKey)
+{
+    MeshCacheWriter writer;
+    for (auto& job : jobs)
+    {
+        MeshCacheMeshDesc desc;
+        desc.name = job.name.c_str();
+        desc.vertexCount = (UINT)job.vertexCount;
+        desc.indexCount = (UINT)job.indexCount;
+        desc.meshletCount = (UINT)job.meshletCount;
+        desc.indexSize = job.indexSize;
+        desc.dequantization = job.dequantization;
+        desc.bounds = job.bounds;
+        desc.contentHash = job.contentHash;
+        desc.contentCheck = job.contentCheck;
+        for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+        {
+            desc.blobData[b] = job.blobData[b];
+            desc.blobBytes[b] = job.blobBytes[b];
+        }
+        desc.cacheStatsBefore = job.cacheStatsBefore;
+        desc.cacheStatsAfter = job.cacheStatsAfter;
+        writer.AddMesh(desc);
+    }
+    writer.Write(cachePath, cacheKey);
+}
+
+void RTR::ModelContext::ReportMesh(const MeshImportJob& job, const ModelImportOptions& options)
+{
+    // Report optimization
+    #ifdef _DEBUG
+    if (options.optimizeIndices || options.buildMeshlets || options.lodCount > 1)
+    {
+        char report[512];
+        snprintf(report, sizeof(report), "Mesh \"%s\": ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %zu meshlets, %zu lods\n", job.name.c_str(),
+            job.cacheStatsBefore.acmr, job.cacheStatsAfter.acmr, job.cacheStatsBefore.atvr, job.cacheStatsAfter.atvr, job.meshletCount, job.lods.size() + 1
+        );
+        OutputDebugStringA(report);
+    }
+    #endif
+}
+
+void RTR::ModelContext::LoadJobsFromCache(const MeshCacheFile& cache, std::vector<MeshImportJob>& jobsOut)
+{
+    jobsOut.resize(cache.GetMeshCount());
+    for (UINT i = 0; i < cache.GetMeshCount(); i++)
+    {
+        const MeshCacheEntry& entry = cache.GetEntry(i);
+
+        // All blobs come straight from the mapping
+        MeshImportJob& job = jobsOut[i];
+        job.name = cache.GetName(i);
+        job.vertexCount = entry.vertexCount;
+        job.indexCount = entry.indexCount;
+        job.cacheStatsBefore = entry.cacheStatsBefore;
+        job.cacheStatsAfter = entry.cacheStatsAfter;
+        job.meshletCount = entry.meshletCount;
+        job.indexSize = entry.indexSize;
+        job.dequantization = entry.dequantization;
+        job.bounds = entry.bounds;
+        for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+        {
+            job.blobData[b] = cache.GetBlob(i, (MeshCacheBlob)b);
+            job.blobBytes[b] = cache.GetBlobSize(i, (MeshCacheBlob)b);
+        }
+        job.contentHash = entry.contentHash;
+        job.contentCheck = entry.contentCheck;
+        if (!job.contentHash)
+            job.contentHash = HashMeshContent(job, &job.contentCheck);
+    }
+}
+
+RTR::ModelInfo RTR::ModelContext::LoadModelFromCache(const MeshCacheFile& cache, D3DUploadBuffer& uploader)
+{
+    ModelInfo infoOut;
+    infoOut.idx = m_sets.size();
+    infoOut.count = 0;
+
+    // Allocate and reserve in mesh order
+    std::vector<MeshImportJob> candidates;
+    LoadJobsFromCache(cache, candidates);
+    std::vector<MeshImportJob> jobs;
+    for (auto& job : candidates)
+    {
+        if (AllocateMesh(job))
+        {
+            ReserveMesh(job, uploader);
+            jobs.push_back(std::move(job));
+        }
+    }
+
+    // Copy blobs from the mapping
+    m_importWorkers.ParallelFor(jobs.size(), [&](size_t idx)
+        {
+            UploadMesh(jobs[idx]);
+        }
+    );
+
+    // Commit uploads in mesh order
+    for (auto& job : jobs)
+    {
+        CommitMesh(job, uploader);
+    }
+
+    // Blobs larger than the free upload memory go out in chunks
+    infoOut.count = StreamModel(jobs, infoOut.idx, uploader);
+    return infoOut;
+}
+
+bool RTR::ModelContext::AllocateMesh(MeshImportJob& job)
+{
+    // Identical meshes share their gpu memory
+    MeshShareKey shareKey;
+    shareKey.contentHash = job.contentHash;
+    shareKey.contentCheck = job.contentCheck;
+    shareKey.vertexCount = job.vertexCount;
+    shareKey.indexCount = job.indexCount;
+    shareKey.meshletCount = job.meshletCount;
+    shareKey.indexSize = job.indexSize;
+    for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+        shareKey.blobBytes[b] = job.blobBytes[b];
+    bool collision = false;
+    if (const SharedMesh* ptrShared = m_sharedMeshes.Acquire(shareKey, &collision))
+    {
+        for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+            job.blobPart[b] = ptrShared->parts[b];
+        job.isShared = true;
+    }
+    else
+    {
+        // Colliding meshes stay unshared (hash 0 also keeps UnloadModel away from the other entry)
+        if (collision)
+            job.contentHash = 0;
+
+        // Vertices start at a multiple of their stride (and of 4 for the view)
+        UINT64 vertexAlignment = job.vertexCount ? job.blobBytes[(UINT)MeshCacheBlob::Vertices] / job.vertexCount : 4;
+        if (vertexAlignment % 4)
+            vertexAlignment *= vertexAlignment % 2 ? 4 : 2;
+
+        // Allocate memory buffers on gpu buffer (empty blobs get an empty view)
+        for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+        {
+            if (MeshCacheBlobOnGpu((MeshCacheBlob)b) && !m_geometryDataBuffer.Alloc(job.blobBytes[b], &job.blobPart[b], b == (UINT)MeshCacheBlob::Vertices ? vertexAlignment : 4))
+            {
+                // Roll back the blobs that got memory
+                for (UINT r = 0; r < b; r++)
+                {
+                    if (MeshCacheBlobOnGpu((MeshCacheBlob)r))
+                        m_geometryDataBuffer.Free(job.blobPart[r]);
+                }
+                return false;
+            }
+        }
+
+        // Register for sharing
+        if (job.contentHash)
+        {
+            SharedMesh& shared = m_sharedMeshes.Insert(shareKey);
+            for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+                shared.parts[b] = job.blobPart[b];
+        }
+    }
+
+    // Create set
+    MeshInfo set;
+    set.name = job.name;
+    set.contentHash = job.contentHash;
+    set.vertexBuffer = job.blobPart[(UINT)MeshCacheBlob::Vertices];
+    set.indexBuffer = job.blobPart[(UINT)MeshCacheBlob::Indices];
+    set.indexCount = (UINT)job.indexCount;
+    set.indexSize = job.indexSize;
+    set.vertexStride = job.vertexCount ? (UINT)(job.blobBytes[(UINT)MeshCacheBlob::Vertices] / job.vertexCount) : 0;
+    set.dequantization = job.dequantization;
+    set.bounds = job.bounds;
+    set.cacheStatsBefore = job.cacheStatsBefore;
+    set.cacheStatsAfter = job.cacheStatsAfter;
+    set.meshletBuffer = job.blobPart[(UINT)MeshCacheBlob::Meshlets];
+    set.meshletBoundsBuffer = job.blobPart[(UINT)MeshCacheBlob::MeshletBounds];
+    set.meshletVertexBuffer = job.blobPart[(UINT)MeshCacheBlob::MeshletVertices];
+    set.meshletPrimitiveBuffer = job.blobPart[(UINT)MeshCacheBlob::MeshletPrimitives];
+    set.meshletCount = (UINT)job.meshletCount;
+    set.lodIndexBuffer = job.blobPart[(UINT)MeshCacheBlob::LodIndices];
+
+    // Levels of detail (the imported mesh is the finest one)
+    const MeshLodRange* ptrLods = (const MeshLodRange*)job.blobData[(UINT)MeshCacheBlob::Lods];
+    const ModelPartView& lodPart = job.blobPart[(UINT)MeshCacheBlob::LodIndices];
+    set.lods.push_back({ set.indexBuffer, set.indexCount, 0.0f });
+    for (size_t l = 0; l < job.blobBytes[(UINT)MeshCacheBlob::Lods] / sizeof(MeshLodRange); l++)
+    {
+        MeshLod lod;
+        lod.indexBuffer.ptrBuffer = lodPart.ptrBuffer;
+        lod.indexBuffer.Offset = lodPart.Offset + (UINT64)job.indexSize * ptrLods[l].indexOffset;
+        lod.indexBuffer.Size = (UINT64)job.indexSize * ptrLods[l].indexCount;
+        lod.indexCount = ptrLods[l].indexCount;
+        lod.error = ptrLods[l].error;
+        set.lods.push_back(lod);
+    }
+
+    m_sets.push_back(std::move(set));
+
+    return true;
+}
+
+void RTR::ModelContext::ReserveMesh(MeshImportJob& job, D3DUploadBuffer& uploader)
+{
+    // Shared meshes are already uploaded
+    if (job.isShared)
+        return;
+
+    for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+    {
+        if (MeshCacheBlobOnGpu((MeshCacheBlob)b) && job.blobBytes[b])
+            job.ptrBlobUpload[b] = (unsigned char*)uploader.ReserverUploadMemory(job.blobBytes[b]);
+    }
+}
+
+void RTR::ModelContext::CommitMesh(MeshImportJob& job, D3DUploadBuffer& uploader)
+{
+    for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+    {
+        if (job.ptrBlobUpload[b])
+            uploader.CommitBufferCopy(job.ptrBlobUpload[b], job.blobBytes[b], job.blobPart[b].ptrBuffer->Get(), job.blobPart[b].Offset);
+    }
+}
+
+bool RTR::ModelContext::StreamMesh(MeshImportJob& job, D3DUploadBuffer& uploader)
+{
+    if (job.isShared)
+        return true;
+
+    for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+    {
+        if (MeshCacheBlobOnGpu((MeshCacheBlob)b) && job.blobBytes[b] && !job.ptrBlobUpload[b])
+        {
+            const unsigned char* ptrSource = (const unsigned char*)job.blobData[b];
+            const bool streamed = uploader.StreamBufferData(job.blobBytes[b], [&](void* ptrChunk, UINT64 offset, UINT64 size)
+                {
+                    StreamCopyParallel(m_importWorkers, ptrChunk, ptrSource + offset, (size_t)size);
+                    return true;
+                },
+                job.blobPart[b].ptrBuffer->Get(), job.blobPart[b].Offset
+            );
+            if (!streamed)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+size_t RTR::ModelContext::StreamModel(std::vector<MeshImportJob>& jobs, size_t firstSet, D3DUploadBuffer& uploader)
+{
+    // Stream every mesh, remember the shared memory that never got its data
+    std::vector<bool> failed(jobs.size(), false);
+    std::unordered_set<UINT64> failedContent;
+    bool anyFailed = false;
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        if (!StreamMesh(jobs[i], uploader))
+        {
+            failed[i] = anyFailed = true;
+            if (jobs[i].contentHash)
+                failedContent.insert(jobs[i].contentHash);
+        }
+    }
+    if (!anyFailed)
+        return jobs.size();
+
+    // Meshes sharing a failed upload have no data either (the upload owner is always a mesh of this model)
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        if (jobs[i].isShared && failedContent.count(jobs[i].contentHash))
+            failed[i] = true;
+    }
+
+    // Release the failed meshes and close the gap in the sets of this model (copies already recorded for their memory
+    // execute before any later upload to it)
+    size_t kept = 0;
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        if (failed[i])
+        {
+            ReleaseSet(m_sets[firstSet + i]);
+            continue;
+        }
+        if (kept != i)
+            m_sets[firstSet + kept] = std::move(m_sets[firstSet + i]);
+        kept++;
+    }
+    m_sets.resize(firstSet + kept);
+
+    return kept;
+}
+
+void RTR::ModelContext::PrepareMesh(MeshImportJob& job, const ModelImportOptions& options)
+{
+    const aiMesh* asMesh = job.ptrMesh;
+    job.name = asMesh->mName.C_Str();
+    job.vertexCount = asMesh->mNumVertices;
+
+    // Gather all faces
+    for (size_t i = 0; i < asMesh->mNumFaces; i++)
+        job.indexCount += asMesh->mFaces[i].mNumIndices;
+    job.indices.resize(job.indexCount);
+    size_t offset = 0;
+    for (size_t i = 0; i < asMesh->mNumFaces; i++)
+    {
+        memcpy(&job.indices[offset], asMesh->mFaces[i].mIndices, sizeof(unsigned int) * asMesh->mFaces[i].mNumIndices);
+        offset += asMesh->mFaces[i].mNumIndices;
+    }
+
+    // Optimizations and meshlets work on triangle lists only
+    const bool isTriangleList = asMesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE && job.indexCount && job.vertexCount;
+    if (options.optimizeIndices && isTriangleList)
+    {
+        job.cacheStatsBefore = MeshAnalyzeVertexCache(job.indices.data(), job.indexCount, job.vertexCount, options.vertexCacheSize);
+
+        // Post transform cache
+        std::vector<unsigned int> optimized(job.indexCount);
+        std::vector<uint32_t> clusters;
+        MeshOptimizeVertexCache(optimized.data(), job.indices.data(), job.indexCount, job.vertexCount, options.vertexCacheSize, &clusters);
+
+        // Overdraw
+        MeshOptimizeOverdraw(optimized.data(), optimized.data(), job.indexCount, &asMesh->mVertices[0].x, sizeof(aiVector3D), job.vertexCount,
+            clusters, options.vertexCacheSize, options.overdrawThreshold);
+
+        // Vertex fetch
+        job.vertexRemap.resize(job.vertexCount);
+        MeshOptimizeVertexFetch(job.vertexRemap.data(), optimized.data(), job.indexCount, job.vertexCount);
+
+        job.indices = std::move(optimized);
+        job.cacheStatsAfter = MeshAnalyzeVertexCache(job.indices.data(), job.indexCount, job.vertexCount, options.vertexCacheSize);
+    }
+
+    // Meshlets and levels of detail index the output vertex order
+    const bool buildLods = options.lodCount > 1;
+    if ((options.buildMeshlets || buildLods) && isTriangleList)
+    {
+        std::vector<aiVector3D> remappedPositions;
+        const aiVector3D* ptrPositions = asMesh->mVertices;
+        if (!job.vertexRemap.empty())
+        {
+            remappedPositions.resize(job.vertexCount);
+            for (size_t i = 0; i < job.vertexCount; i++)
+                remappedPositions[i] = asMesh->mVertices[job.vertexRemap[i]];
+            ptrPositions = remappedPositions.data();
+        }
+
+        if (options.buildMeshlets)
+        {
+            MeshBuildMeshlets(job.meshlets, job.indices.data(), job.indexCount, &ptrPositions[0].x, sizeof(aiVector3D), job.vertexCount,
+                options.meshletMaxVertices, options.meshletMaxPrimitives);
+            job.meshletCount = job.meshlets.meshlets.size();
+        }
+
+        if (buildLods)
+        {
+            BuildLods(job, options, &ptrPositions[0].x, sizeof(aiVector3D));
+        }
+    }
+
+    // Culling bounds
+    if (job.vertexCount)
+    {
+        job.bounds = ComputeMeshBounds(&asMesh->mVertices[0].x, sizeof(aiVector3D), job.vertexCount);
+    }
+
+    // Quantization bounds
+    job.quantizeVertices = options.quantizeVertices;
+    if (options.quantizeVertices && job.vertexCount)
+    {
+        job.dequantization = ComputeVertexDequantization(&asMesh->mVertices[0].x, sizeof(aiVector3D), job.vertexCount);
+    }
+
+    // CPU side blobs
+    if (options.shortIndices && ShortIndicesFit(job.vertexCount))
+    {
+        job.indexSize = sizeof(uint16_t);
+        job.shortIndices.assign(job.indices.begin(), job.indices.end());
+        job.shortLodIndices.assign(job.lodIndices.begin(), job.lodIndices.end());
+        job.blobData[(UINT)MeshCacheBlob::Indices] = job.shortIndices.data();
+        job.blobData[(UINT)MeshCacheBlob::LodIndices] = job.shortLodIndices.data();
+    }
+    else
+    {
+        job.blobData[(UINT)MeshCacheBlob::Indices] = job.indices.data();
+        job.blobData[(UINT)MeshCacheBlob::LodIndices] = job.lodIndices.data();
+    }
+    job.blobBytes[(UINT)MeshCacheBlob::Indices] = (UINT64)job.indexSize * job.indexCount;
+    job.blobBytes[(UINT)MeshCacheBlob::LodIndices] = (UINT64)job.indexSize * job.lodIndices.size();
+    job.blobData[(UINT)MeshCacheBlob::Meshlets] = job.meshlets.meshlets.data();
+    job.blobBytes[(UINT)MeshCacheBlob::Meshlets] = sizeof(Meshlet) * job.meshlets.meshlets.size();
+    job.blobData[(UINT)MeshCacheBlob::MeshletBounds] = job.meshlets.bounds.data();
+    job.blobBytes[(UINT)MeshCacheBlob::MeshletBounds] = sizeof(MeshletBounds) * job.meshlets.bounds.size();
+    job.blobData[(UINT)MeshCacheBlob::MeshletVertices] = job.meshlets.vertices.data();
+    job.blobBytes[(UINT)MeshCacheBlob::MeshletVertices] = sizeof(uint32_t) * job.meshlets.vertices.size();
+    job.blobData[(UINT)MeshCacheBlob::MeshletPrimitives] = job.meshlets.primitives.data();
+    job.blobBytes[(UINT)MeshCacheBlob::MeshletPrimitives] = sizeof(uint32_t) * job.meshlets.primitives.size();
+    job.blobData[(UINT)MeshCacheBlob::Lods] = job.lods.data();
+    job.blobBytes[(UINT)MeshCacheBlob::Lods] = sizeof(MeshLodRange) * job.lods.size();
+}
+
+void RTR::ModelContext::BuildLods(MeshImportJob& job, const ModelImportOptions& options, const float* positions, size_t positionStride)
+{
+    const aiMesh* asMesh = job.ptrMesh;
+
+    // Attributes that should survive simplification (in output vertex order)
+    std::vector<float> attributes;
+    std::vector<float> attributeWeights;
+    if (asMesh->HasNormals())
+        attributeWeights.insert(attributeWeights.end(), 3, options.lodNormalWeight);
+    if (asMesh->HasTextureCoords(0))
+        attributeWeights.insert(attributeWeights.end(), 2, options.lodUvWeight);
+    const size_t attributeCount = attributeWeights.size();
+    if (attributeCount)
+    {
+        attributes.resize(job.vertexCount * attributeCount);
+        for (size_t i = 0; i < job.vertexCount; i++)
+        {
+            const size_t source = job.vertexRemap.empty() ? i : job.vertexRemap[i];
+            float* ptrAttributes = &attributes[i * attributeCount];
+            if (asMesh->HasNormals())
+            {
+                memcpy(ptrAttributes, &asMesh->mNormals[source], sizeof(float) * 3);
+                ptrAttributes += 3;
+            }
+            if (asMesh->HasTextureCoords(0))
+            {
+                memcpy(ptrAttributes, &asMesh->mTextureCoords[0][source], sizeof(float) * 2);
+            }
+        }
+    }
+
+    // Every level is simplified from the previous one, so errors add up
+    const float maxError = options.lodMaxError * MeshComputeExtent(positions, positionStride, job.vertexCount);
+    std::vector<unsigned int> source = job.indices;
+    std::vector<unsigned int> simplified(source.size());
+    float error = 0.0f;
+    for (unsigned int level = 1; level < options.lodCount; level++)
+    {
+        const size_t targetIndexCount = (size_t)(source.size() * options.lodReduction) / 3 * 3;
+        float levelError = 0.0f;
+        const size_t indexCount = MeshSimplify(simplified.data(), source.data(), source.size(), positions, positionStride, job.vertexCount,
+            attributeCount ? attributes.data() : nullptr, sizeof(float) * attributeCount, attributeWeights.data(), attributeCount,
+            targetIndexCount, maxError - error, &levelError);
+
+        // Stop when the error budget does not allow any further reduction
+        if (!indexCount || indexCount >= source.size())
+            break;
+        simplified.resize(indexCount);
+        error += levelError;
+
+        // Keep the post transform cache order (vertices are shared with the finer levels so they can not be reordered)
+        MeshLodRange range;
+        range.indexOffset = (UINT)job.lodIndices.size();
+        range.indexCount = (UINT)indexCount;
+        range.error = error;
+        range.reserved = 0;
+        job.lods.push_back(range);
+
+        job.lodIndices.resize(range.indexOffset + indexCount);
+        if (options.optimizeIndices)
+            MeshOptimizeVertexCache(&job.lodIndices[range.indexOffset], simplified.data(), indexCount, job.vertexCount, options.vertexCacheSize);
+        else
+            memcpy(&job.lodIndices[range.indexOffset], simplified.data(), sizeof(unsigned int) * indexCount);
+
+        source.swap(simplified);
+        simplified.resize(source.size());
+    }
+}
+
+void RTR::ModelContext::AssembleMesh(MeshImportJob& job, size_t vertexSize, FModelVertexCallback callback, FModelVertexBatchCallback batchCallback)
+{
+    // Vertices are assembled into CPU memory (the upload memory is write combined and the data is hashed)
+    job.vertexScratch.resize(vertexSize * job.vertexCount);
+    job.blobData[(UINT)MeshCacheBlob::Vertices] = job.vertexScratch.data();
+    job.blobBytes[(UINT)MeshCacheBlob::Vertices] = job.vertexScratch.size();
+    unsigned char* ptrVertexOut = job.vertexScratch.data();
+
+    if (job.quantizeVertices)
+    {
+        const aiMesh* asMesh = job.ptrMesh;
+        QuantizedVertex* ptrQuantized = (QuantizedVertex*)ptrVertexOut;
+        for (size_t i = 0; i < job.vertexCount; i++)
+        {
+            // Compress in reordered sequence
+            const size_t idx = job.vertexRemap.empty() ? i : job.vertexRemap[i];
+            QuantizeVertex(&ptrQuantized[i], job.dequantization, &asMesh->mVertices[idx].x,
+                asMesh->HasNormals() ? &asMesh->mNormals[idx].x : nullptr,
+                asMesh->HasTangentsAndBitangents() ? &asMesh->mTangents[idx].x : nullptr,
+                asMesh->HasTangentsAndBitangents() ? &asMesh->mBitangents[idx].x : nullptr,
+                asMesh->HasTextureCoords(0) ? &asMesh->mTextureCoords[0][idx].x : nullptr
+            );
+        }
+    }
+    else if (batchCallback)
+    {
+        // One call for the whole mesh (in reordered sequence)
+        batchCallback(ptrVertexOut, job.vertexRemap.empty() ? nullptr : job.vertexRemap.data(), job.vertexCount, job.ptrMesh);
+    }
+    else
+    {
+        size_t offset = 0;
+        for (size_t i = 0; i < job.vertexCount; i++)
+        {
+            // Set this be handled by the callback (in reordered sequence)
+            callback(&ptrVertexOut[offset], job.vertexRemap.empty() ? i : job.vertexRemap[i], job.ptrMesh);
+            offset += vertexSize;
+        }
+    }
+
+    job.contentHash = HashMeshContent(job, &job.contentCheck);
+}
+
+UINT64 RTR::ModelContext::HashMeshContent(const MeshImportJob& job, UINT64* ptrCheckOut)
+{
+    // Every blob with its size (LOD ranges included since they shape the set)
+    UINT64 hash = HashFnv1aValue(job.indexSize);
+    UINT64 check = HashMixWide(&job.indexSize, sizeof(job.indexSize));
+    for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+    {
+        hash = HashFnv1aValue(job.blobBytes[b], hash);
+        if (job.blobBytes[b])
+        {
+            hash = HashFnv1aWide(job.blobData[b], (size_t)job.blobBytes[b], hash);
+            check = HashMixWide(job.blobData[b], (size_t)job.blobBytes[b], check);
+        }
+    }
+    *ptrCheckOut = check;
+
+    // 0 marks unshared meshes
+    return hash ? hash : 1;
+}
+
+void RTR::ModelContext::UploadMesh(MeshImportJob& job)
+{
+    for (UINT b = 0; b < (UINT)MeshCacheBlob::Count; b++)
+    {
+        if (job.ptrBlobUpload[b])
+            StreamCopy(job.ptrBlobUpload[b], job.blobData[b], (size_t)job.blobBytes[b]);
+    }
+}
@@ -1,8 +1,26 @@
 #pragma once
 
 #include <RTR/3DModells/ModelBuffer.h>
+#include <RTR/3DModells/MeshCache.h>
+#include <RTR/3DModells/MeshOptimizer.h>
+#include <RTR/3DModells/MeshletBuilder.h>
+#include <RTR/3DModells/MeshSimplifier.h>
+#include <RTR/3DModells/MeshShareTable.h>
+#include <RTR/3DModells/VertexQuantization.h>
+#include <RTR/3DModells/VertexLayout.h>
+#include <RTR/3DModells/ModelStreamer.h>
+#include <Util/WorkerPool.h>
+#include <Util/StreamCopy.h>
 
 #include <DirectXMath.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <assimp/Importer.hpp>
@@ -11,6 +29,21 @@
 
 namespace RTR
 {
+    // Index range of one level of detail (all levels share the vertex buffer)
+    struct MeshLod
+    {
+        ModelPartView indexBuffer;
+        UINT indexCount;
+        // Geometric error in model units (0 for the imported mesh)
+        float error;
+
+        // First index in the shared index buffer view (see ModelContext::CreateSharedIndexBufferView)
+        inline UINT GetStartIndex(UINT indexSize) const
+        {
+            return indexBuffer.GetFirstElement(indexSize);
+        }
+    };
+
     // Set of vertices and indices
     struct MeshInfo
     {
@@ -18,6 +51,98 @@ namespace RTR
         ModelPartView indexBuffer;
         UINT indexCount;
         std::string name;
+        // Hash of the gpu data (identical meshes share it)
+        UINT64 contentHash = 0;
+
+        // Size of one index (2 or 4, shared by all levels of detail) and of one vertex
+        UINT indexSize = sizeof(unsigned int);
+        UINT vertexStride = 0;
+        // Restores model space positions of QuantizedVertex data
+        VertexDequantization dequantization;
+        // Model space bounds (for culling)
+        MeshBounds bounds;
+
+        // Meshlets for the mesh shader path (empty unless ModelImportOptions::buildMeshlets)
+        ModelPartView meshletBuffer;
+        ModelPartView meshletBoundsBuffer;
+        ModelPartView meshletVertexBuffer;
+        ModelPartView meshletPrimitiveBuffer;
+        UINT meshletCount = 0;
+
+        // Indices of all simplified levels
+        ModelPartView lodIndexBuffer;
+        // Levels of detail from fine to coarse (lods[0] is the imported mesh, lods[1..] are views into lodIndexBuffer)
+        std::vector<MeshLod> lods;
+
+        // Post transform cache efficiency before and after import optimization
+        VertexCacheStats cacheStatsBefore;
+        VertexCacheStats cacheStatsAfter;
+
+        // First vertex in the shared vertex buffer view (see ModelContext::CreateSharedVertexBufferView).
+        // Vertices are placed at a multiple of their stride, so this is exact.
+        inline INT GetBaseVertex() const
+        {
+            return vertexStride ? (INT)vertexBuffer.GetFirstElement(vertexStride) : 0;
+        }
+        // First index of the imported mesh in the shared index buffer view
+        inline UINT GetStartIndex() const
+        {
+            return indexBuffer.GetFirstElement(indexSize);
+        }
+
+        // Coarsest level whose projected error (see MeshProjectError) is at most pixelError, level 0 if none is
+        size_t SelectLod(float distance, float projectionScale, float pixelError) const;
+    };
+
+    // Options for model importing
+    struct ModelImportOptions
+    {
+        // Reorder triangles for the post transform cache and overdraw, then vertices for fetch locality
+        bool optimizeIndices = false;
+        // Size of the simulated post transform cache
+        unsigned int vertexCacheSize = 16;
+        // Soft cluster threshold of the overdraw optimization
+        float overdrawThreshold = 1.05f;
+
+        // Split triangle meshes into meshlets (with culling bounds) for mesh shaders
+        bool buildMeshlets = false;
+        // Meshlet limits (the D3D12 maximum is 256 / 256; 64 / 124 is a good fit for most hardware)
+        unsigned int meshletMaxVertices = 64;
+        unsigned int meshletMaxPrimitives = 124;
+
+        // Write QuantizedVertex data instead of calling the vertex callback
+        bool quantizeVertices = false;
+        // Use 16 bit indices for meshes with up to 65535 vertices (see ShortIndicesFit)
+        bool shortIndices = false;
+
+        // Count of levels of detail including the imported mesh (1: no simplification)
+        unsigned int lodCount = 1;
+        // Index count of every level relative to the previous one
+        float lodReduction = 0.5f;
+        // Largest error of the coarsest level relative to the mesh extent
+        float lodMaxError = 0.05f;
+        // Weights of the normal and first uv channel differences while simplifying
+        float lodNormalWeight = 0.5f;
+        float lodUvWeight = 0.5f;
+
+        // Hash of all options that change the imported data
+        inline UINT64 Hash() const
+        {
+            UINT64 hash = HashFnv1aValue(optimizeIndices);
+            hash = HashFnv1aValue(vertexCacheSize, hash);
+            hash = HashFnv1aValue(overdrawThreshold, hash);
+            hash = HashFnv1aValue(buildMeshlets, hash);
+            hash = HashFnv1aValue(meshletMaxVertices, hash);
+            hash = HashFnv1aValue(meshletMaxPrimitives, hash);
+            hash = HashFnv1aValue(quantizeVertices, hash);
+            hash = HashFnv1aValue(shortIndices, hash);
+            hash = HashFnv1aValue(lodCount, hash);
+            hash = HashFnv1aValue(lodReduction, hash);
+            hash = HashFnv1aValue(lodMaxError, hash);
+            hash = HashFnv1aValue(lodNormalWeight, hash);
+            hash = HashFnv1aValue(lodUvWeight, hash);
+            return hash;
+        }
     };
 
     // Model draw info
@@ -32,24 +157,92 @@ namespace RTR
         }
     };
 
+    // Handle of an asynchronous model load (0 is invalid)
+    typedef UINT64 ModelStreamHandle;
+
+    // Progress of an asynchronous model load
+    enum class ModelStreamState : UINT
+    {
+        // Parsing and converting on the background thread
+        Loading = 0,
+        // Copies are streamed by UpdateStreaming
+        Uploading,
+        // All meshes are resident
+        Ready,
+        // Import failed or no mesh got gpu memory
+        Failed,
+    };
+
     // Callback for vertex creation
     typedef void(*FModelVertexCallback)(void* vtxOut, size_t idx, const aiMesh* ptrMesh);
+    // Callback for the creation of count vertices (vertex i is element remap[i] of the mesh, or i when remap is nullptr)
+    typedef void(*FModelVertexBatchCallback)(void* vtxOut, const unsigned int* remap, size_t count, const aiMesh* ptrMesh);
+
+    // Source streams of an assimp mesh
+    VertexStreams ModelVertexStreams(const aiMesh* ptrMesh);
+
+    // Batch callback that assembles TLayout vertices
+    template<typename TLayout>
+    void ModelVertexLayoutCallback(void* vtxOut, const unsigned int* remap, size_t count, const aiMesh* ptrMesh)
+    {
+        VertexLayoutAssemble<TLayout>(vtxOut, ModelVertexStreams(ptrMesh), remap, count);
+    }
 
     // Class that manages model uploading and stuff context 
     class ModelContext
     {
+        // Loads through the internal entry points
+        friend class ModelRegistry;
+
         public:
             // Construct
             ModelContext() = delete;
             ModelContext(const ModelContext&) = delete;
-            ModelContext(UINT64 memoryBudget);
+            ModelContext(UINT64 memoryBudget, unsigned int importThreadCount = 0);
+
+            // Destruct
+            ~ModelContext();
 
             // Assign
             ModelContext& operator=(const ModelContext&) = delete;
 
-            // Load a model form disk
-            ModelInfo LoadModel(const char* filePath, D3DUploadBuffer& uploader, size_t vertexSize, FModelVertexCallback callback);
+            // Load a model form disk. A non zero vertexLayout identifies the output of callback and enables the baked mesh cache
+            // ("<filePath>.rtrmesh"), which is loaded without touching assimp when still valid.
+            // With ModelImportOptions::quantizeVertices the loader writes QuantizedVertex data itself (vertexSize and callback are ignored).
+            ModelInfo LoadModel(const char* filePath, D3DUploadBuffer& uploader, size_t vertexSize, FModelVertexCallback callback, UINT64 vertexLayout = 0, const ModelImportOptions& options = ModelImportOptions());
+            // Load a model form disk with vertices described by a compile time layout (see VertexLayout.h, always uses the mesh cache)
+            template<typename TLayout>
+            inline ModelInfo LoadModel(const char* filePath, D3DUploadBuffer& uploader, const ModelImportOptions& options = ModelImportOptions())
+            {
+                return LoadModelInternal(filePath, uploader, VertexLayoutStride<TLayout>(), nullptr, &ModelVertexLayoutCallback<TLayout>, VertexLayoutHash<TLayout>(), options);
+            }
             MeshInfo GetMeshInfo(ModelInfo& modelInfo, size_t idx = 0);
+            // Release the gpu memory of a model (the gpu must be done with it, its mesh slots stay empty)
+            void UnloadModel(ModelInfo& modelInfo);
+
+            // Move up to maxBytes of the highest allocations into lower free ranges through a staging buffer and patch all views.
+            // Records the copies on cmdList, which has to execute before anything else is uploaded into the geometry buffer
+            // and before the next call (a replaced staging buffer is released once the queue passed that execution).
+            // MeshInfo copies taken before are stale. Does nothing while models are streaming. Returns the moved bytes.
+            UINT64 Defragment(D3DCommandList& cmdList, UINT64 maxBytes);
+            // Whether Defragment is worth calling: geometry memory was freed since the last call that moved nothing and the free
+            // memory is more fragmented than fragmentationThreshold (see TlsfAllocator::GetFragmentation)
+            bool NeedsDefragment(double fragmentationThreshold = 0.25) const;
+
+            // Queue a model for loading on the background thread and return right away (same arguments as LoadModel).
+            // The callback is invoked from worker threads.
+            ModelStreamHandle LoadModelAsync(const char* filePath, size_t vertexSize, FModelVertexCallback callback, UINT64 vertexLayout = 0, const ModelImportOptions& options = ModelImportOptions());
+            template<typename TLayout>
+            inline ModelStreamHandle LoadModelAsync(const char* filePath, const ModelImportOptions& options = ModelImportOptions())
+            {
+                return LoadModelAsyncInternal(filePath, VertexLayoutStride<TLayout>(), nullptr, &ModelVertexLayoutCallback<TLayout>, VertexLayoutHash<TLayout>(), options);
+            }
+            // Allocate imported models and stream their data within budget (call once per frame before the uploader executes)
+            ModelStreamStats UpdateStreaming(IModelStreamUploader& uploader, const ModelStreamBudget& budget = ModelStreamBudget());
+            // Progress of an asynchronous load
+            ModelStreamState GetModelStreamState(ModelStreamHandle handle);
+            // Check if all meshes of an asynchronous load are resident (ptrInfoOut receives the model once ready)
+            bool IsModelReady(ModelStreamHandle handle, ModelInfo* ptrInfoOut = nullptr);
 
             // Retrive buffer resource
             inline D3DResource* GetGeometryBufferResource()
@@ -57,11 +250,176 @@ namespace RTR
                 return &m_geometryDataBuffer;
             }
 
+            // Views of the whole geometry buffer. Bound once, every mesh with the same vertex stride and index size is drawn
+            // by its offsets (MeshInfo::GetBaseVertex and MeshLod::GetStartIndex) without touching the input assembler again.
+            inline D3D12_VERTEX_BUFFER_VIEW CreateSharedVertexBufferView(UINT vertexStride)
+            {
+                return m_geometryDataBuffer.GetWholeView().CreateVertexBufferView(vertexStride);
+            }
+            inline D3D12_INDEX_BUFFER_VIEW CreateSharedIndexBufferView(UINT indexSize)
+            {
+                return m_geometryDataBuffer.GetWholeView().CreateIndexBufferView(indexSize);
+            }
+
         private:
+            // Per mesh state while importing
+            struct MeshImportJob
+            {
+                const aiMesh* ptrMesh = nullptr;
+                std::string name;
+
+                // Sizes
+                size_t vertexCount = 0;
+                size_t indexCount = 0;
+
+                // Final indices and the source vertex of every output vertex (empty when not reordered)
+                std::vector<unsigned int> indices;
+                std::vector<unsigned int> vertexRemap;
+                VertexCacheStats cacheStatsBefore, cacheStatsAfter;
+
+                // Meshlets (in output vertex order)
+                MeshletData meshlets;
+                size_t meshletCount = 0;
+
+                // Simplified levels (indices of all levels back to back)
+                std::vector<unsigned int> lodIndices;
+                std::vector<MeshLodRange> lods;
+
+                // Compression
+                bool quantizeVertices = false;
+                VertexDequantization dequantization;
+                MeshBounds bounds;
+                UINT indexSize = sizeof(unsigned int);
+                std::vector<uint16_t> shortIndices, shortLodIndices;
+
+                // CPU data, target on the gpu and upload reservation of every blob
+                const void* blobData[(UINT)MeshCacheBlob::Count] = {};
+                UINT64 blobBytes[(UINT)MeshCacheBlob::Count] = {};
+                ModelPartView blobPart[(UINT)MeshCacheBlob::Count] = {};
+                unsigned char* ptrBlobUpload[(UINT)MeshCacheBlob::Count] = {};
+
+                // CPU copy of the vertex data
+                std::vector<unsigned char> vertexScratch;
+
+                // Hashes of all blobs (0 keeps the mesh unshared) and whether the gpu data of an identical mesh is reused
+                UINT64 contentHash = 0;
+                UINT64 contentCheck = 0;
+                bool isShared = false;
+            };
+
+            // One asynchronous load
+            struct StreamRequest
+            {
+                ModelStreamHandle handle = 0;
+                std::atomic<ModelStreamState> state = ModelStreamState::Loading;
+
+                // Arguments
+                std::string filePath;
+                size_t vertexSize = 0;
+                FModelVertexCallback callback = nullptr;
+                FModelVertexBatchCallback batchCallback = nullptr;
+                UINT64 vertexLayout = 0;
+                ModelImportOptions options;
+
+                // Imported meshes (blobs in CPU memory or the mapped cache file)
+                std::vector<MeshImportJob> jobs;
+                std::unique_ptr<MeshCacheFile> cache;
+
+                // Model once allocated
+                bool allocated = false;
+                ModelInfo info = { 0, 0 };
+                // Loads that upload meshes this one shares
+                std::vector<ModelStreamHandle> dependencies;
+            };
+
+            // Shared implementation of both LoadModel variants (exactly one callback is set)
+            ModelInfo LoadModelInternal(const char* filePath, D3DUploadBuffer& uploader, size_t vertexSize, FModelVertexCallback callback, FModelVertexBatchCallback batchCallback, UINT64 vertexLayout, const ModelImportOptions& options);
+            ModelStreamHandle LoadModelAsyncInternal(const char* filePath, size_t vertexSize, FModelVertexCallback callback, FModelVertexBatchCallback batchCallback, UINT64 vertexLayout, const ModelImportOptions& options);
+            // Load all meshes of a validated cache file
+            ModelInfo LoadModelFromCache(const MeshCacheFile& cache, D3DUploadBuffer& uploader);
+
+            // Background importer
+            void StreamThreadMain();
+            // Import all meshes of a request into CPU memory (background thread)
+            bool ImportModel(StreamRequest& request);
+
+            // Key of the baked mesh cache (false when the cache is not used)
+            static bool MakeCacheKey(const char* filePath, size_t vertexSize, UINT64 vertexLayout, const ModelImportOptions& options, MeshCacheKey* ptrKeyOut);
+            // Open the cache of a source file (hashes the source only when its size or write time changed, the hash is left in the key for baking)
+            static bool OpenCache(MeshCacheFile& cache, const char* filePath, const char* cachePath, MeshCacheKey& key);
+            // Create a job for every mesh of a validated cache file
+            static void LoadJobsFromCache(const MeshCacheFile& cache, std::vector<MeshImportJob>& jobsOut);
+            // Write all assembled jobs to the mesh cache
+            static void BakeModel(const std::vector<MeshImportJob>& jobs, const char* cachePath, const MeshCacheKey& cacheKey);
+            // Print the optimization results of a job (debug builds)
+            static void ReportMesh(const MeshImportJob& job, const ModelImportOptions& options);
+
+            // Allocate gpu memory for all blobs of a job and create its set (false when out of memory)
+            bool AllocateMesh(MeshImportJob& job);
+            // Reserve upload memory for all blobs of an allocated job
+            static void ReserveMesh(MeshImportJob& job, D3DUploadBuffer& uploader);
+            // Copy all blobs into their upload reservations (thread safe)
+            static void UploadMesh(MeshImportJob& job);
+            // Copy all reserved blobs to the gpu
+            static void CommitMesh(MeshImportJob& job, D3DUploadBuffer& uploader);
+            // Stream the blobs that did not fit into the upload buffer in chunks (after all reservations were committed, false when
+            // a blob could not be uploaded)
+            bool StreamMesh(MeshImportJob& job, D3DUploadBuffer& uploader);
+            // Stream the jobs of a model whose sets start at firstSet. Meshes that failed (and the ones sharing their memory) are
+            // released and removed from the model, returns the count of sets the model keeps.
+            size_t StreamModel(std::vector<MeshImportJob>& jobs, size_t firstSet, D3DUploadBuffer& uploader);
+            // Release the gpu memory of a set (shared memory with its last user)
+            void ReleaseSet(MeshInfo& set);
+
+            // Gather and optimize the indices of one mesh, build its meshlets and levels of detail (thread safe)
+            static void PrepareMesh(MeshImportJob& job, const ModelImportOptions& options);
+            // Simplify the indices of a prepared mesh into its levels of detail (thread safe)
+            static void BuildLods(MeshImportJob& job, const ModelImportOptions& options, const float* positions, size_t positionStride);
+            // Assemble the vertices of one mesh into CPU memory and hash all of its blobs (thread safe)
+            static void AssembleMesh(MeshImportJob& job, size_t vertexSize, FModelVertexCallback callback, FModelVertexBatchCallback batchCallback);
+            // Hash of all blobs of a job (never 0) and an independent check hash of the same data
+            static UINT64 HashMeshContent(const MeshImportJob& job, UINT64* ptrCheckOut);
+
+        private:
+            // Workers used for mesh assembly
+            WorkerPool m_importWorkers;
+
             // Index and vertex buffer
             ModelBuffer m_geometryDataBuffer;
 
             // Vector of drawable data
             std::vector<MeshInfo> m_sets;
+
+            // Gpu data of meshes by content (see MeshShareTable)
+            struct SharedMesh
+            {
+                ModelPartView parts[(UINT)MeshCacheBlob::Count];
+                // Asynchronous load that streams the data (0 for LoadModel)
+                ModelStreamHandle uploadOwner = 0;
+            };
+            MeshShareTable<SharedMesh> m_sharedMeshes;
+
+            // Staging buffer of Defragment and replaced ones the queue may still read (released once it passed the fence)
+            struct RetiredStaging
+            {
+                UINT64 fenceValue;
+                std::unique_ptr<ModelBuffer> buffer;
+            };
+            std::unique_ptr<ModelBuffer> m_defragStaging;
+            std::vector<RetiredStaging> m_retiredDefragStaging;
+            // Memory was freed since the last Defragment that found nothing to move
+            bool m_defragmentPending = false;
+
+            // Asynchronous loads (render thread only, ordered by handle)
+            std::map<ModelStreamHandle, std::shared_ptr<StreamRequest>> m_streams;
+            ModelStreamHandle m_lastStreamHandle = 0;
+            ModelStreamer m_streamer;
+
+            // Background importer queue
+            std::thread m_streamThread;
+            std::mutex m_streamMutex;
+            std::condition_variable m_streamCv;
+            std::deque<std::shared_ptr<StreamRequest>> m_streamQueue;
+            bool m_streamShutdown = false;
     };
 }
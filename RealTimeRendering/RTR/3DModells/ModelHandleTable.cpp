@@ -0,0 +1,120 @@
+#include "ModelHandleTable.h"
+
+#include <cctype>
+
+std::string RTR::NormalizeModelPath(const char* filePath)
+{
+    // Case and separators do not matter on windows
+    std::string key = filePath;
+    #ifdef _WIN32
+    for (char& c : key)
+        c = c == '\\' ? '/' : (char)std::tolower((unsigned char)c);
+    #endif
+
+    // Collapse "./" and duplicate separators
+    std::string path;
+    for (size_t i = 0; i < key.size(); i++)
+    {
+        if (key[i] == '/' && (path.empty() || path.back() == '/'))
+            continue;
+        if (key[i] == '.' && (i + 1 == key.size() || key[i + 1] == '/') && (path.empty() || path.back() == '/'))
+            continue;
+        path.push_back(key[i]);
+    }
+    if (!key.empty() && key[0] == '/')
+        path.insert(path.begin(), '/');
+
+    return path;
+}
+
+uint64_t RTR::ModelHandleTable::Acquire(const std::string& key)
+{
+    // This also revives released entries that wait for their load
+    auto it = m_handles.find(key);
+    if (it == m_handles.end())
+        return 0;
+
+    m_entries[it->second].refCount++;
+    return it->second;
+}
+
+uint64_t RTR::ModelHandleTable::Insert(const std::string& key, bool pending)
+{
+    Entry entry;
+    entry.key = key;
+    entry.refCount = 1;
+    entry.pending = pending;
+
+    const uint64_t handle = ++m_lastHandle;
+    m_handles.emplace(key, handle);
+    m_entries.emplace(handle, std::move(entry));
+    return handle;
+}
+
+void RTR::ModelHandleTable::AddRef(uint64_t handle)
+{
+    auto it = m_entries.find(handle);
+    if (it != m_entries.end())
+        it->second.refCount++;
+}
+
+bool RTR::ModelHandleTable::Release(uint64_t handle)
+{
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end() || !it->second.refCount || --it->second.refCount)
+        return false;
+
+    // Pending entries are removed once resolved (see GetReleased)
+    return !it->second.pending;
+}
+
+void RTR::ModelHandleTable::Resolve(uint64_t handle)
+{
+    auto it = m_entries.find(handle);
+    if (it != m_entries.end())
+        it->second.pending = false;
+}
+
+void RTR::ModelHandleTable::Remove(uint64_t handle)
+{
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end())
+        return;
+
+    m_handles.erase(it->second.key);
+    m_entries.erase(it);
+}
+
+std::vector<uint64_t> RTR::ModelHandleTable::GetReleased() const
+{
+    std::vector<uint64_t> released;
+    for (const auto& entry : m_entries)
+    {
+        if (!entry.second.refCount && !entry.second.pending)
+            released.push_back(entry.first);
+    }
+    return released;
+}
+
+std::vector<uint64_t> RTR::ModelHandleTable::GetPending() const
+{
+    std::vector<uint64_t> pending;
+    for (const auto& entry : m_entries)
+    {
+        if (entry.second.pending)
+            pending.push_back(entry.first);
+    }
+    return pending;
+}
+
+uint32_t RTR::ModelHandleTable::GetRefCount(uint64_t handle) const
+{
+    auto it = m_entries.find(handle);
+    return it != m_entries.end() ? it->second.refCount : 0;
+}
+
+bool RTR::ModelHandleTable::IsPending(uint64_t handle) const
+{
+    auto it = m_entries.find(handle);
+    return it != m_entries.end() && it->second.pending;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RTR
+{
+    // Normalized form of a model path for lookups ("\" becomes "/" and case is ignored on windows, "./" and duplicate separators are dropped)
+    std::string NormalizeModelPath(const char* filePath);
+
+    // Refcounted handles by lookup key (the bookkeeping of ModelRegistry, no gpu objects).
+    // Pending entries are still loading: their last release is deferred until they are resolved.
+    class ModelHandleTable
+    {
+        public:
+            // Handle of key with one more reference (0 when the key is unknown)
+            uint64_t Acquire(const std::string& key);
+            // Register an unknown key with one reference (pending while loading asynchronously)
+            uint64_t Insert(const std::string& key, bool pending);
+            // Add a reference
+            void AddRef(uint64_t handle);
+            // Drop a reference, true when it was the last one and the entry is not pending (the caller removes it)
+            bool Release(uint64_t handle);
+            // Mark a pending entry as loaded
+            void Resolve(uint64_t handle);
+            // Forget an entry
+            void Remove(uint64_t handle);
+
+            // Loaded entries without references (released while pending)
+            std::vector<uint64_t> GetReleased() const;
+            // Pending entries
+            std::vector<uint64_t> GetPending() const;
+
+            // References of an entry (0 for unknown handles)
+            uint32_t GetRefCount(uint64_t handle) const;
+            // Check for a pending entry
+            bool IsPending(uint64_t handle) const;
+            // Count of entries
+            inline size_t GetCount() const
+            {
+                return m_entries.size();
+            }
+
+        private:
+            // One key
+            struct Entry
+            {
+                std::string key;
+                uint32_t refCount = 0;
+                bool pending = false;
+            };
+
+        private:
+            // Entries by handle and handles by key
+            std::unordered_map<uint64_t, Entry> m_entries;
+            std::unordered_map<std::string, uint64_t> m_handles;
+            uint64_t m_lastHandle = 0;
+    };
+}
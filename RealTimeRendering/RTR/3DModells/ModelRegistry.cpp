@@ -0,0 +1,126 @@
+#include "ModelRegistry.h"
+
+#include <cstdint>
+
+RTR::ModelHandle RTR::ModelRegistry::Acquire(const char* filePath, D3DUploadBuffer& uploader, size_t vertexSize, FModelVertexCallback callback, UINT64 vertexLayout, const ModelImportOptions& options)
+{
+    return AcquireInternal(filePath, &uploader, vertexSize, callback, nullptr, vertexLayout, options);
+}
+
+RTR::ModelHandle RTR::ModelRegistry::AcquireAsync(const char* filePath, size_t vertexSize, FModelVertexCallback callback, UINT64 vertexLayout, const ModelImportOptions& options)
+{
+    return AcquireInternal(filePath, nullptr, vertexSize, callback, nullptr, vertexLayout, options);
+}
+
+void RTR::ModelRegistry::AddRef(ModelHandle handle)
+{
+    m_table.AddRef(handle);
+}
+
+bool RTR::ModelRegistry::Release(ModelHandle handle)
+{
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end())
+        return false;
+
+    // Models that are still streaming are unloaded by Update
+    ResolveStream(handle, it->second);
+    if (!m_table.Release(handle))
+        return false;
+
+    Remove(handle);
+    return true;
+}
+
+void RTR::ModelRegistry::Update()
+{
+    // Resolve finished loads, then unload the ones released meanwhile
+    for (ModelHandle handle : m_table.GetPending())
+        ResolveStream(handle, m_entries[handle]);
+    for (ModelHandle handle : m_table.GetReleased())
+        Remove(handle);
+}
+
+bool RTR::ModelRegistry::GetModel(ModelHandle handle, ModelInfo* ptrInfoOut)
+{
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end() || !ResolveStream(handle, it->second) || !it->second.info.count)
+        return false;
+
+    if (ptrInfoOut)
+        *ptrInfoOut = it->second.info;
+    return true;
+}
+
+UINT RTR::ModelRegistry::GetRefCount(ModelHandle handle) const
+{
+    return m_table.GetRefCount(handle);
+}
+
+RTR::ModelHandle RTR::ModelRegistry::AcquireInternal(const char* filePath, D3DUploadBuffer* ptrUploader, size_t vertexSize, FModelVertexCallback callback, FModelVertexBatchCallback batchCallback, UINT64 vertexLayout, const ModelImportOptions& options)
+{
+    // Reference a registered model (this also revives released models that wait for Update)
+    std::string key = MakeKey(filePath, vertexSize, batchCallback ? (const void*)batchCallback : (const void*)callback, vertexLayout, options);
+    if (ModelHandle handle = m_table.Acquire(key))
+        return handle;
+
+    // Load it
+    Entry entry;
+    if (ptrUploader)
+    {
+        entry.info = m_context.LoadModelInternal(filePath, *ptrUploader, vertexSize, callback, batchCallback, vertexLayout, options);
+        if (!entry.info)
+            return 0;
+    }
+    else
+    {
+        entry.stream = m_context.LoadModelAsyncInternal(filePath, vertexSize, callback, batchCallback, vertexLayout, options);
+    }
+
+    // Register
+    const ModelHandle handle = m_table.Insert(key, entry.stream != 0);
+    m_entries.emplace(handle, entry);
+    return handle;
+}
+
+bool RTR::ModelRegistry::ResolveStream(ModelHandle handle, Entry& entry)
+{
+    if (!entry.stream)
+        return true;
+
+    // Failed loads resolve to an empty model
+    switch (m_context.GetModelStreamState(entry.stream))
+    {
+        case ModelStreamState::Ready:
+            m_context.IsModelReady(entry.stream, &entry.info);
+            break;
+        case ModelStreamState::Failed:
+            entry.info = { 0, 0 };
+            break;
+        default:
+            return false;
+    }
+
+    entry.stream = 0;
+    m_table.Resolve(handle);
+    return true;
+}
+
+void RTR::ModelRegistry::Remove(ModelHandle handle)
+{
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end())
+        return;
+
+    if (it->second.info)
+        m_context.UnloadModel(it->second.info);
+    m_table.Remove(handle);
+    m_entries.erase(it);
+}
+
+std::string RTR::ModelRegistry::MakeKey(const char* filePath, size_t vertexSize, const void* callback, UINT64 vertexLayout, const ModelImportOptions& options)
+{
+    // Without a layout the callback identifies the vertices
+    return NormalizeModelPath(filePath) + "|" + std::to_string(vertexLayout) + "|" + std::to_string(vertexSize) + "|" + std::to_string(options.Hash()) +
+        "|" + std::to_string(vertexLayout ? 0 : (uintptr_t)callback);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <RTR/3DModells/ModelContext.h>
+#include <RTR/3DModells/ModelHandleTable.h>
+
+#include <string>
+#include <unordered_map>
+
+namespace RTR
+{
+    // Handle of a registered model (0 is invalid)
+    typedef UINT64 ModelHandle;
+
+    // Loads every model once per path and import settings and hands out refcounted handles.
+    // Identical meshes of different models share their gpu data inside the ModelContext.
+    class ModelRegistry
+    {
+        public:
+            // Construct
+            ModelRegistry() = delete;
+            ModelRegistry(const ModelRegistry&) = delete;
+            ModelRegistry(ModelContext& context) :
+                m_context(context)
+            { }
+
+            // Assign
+            ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+            // Load a model or add a reference to an already registered one (same arguments as ModelContext::LoadModel, 0 on failure)
+            ModelHandle Acquire(const char* filePath, D3DUploadBuffer& uploader, size_t vertexSize, FModelVertexCallback callback, UINT64 vertexLayout = 0, const ModelImportOptions& options = ModelImportOptions());
+            template<typename TLayout>
+            inline ModelHandle Acquire(const char* filePath, D3DUploadBuffer& uploader, const ModelImportOptions& options = ModelImportOptions())
+            {
+                return AcquireInternal(filePath, &uploader, VertexLayoutStride<TLayout>(), nullptr, &ModelVertexLayoutCallback<TLayout>, VertexLayoutHash<TLayout>(), options);
+            }
+            // Same as Acquire but loads through ModelContext::LoadModelAsync (use GetModel to wait for residency)
+            ModelHandle AcquireAsync(const char* filePath, size_t vertexSize, FModelVertexCallback callback, UINT64 vertexLayout = 0, const ModelImportOptions& options = ModelImportOptions());
+            template<typename TLayout>
+            inline ModelHandle AcquireAsync(const char* filePath, const ModelImportOptions& options = ModelImportOptions())
+            {
+                return AcquireInternal(filePath, nullptr, VertexLayoutStride<TLayout>(), nullptr, &ModelVertexLayoutCallback<TLayout>, VertexLayoutHash<TLayout>(), options);
+            }
+
+            // Add a reference
+            void AddRef(ModelHandle handle);
+            // Drop a reference. The last one unloads the model (the gpu must be done with it), asynchronous loads are unloaded by Update once resident.
+            // Returns true when the model was unloaded.
+            bool Release(ModelHandle handle);
+            // Unload released models whose asynchronous load finished (call once per frame after ModelContext::UpdateStreaming)
+            void Update();
+
+            // Retrive a model (false while it is streaming or when the load failed)
+            bool GetModel(ModelHandle handle, ModelInfo* ptrInfoOut);
+            // References of a model (0 for unknown handles)
+            UINT GetRefCount(ModelHandle handle) const;
+            // Count of registered models
+            inline size_t GetModelCount() const
+            {
+                return m_table.GetCount();
+            }
+
+        private:
+            // Data of one registered model
+            struct Entry
+            {
+                // Asynchronous load (0 once the model is known)
+                ModelStreamHandle stream = 0;
+                ModelInfo info = { 0, 0 };
+            };
+
+            // Load or reference a model (synchronous when ptrUploader is set)
+            ModelHandle AcquireInternal(const char* filePath, D3DUploadBuffer* ptrUploader, size_t vertexSize, FModelVertexCallback callback, FModelVertexBatchCallback batchCallback, UINT64 vertexLayout, const ModelImportOptions& options);
+            // Resolve a finished asynchronous load (false while streaming)
+            bool ResolveStream(ModelHandle handle, Entry& entry);
+            // Unload and forget a model
+            void Remove(ModelHandle handle);
+
+            // Lookup key of a load (normalized path and everything that changes the imported data)
+            static std::string MakeKey(const char* filePath, size_t vertexSize, const void* callback, UINT64 vertexLayout, const ModelImportOptions& options);
+
+        private:
+            ModelContext& m_context;
+
+            // Keys and references, models by handle
+            ModelHandleTable m_table;
+            std::unordered_map<ModelHandle, Entry> m_entries;
+    };
+}
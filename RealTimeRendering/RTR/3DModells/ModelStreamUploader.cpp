@@ -0,0 +1,21 @@
+#include "ModelStreamUploader.h"
+
+UINT64 RTR::ModelStreamUploader::GetFreeMemory()
+{
+    return m_uploader.GetFreeMemory();
+}
+
+bool RTR::ModelStreamUploader::UploadBufferData(const void* ptrData, UINT64 size, ID3D12Resource* ptrTarget, UINT64 targetOffset)
+{
+    return m_uploader.CopyBufferData((void*)ptrData, size, ptrTarget, targetOffset);
+}
+
+UINT64 RTR::ModelStreamUploader::GetRecordingBatch()
+{
+    return m_uploader.GetRecordingExecution();
+}
+
+UINT64 RTR::ModelStreamUploader::GetFinishedBatchCount()
+{
+    return m_uploader.GetFinishedExecutionCount();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <WinInclude.h>
+#include <RTR/3DModells/IModelStreamUploader.h>
+#include <D3DMemory/D3DUploadBuffer.h>
+
+namespace RTR
+{
+    // Streams through a D3DUploadBuffer (the owner still executes it, copies are done once that execution finished)
+    class ModelStreamUploader : public IModelStreamUploader
+    {
+        public:
+            // Construct
+            ModelStreamUploader(D3DUploadBuffer& uploader) :
+                m_uploader(uploader)
+            { }
+
+            // IModelStreamUploader
+            UINT64 GetFreeMemory() override;
+            bool UploadBufferData(const void* ptrData, UINT64 size, ID3D12Resource* ptrTarget, UINT64 targetOffset) override;
+            UINT64 GetRecordingBatch() override;
+            UINT64 GetFinishedBatchCount() override;
+
+        private:
+            D3DUploadBuffer& m_uploader;
+    };
+}
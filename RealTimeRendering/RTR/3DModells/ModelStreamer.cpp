@@ -0,0 +1,65 @@
+#include "ModelStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+
+void RTR::ModelStreamer::Enqueue(uint64_t owner, const void* ptrData, uint64_t size, ID3D12Resource* ptrTarget, uint64_t targetOffset)
+{
+    if (!size)
+        return;
+
+    m_copies.push_back({ owner, (const unsigned char*)ptrData, size, ptrTarget, targetOffset });
+    m_owners[owner].pendingCopies++;
+}
+
+RTR::ModelStreamStats RTR::ModelStreamer::Update(IModelStreamUploader& uploader, const ModelStreamBudget& budget)
+{
+    ModelStreamStats stats;
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t batch = uploader.GetRecordingBatch();
+
+    while (!m_copies.empty() && stats.bytesUploaded < budget.bytesPerFrame)
+    {
+        // Split the copy to what is left of the budget and the upload memory
+        Copy& copy = m_copies.front();
+        const uint64_t size = std::min({ copy.size, budget.bytesPerFrame - stats.bytesUploaded, uploader.GetFreeMemory() });
+        if (!size || !uploader.UploadBufferData(copy.ptrData, size, copy.ptrTarget, copy.targetOffset))
+            break;
+
+        stats.bytesUploaded += size;
+        stats.copyCount++;
+
+        // Remember the batch of the last part of every copy
+        Owner& owner = m_owners[copy.owner];
+        owner.lastBatch = batch;
+        copy.ptrData += size;
+        copy.size -= size;
+        copy.targetOffset += size;
+        if (!copy.size)
+        {
+            owner.pendingCopies--;
+            m_copies.pop_front();
+        }
+
+        // Time budget
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budget.msPerFrame)
+            break;
+    }
+
+    stats.pendingCopies = m_copies.size();
+    return stats;
+}
+
+bool RTR::ModelStreamer::IsComplete(uint64_t owner, IModelStreamUploader& uploader)
+{
+    auto it = m_owners.find(owner);
+    if (it == m_owners.end())
+        return true;
+
+    // Forget owners once their last batch finished
+    const bool complete = !it->second.pendingCopies && uploader.GetFinishedBatchCount() >= it->second.lastBatch;
+    if (complete)
+        m_owners.erase(it);
+    return complete;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <RTR/3DModells/IModelStreamUploader.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+namespace RTR
+{
+    // Limits of one ModelStreamer::Update call
+    struct ModelStreamBudget
+    {
+        // Bytes copied into upload memory per frame
+        uint64_t bytesPerFrame = 16ULL * 1024 * 1024;
+        // CPU time spent copying per frame
+        float msPerFrame = 2.0f;
+    };
+
+    // Result of one ModelStreamer::Update call
+    struct ModelStreamStats
+    {
+        uint64_t bytesUploaded = 0;
+        uint32_t copyCount = 0;
+        // Copies still waiting for budget
+        size_t pendingCopies = 0;
+    };
+
+    // Schedules buffer copies of many owners across frames. Copies are issued in queue order and split when they exceed the budget.
+    class ModelStreamer
+    {
+        public:
+            // Construct
+            ModelStreamer() = default;
+            ModelStreamer(const ModelStreamer&) = delete;
+
+            // Assign
+            ModelStreamer& operator=(const ModelStreamer&) = delete;
+
+            // Queue a copy for owner (ptrData must stay valid until IsComplete(owner) returns true)
+            void Enqueue(uint64_t owner, const void* ptrData, uint64_t size, ID3D12Resource* ptrTarget, uint64_t targetOffset);
+            // Issue queued copies within the budget
+            ModelStreamStats Update(IModelStreamUploader& uploader, const ModelStreamBudget& budget);
+            // True when every copy of owner was issued and has finished on the gpu (owners without copies are complete)
+            bool IsComplete(uint64_t owner, IModelStreamUploader& uploader);
+
+            // Count of queued copies
+            inline size_t GetPendingCopyCount() const
+            {
+                return m_copies.size();
+            }
+
+        private:
+            // One queued copy
+            struct Copy
+            {
+                uint64_t owner;
+                const unsigned char* ptrData;
+                uint64_t size;
+                ID3D12Resource* ptrTarget;
+                uint64_t targetOffset;
+            };
+
+            // Progress of one owner
+            struct Owner
+            {
+                size_t pendingCopies = 0;
+                uint64_t lastBatch = 0;
+            };
+
+        private:
+            // Copies in issue order
+            std::deque<Copy> m_copies;
+            // Owners with copies that are pending or not finished
+            std::unordered_map<uint64_t, Owner> m_owners;
+    };
+}
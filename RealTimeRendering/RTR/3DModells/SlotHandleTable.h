@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace RTR
+{
+    // Generational handles to offsets of a fixed size array. A handle packs the slot (low 32 bits) and its generation
+    // (high bits). Freeing bumps the generation so old copies of the handle go stale; 0 is never a valid handle.
+    template<typename TGeneration = uint32_t>
+    class SlotHandleTable
+    {
+        public:
+            // Offset of stale handles
+            static constexpr uint32_t InvalidOffset = 0xFFFFFFFF;
+
+            // Construct
+            SlotHandleTable() = delete;
+            SlotHandleTable(uint32_t count) :
+                m_count(count),
+                m_offsetSlots(count, InvalidOffset)
+            {
+            }
+
+            // Bind the lowest freed offset (or grow the used range). Returns 0 when all offsets are taken.
+            uint64_t Allocate(uint32_t* ptrOffsetOut)
+            {
+                uint32_t offset;
+                if (!m_freeOffsets.empty())
+                {
+                    offset = m_freeOffsets.top();
+                    m_freeOffsets.pop();
+                }
+                else if (m_usage < m_count)
+                {
+                    offset = m_usage++;
+                }
+                else
+                {
+                    return 0;
+                }
+
+                // Reuse a slot (keeps its bumped generation) or add one
+                uint32_t slot;
+                if (!m_freeSlots.empty())
+                {
+                    slot = m_freeSlots.back();
+                    m_freeSlots.pop_back();
+                }
+                else
+                {
+                    slot = (uint32_t)m_slots.size();
+                    m_slots.emplace_back();
+                }
+                m_slots[slot].offset = offset;
+                m_offsetSlots[offset] = slot;
+                m_liveCount++;
+
+                *ptrOffsetOut = offset;
+                return ((uint64_t)m_slots[slot].generation << 32) | slot;
+            }
+
+            // Release the offset of a handle (false for stale handles)
+            bool Free(uint64_t handle)
+            {
+                if (GetOffset(handle) == InvalidOffset)
+                    return false;
+
+                // Generation 0 is skipped on wraparound so handles are never 0
+                Slot& slot = m_slots[(uint32_t)handle];
+                m_offsetSlots[slot.offset] = InvalidOffset;
+                m_freeOffsets.push(slot.offset);
+                slot.offset = InvalidOffset;
+                if (!++slot.generation)
+                    slot.generation = 1;
+                m_freeSlots.push_back((uint32_t)handle);
+                m_liveCount--;
+                return true;
+            }
+
+            // Current offset of a handle (InvalidOffset for stale handles)
+            uint32_t GetOffset(uint64_t handle) const
+            {
+                const uint32_t slot = (uint32_t)handle;
+                if (slot >= m_slots.size() || m_slots[slot].generation != (handle >> 32))
+                    return InvalidOffset;
+                return m_slots[slot].offset;
+            }
+            inline bool IsValid(uint64_t handle) const
+            {
+                return GetOffset(handle) != InvalidOffset;
+            }
+
+            // Move live offsets down into freed ones (keeps their order). move(from, to) is called for every moved offset
+            // before the next one moves. Returns the count of moved offsets.
+            template<typename F>
+            uint32_t Compact(F&& move)
+            {
+                uint32_t moved = 0;
+                uint32_t write = 0;
+                for (uint32_t read = 0; read < m_usage; read++)
+                {
+                    const uint32_t slot = m_offsetSlots[read];
+                    if (slot == InvalidOffset)
+                        continue;
+
+                    if (read != write)
+                    {
+                        move(read, write);
+                        m_offsetSlots[write] = slot;
+                        m_offsetSlots[read] = InvalidOffset;
+                        m_slots[slot].offset = write;
+                        moved++;
+                    }
+                    write++;
+                }
+
+                // Everything above the live offsets is free
+                m_usage = write;
+                m_freeOffsets = decltype(m_freeOffsets)();
+                return moved;
+            }
+
+            // Offsets in use (end of the used range), live handles and total offsets
+            inline uint32_t GetUsage() const
+            {
+                return m_usage;
+            }
+            inline uint32_t GetLiveCount() const
+            {
+                return m_liveCount;
+            }
+            inline uint32_t GetCount() const
+            {
+                return m_count;
+            }
+
+        private:
+            // Offset (InvalidOffset while free) and generation of a slot
+            struct Slot
+            {
+                uint32_t offset = InvalidOffset;
+                TGeneration generation = 1;
+            };
+
+        private:
+            uint32_t m_count = 0;
+            uint32_t m_usage = 0;
+            uint32_t m_liveCount = 0;
+
+            // Handle slots and the slot of every offset
+            std::vector<Slot> m_slots;
+            std::vector<uint32_t> m_freeSlots;
+            std::vector<uint32_t> m_offsetSlots;
+            // Freed offsets below m_usage (lowest first)
+            std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> m_freeOffsets;
+    };
+}
@@ -0,0 +1,236 @@
+#include "TransformBatch.h"
+
+#ifdef RTR_TRANSFORM_BATCH_SSE
+#include <immintrin.h>
+#endif
+
+void RTR::TransformBatchCompose(const TransformBatch& batch, size_t begin, size_t end, const uint32_t* offsets, float* ptrMatricesOut, size_t matrixFloats)
+{
+    size_t i = begin;
+
+    #if defined(__AVX2__)
+    // 8 transforms per iteration
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    for (; i + 8 <= end; i += 8)
+    {
+        const __m256 qx = _mm256_loadu_ps(batch.ptrRotationX + i);
+        const __m256 qy = _mm256_loadu_ps(batch.ptrRotationY + i);
+        const __m256 qz = _mm256_loadu_ps(batch.ptrRotationZ + i);
+        const __m256 qw = _mm256_loadu_ps(batch.ptrRotationW + i);
+        const __m256 sx = _mm256_loadu_ps(batch.ptrScaleX + i);
+        const __m256 sy = _mm256_loadu_ps(batch.ptrScaleY + i);
+        const __m256 sz = _mm256_loadu_ps(batch.ptrScaleZ + i);
+
+        // Doubled quaternion products
+        const __m256 x2 = _mm256_mul_ps(qx, two), y2 = _mm256_mul_ps(qy, two), z2 = _mm256_mul_ps(qz, two);
+        const __m256 xx = _mm256_mul_ps(qx, x2), yy = _mm256_mul_ps(qy, y2), zz = _mm256_mul_ps(qz, z2);
+        const __m256 xy = _mm256_mul_ps(qx, y2), xz = _mm256_mul_ps(qx, z2), yz = _mm256_mul_ps(qy, z2);
+        const __m256 wx = _mm256_mul_ps(qw, x2), wy = _mm256_mul_ps(qw, y2), wz = _mm256_mul_ps(qw, z2);
+
+        // Component k of all 8 transposed matrices (columns of the world matrix)
+        __m256 lo[8], hi[8];
+        lo[0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx);
+        lo[1] = _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy);
+        lo[2] = _mm256_mul_ps(_mm256_add_ps(xz, wy), sz);
+        lo[3] = _mm256_loadu_ps(batch.ptrPositionX + i);
+        lo[4] = _mm256_mul_ps(_mm256_add_ps(xy, wz), sx);
+        lo[5] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy);
+        lo[6] = _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz);
+        lo[7] = _mm256_loadu_ps(batch.ptrPositionY + i);
+        hi[0] = _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx);
+        hi[1] = _mm256_mul_ps(_mm256_add_ps(yz, wx), sy);
+        hi[2] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz);
+        hi[3] = _mm256_loadu_ps(batch.ptrPositionZ + i);
+        hi[4] = hi[5] = hi[6] = _mm256_setzero_ps();
+        hi[7] = one;
+
+        // 8x8 transposes turn the components into the first and second half of every matrix
+        auto transpose = [](__m256* r)
+        {
+            const __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+            const __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+            const __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+            const __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+            const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+            r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+            r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+            r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+            r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+            r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+            r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+            r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+            r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+        };
+        transpose(lo);
+        transpose(hi);
+
+        for (size_t k = 0; k < 8; k++)
+        {
+            float* ptrOut = ptrMatricesOut + (size_t)offsets[i + k] * matrixFloats;
+            _mm256_storeu_ps(ptrOut, lo[k]);
+            if (matrixFloats == 16)
+                _mm256_storeu_ps(ptrOut + 8, hi[k]);
+            else
+                _mm_storeu_ps(ptrOut + 8, _mm256_castps256_ps128(hi[k]));
+        }
+    }
+    #elif defined(RTR_TRANSFORM_BATCH_SSE)
+    // 4 transforms per iteration
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    for (; i + 4 <= end; i += 4)
+    {
+        const __m128 qx = _mm_loadu_ps(batch.ptrRotationX + i);
+        const __m128 qy = _mm_loadu_ps(batch.ptrRotationY + i);
+        const __m128 qz = _mm_loadu_ps(batch.ptrRotationZ + i);
+        const __m128 qw = _mm_loadu_ps(batch.ptrRotationW + i);
+        const __m128 sx = _mm_loadu_ps(batch.ptrScaleX + i);
+        const __m128 sy = _mm_loadu_ps(batch.ptrScaleY + i);
+        const __m128 sz = _mm_loadu_ps(batch.ptrScaleZ + i);
+
+        // Doubled quaternion products
+        const __m128 x2 = _mm_mul_ps(qx, two), y2 = _mm_mul_ps(qy, two), z2 = _mm_mul_ps(qz, two);
+        const __m128 xx = _mm_mul_ps(qx, x2), yy = _mm_mul_ps(qy, y2), zz = _mm_mul_ps(qz, z2);
+        const __m128 xy = _mm_mul_ps(qx, y2), xz = _mm_mul_ps(qx, z2), yz = _mm_mul_ps(qy, z2);
+        const __m128 wx = _mm_mul_ps(qw, x2), wy = _mm_mul_ps(qw, y2), wz = _mm_mul_ps(qw, z2);
+
+        // Rows of the transposed matrices (one 4x4 transpose per row)
+        __m128 r0 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+        __m128 r1 = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+        __m128 r2 = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+        __m128 r3 = _mm_loadu_ps(batch.ptrPositionX + i);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        __m128 r4 = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+        __m128 r5 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+        __m128 r6 = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+        __m128 r7 = _mm_loadu_ps(batch.ptrPositionY + i);
+        _MM_TRANSPOSE4_PS(r4, r5, r6, r7);
+        __m128 r8 = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+        __m128 r9 = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+        __m128 r10 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+        __m128 r11 = _mm_loadu_ps(batch.ptrPositionZ + i);
+        _MM_TRANSPOSE4_PS(r8, r9, r10, r11);
+
+        const __m128 rows[4][3] = { { r0, r4, r8 }, { r1, r5, r9 }, { r2, r6, r10 }, { r3, r7, r11 } };
+        const __m128 lastRow = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+        for (size_t k = 0; k < 4; k++)
+        {
+            float* ptrOut = ptrMatricesOut + (size_t)offsets[i + k] * matrixFloats;
+            _mm_storeu_ps(ptrOut, rows[k][0]);
+            _mm_storeu_ps(ptrOut + 4, rows[k][1]);
+            _mm_storeu_ps(ptrOut + 8, rows[k][2]);
+            if (matrixFloats == 16)
+                _mm_storeu_ps(ptrOut + 12, lastRow);
+        }
+    }
+    #endif
+
+    // Remaining transforms
+    TransformBatchComposeScalar(batch, i, end, offsets, ptrMatricesOut, matrixFloats);
+}
+
+void RTR::TransformBatchComposeScalar(const TransformBatch& batch, size_t begin, size_t end, const uint32_t* offsets, float* ptrMatricesOut, size_t matrixFloats)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        const float qx = batch.ptrRotationX[i], qy = batch.ptrRotationY[i], qz = batch.ptrRotationZ[i], qw = batch.ptrRotationW[i];
+        const float sx = batch.ptrScaleX[i], sy = batch.ptrScaleY[i], sz = batch.ptrScaleZ[i];
+        const float xx = qx * qx * 2.0f, yy = qy * qy * 2.0f, zz = qz * qz * 2.0f;
+        const float xy = qx * qy * 2.0f, xz = qx * qz * 2.0f, yz = qy * qz * 2.0f;
+        const float wx = qw * qx * 2.0f, wy = qw * qy * 2.0f, wz = qw * qz * 2.0f;
+
+        const float m[16] = {
+            (1.0f - yy - zz) * sx, (xy - wz) * sy, (xz + wy) * sz, batch.ptrPositionX[i],
+            (xy + wz) * sx, (1.0f - xx - zz) * sy, (yz - wx) * sz, batch.ptrPositionY[i],
+            (xz - wy) * sx, (yz + wx) * sy, (1.0f - xx - yy) * sz, batch.ptrPositionZ[i],
+            0.0f, 0.0f, 0.0f, 1.0f,
+        };
+
+        float* ptrOut = ptrMatricesOut + (size_t)offsets[i] * matrixFloats;
+        for (size_t k = 0; k < matrixFloats; k++)
+            ptrOut[k] = m[k];
+    }
+}
+
+void RTR::TransformBatchConcatenate(const float* ptrMatrices, size_t matrixFloats, const uint32_t* offsets, size_t begin, size_t end, const float* viewProjection, float* ptrOut)
+{
+    size_t i = begin;
+
+    #if defined(__AVX2__)
+    // Two matrices per iteration: row r of the result is sum_k viewProjection[k][r] * row k of the transposed world
+    __m256 coefficients[4][4];
+    for (unsigned int r = 0; r < 4; r++)
+        for (unsigned int k = 0; k < 4; k++)
+            coefficients[r][k] = _mm256_set1_ps(viewProjection[k * 4 + r]);
+    const __m256 lastRow = _mm256_set_ps(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+
+    for (; i + 2 <= end; i += 2)
+    {
+        const float* ptrA = ptrMatrices + (size_t)offsets[i] * matrixFloats;
+        const float* ptrB = ptrMatrices + (size_t)offsets[i + 1] * matrixFloats;
+        __m256 world[4];
+        for (unsigned int k = 0; k < 3; k++)
+            world[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptrA + k * 4)), _mm_loadu_ps(ptrB + k * 4), 1);
+        world[3] = matrixFloats == 16 ? _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptrA + 12)), _mm_loadu_ps(ptrB + 12), 1) : lastRow;
+
+        float* ptrOutA = ptrOut + i * 16;
+        for (unsigned int r = 0; r < 4; r++)
+        {
+            __m256 row = _mm256_mul_ps(coefficients[r][0], world[0]);
+            row = _mm256_add_ps(row, _mm256_mul_ps(coefficients[r][1], world[1]));
+            row = _mm256_add_ps(row, _mm256_mul_ps(coefficients[r][2], world[2]));
+            row = _mm256_add_ps(row, _mm256_mul_ps(coefficients[r][3], world[3]));
+            _mm_storeu_ps(ptrOutA + r * 4, _mm256_castps256_ps128(row));
+            _mm_storeu_ps(ptrOutA + 16 + r * 4, _mm256_extractf128_ps(row, 1));
+        }
+    }
+    #elif defined(RTR_TRANSFORM_BATCH_SSE)
+    // One matrix per iteration: row r of the result is sum_k viewProjection[k][r] * row k of the transposed world
+    __m128 coefficients[4][4];
+    for (unsigned int r = 0; r < 4; r++)
+        for (unsigned int k = 0; k < 4; k++)
+            coefficients[r][k] = _mm_set1_ps(viewProjection[k * 4 + r]);
+    const __m128 lastRow = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+    for (; i < end; i++)
+    {
+        const float* ptrWorld = ptrMatrices + (size_t)offsets[i] * matrixFloats;
+        const __m128 world[4] = { _mm_loadu_ps(ptrWorld), _mm_loadu_ps(ptrWorld + 4), _mm_loadu_ps(ptrWorld + 8), matrixFloats == 16 ? _mm_loadu_ps(ptrWorld + 12) : lastRow };
+        for (unsigned int r = 0; r < 4; r++)
+        {
+            __m128 row = _mm_mul_ps(coefficients[r][0], world[0]);
+            row = _mm_add_ps(row, _mm_mul_ps(coefficients[r][1], world[1]));
+            row = _mm_add_ps(row, _mm_mul_ps(coefficients[r][2], world[2]));
+            row = _mm_add_ps(row, _mm_mul_ps(coefficients[r][3], world[3]));
+            _mm_storeu_ps(ptrOut + i * 16 + r * 4, row);
+        }
+    }
+    #endif
+
+    // Remaining matrices
+    TransformBatchConcatenateScalar(ptrMatrices, matrixFloats, offsets, i, end, viewProjection, ptrOut);
+}
+
+void RTR::TransformBatchConcatenateScalar(const float* ptrMatrices, size_t matrixFloats, const uint32_t* offsets, size_t begin, size_t end, const float* viewProjection, float* ptrOut)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        const float* ptrWorld = ptrMatrices + (size_t)offsets[i] * matrixFloats;
+        for (unsigned int r = 0; r < 4; r++)
+        {
+            for (unsigned int c = 0; c < 4; c++)
+            {
+                const float lastRow = c == 3 ? 1.0f : 0.0f;
+                ptrOut[i * 16 + r * 4 + c] =
+                    viewProjection[0 * 4 + r] * ptrWorld[0 * 4 + c] +
+                    viewProjection[1 * 4 + r] * ptrWorld[1 * 4 + c] +
+                    viewProjection[2 * 4 + r] * ptrWorld[2 * 4 + c] +
+                    viewProjection[3 * 4 + r] * (matrixFloats == 16 ? ptrWorld[3 * 4 + c] : lastRow);
+            }
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define RTR_TRANSFORM_BATCH_SSE
+#endif
+
+namespace RTR
+{
+    // Transforms in SoA layout (all arrays hold at least as many elements as the batch is used for)
+    struct TransformBatch
+    {
+        // Translation
+        const float* ptrPositionX = nullptr;
+        const float* ptrPositionY = nullptr;
+        const float* ptrPositionZ = nullptr;
+        // Unit quaternion
+        const float* ptrRotationX = nullptr;
+        const float* ptrRotationY = nullptr;
+        const float* ptrRotationZ = nullptr;
+        const float* ptrRotationW = nullptr;
+        // Scale
+        const float* ptrScaleX = nullptr;
+        const float* ptrScaleY = nullptr;
+        const float* ptrScaleZ = nullptr;
+    };
+
+    // Write the transposed world matrices (scale * rotation * translation like DirectXMath) of transforms [begin, end).
+    // Transform i goes to ptrMatricesOut + offsets[i] * matrixFloats (16: row major 4x4 as uploaded to the gpu, 12: without the constant last row).
+    void TransformBatchCompose(const TransformBatch& batch, size_t begin, size_t end, const uint32_t* offsets, float* ptrMatricesOut, size_t matrixFloats = 16);
+    // Reference implementation without SIMD
+    void TransformBatchComposeScalar(const TransformBatch& batch, size_t begin, size_t end, const uint32_t* offsets, float* ptrMatricesOut, size_t matrixFloats = 16);
+
+    // Concatenate transposed matrices with a row major 4x4 viewProjection (row vectors like DirectXMath) for elements [begin, end):
+    // ptrOut[i] = transpose(world * viewProjection) where transpose(world) is read from ptrMatrices + offsets[i] * matrixFloats
+    // (12 floats imply a last row of 0, 0, 0, 1). Output matrices are 16 floats each, ready for constant buffers.
+    void TransformBatchConcatenate(const float* ptrMatrices, size_t matrixFloats, const uint32_t* offsets, size_t begin, size_t end, const float* viewProjection, float* ptrOut);
+    // Reference implementation without SIMD
+    void TransformBatchConcatenateScalar(const float* ptrMatrices, size_t matrixFloats, const uint32_t* offsets, size_t begin, size_t end, const float* viewProjection, float* ptrOut);
+}
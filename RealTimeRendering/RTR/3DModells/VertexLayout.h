@@ -0,0 +1,281 @@
+#pragma once
+
+#include <WinInclude.h>
+#include <D3DCommon/D3DPipelineState.h>
+#include <RTR/3DModells/VertexQuantization.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define RTR_VERTEX_LAYOUT_SSE
+#include <immintrin.h>
+#endif
+
+namespace RTR
+{
+    // Stream an attribute is read from (SoA arrays of the importer)
+    enum class VertexSource : UINT
+    {
+        Position = 0,
+        Normal,
+        Tangent,
+        Bitangent,
+        TexCoord0,
+        TexCoord1,
+        Color0,
+
+        // Count of sources
+        Count,
+    };
+
+    // Format an attribute is stored in
+    enum class VertexFormat : UINT
+    {
+        // 32 bit floats (missing components are 0, w of positions is 1)
+        Float2 = 0,
+        Float3,
+        Float4,
+        // 16 bit floats
+        Half2,
+        Half4,
+        // Normalized integers
+        Snorm16x4,
+        Unorm8x4,
+    };
+
+    // One attribute of an interleaved vertex
+    struct VertexAttribute
+    {
+        const char* semantic;
+        UINT semanticIndex;
+        VertexFormat format;
+        VertexSource source;
+    };
+
+    // Source arrays of one mesh (components floats per element, nullptr for missing streams)
+    struct VertexStreams
+    {
+        const float* ptrData[(UINT)VertexSource::Count] = {};
+        UINT stride[(UINT)VertexSource::Count] = {};
+    };
+
+    // Size of a format in bytes
+    constexpr UINT VertexFormatSize(VertexFormat format)
+    {
+        return
+            format == VertexFormat::Float2 ? 8 :
+            format == VertexFormat::Float3 ? 12 :
+            format == VertexFormat::Float4 ? 16 :
+            format == VertexFormat::Half2 ? 4 :
+            format == VertexFormat::Half4 ? 8 :
+            format == VertexFormat::Snorm16x4 ? 8 : 4;
+    }
+
+    // DXGI format of a format
+    constexpr DXGI_FORMAT VertexFormatDxgi(VertexFormat format)
+    {
+        return
+            format == VertexFormat::Float2 ? DXGI_FORMAT_R32G32_FLOAT :
+            format == VertexFormat::Float3 ? DXGI_FORMAT_R32G32B32_FLOAT :
+            format == VertexFormat::Float4 ? DXGI_FORMAT_R32G32B32A32_FLOAT :
+            format == VertexFormat::Half2 ? DXGI_FORMAT_R16G16_FLOAT :
+            format == VertexFormat::Half4 ? DXGI_FORMAT_R16G16B16A16_FLOAT :
+            format == VertexFormat::Snorm16x4 ? DXGI_FORMAT_R16G16B16A16_SNORM : DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+
+    // === Layout traits ===
+    // A layout is a type with a static constexpr VertexAttribute Attributes[] member:
+    //     struct MyLayout { static constexpr VertexAttribute Attributes[] = { { "POSITION", 0, VertexFormat::Float3, VertexSource::Position } }; };
+
+    template<typename TLayout>
+    constexpr size_t VertexLayoutAttributeCount()
+    {
+        return sizeof(TLayout::Attributes) / sizeof(VertexAttribute);
+    }
+
+    template<typename TLayout>
+    constexpr UINT VertexLayoutOffset(size_t attribute)
+    {
+        UINT offset = 0;
+        for (size_t i = 0; i < attribute; i++)
+            offset += VertexFormatSize(TLayout::Attributes[i].format);
+        return offset;
+    }
+
+    template<typename TLayout>
+    constexpr UINT VertexLayoutStride()
+    {
+        return VertexLayoutOffset<TLayout>(VertexLayoutAttributeCount<TLayout>());
+    }
+
+    // Identifies the layout for the mesh cache (never 0)
+    template<typename TLayout>
+    constexpr uint64_t VertexLayoutHash()
+    {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        auto mix = [&hash](uint64_t value) { hash = (hash ^ value) * 0x100000001B3ULL; };
+        for (size_t i = 0; i < VertexLayoutAttributeCount<TLayout>(); i++)
+        {
+            const VertexAttribute& attribute = TLayout::Attributes[i];
+            for (const char* c = attribute.semantic; *c; c++)
+                mix((unsigned char)*c);
+            mix(attribute.semanticIndex);
+            mix((uint64_t)attribute.format);
+            mix((uint64_t)attribute.source);
+        }
+        return hash ? hash : 1;
+    }
+
+    // Add the input elements of a layout (slot 0, in attribute order)
+    template<typename TLayout>
+    void VertexLayoutAddInputElements(GfxPsoManipulator* ptrManipulator)
+    {
+        for (size_t i = 0; i < VertexLayoutAttributeCount<TLayout>(); i++)
+        {
+            const VertexAttribute& attribute = TLayout::Attributes[i];
+            ptrManipulator->IAAddElement(attribute.semantic, VertexFormatDxgi(attribute.format), attribute.semanticIndex);
+        }
+    }
+
+    // === Assembly ===
+    namespace VertexLayoutDetail
+    {
+        // Value of w when the source has only three components
+        constexpr float DefaultW(VertexSource source)
+        {
+            return source == VertexSource::Position ? 1.0f : 0.0f;
+        }
+
+        // Convert one attribute of count vertices (SoA -> AoS column)
+        template<VertexSource Source, VertexFormat Format>
+        void AssembleAttribute(unsigned char* ptrOut, size_t outStride, const float* ptrSource, size_t sourceStride, const unsigned int* remap, size_t count)
+        {
+            constexpr float w = DefaultW(Source);
+            const size_t sourceComponents = sourceStride / sizeof(float);
+
+            // Missing streams are zero (w of positions is 1)
+            if (!ptrSource)
+            {
+                unsigned char zero[16] = {};
+                if (Format == VertexFormat::Float4)
+                    memcpy(&zero[12], &w, sizeof(float));
+                for (size_t i = 0; i < count; i++)
+                    memcpy(ptrOut + outStride * i, zero, VertexFormatSize(Format));
+                return;
+            }
+
+            #ifdef RTR_VERTEX_LAYOUT_SSE
+            const __m128 wVector = _mm_set_ps(sourceComponents < 4 ? w : 0.0f, 0.0f, 0.0f, 0.0f);
+            #endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const float* s = (const float*)((const unsigned char*)ptrSource + sourceStride * (remap ? remap[i] : i));
+                unsigned char* d = ptrOut + outStride * i;
+
+                if constexpr (Format == VertexFormat::Float2)
+                {
+                    memcpy(d, s, sizeof(float) * 2);
+                }
+                else if constexpr (Format == VertexFormat::Float3)
+                {
+                    memcpy(d, s, sizeof(float) * 3);
+                    if (sourceComponents < 3)
+                        memset(d + sizeof(float) * 2, 0x00, sizeof(float));
+                }
+                else
+                {
+                    #ifdef RTR_VERTEX_LAYOUT_SSE
+                    // Load the components of the element without reading past it
+                    __m128 v =
+                        sourceComponents >= 4 ? _mm_loadu_ps(s) :
+                        sourceComponents == 3 ? _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd((const double*)s)), _mm_load_ss(s + 2)) :
+                        _mm_castpd_ps(_mm_load_sd((const double*)s));
+                    v = _mm_add_ps(v, wVector);
+
+                    if constexpr (Format == VertexFormat::Float4)
+                    {
+                        _mm_storeu_ps((float*)d, v);
+                    }
+                    else if constexpr (Format == VertexFormat::Snorm16x4)
+                    {
+                        v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+                        __m128i i32 = _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(32767.0f)));
+                        _mm_storel_epi64((__m128i*)d, _mm_packs_epi32(i32, i32));
+                    }
+                    else if constexpr (Format == VertexFormat::Unorm8x4)
+                    {
+                        v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                        __m128i i32 = _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(255.0f)));
+                        __m128i i16 = _mm_packs_epi32(i32, i32);
+                        int packed = _mm_cvtsi128_si32(_mm_packus_epi16(i16, i16));
+                        memcpy(d, &packed, sizeof(packed));
+                    }
+                    #if defined(__F16C__) || defined(__AVX2__)
+                    else if constexpr (Format == VertexFormat::Half2 || Format == VertexFormat::Half4)
+                    {
+                        __m128i h = _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+                        if constexpr (Format == VertexFormat::Half4)
+                            _mm_storel_epi64((__m128i*)d, h);
+                        else
+                        {
+                            int packed = _mm_cvtsi128_si32(h);
+                            memcpy(d, &packed, sizeof(packed));
+                        }
+                    }
+                    #endif
+                    else
+                    #endif
+                    {
+                        // Scalar conversion
+                        float f[4] = { s[0], s[1], sourceComponents >= 3 ? s[2] : 0.0f, sourceComponents >= 4 ? s[3] : w };
+                        if constexpr (Format == VertexFormat::Float4)
+                        {
+                            memcpy(d, f, sizeof(f));
+                        }
+                        else if constexpr (Format == VertexFormat::Half2 || Format == VertexFormat::Half4)
+                        {
+                            uint16_t h[4] = { FloatToHalf(f[0]), FloatToHalf(f[1]), FloatToHalf(f[2]), FloatToHalf(f[3]) };
+                            memcpy(d, h, VertexFormatSize(Format));
+                        }
+                        else if constexpr (Format == VertexFormat::Snorm16x4)
+                        {
+                            int16_t q[4] = { QuantizeSnorm16(f[0]), QuantizeSnorm16(f[1]), QuantizeSnorm16(f[2]), QuantizeSnorm16(f[3]) };
+                            memcpy(d, q, sizeof(q));
+                        }
+                        else
+                        {
+                            unsigned char q[4];
+                            for (unsigned int k = 0; k < 4; k++)
+                            {
+                                const float c = f[k] < 0.0f ? 0.0f : (f[k] > 1.0f ? 1.0f : f[k]);
+                                q[k] = (unsigned char)(c * 255.0f + 0.5f);
+                            }
+                            memcpy(d, q, sizeof(q));
+                        }
+                    }
+                }
+            }
+        }
+
+        template<typename TLayout, size_t... I>
+        void Assemble(unsigned char* ptrOut, const VertexStreams& streams, const unsigned int* remap, size_t count, std::index_sequence<I...>)
+        {
+            (AssembleAttribute<TLayout::Attributes[I].source, TLayout::Attributes[I].format>(
+                ptrOut + VertexLayoutOffset<TLayout>(I), VertexLayoutStride<TLayout>(),
+                streams.ptrData[(UINT)TLayout::Attributes[I].source], streams.stride[(UINT)TLayout::Attributes[I].source],
+                remap, count
+            ), ...);
+        }
+    }
+
+    // Interleave count vertices (vertex i is read from element remap[i], or i when remap is nullptr)
+    template<typename TLayout>
+    void VertexLayoutAssemble(void* ptrOut, const VertexStreams& streams, const unsigned int* remap, size_t count)
+    {
+        VertexLayoutDetail::Assemble<TLayout>((unsigned char*)ptrOut, streams, remap, count, std::make_index_sequence<VertexLayoutAttributeCount<TLayout>()>());
+    }
+}
@@ -0,0 +1,200 @@
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+uint16_t RTR::FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // NaN / Inf
+    if (((bits >> 23) & 0xFF) == 0xFF)
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+    // Overflow to Inf
+    if (exponent >= 0x1F)
+        return (uint16_t)(sign | 0x7C00);
+
+    // Subnormal or zero
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return (uint16_t)sign;
+
+        mantissa |= 0x800000;
+        const uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1U << shift) - 1);
+        const uint32_t halfway = 1U << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            half++;
+        return (uint16_t)(sign | half);
+    }
+
+    // Normal (rounding may carry into the exponent which is still correct)
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        half++;
+    return (uint16_t)(sign | half);
+}
+
+float RTR::HalfToFloat(uint16_t value)
+{
+    const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0x1F)
+    {
+        // NaN / Inf
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent == 0)
+    {
+        if (!mantissa)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Normalize subnormal
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400))
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    }
+    else
+    {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void RTR::OctahedralEncode(const float* ptrVector, float* ptrEncodedOut)
+{
+    // Project onto the octahedron
+    const float length = std::fabs(ptrVector[0]) + std::fabs(ptrVector[1]) + std::fabs(ptrVector[2]);
+    if (length <= 0.0f)
+    {
+        ptrEncodedOut[0] = 0.0f;
+        ptrEncodedOut[1] = 0.0f;
+        return;
+    }
+    float x = ptrVector[0] / length;
+    float y = ptrVector[1] / length;
+
+    // Fold the lower hemisphere over the diagonals
+    if (ptrVector[2] < 0.0f)
+    {
+        const float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    ptrEncodedOut[0] = x;
+    ptrEncodedOut[1] = y;
+}
+
+void RTR::OctahedralDecode(const float* ptrEncoded, float* ptrVectorOut)
+{
+    float x = ptrEncoded[0];
+    float y = ptrEncoded[1];
+    const float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+    // Unfold the lower hemisphere
+    if (z < 0.0f)
+    {
+        const float unfoldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float unfoldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+
+    const float length = std::sqrt(x * x + y * y + z * z);
+    ptrVectorOut[0] = x / length;
+    ptrVectorOut[1] = y / length;
+    ptrVectorOut[2] = z / length;
+}
+
+RTR::VertexDequantization RTR::ComputeVertexDequantization(const float* positions, size_t positionStride, size_t vertexCount)
+{
+    VertexDequantization dequantization;
+    if (!vertexCount)
+        return dequantization;
+
+    float minimum[3] = { positions[0], positions[1], positions[2] };
+    float maximum[3] = { positions[0], positions[1], positions[2] };
+    for (size_t v = 1; v < vertexCount; v++)
+    {
+        const float* p = (const float*)((const unsigned char*)positions + positionStride * v);
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            minimum[k] = std::min(minimum[k], p[k]);
+            maximum[k] = std::max(maximum[k], p[k]);
+        }
+    }
+
+    for (unsigned int k = 0; k < 3; k++)
+    {
+        // Flat axes keep a unit scale so quantization never divides by zero
+        const float halfExtent = (maximum[k] - minimum[k]) * 0.5f;
+        dequantization.positionScale[k] = halfExtent > 0.0f ? halfExtent : 1.0f;
+        dequantization.positionOffset[k] = (maximum[k] + minimum[k]) * 0.5f;
+    }
+
+    return dequantization;
+}
+
+void RTR::QuantizeVertex(QuantizedVertex* ptrVertexOut, const VertexDequantization& dequantization,
+    const float* ptrPosition, const float* ptrNormal, const float* ptrTangent, const float* ptrBitangent, const float* ptrUv)
+{
+    // Position relative to the bounds
+    for (unsigned int k = 0; k < 3; k++)
+        ptrVertexOut->position[k] = QuantizeSnorm16((ptrPosition[k] - dequantization.positionOffset[k]) / dequantization.positionScale[k]);
+
+    // Bitangent sign: +1 when bitangent = cross(normal, tangent)
+    float handedness = 1.0f;
+    if (ptrNormal && ptrTangent && ptrBitangent)
+    {
+        const float c[3] = {
+            ptrNormal[1] * ptrTangent[2] - ptrNormal[2] * ptrTangent[1],
+            ptrNormal[2] * ptrTangent[0] - ptrNormal[0] * ptrTangent[2],
+            ptrNormal[0] * ptrTangent[1] - ptrNormal[1] * ptrTangent[0],
+        };
+        handedness = c[0] * ptrBitangent[0] + c[1] * ptrBitangent[1] + c[2] * ptrBitangent[2] < 0.0f ? -1.0f : 1.0f;
+    }
+    ptrVertexOut->position[3] = QuantizeSnorm16(handedness);
+
+    // Unit vectors
+    float encoded[2] = { 0.0f, 0.0f };
+    if (ptrNormal)
+        OctahedralEncode(ptrNormal, encoded);
+    ptrVertexOut->normal[0] = QuantizeSnorm16(encoded[0]);
+    ptrVertexOut->normal[1] = QuantizeSnorm16(encoded[1]);
+
+    encoded[0] = encoded[1] = 0.0f;
+    if (ptrTangent)
+        OctahedralEncode(ptrTangent, encoded);
+    ptrVertexOut->tangent[0] = QuantizeSnorm16(encoded[0]);
+    ptrVertexOut->tangent[1] = QuantizeSnorm16(encoded[1]);
+
+    // Texture coordinates
+    ptrVertexOut->uv[0] = FloatToHalf(ptrUv ? ptrUv[0] : 0.0f);
+    ptrVertexOut->uv[1] = FloatToHalf(ptrUv ? ptrUv[1] : 0.0f);
+}
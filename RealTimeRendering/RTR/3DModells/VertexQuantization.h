@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace RTR
+{
+    // Compressed vertex written by the loader when ModelImportOptions::quantizeVertices is set (20 bytes)
+    struct QuantizedVertex
+    {
+        // DXGI_FORMAT_R16G16B16A16_SNORM: xyz relative to the mesh bounds (see VertexDequantization), w is the bitangent sign (+-1)
+        int16_t position[4];
+        // DXGI_FORMAT_R16G16_SNORM: octahedral encoded unit vectors
+        int16_t normal[2];
+        int16_t tangent[2];
+        // DXGI_FORMAT_R16G16_FLOAT: first uv channel
+        uint16_t uv[2];
+    };
+
+    // Per mesh constants to restore model space positions: position = snorm * positionScale + positionOffset
+    struct VertexDequantization
+    {
+        float positionScale[3] = { 1.0f, 1.0f, 1.0f };
+        float positionOffset[3] = { 0.0f, 0.0f, 0.0f };
+    };
+
+    // SNORM16 conversion
+    inline int16_t QuantizeSnorm16(float value)
+    {
+        value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+        return (int16_t)(value * 32767.0f + (value >= 0.0f ? 0.5f : -0.5f));
+    }
+    inline float DequantizeSnorm16(int16_t value)
+    {
+        const float f = (float)value / 32767.0f;
+        return f < -1.0f ? -1.0f : f;
+    }
+
+    // IEEE 754 half precision conversion (round to nearest even)
+    uint16_t FloatToHalf(float value);
+    float HalfToFloat(uint16_t value);
+
+    // Octahedral unit vector encoding (Cigolle et al. 2014), output in [-1, 1]
+    void OctahedralEncode(const float* ptrVector, float* ptrEncodedOut);
+    void OctahedralDecode(const float* ptrEncoded, float* ptrVectorOut);
+
+    // Dequantization constants that map the bounds of all positions to [-1, 1]
+    VertexDequantization ComputeVertexDequantization(const float* positions, size_t positionStride, size_t vertexCount);
+
+    // Compress one vertex (normal / tangent / bitangent / uv are optional)
+    void QuantizeVertex(QuantizedVertex* ptrVertexOut, const VertexDequantization& dequantization,
+        const float* ptrPosition, const float* ptrNormal, const float* ptrTangent, const float* ptrBitangent, const float* ptrUv);
+
+    // 16 bit indices fit meshes with up to 65535 vertices (indices 0 - 65534, 0xFFFF stays free as the strip cut value)
+    constexpr size_t ShortIndexMaxVertices = 0xFFFF;
+    constexpr bool ShortIndicesFit(size_t vertexCount)
+    {
+        return vertexCount <= ShortIndexMaxVertices;
+    }
+}
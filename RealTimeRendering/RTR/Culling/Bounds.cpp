@@ -0,0 +1,70 @@
+#include "Bounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+RTR::MeshBounds RTR::ComputeMeshBounds(const float* positions, size_t positionStride, size_t count)
+{
+    MeshBounds bounds;
+    if (!count)
+        return bounds;
+
+    auto position = [&](size_t i) { return (const float*)((const unsigned char*)positions + positionStride * i); };
+
+    // Box
+    for (unsigned int c = 0; c < 3; c++)
+        bounds.box.min[c] = bounds.box.max[c] = positions[c];
+    for (size_t i = 1; i < count; i++)
+    {
+        const float* p = position(i);
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            bounds.box.min[c] = std::min(bounds.box.min[c], p[c]);
+            bounds.box.max[c] = std::max(bounds.box.max[c], p[c]);
+        }
+    }
+
+    // Sphere around the box center
+    float radiusSq = 0.0f;
+    for (unsigned int c = 0; c < 3; c++)
+        bounds.sphere.center[c] = (bounds.box.min[c] + bounds.box.max[c]) * 0.5f;
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* p = position(i);
+        const float dx = p[0] - bounds.sphere.center[0], dy = p[1] - bounds.sphere.center[1], dz = p[2] - bounds.sphere.center[2];
+        radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+    }
+    bounds.sphere.radius = std::sqrt(radiusSq);
+
+    return bounds;
+}
+
+RTR::BoundingSphere RTR::TransformBoundingSphere(const BoundingSphere& sphere, const float* matrix)
+{
+    BoundingSphere out;
+    for (unsigned int c = 0; c < 3; c++)
+        out.center[c] = sphere.center[0] * matrix[c] + sphere.center[1] * matrix[4 + c] + sphere.center[2] * matrix[8 + c] + matrix[12 + c];
+
+    // Largest scale of the three axes
+    float scaleSq = 0.0f;
+    for (unsigned int r = 0; r < 3; r++)
+        scaleSq = std::max(scaleSq, matrix[r * 4] * matrix[r * 4] + matrix[r * 4 + 1] * matrix[r * 4 + 1] + matrix[r * 4 + 2] * matrix[r * 4 + 2]);
+    out.radius = sphere.radius * std::sqrt(scaleSq);
+
+    return out;
+}
+
+RTR::BoundingSphere RTR::TransformBoundingSphereTransposed(const BoundingSphere& sphere, const float* matrix)
+{
+    BoundingSphere out;
+    for (unsigned int c = 0; c < 3; c++)
+        out.center[c] = sphere.center[0] * matrix[c * 4] + sphere.center[1] * matrix[c * 4 + 1] + sphere.center[2] * matrix[c * 4 + 2] + matrix[c * 4 + 3];
+
+    // Largest scale of the three axes (columns of the transposed matrix)
+    float scaleSq = 0.0f;
+    for (unsigned int r = 0; r < 3; r++)
+        scaleSq = std::max(scaleSq, matrix[r] * matrix[r] + matrix[4 + r] * matrix[4 + r] + matrix[8 + r] * matrix[8 + r]);
+    out.radius = sphere.radius * std::sqrt(scaleSq);
+
+    return out;
+}
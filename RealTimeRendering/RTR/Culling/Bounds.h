@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+namespace RTR
+{
+    // Axis aligned box
+    struct BoundingBox
+    {
+        float min[3] = { 0.0f, 0.0f, 0.0f };
+        float max[3] = { 0.0f, 0.0f, 0.0f };
+    };
+
+    // Sphere
+    struct BoundingSphere
+    {
+        float center[3] = { 0.0f, 0.0f, 0.0f };
+        float radius = 0.0f;
+    };
+
+    // Model space bounds of a mesh
+    struct MeshBounds
+    {
+        BoundingBox box;
+        BoundingSphere sphere;
+    };
+
+    // Box and sphere of count positions (the sphere is centered in the box and touches the most distant position)
+    MeshBounds ComputeMeshBounds(const float* positions, size_t positionStride, size_t count);
+
+    // Sphere that encloses a transformed sphere (matrix is row major 4x4 with row vectors like DirectXMath, radius scales by the largest axis)
+    BoundingSphere TransformBoundingSphere(const BoundingSphere& sphere, const float* matrix);
+    // Same for a transposed matrix as stored by MatrixBuffer (only the first three rows are read, 3x4 storage works as well)
+    BoundingSphere TransformBoundingSphereTransposed(const BoundingSphere& sphere, const float* matrix);
+}
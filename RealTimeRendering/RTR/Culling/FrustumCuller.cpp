@@ -0,0 +1,225 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifdef RTR_CULLING_SSE
+#include <immintrin.h>
+#endif
+
+RTR::Frustum RTR::FrustumFromViewProjection(const float* viewProjection)
+{
+    // Clip space component c of a row vector is the dot product with column c
+    auto column = [viewProjection](unsigned int c, float* ptrOut)
+    {
+        for (unsigned int r = 0; r < 4; r++)
+            ptrOut[r] = viewProjection[r * 4 + c];
+    };
+    float cx[4], cy[4], cz[4], cw[4];
+    column(0, cx);
+    column(1, cy);
+    column(2, cz);
+    column(3, cw);
+
+    // Left, right, bottom, top, near (z >= 0) and far (z <= w)
+    Frustum frustum;
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        frustum.planes[0][i] = cw[i] + cx[i];
+        frustum.planes[1][i] = cw[i] - cx[i];
+        frustum.planes[2][i] = cw[i] + cy[i];
+        frustum.planes[3][i] = cw[i] - cy[i];
+        frustum.planes[4][i] = cz[i];
+        frustum.planes[5][i] = cw[i] - cz[i];
+    }
+
+    // Normalize (degenerated planes like an infinite far plane keep their sign and never cull)
+    for (auto& plane : frustum.planes)
+    {
+        const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f)
+        {
+            for (unsigned int i = 0; i < 4; i++)
+                plane[i] /= length;
+        }
+    }
+
+    return frustum;
+}
+
+size_t RTR::CullingSpheres::Add(const BoundingSphere& sphere)
+{
+    // Grow by whole batches, padding can never be visible
+    if (m_count == m_x.size())
+    {
+        const size_t size = m_count + BatchSize;
+        m_x.resize(size, 0.0f);
+        m_y.resize(size, 0.0f);
+        m_z.resize(size, 0.0f);
+        m_radius.resize(size, -std::numeric_limits<float>::infinity());
+    }
+
+    Set(m_count, sphere);
+    return m_count++;
+}
+
+void RTR::CullingSpheres::Set(size_t idx, const BoundingSphere& sphere)
+{
+    m_x[idx] = sphere.center[0];
+    m_y[idx] = sphere.center[1];
+    m_z[idx] = sphere.center[2];
+    m_radius[idx] = sphere.radius;
+}
+
+void RTR::CullingSpheres::Clear()
+{
+    m_count = 0;
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_radius.clear();
+}
+
+RTR::FrustumCuller::FrustumCuller(WorkerPool& workers, size_t chunkSize) :
+    m_workers(workers),
+    // Chunks start at batch boundaries
+    m_chunkSize(std::max<size_t>((chunkSize + CullingSpheres::BatchSize - 1) / CullingSpheres::BatchSize, 1) * CullingSpheres::BatchSize)
+{ }
+
+RTR::CullingStats RTR::FrustumCuller::Cull(const Frustum& frustum, const CullingSpheres& spheres, std::vector<uint32_t>& visibleOut)
+{
+    CullingStats stats;
+    stats.tested = spheres.GetCount();
+    stats.chunks = (stats.tested + m_chunkSize - 1) / m_chunkSize;
+    visibleOut.resize(stats.tested);
+
+    // Small sets are not worth waking the workers
+    if (stats.chunks <= 1)
+    {
+        stats.visible = CullRange(frustum, spheres, 0, stats.tested, visibleOut.data());
+        visibleOut.resize(stats.visible);
+        return stats;
+    }
+
+    // Every chunk writes its own list
+    if (m_chunkVisible.size() < stats.chunks)
+        m_chunkVisible.resize(stats.chunks);
+    m_chunkCount.resize(stats.chunks);
+    m_workers.ParallelFor(stats.chunks, [&](size_t chunk)
+        {
+            const size_t begin = chunk * m_chunkSize;
+            const size_t end = std::min(begin + m_chunkSize, stats.tested);
+            m_chunkVisible[chunk].resize(m_chunkSize);
+            m_chunkCount[chunk] = CullRange(frustum, spheres, begin, end, m_chunkVisible[chunk].data());
+        }
+    );
+
+    // Concatenate in chunk order (keeps the indices ascending)
+    for (size_t chunk = 0; chunk < stats.chunks; chunk++)
+    {
+        memcpy(&visibleOut[stats.visible], m_chunkVisible[chunk].data(), m_chunkCount[chunk] * sizeof(uint32_t));
+        stats.visible += m_chunkCount[chunk];
+    }
+    visibleOut.resize(stats.visible);
+
+    return stats;
+}
+
+size_t RTR::FrustumCuller::CullRange(const Frustum& frustum, const CullingSpheres& spheres, size_t begin, size_t end, uint32_t* ptrVisibleOut)
+{
+    const float* ptrX = spheres.GetX();
+    const float* ptrY = spheres.GetY();
+    const float* ptrZ = spheres.GetZ();
+    const float* ptrRadius = spheres.GetRadius();
+    size_t count = 0;
+
+    #if defined(__AVX2__)
+    // 8 spheres per batch
+    constexpr size_t Width = 8;
+    __m256 planes[6][4];
+    for (unsigned int p = 0; p < 6; p++)
+        for (unsigned int c = 0; c < 4; c++)
+            planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+
+    auto testBatch = [&](size_t i)
+    {
+        const __m256 x = _mm256_loadu_ps(ptrX + i);
+        const __m256 y = _mm256_loadu_ps(ptrY + i);
+        const __m256 z = _mm256_loadu_ps(ptrZ + i);
+        const __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(ptrRadius + i));
+
+        // Visible when no plane has the sphere fully outside
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (unsigned int p = 0; p < 6; p++)
+        {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(x, planes[p][0]), planes[p][3]);
+            d = _mm256_add_ps(_mm256_mul_ps(y, planes[p][1]), d);
+            d = _mm256_add_ps(_mm256_mul_ps(z, planes[p][2]), d);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negRadius, _CMP_GE_OQ));
+        }
+        return (unsigned int)_mm256_movemask_ps(inside);
+    };
+    #elif defined(RTR_CULLING_SSE)
+    // 4 spheres per batch
+    constexpr size_t Width = 4;
+    __m128 planes[6][4];
+    for (unsigned int p = 0; p < 6; p++)
+        for (unsigned int c = 0; c < 4; c++)
+            planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+
+    auto testBatch = [&](size_t i)
+    {
+        const __m128 x = _mm_loadu_ps(ptrX + i);
+        const __m128 y = _mm_loadu_ps(ptrY + i);
+        const __m128 z = _mm_loadu_ps(ptrZ + i);
+        const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(ptrRadius + i));
+
+        // Visible when no plane has the sphere fully outside
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (unsigned int p = 0; p < 6; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_mul_ps(x, planes[p][0]), planes[p][3]);
+            d = _mm_add_ps(_mm_mul_ps(y, planes[p][1]), d);
+            d = _mm_add_ps(_mm_mul_ps(z, planes[p][2]), d);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+        }
+        return (unsigned int)_mm_movemask_ps(inside);
+    };
+    #else
+    return CullRangeScalar(frustum, spheres, begin, end, ptrVisibleOut);
+    #endif
+
+    #if defined(__AVX2__) || defined(RTR_CULLING_SSE)
+    for (size_t i = begin; i < end; i += Width)
+    {
+        // Branchless compaction (the write slot only advances for visible spheres)
+        const unsigned int mask = testBatch(i);
+        const size_t lanes = std::min(Width, end - i);
+        for (size_t k = 0; k < lanes; k++)
+        {
+            ptrVisibleOut[count] = (uint32_t)(i + k);
+            count += (mask >> k) & 1;
+        }
+    }
+    return count;
+    #endif
+}
+
+size_t RTR::FrustumCuller::CullRangeScalar(const Frustum& frustum, const CullingSpheres& spheres, size_t begin, size_t end, uint32_t* ptrVisibleOut)
+{
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        bool inside = true;
+        for (const auto& plane : frustum.planes)
+        {
+            const float d = spheres.GetX()[i] * plane[0] + spheres.GetY()[i] * plane[1] + spheres.GetZ()[i] * plane[2] + plane[3];
+            inside &= d >= -spheres.GetRadius()[i];
+        }
+        if (inside)
+            ptrVisibleOut[count++] = (uint32_t)i;
+    }
+    return count;
+}
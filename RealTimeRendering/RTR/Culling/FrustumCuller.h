@@ -0,0 +1,98 @@
+#pragma once
+
+#include <RTR/Culling/Bounds.h>
+#include <Util/WorkerPool.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define RTR_CULLING_SSE
+#endif
+
+namespace RTR
+{
+    // Six normalized planes (xyz normal pointing inside, w distance): a point p is inside when dot(n, p) + w >= 0 for all planes
+    struct Frustum
+    {
+        float planes[6][4];
+    };
+
+    // Frustum of a view projection matrix (row major with row vectors like DirectXMath, D3D clip space with 0 <= z <= w)
+    Frustum FrustumFromViewProjection(const float* viewProjection);
+
+    // World space spheres of many instances in SoA layout (padded to whole batches of 8)
+    class CullingSpheres
+    {
+        public:
+            // Spheres per SIMD batch (arrays are padded to it)
+            static constexpr size_t BatchSize = 8;
+
+        public:
+            // Append a sphere and return its index
+            size_t Add(const BoundingSphere& sphere);
+            // Replace a sphere
+            void Set(size_t idx, const BoundingSphere& sphere);
+            // Remove all spheres
+            void Clear();
+
+            // Count of spheres
+            inline size_t GetCount() const noexcept
+            {
+                return m_count;
+            }
+
+            // Component arrays (GetCount() valid elements, padding is a sphere that is never visible)
+            inline const float* GetX() const noexcept { return m_x.data(); }
+            inline const float* GetY() const noexcept { return m_y.data(); }
+            inline const float* GetZ() const noexcept { return m_z.data(); }
+            inline const float* GetRadius() const noexcept { return m_radius.data(); }
+
+        private:
+            size_t m_count = 0;
+            std::vector<float> m_x, m_y, m_z, m_radius;
+    };
+
+    // Result of one FrustumCuller::Cull call
+    struct CullingStats
+    {
+        size_t tested = 0;
+        size_t visible = 0;
+        // Work items handed to the workers
+        size_t chunks = 0;
+    };
+
+    // Tests spheres against a frustum in batches of 8 (AVX2) or 4 (SSE) spread over a WorkerPool
+    class FrustumCuller
+    {
+        public:
+            // Spheres per work item (smaller sets run on the calling thread only)
+            static constexpr size_t DefaultChunkSize = 4096;
+
+        public:
+            // Construct
+            FrustumCuller(WorkerPool& workers, size_t chunkSize = DefaultChunkSize);
+            FrustumCuller(const FrustumCuller&) = delete;
+
+            // Assign
+            FrustumCuller& operator=(const FrustumCuller&) = delete;
+
+            // Write the indices of all visible spheres to visibleOut in ascending order (compact, ready for the draw loop)
+            CullingStats Cull(const Frustum& frustum, const CullingSpheres& spheres, std::vector<uint32_t>& visibleOut);
+
+            // Test spheres [begin, end) on the calling thread (begin must be a multiple of CullingSpheres::BatchSize).
+            // ptrVisibleOut needs room for end - begin indices, returns the count written.
+            static size_t CullRange(const Frustum& frustum, const CullingSpheres& spheres, size_t begin, size_t end, uint32_t* ptrVisibleOut);
+            // Reference implementation without SIMD
+            static size_t CullRangeScalar(const Frustum& frustum, const CullingSpheres& spheres, size_t begin, size_t end, uint32_t* ptrVisibleOut);
+
+        private:
+            WorkerPool& m_workers;
+            size_t m_chunkSize;
+
+            // Per chunk results
+            std::vector<std::vector<uint32_t>> m_chunkVisible;
+            std::vector<size_t> m_chunkCount;
+    };
+}
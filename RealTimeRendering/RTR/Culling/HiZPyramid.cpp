@@ -0,0 +1,62 @@
+#include "HiZPyramid.h"
+
+#include <algorithm>
+
+void RTR::HiZPyramid::Build(const float* ptrDepth, uint32_t width, uint32_t height, bool reversedDepth)
+{
+    m_width = width;
+    m_height = height;
+    m_reversedDepth = reversedDepth;
+
+    // Levels down to 1x1
+    m_levelCount = 1;
+    while (GetLevelSize(width, m_levelCount - 1) > 1 || GetLevelSize(height, m_levelCount - 1) > 1)
+        m_levelCount++;
+    m_data.resize(GetLevelOffset(width, height, m_levelCount));
+
+    // Level 0 is the depth buffer
+    const size_t pixelCount = (size_t)width * height;
+    for (size_t i = 0; i < pixelCount; i++)
+        m_data[i] = reversedDepth ? 1.0f - ptrDepth[i] : ptrDepth[i];
+
+    // Farthest of the (up to) 2x2 texels below
+    for (uint32_t level = 1; level < m_levelCount; level++)
+    {
+        const uint32_t srcWidth = GetLevelSize(width, level - 1);
+        const uint32_t srcHeight = GetLevelSize(height, level - 1);
+        const uint32_t dstWidth = GetLevelSize(width, level);
+        const uint32_t dstHeight = GetLevelSize(height, level);
+        const float* ptrSrc = &m_data[GetLevelOffset(width, height, level - 1)];
+        float* ptrDst = &m_data[GetLevelOffset(width, height, level)];
+
+        for (uint32_t y = 0; y < dstHeight; y++)
+        {
+            const uint32_t y0 = y * 2;
+            const uint32_t y1 = std::min(y0 + 1, srcHeight - 1);
+            for (uint32_t x = 0; x < dstWidth; x++)
+            {
+                const uint32_t x0 = x * 2;
+                const uint32_t x1 = std::min(x0 + 1, srcWidth - 1);
+                ptrDst[(size_t)y * dstWidth + x] = std::max(
+                    std::max(ptrSrc[(size_t)y0 * srcWidth + x0], ptrSrc[(size_t)y0 * srcWidth + x1]),
+                    std::max(ptrSrc[(size_t)y1 * srcWidth + x0], ptrSrc[(size_t)y1 * srcWidth + x1])
+                );
+            }
+        }
+    }
+}
+
+uint32_t RTR::HiZPyramid::GetLevelSize(uint32_t size, uint32_t level)
+{
+    for (uint32_t i = 0; i < level; i++)
+        size = std::max(1u, (size + 1) / 2);
+    return size;
+}
+
+size_t RTR::HiZPyramid::GetLevelOffset(uint32_t width, uint32_t height, uint32_t level)
+{
+    size_t offset = 0;
+    for (uint32_t i = 0; i < level; i++)
+        offset += (size_t)GetLevelSize(width, i) * GetLevelSize(height, i);
+    return offset;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RTR
+{
+    // Mip chain of the farthest depth (D3D clip space z / w, 0 near and 1 far) of a depth buffer. Every level halves the
+    // size (rounded up) and a texel covers 2x2 texels of the level below. All levels are packed into one float array,
+    // level after level in row order, so the same data can be read by CullIndirectCS from a buffer.
+    class HiZPyramid
+    {
+        public:
+            // Build from a width * height depth buffer in row order (reversedDepth for depth buffers with 1 at the near plane, their
+            // values are stored flipped so the pyramid always holds 0 near and 1 far)
+            void Build(const float* ptrDepth, uint32_t width, uint32_t height, bool reversedDepth = false);
+
+            // Size of a level
+            static uint32_t GetLevelSize(uint32_t size, uint32_t level);
+            // First value of a level in the packed data
+            static size_t GetLevelOffset(uint32_t width, uint32_t height, uint32_t level);
+
+            // Farthest depth of a texel
+            inline float GetDepth(uint32_t level, uint32_t x, uint32_t y) const
+            {
+                return m_data[GetLevelOffset(m_width, m_height, level) + (size_t)y * GetLevelSize(m_width, level) + x];
+            }
+
+            // Properties of level 0 and the level count (down to 1x1)
+            inline uint32_t GetWidth() const noexcept
+            {
+                return m_width;
+            }
+            inline uint32_t GetHeight() const noexcept
+            {
+                return m_height;
+            }
+            inline uint32_t GetLevelCount() const noexcept
+            {
+                return m_levelCount;
+            }
+            // Built from a reversed depth buffer (the culling has to flip the projected depth the same way)
+            inline bool IsReversedDepth() const noexcept
+            {
+                return m_reversedDepth;
+            }
+
+            // Packed levels
+            inline const float* GetData() const noexcept
+            {
+                return m_data.data();
+            }
+            inline size_t GetDataSize() const noexcept
+            {
+                return m_data.size() * sizeof(float);
+            }
+
+        private:
+            uint32_t m_width = 0;
+            uint32_t m_height = 0;
+            uint32_t m_levelCount = 0;
+            bool m_reversedDepth = false;
+            std::vector<float> m_data;
+    };
+}
@@ -0,0 +1,120 @@
+#include "IndirectCulling.h"
+
+#include <RTR/Culling/FrustumCuller.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Occlusion test against the pyramid (same steps as IsOccluded in CullIndirectCS.hlsl)
+    bool IsOccluded(const RTR::IndirectCullConstants& constants, const float* sphere, const float* ptrHiZ)
+    {
+        // Screen rectangle and nearest depth of the corners of the sphere's box
+        float minX = 1.0f, minY = 1.0f, maxX = 0.0f, maxY = 0.0f, nearestZ = 1.0f;
+        for (unsigned int corner = 0; corner < 8; corner++)
+        {
+            const float p[3] = {
+                sphere[0] + (corner & 1 ? sphere[3] : -sphere[3]),
+                sphere[1] + (corner & 2 ? sphere[3] : -sphere[3]),
+                sphere[2] + (corner & 4 ? sphere[3] : -sphere[3]),
+            };
+            float clip[4];
+            for (unsigned int c = 0; c < 4; c++)
+                clip[c] = p[0] * constants.viewProjection[c * 4] + p[1] * constants.viewProjection[c * 4 + 1] + p[2] * constants.viewProjection[c * 4 + 2] + constants.viewProjection[c * 4 + 3];
+
+            // Crossing the near plane (never occluded, the near plane is at z = w with reversed depth)
+            if (clip[3] <= 0.0f || (constants.reversedDepth ? clip[2] > clip[3] : clip[2] < 0.0f))
+                return false;
+
+            const float u = clip[0] / clip[3] * 0.5f + 0.5f;
+            const float v = 0.5f - clip[1] / clip[3] * 0.5f;
+            minX = std::min(minX, u);
+            minY = std::min(minY, v);
+            maxX = std::max(maxX, u);
+            maxY = std::max(maxY, v);
+            // Flipped like the pyramid's values
+            const float z = clip[2] / clip[3];
+            nearestZ = std::min(nearestZ, constants.reversedDepth ? 1.0f - z : z);
+        }
+        minX = std::max(minX, 0.0f) * constants.hiZWidth;
+        minY = std::max(minY, 0.0f) * constants.hiZHeight;
+        maxX = std::min(maxX, 1.0f) * constants.hiZWidth;
+        maxY = std::min(maxY, 1.0f) * constants.hiZHeight;
+
+        // Level where the rectangle covers at most 2x2 texels
+        const float extent = std::max(maxX - minX, maxY - minY);
+        const uint32_t level = std::min(extent > 1.0f ? (uint32_t)std::ceil(std::log2(extent)) : 0u, constants.hiZLevels - 1);
+        const uint32_t width = RTR::HiZPyramid::GetLevelSize(constants.hiZWidth, level);
+        const uint32_t height = RTR::HiZPyramid::GetLevelSize(constants.hiZHeight, level);
+        const float* ptrLevel = ptrHiZ + RTR::HiZPyramid::GetLevelOffset(constants.hiZWidth, constants.hiZHeight, level);
+        const float scale = 1.0f / (float)(1u << level);
+
+        const uint32_t x0 = std::min((uint32_t)(minX * scale), width - 1);
+        const uint32_t y0 = std::min((uint32_t)(minY * scale), height - 1);
+        const uint32_t x1 = std::min((uint32_t)(maxX * scale), width - 1);
+        const uint32_t y1 = std::min((uint32_t)(maxY * scale), height - 1);
+
+        // Occluded when nearer than everything in front of it
+        float farthest = 0.0f;
+        for (uint32_t y = y0; y <= y1; y++)
+        {
+            for (uint32_t x = x0; x <= x1; x++)
+                farthest = std::max(farthest, ptrLevel[(size_t)y * width + x]);
+        }
+        return nearestZ > farthest;
+    }
+}
+
+RTR::IndirectCullConstants RTR::MakeIndirectCullConstants(const float* viewProjection, uint32_t drawCount, uint32_t commandValues, const HiZPyramid* ptrHiZ)
+{
+    IndirectCullConstants constants = {};
+    for (unsigned int r = 0; r < 4; r++)
+    {
+        for (unsigned int c = 0; c < 4; c++)
+            constants.viewProjection[c * 4 + r] = viewProjection[r * 4 + c];
+    }
+
+    const Frustum frustum = FrustumFromViewProjection(viewProjection);
+    memcpy(constants.planes, frustum.planes, sizeof(constants.planes));
+
+    constants.drawCount = drawCount;
+    constants.commandValues = commandValues;
+    if (ptrHiZ)
+    {
+        constants.hiZWidth = ptrHiZ->GetWidth();
+        constants.hiZHeight = ptrHiZ->GetHeight();
+        constants.hiZLevels = ptrHiZ->GetLevelCount();
+        constants.reversedDepth = ptrHiZ->IsReversedDepth() ? 1 : 0;
+    }
+
+    return constants;
+}
+
+bool RTR::IsDrawableVisible(const IndirectCullConstants& constants, const float* sphere, const float* ptrHiZ)
+{
+    // Frustum
+    for (const auto& plane : constants.planes)
+    {
+        if (sphere[0] * plane[0] + sphere[1] * plane[1] + sphere[2] * plane[2] + plane[3] < -sphere[3])
+            return false;
+    }
+
+    // Occlusion
+    return !constants.hiZLevels || !IsOccluded(constants, sphere, ptrHiZ);
+}
+
+uint32_t RTR::CullIndirectReference(const IndirectCullConstants& constants, const float* spheres, const uint32_t* commands, const float* ptrHiZ, uint32_t* ptrArgumentsOut)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < constants.drawCount; i++)
+    {
+        if (IsDrawableVisible(constants, spheres + (size_t)i * 4, ptrHiZ))
+        {
+            memcpy(ptrArgumentsOut + (size_t)count * constants.commandValues, commands + (size_t)i * constants.commandValues, constants.commandValues * sizeof(uint32_t));
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <RTR/Culling/HiZPyramid.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace RTR
+{
+    // Constants of the culling pass (Cull in CullIndirectCS.hlsl)
+    struct IndirectCullConstants
+    {
+        // Transposed view projection (row vectors like DirectXMath, as read by the shader)
+        float viewProjection[16];
+        // Frustum planes (see Frustum)
+        float planes[6][4];
+        // Drawables to test and 32 bit values per command (see IndirectDrawBuilder)
+        uint32_t drawCount;
+        uint32_t commandValues;
+        // Hi-Z pyramid (see HiZPyramid, no levels disable the occlusion test)
+        uint32_t hiZWidth;
+        uint32_t hiZHeight;
+        uint32_t hiZLevels;
+        // The view projection maps the near plane to 1 (taken from the pyramid, see HiZPyramid::IsReversedDepth)
+        uint32_t reversedDepth;
+        uint32_t padding[2];
+    };
+    static_assert(sizeof(IndirectCullConstants) == 192, "IndirectCullConstants must match the hlsl layout");
+
+    // Constants for a view projection (row major 4x4 like FrustumFromViewProjection) and an optional pyramid of the last depth buffer
+    IndirectCullConstants MakeIndirectCullConstants(const float* viewProjection, uint32_t drawCount, uint32_t commandValues, const HiZPyramid* ptrHiZ = nullptr);
+
+    // Test of one drawable as done by one thread of CullIndirectCS. sphere is the world space center and radius, ptrHiZ the
+    // packed pyramid data (unused without levels). Visible when inside the frustum and not behind the pyramid's depth.
+    bool IsDrawableVisible(const IndirectCullConstants& constants, const float* sphere, const float* ptrHiZ);
+
+    // Reference of CullIndirectCS: appends the command (commandValues 32 bit values from commands) of every visible drawable to
+    // ptrArgumentsOut and returns the count. spheres holds drawCount float4 spheres. Commands keep the order of the drawables,
+    // the gpu appends them in any order.
+    uint32_t CullIndirectReference(const IndirectCullConstants& constants, const float* spheres, const uint32_t* commands, const float* ptrHiZ, uint32_t* ptrArgumentsOut);
+}
@@ -0,0 +1,36 @@
+#include "AtomicBumpAllocator.h"
+
+RTR::AtomicBumpAllocator::AtomicBumpAllocator(uint64_t size)
+{
+    Reset(size);
+}
+
+void RTR::AtomicBumpAllocator::Reset(uint64_t size)
+{
+    m_size = size;
+    Reset();
+}
+
+void RTR::AtomicBumpAllocator::Reset()
+{
+    m_usage.store(0, std::memory_order_relaxed);
+}
+
+bool RTR::AtomicBumpAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t* ptrOffsetOut)
+{
+    if (!alignment || size > m_size)
+        return false;
+
+    // Bump only when the aligned range fits (a failed compare exchange reloads the usage of the winning thread)
+    uint64_t usage = m_usage.load(std::memory_order_relaxed);
+    uint64_t offset;
+    do
+    {
+        offset = (usage + alignment - 1) / alignment * alignment;
+        if (offset < usage || offset > m_size - size)
+            return false;
+    } while (!m_usage.compare_exchange_weak(usage, offset + size, std::memory_order_relaxed));
+
+    *ptrOffsetOut = offset;
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace RTR
+{
+    // Lock free linear allocator over an external memory range. Any thread may allocate at any time (compare exchange loop),
+    // Reset must not race with allocations. Only bookkeeping lives here, so the reservation path runs headless.
+    class AtomicBumpAllocator
+    {
+        public:
+            // Construct
+            AtomicBumpAllocator(uint64_t size = 0);
+
+            // Start over on a range of size bytes / the current range
+            void Reset(uint64_t size);
+            void Reset();
+
+            // Allocate size bytes at a multiple of alignment (any non zero value). A failed allocation leaves the range untouched,
+            // so smaller ones may still fit.
+            bool Allocate(uint64_t size, uint64_t alignment, uint64_t* ptrOffsetOut);
+
+            // Statistics
+            inline uint64_t GetSize() const
+            {
+                return m_size;
+            }
+            inline uint64_t GetUsedSize() const
+            {
+                return m_usage.load(std::memory_order_relaxed);
+            }
+            inline uint64_t GetFreeSize() const
+            {
+                return m_size - GetUsedSize();
+            }
+
+        private:
+            uint64_t m_size = 0;
+            std::atomic<uint64_t> m_usage = 0;
+    };
+}
@@ -0,0 +1,32 @@
+#include "CopyCoalescing.h"
+
+#include <algorithm>
+#include <functional>
+
+size_t RTR::CoalesceBufferCopies(std::vector<BufferCopy>& copies)
+{
+    if (copies.empty())
+        return 0;
+
+    // Group by target in target order (copies to the same bytes race on the gpu anyway, stable keeps the commit order)
+    std::stable_sort(copies.begin(), copies.end(), [](const BufferCopy& a, const BufferCopy& b)
+        {
+            return a.ptrTarget != b.ptrTarget ? std::less<const void*>()(a.ptrTarget, b.ptrTarget) : a.targetOffset < b.targetOffset;
+        });
+
+    // Grow each copy as long as the next one continues it in both buffers
+    size_t count = 1;
+    for (size_t i = 1; i < copies.size(); i++)
+    {
+        BufferCopy& merged = copies[count - 1];
+        const BufferCopy& next = copies[i];
+        if (next.ptrTarget == merged.ptrTarget && next.targetOffset == merged.targetOffset + merged.size && next.sourceOffset == merged.sourceOffset + merged.size)
+            merged.size += next.size;
+        else
+            copies[count++] = next;
+    }
+
+    const size_t mergedCount = copies.size() - count;
+    copies.resize(count);
+    return mergedCount;
+}
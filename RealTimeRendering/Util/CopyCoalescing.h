@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RTR
+{
+    // Deferred copy of size bytes from sourceOffset of a staging buffer to targetOffset of ptrTarget (any resource handle)
+    struct BufferCopy
+    {
+        const void* ptrTarget;
+        uint64_t targetOffset;
+        uint64_t sourceOffset;
+        uint64_t size;
+    };
+
+    // Sort copies by target and target offset and merge every copy into its predecessor when it continues it in both the
+    // source and the target. copies keeps the copies to record, returns the count of copies merged away. Copies to the same
+    // target bytes keep their commit order.
+    size_t CoalesceBufferCopies(std::vector<BufferCopy>& copies);
+}
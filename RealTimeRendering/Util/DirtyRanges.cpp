@@ -0,0 +1,39 @@
+#include "DirtyRanges.h"
+
+namespace
+{
+    inline bool IsDirty(const uint64_t* bits, uint32_t idx)
+    {
+        return (bits[idx / 64] >> (idx % 64)) & 1;
+    }
+}
+
+RTR::DirtyRange RTR::FindDirtyRange(const uint64_t* bits, uint32_t from, uint32_t end, uint32_t mergeGap)
+{
+    // Skip clean elements (whole words at once)
+    uint32_t idx = from;
+    while (idx < end && !IsDirty(bits, idx))
+        idx = idx % 64 == 0 && !bits[idx / 64] ? idx + 64 : idx + 1;
+    if (idx >= end)
+        return { end, end };
+
+    // Grow the range over gaps of up to mergeGap clean elements
+    DirtyRange range = { idx, idx + 1 };
+    for (idx = range.end; idx < end && idx - range.end <= mergeGap; idx++)
+    {
+        if (IsDirty(bits, idx))
+            range.end = idx + 1;
+    }
+    return range;
+}
+
+uint32_t RTR::ClearDirtyRange(uint64_t* bits, DirtyRange range)
+{
+    uint32_t cleared = 0;
+    for (uint32_t i = range.begin; i < range.end; i++)
+    {
+        cleared += IsDirty(bits, i);
+        bits[i / 64] &= ~(1ULL << (i % 64));
+    }
+    return cleared;
+}
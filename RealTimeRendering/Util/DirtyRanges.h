@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+namespace RTR
+{
+    // Elements [begin, end) of a dirty bitset (one bit per element, 64 per word)
+    struct DirtyRange
+    {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    // First dirty range that starts in [from, end). The range grows over gaps of up to mergeGap clean elements and ends
+    // after its last dirty element (never past end). Returns { end, end } when nothing is dirty.
+    DirtyRange FindDirtyRange(const uint64_t* bits, uint32_t from, uint32_t end, uint32_t mergeGap);
+
+    // Clear the bits of a range, returns how many of them were set
+    uint32_t ClearDirtyRange(uint64_t* bits, DirtyRange range);
+}
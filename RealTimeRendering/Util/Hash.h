@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace RTR
+{
+    // FNV-1a 64 bit basis
+    constexpr uint64_t HashFnv1aBasis = 0xCBF29CE484222325ULL;
+
+    // FNV-1a 64 bit hash over a block of memory (pass a previous hash as seed to chain blocks)
+    inline uint64_t HashFnv1a(const void* data, size_t size, uint64_t seed = HashFnv1aBasis)
+    {
+        const unsigned char* ptrBytes = (const unsigned char*)data;
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= ptrBytes[i];
+            hash *= 0x100000001B3ULL;
+        }
+        return hash;
+    }
+
+    // FNV-1a style hash that mixes 8 bytes per step (for large payloads, not compatible with HashFnv1a)
+    inline uint64_t HashFnv1aWide(const void* data, size_t size, uint64_t seed = HashFnv1aBasis)
+    {
+        const unsigned char* ptrBytes = (const unsigned char*)data;
+        uint64_t hash = seed;
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, &ptrBytes[i], sizeof(word));
+            hash ^= word;
+            hash *= 0x100000001B3ULL;
+            hash ^= hash >> 32;
+        }
+        return HashFnv1a(&ptrBytes[i], size - i, hash);
+    }
+
+    // Multiply rotate hash over 8 byte words with a full avalanche finalizer (structurally independent of the FNV variants,
+    // pair it with one of them where a 64 bit collision must not go unnoticed)
+    inline uint64_t HashMixWide(const void* data, size_t size, uint64_t seed = HashFnv1aBasis)
+    {
+        const unsigned char* ptrBytes = (const unsigned char*)data;
+        uint64_t hash = seed ^ (size * 0x9E3779B97F4A7C15ULL);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, &ptrBytes[i], sizeof(word));
+            word *= 0x87C37B91114253D5ULL;
+            word = (word << 31) | (word >> 33);
+            word *= 0x4CF5AD432745937FULL;
+            hash ^= word;
+            hash = ((hash << 27) | (hash >> 37)) * 5 + 0x52DCE729;
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, &ptrBytes[i], size - i);
+        hash ^= tail * 0x87C37B91114253D5ULL;
+
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    // Hash a trivially copyable value
+    template<typename T>
+    inline uint64_t HashFnv1aValue(const T& value, uint64_t seed = HashFnv1aBasis)
+    {
+        return HashFnv1a(&value, sizeof(T), seed);
+    }
+}
@@ -0,0 +1,105 @@
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RTR::MappedFile::MappedFile(const char* filePath)
+{
+    Open(filePath);
+}
+
+RTR::MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool RTR::MappedFile::Open(const char* filePath)
+{
+    Close();
+
+    #ifdef _WIN32
+    // Open file
+    m_hFile = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_hFile != INVALID_HANDLE_VALUE)
+    {
+        // Get size (empty files can not be mapped)
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(m_hFile, &fileSize) && fileSize.QuadPart)
+        {
+            // Map the full file
+            m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_hMapping)
+            {
+                m_ptrData = (const unsigned char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+                if (m_ptrData)
+                {
+                    m_size = fileSize.QuadPart;
+                }
+            }
+        }
+    }
+    #else
+    // Open file
+    m_fd = open(filePath, O_RDONLY);
+    if (m_fd >= 0)
+    {
+        // Get size (empty files can not be mapped)
+        struct stat fileStat;
+        if (fstat(m_fd, &fileStat) == 0 && fileStat.st_size > 0)
+        {
+            // Map the full file
+            void* ptrMapping = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+            if (ptrMapping != MAP_FAILED)
+            {
+                m_ptrData = (const unsigned char*)ptrMapping;
+                m_size = (uint64_t)fileStat.st_size;
+            }
+        }
+    }
+    #endif
+
+    // Cleanup on failure
+    if (!m_ptrData)
+    {
+        Close();
+    }
+
+    return m_ptrData != nullptr;
+}
+
+void RTR::MappedFile::Close()
+{
+    #ifdef _WIN32
+    if (m_ptrData)
+    {
+        UnmapViewOfFile(m_ptrData);
+        m_ptrData = nullptr;
+    }
+    if (m_hMapping)
+    {
+        CloseHandle(m_hMapping);
+        m_hMapping = NULL;
+    }
+    if (m_hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+    #else
+    if (m_ptrData)
+    {
+        munmap((void*)m_ptrData, (size_t)m_size);
+        m_ptrData = nullptr;
+    }
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+    #endif
+    m_size = 0;
+}
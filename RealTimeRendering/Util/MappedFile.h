@@ -0,0 +1,61 @@
+#pragma once
+
+#ifdef _WIN32
+#include <WinInclude.h>
+#endif
+
+#include <cstdint>
+
+namespace RTR
+{
+    // Read only memory mapping of a file (Win32 file mapping or POSIX mmap)
+    class MappedFile
+    {
+        public:
+            // Construct
+            MappedFile() = default;
+            MappedFile(const MappedFile&) = delete;
+            MappedFile(const char* filePath);
+
+            // Destruct
+            ~MappedFile();
+
+            // Assign
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            // Open a file (closes the previous mapping)
+            bool Open(const char* filePath);
+            // Close mapping
+            void Close();
+
+            // Access
+            inline const unsigned char* GetData() const noexcept
+            {
+                return m_ptrData;
+            }
+            inline uint64_t GetSize() const noexcept
+            {
+                return m_size;
+            }
+
+            // Checks if valid
+            inline operator bool() const noexcept
+            {
+                return m_ptrData != nullptr;
+            }
+
+        private:
+            #ifdef _WIN32
+            // Win32 handles
+            HANDLE m_hFile = INVALID_HANDLE_VALUE;
+            HANDLE m_hMapping = NULL;
+            #else
+            // File descriptor
+            int m_fd = -1;
+            #endif
+
+            // Mapped view
+            const unsigned char* m_ptrData = nullptr;
+            uint64_t m_size = 0;
+    };
+}
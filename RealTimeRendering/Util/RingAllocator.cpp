@@ -0,0 +1,97 @@
+#include "RingAllocator.h"
+
+RTR::RingAllocator::RingAllocator(uint64_t size)
+{
+    Reset(size);
+}
+
+void RTR::RingAllocator::Reset(uint64_t size)
+{
+    m_size = size;
+    m_head = m_tail = 0;
+    m_usedSize = 0;
+    m_openSize = 0;
+    m_frames.clear();
+}
+
+bool RTR::RingAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t* ptrOffsetOut)
+{
+    if (!size)
+        size = 1;
+    if (!alignment || m_usedSize == m_size)
+        return false;
+
+    // Empty rings start over at the front
+    if (!m_usedSize)
+        m_head = m_tail = 0;
+
+    // Free range behind the head (up to the end when the tail is in front of it)
+    const uint64_t offset = (m_head + alignment - 1) / alignment * alignment;
+    const uint64_t limit = m_head >= m_tail ? m_size : m_tail;
+    uint64_t padding = 0;
+    uint64_t placed = offset;
+    if (offset > limit || limit - offset < size)
+    {
+        // Skip the tail and wrap to the front (offset 0 fits every alignment)
+        if (m_head < m_tail || m_tail < size)
+            return false;
+        padding = m_size - m_head;
+        placed = 0;
+    }
+    else
+    {
+        padding = offset - m_head;
+    }
+
+    // Charge the open frame
+    m_usedSize += padding + size;
+    m_openSize += padding + size;
+    m_head = (placed + size) % m_size;
+
+    *ptrOffsetOut = placed;
+    return true;
+}
+
+void RTR::RingAllocator::FinishFrame(uint64_t fenceValue)
+{
+    if (m_openSize)
+        m_frames.push_back({ m_openSize, fenceValue });
+    m_openSize = 0;
+}
+
+size_t RTR::RingAllocator::Retire(uint64_t completedFenceValue)
+{
+    size_t retired = 0;
+    while (!m_frames.empty() && m_frames.front().fence <= completedFenceValue)
+    {
+        // Frames are contiguous in ring order, so the tail moves over the whole frame
+        m_tail = (m_tail + m_frames.front().size) % m_size;
+        m_usedSize -= m_frames.front().size;
+        m_frames.pop_front();
+        retired++;
+    }
+
+    return retired;
+}
+
+uint64_t RTR::RingAllocator::GetContiguousFreeSize() const
+{
+    if (!m_usedSize)
+        return m_size;
+    if (m_usedSize == m_size)
+        return 0;
+
+    // Behind the head up to the tail, or the larger of the end of the ring and the front
+    if (m_head < m_tail)
+        return m_tail - m_head;
+    return m_size - m_head > m_tail ? m_size - m_head : m_tail;
+}
+
+bool RTR::RingAllocator::GetOldestFence(uint64_t* ptrFenceOut) const
+{
+    if (m_frames.empty())
+        return false;
+
+    *ptrFenceOut = m_frames.front().fence;
+    return true;
+}
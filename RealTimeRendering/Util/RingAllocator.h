@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace RTR
+{
+    // Ring of offsets into an external memory range for transient per frame data.
+    // Allocations are grouped into frames that are tagged with a fence value and retired together once that value completed.
+    // Only bookkeeping lives here (no gpu objects), so the retirement logic runs headless.
+    class RingAllocator
+    {
+        public:
+            // Construct
+            RingAllocator(uint64_t size = 0);
+
+            // Reset to an empty ring of size bytes (pending frames are dropped)
+            void Reset(uint64_t size);
+
+            // Allocate size bytes at a multiple of alignment (any non zero value) for the open frame.
+            // Allocations are contiguous and never wrap, the skipped tail of the ring is charged to the open frame.
+            bool Allocate(uint64_t size, uint64_t alignment, uint64_t* ptrOffsetOut);
+            // Close the open frame, its memory stays in use until Retire sees fenceValue (empty frames are dropped)
+            void FinishFrame(uint64_t fenceValue);
+            // Release all closed frames with a fence value of at most completedFenceValue (in order), returns the count of retired frames
+            size_t Retire(uint64_t completedFenceValue);
+
+            // Fence value of the oldest closed frame (false if no frame is pending)
+            bool GetOldestFence(uint64_t* ptrFenceOut) const;
+
+            // Statistics
+            inline uint64_t GetSize() const
+            {
+                return m_size;
+            }
+            // Bytes of the open and all pending frames (including skipped tails)
+            inline uint64_t GetUsedSize() const
+            {
+                return m_usedSize;
+            }
+            inline uint64_t GetOpenFrameSize() const
+            {
+                return m_openSize;
+            }
+            inline size_t GetPendingFrameCount() const
+            {
+                return m_frames.size();
+            }
+            // Largest allocation (alignment 1) that fits right now
+            uint64_t GetContiguousFreeSize() const;
+
+        private:
+            // Closed frame
+            struct Frame
+            {
+                uint64_t size;
+                uint64_t fence;
+            };
+
+        private:
+            uint64_t m_size = 0;
+
+            // Next write offset and start of the oldest live frame (equal for an empty and a full ring)
+            uint64_t m_head = 0;
+            uint64_t m_tail = 0;
+            uint64_t m_usedSize = 0;
+
+            // Frames in ring order
+            uint64_t m_openSize = 0;
+            std::deque<Frame> m_frames;
+    };
+}
@@ -0,0 +1,32 @@
+#include "StreamChunking.h"
+
+#include <algorithm>
+
+RTR::StreamChunk RTR::PlanStreamChunk(uint64_t size, uint64_t streamed, uint64_t chunkSize, uint64_t bufferSize, uint64_t freeMemory, uint64_t openReservations, bool ring)
+{
+    StreamChunk chunk;
+    chunk.offset = streamed;
+    if (streamed >= size)
+        return chunk;
+
+    if (!chunkSize)
+        chunkSize = std::max<uint64_t>(bufferSize / 4, 1);
+    const uint64_t wanted = std::min(chunkSize, size - streamed);
+
+    if (ring)
+    {
+        // The buffer waits for the oldest chunk in flight when it is full
+        chunk.size = wanted;
+        chunk.executeAfter = streamed + wanted < size;
+    }
+    else
+    {
+        // Fill what is left of the buffer, flush it when full (a flush frees all of it)
+        chunk.flushBefore = !freeMemory;
+        if (chunk.flushBefore && openReservations)
+            return chunk;
+        chunk.size = std::min(wanted, chunk.flushBefore ? bufferSize : freeMemory);
+    }
+
+    return chunk;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace RTR
+{
+    // Next chunk of a streamed upload (see PlanStreamChunk)
+    struct StreamChunk
+    {
+        // Offset in the source and the target (relative to the start of the stream) and size of the chunk (0: stop)
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        // Flush the staging memory before reserving the chunk (execute and wait for everything recorded)
+        bool flushBefore = false;
+        // Execute after committing the chunk so the gpu copies it while the next one is produced
+        bool executeAfter = false;
+    };
+
+    // Plan the chunk after streamed of size bytes through a staging buffer of bufferSize bytes (chunkSize 0: a quarter of it).
+    // A ring buffer makes room by itself and overlaps chunks with the gpu copies. A linear one fills the freeMemory it has left
+    // and is flushed when full, which would pull the memory from under other reservations: with openReservations the plan
+    // stops instead. The size is 0 when the stream is complete or stopped.
+    StreamChunk PlanStreamChunk(uint64_t size, uint64_t streamed, uint64_t chunkSize, uint64_t bufferSize, uint64_t freeMemory, uint64_t openReservations, bool ring);
+}
@@ -0,0 +1,90 @@
+#include "StreamCopy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef RTR_STREAMCOPY_SSE
+#include <immintrin.h>
+#endif
+
+void RTR::StreamCopy(void* ptrDest, const void* ptrSource, size_t size)
+{
+    unsigned char* ptrOut = (unsigned char*)ptrDest;
+    const unsigned char* ptrIn = (const unsigned char*)ptrSource;
+
+    #if defined(RTR_STREAMCOPY_SSE)
+    if (size < StreamCopyMinSize)
+    {
+        memcpy(ptrOut, ptrIn, size);
+        return;
+    }
+
+    #if defined(__AVX2__)
+    // 32 byte registers, 4 per iteration
+    constexpr size_t Width = 32;
+    #else
+    // 16 byte registers, 4 per iteration
+    constexpr size_t Width = 16;
+    #endif
+
+    // Regular head up to the first aligned destination address
+    const size_t head = (Width - ((uintptr_t)ptrOut & (Width - 1))) & (Width - 1);
+    memcpy(ptrOut, ptrIn, head);
+    ptrOut += head;
+    ptrIn += head;
+    size -= head;
+
+    // Streaming body (the source may be unaligned)
+    const size_t body = size / (Width * 4) * (Width * 4);
+    for (size_t i = 0; i < body; i += Width * 4)
+    {
+        #if defined(__AVX2__)
+        const __m256i a = _mm256_loadu_si256((const __m256i*)(ptrIn + i));
+        const __m256i b = _mm256_loadu_si256((const __m256i*)(ptrIn + i + 32));
+        const __m256i c = _mm256_loadu_si256((const __m256i*)(ptrIn + i + 64));
+        const __m256i d = _mm256_loadu_si256((const __m256i*)(ptrIn + i + 96));
+        _mm256_stream_si256((__m256i*)(ptrOut + i), a);
+        _mm256_stream_si256((__m256i*)(ptrOut + i + 32), b);
+        _mm256_stream_si256((__m256i*)(ptrOut + i + 64), c);
+        _mm256_stream_si256((__m256i*)(ptrOut + i + 96), d);
+        #else
+        const __m128i a = _mm_loadu_si128((const __m128i*)(ptrIn + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(ptrIn + i + 16));
+        const __m128i c = _mm_loadu_si128((const __m128i*)(ptrIn + i + 32));
+        const __m128i d = _mm_loadu_si128((const __m128i*)(ptrIn + i + 48));
+        _mm_stream_si128((__m128i*)(ptrOut + i), a);
+        _mm_stream_si128((__m128i*)(ptrOut + i + 16), b);
+        _mm_stream_si128((__m128i*)(ptrOut + i + 32), c);
+        _mm_stream_si128((__m128i*)(ptrOut + i + 48), d);
+        #endif
+    }
+
+    // Regular tail
+    memcpy(ptrOut + body, ptrIn + body, size - body);
+
+    // Non temporal stores are weakly ordered, make them visible before the copy is committed
+    _mm_sfence();
+    #else
+    memcpy(ptrOut, ptrIn, size);
+    #endif
+}
+
+void RTR::StreamCopyParallel(WorkerPool& pool, void* ptrDest, const void* ptrSource, size_t size, size_t minBlockSize)
+{
+    // One block per thread at most, each a multiple of a cache line
+    const size_t blockCount = std::min<size_t>(pool.GetThreadCount(), size / std::max<size_t>(minBlockSize, 1));
+    if (blockCount < 2)
+    {
+        StreamCopy(ptrDest, ptrSource, size);
+        return;
+    }
+    const size_t blockSize = (size / blockCount + 63) & ~(size_t)63;
+
+    pool.ParallelFor(blockCount, [&](size_t idx)
+        {
+            const size_t begin = std::min(idx * blockSize, size);
+            const size_t end = std::min(begin + blockSize, size);
+            StreamCopy((unsigned char*)ptrDest + begin, (const unsigned char*)ptrSource + begin, end - begin);
+        }
+    );
+}
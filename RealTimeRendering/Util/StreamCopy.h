@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Util/WorkerPool.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define RTR_STREAMCOPY_SSE
+#endif
+
+namespace RTR
+{
+    // Copies below this size are plain memcpy calls (non temporal stores only pay off for whole cache lines)
+    constexpr size_t StreamCopyMinSize = 256;
+    // Smallest block a parallel copy hands to one worker
+    constexpr size_t StreamCopyParallelBlockSize = 1024 * 1024;
+
+    // Copy size bytes into write combined memory (upload heaps) with non temporal stores that bypass the cache. Unaligned heads and
+    // tails are copied regularly, the stores are fenced before returning. AVX2 when compiled for it, SSE2 on x64, memcpy elsewhere.
+    void StreamCopy(void* ptrDest, const void* ptrSource, size_t size);
+
+    // Same as StreamCopy but split into blocks of at least minBlockSize across the workers of pool (not from inside a work function)
+    void StreamCopyParallel(WorkerPool& pool, void* ptrDest, const void* ptrSource, size_t size, size_t minBlockSize = StreamCopyParallelBlockSize);
+}
@@ -0,0 +1,407 @@
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // Index of the highest set bit (value must not be 0)
+    inline unsigned int HighestBit(uint64_t value)
+    {
+        #ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanReverse64(&idx, value);
+        return (unsigned int)idx;
+        #else
+        return 63 - (unsigned int)__builtin_clzll(value);
+        #endif
+    }
+
+    // Index of the lowest set bit (value must not be 0)
+    inline unsigned int LowestBit(uint64_t value)
+    {
+        #ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanForward64(&idx, value);
+        return (unsigned int)idx;
+        #else
+        return (unsigned int)__builtin_ctzll(value);
+        #endif
+    }
+}
+
+RTR::TlsfAllocator::TlsfAllocator(uint64_t size)
+{
+    Reset(size);
+}
+
+void RTR::TlsfAllocator::Reset(uint64_t size)
+{
+    m_size = size;
+    m_usedSize = 0;
+    m_blocks.clear();
+    m_unusedBlocks.clear();
+    m_allocations.clear();
+
+    // Empty free lists
+    for (unsigned int f = 0; f < FirstLevelCount; f++)
+    {
+        for (unsigned int s = 0; s < SecondLevelCount; s++)
+            m_freeHeads[f][s] = InvalidBlock;
+        m_secondLevelBitmap[f] = 0;
+    }
+    m_firstLevelBitmap = 0;
+
+    // One block spanning everything
+    if (size)
+    {
+        const uint32_t block = CreateBlock();
+        m_blocks[block].size = size;
+        m_blocks[block].isFree = true;
+        InsertFree(block);
+    }
+}
+
+bool RTR::TlsfAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t* ptrOffsetOut)
+{
+    size = std::max<uint64_t>(size, 1);
+    alignment = std::max<uint64_t>(alignment, 1);
+    if (size > m_size || alignment > m_size)
+        return false;
+
+    // Find a block that fits even with the worst case alignment padding
+    uint32_t block = FindFree(size + alignment - 1);
+    if (block == InvalidBlock)
+        return false;
+    RemoveFree(block);
+
+    // Give the padding in front back as a free block (the physical predecessor is used since free blocks are merged)
+    const uint64_t alignedOffset = (m_blocks[block].offset + alignment - 1) / alignment * alignment;
+    const uint64_t padding = alignedOffset - m_blocks[block].offset;
+    if (padding)
+    {
+        const uint32_t front = CreateBlock();
+        Block& frontBlock = m_blocks[front];
+        Block& usedBlock = m_blocks[block];
+        frontBlock.offset = usedBlock.offset;
+        frontBlock.size = padding;
+        frontBlock.isFree = true;
+        frontBlock.prevPhysical = usedBlock.prevPhysical;
+        frontBlock.nextPhysical = block;
+        if (usedBlock.prevPhysical != InvalidBlock)
+            m_blocks[usedBlock.prevPhysical].nextPhysical = front;
+        usedBlock.prevPhysical = front;
+        usedBlock.offset += padding;
+        usedBlock.size -= padding;
+        InsertFree(front);
+    }
+
+    // Mark used and give the tail back
+    m_blocks[block].isFree = false;
+    m_blocks[block].alignment = alignment;
+    if (m_blocks[block].size > size)
+        SplitTail(block, size);
+
+    Block& usedBlock = m_blocks[block];
+    m_usedSize += usedBlock.size;
+    m_allocations[usedBlock.offset] = block;
+
+    *ptrOffsetOut = usedBlock.offset;
+    return true;
+}
+
+bool RTR::TlsfAllocator::Free(uint64_t offset)
+{
+    auto it = m_allocations.find(offset);
+    if (it == m_allocations.end())
+        return false;
+
+    const uint32_t block = it->second;
+    m_allocations.erase(it);
+    m_usedSize -= m_blocks[block].size;
+    m_blocks[block].isFree = true;
+    InsertFree(Merge(block));
+
+    return true;
+}
+
+bool RTR::TlsfAllocator::Relocate(uint64_t offset, uint64_t* ptrOffsetOut)
+{
+    auto it = m_allocations.find(offset);
+    if (it == m_allocations.end())
+        return false;
+
+    // Only moves towards the start of the range are useful
+    const Block& block = m_blocks[it->second];
+    uint64_t newOffset;
+    if (!Allocate(block.size, block.alignment, &newOffset))
+        return false;
+    if (newOffset > offset)
+    {
+        Free(newOffset);
+        return false;
+    }
+
+    *ptrOffsetOut = newOffset;
+    return true;
+}
+
+void RTR::TlsfAllocator::GetAllocations(std::vector<Allocation>& allocationsOut) const
+{
+    allocationsOut.clear();
+    allocationsOut.reserve(m_allocations.size());
+    for (const auto& entry : m_allocations)
+    {
+        const Block& block = m_blocks[entry.second];
+        allocationsOut.push_back({ block.offset, block.size, block.alignment });
+    }
+    std::sort(allocationsOut.begin(), allocationsOut.end(), [](const Allocation& a, const Allocation& b) { return a.offset < b.offset; });
+}
+
+uint64_t RTR::TlsfAllocator::GetLargestFreeBlock() const
+{
+    if (!m_firstLevelBitmap)
+        return 0;
+
+    // All blocks of the highest occupied class are candidates
+    const unsigned int first = HighestBit(m_firstLevelBitmap);
+    const unsigned int second = HighestBit(m_secondLevelBitmap[first]);
+    uint64_t largest = 0;
+    for (uint32_t block = m_freeHeads[first][second]; block != InvalidBlock; block = m_blocks[block].nextFree)
+        largest = std::max(largest, m_blocks[block].size);
+    return largest;
+}
+
+double RTR::TlsfAllocator::GetFragmentation() const
+{
+    const uint64_t free = m_size - m_usedSize;
+    if (!free)
+        return 0.0;
+    const uint64_t largest = std::min(GetLargestFreeBlock(), free);
+    return 1.0 - (double)largest / (double)free;
+}
+
+bool RTR::TlsfAllocator::Validate() const
+{
+    std::unordered_set<uint32_t> unused(m_unusedBlocks.begin(), m_unusedBlocks.end());
+
+    // Physical chain must cover the range without gaps and without free neighbours
+    uint64_t covered = 0, used = 0;
+    size_t liveBlocks = 0, usedBlocks = 0;
+    for (uint32_t b = 0; b < (uint32_t)m_blocks.size(); b++)
+    {
+        if (unused.count(b))
+            continue;
+        liveBlocks++;
+
+        const Block& block = m_blocks[b];
+        if (!block.size)
+            return false;
+        if (block.prevPhysical == InvalidBlock ? block.offset != 0 : m_blocks[block.prevPhysical].offset + m_blocks[block.prevPhysical].size != block.offset)
+            return false;
+        if (block.nextPhysical == InvalidBlock ? block.offset + block.size != m_size : m_blocks[block.nextPhysical].prevPhysical != b)
+            return false;
+        if (block.isFree && block.nextPhysical != InvalidBlock && m_blocks[block.nextPhysical].isFree)
+            return false;
+
+        covered += block.size;
+        if (!block.isFree)
+        {
+            used += block.size;
+            usedBlocks++;
+            auto it = m_allocations.find(block.offset);
+            if (it == m_allocations.end() || it->second != b || block.offset % block.alignment)
+                return false;
+        }
+    }
+    if (covered != m_size || used != m_usedSize || usedBlocks != m_allocations.size())
+        return false;
+
+    // Free lists must hold exactly the free blocks in their size class
+    size_t freeBlocks = 0;
+    for (unsigned int f = 0; f < FirstLevelCount; f++)
+    {
+        for (unsigned int s = 0; s < SecondLevelCount; s++)
+        {
+            const bool occupied = m_freeHeads[f][s] != InvalidBlock;
+            if (occupied != (((m_secondLevelBitmap[f] >> s) & 1) != 0))
+                return false;
+
+            uint32_t prev = InvalidBlock;
+            for (uint32_t b = m_freeHeads[f][s]; b != InvalidBlock; b = m_blocks[b].nextFree)
+            {
+                unsigned int first, second;
+                Mapping(m_blocks[b].size, &first, &second);
+                if (!m_blocks[b].isFree || first != f || second != s || m_blocks[b].prevFree != prev)
+                    return false;
+                prev = b;
+                freeBlocks++;
+            }
+        }
+        if ((m_secondLevelBitmap[f] != 0) != (((m_firstLevelBitmap >> f) & 1) != 0))
+            return false;
+    }
+
+    return freeBlocks + usedBlocks == liveBlocks;
+}
+
+void RTR::TlsfAllocator::Mapping(uint64_t size, unsigned int* ptrFirst, unsigned int* ptrSecond)
+{
+    if (size < SecondLevelCount)
+    {
+        // Small blocks share the first class linearly
+        *ptrFirst = 0;
+        *ptrSecond = (unsigned int)size;
+    }
+    else
+    {
+        const unsigned int log2 = HighestBit(size);
+        *ptrFirst = log2 - SecondLevelLog2 + 1;
+        *ptrSecond = (unsigned int)(size >> (log2 - SecondLevelLog2)) - SecondLevelCount;
+    }
+}
+
+void RTR::TlsfAllocator::MappingSearch(uint64_t size, unsigned int* ptrFirst, unsigned int* ptrSecond)
+{
+    // Round up to the next class boundary so every block of the class is large enough
+    if (size >= SecondLevelCount)
+        size += (1ULL << (HighestBit(size) - SecondLevelLog2)) - 1;
+    Mapping(size, ptrFirst, ptrSecond);
+}
+
+uint32_t RTR::TlsfAllocator::CreateBlock()
+{
+    uint32_t block;
+    if (!m_unusedBlocks.empty())
+    {
+        block = m_unusedBlocks.back();
+        m_unusedBlocks.pop_back();
+        m_blocks[block] = Block();
+    }
+    else
+    {
+        block = (uint32_t)m_blocks.size();
+        m_blocks.emplace_back();
+    }
+    return block;
+}
+
+void RTR::TlsfAllocator::DestroyBlock(uint32_t block)
+{
+    m_unusedBlocks.push_back(block);
+}
+
+void RTR::TlsfAllocator::InsertFree(uint32_t block)
+{
+    unsigned int first, second;
+    Mapping(m_blocks[block].size, &first, &second);
+
+    // Push front
+    const uint32_t head = m_freeHeads[first][second];
+    m_blocks[block].prevFree = InvalidBlock;
+    m_blocks[block].nextFree = head;
+    if (head != InvalidBlock)
+        m_blocks[head].prevFree = block;
+    m_freeHeads[first][second] = block;
+
+    m_firstLevelBitmap |= 1ULL << first;
+    m_secondLevelBitmap[first] |= 1U << second;
+}
+
+void RTR::TlsfAllocator::RemoveFree(uint32_t block)
+{
+    unsigned int first, second;
+    Mapping(m_blocks[block].size, &first, &second);
+
+    // Unlink
+    Block& b = m_blocks[block];
+    if (b.prevFree != InvalidBlock)
+        m_blocks[b.prevFree].nextFree = b.nextFree;
+    else
+        m_freeHeads[first][second] = b.nextFree;
+    if (b.nextFree != InvalidBlock)
+        m_blocks[b.nextFree].prevFree = b.prevFree;
+    b.prevFree = b.nextFree = InvalidBlock;
+
+    // Clear empty classes
+    if (m_freeHeads[first][second] == InvalidBlock)
+    {
+        m_secondLevelBitmap[first] &= ~(1U << second);
+        if (!m_secondLevelBitmap[first])
+            m_firstLevelBitmap &= ~(1ULL << first);
+    }
+}
+
+uint32_t RTR::TlsfAllocator::FindFree(uint64_t size)
+{
+    unsigned int first, second;
+    MappingSearch(size, &first, &second);
+    if (first >= FirstLevelCount)
+        return InvalidBlock;
+
+    // Same first level, equal or larger second level
+    uint32_t secondMap = m_secondLevelBitmap[first] & (~0U << second);
+    if (!secondMap)
+    {
+        // Any larger first level
+        const uint64_t firstMap = first + 1 < 64 ? m_firstLevelBitmap & (~0ULL << (first + 1)) : 0;
+        if (!firstMap)
+            return InvalidBlock;
+        first = LowestBit(firstMap);
+        secondMap = m_secondLevelBitmap[first];
+    }
+
+    return m_freeHeads[first][LowestBit(secondMap)];
+}
+
+void RTR::TlsfAllocator::SplitTail(uint32_t block, uint64_t size)
+{
+    const uint32_t tail = CreateBlock();
+    Block& tailBlock = m_blocks[tail];
+    Block& headBlock = m_blocks[block];
+    tailBlock.offset = headBlock.offset + size;
+    tailBlock.size = headBlock.size - size;
+    tailBlock.isFree = true;
+    tailBlock.prevPhysical = block;
+    tailBlock.nextPhysical = headBlock.nextPhysical;
+    if (headBlock.nextPhysical != InvalidBlock)
+        m_blocks[headBlock.nextPhysical].prevPhysical = tail;
+    headBlock.nextPhysical = tail;
+    headBlock.size = size;
+
+    InsertFree(Merge(tail));
+}
+
+uint32_t RTR::TlsfAllocator::Merge(uint32_t block)
+{
+    // Absorb into a free predecessor
+    const uint32_t prev = m_blocks[block].prevPhysical;
+    if (prev != InvalidBlock && m_blocks[prev].isFree)
+    {
+        RemoveFree(prev);
+        m_blocks[prev].size += m_blocks[block].size;
+        m_blocks[prev].nextPhysical = m_blocks[block].nextPhysical;
+        if (m_blocks[block].nextPhysical != InvalidBlock)
+            m_blocks[m_blocks[block].nextPhysical].prevPhysical = prev;
+        DestroyBlock(block);
+        block = prev;
+    }
+
+    // Absorb a free successor
+    const uint32_t next = m_blocks[block].nextPhysical;
+    if (next != InvalidBlock && m_blocks[next].isFree)
+    {
+        RemoveFree(next);
+        m_blocks[block].size += m_blocks[next].size;
+        m_blocks[block].nextPhysical = m_blocks[next].nextPhysical;
+        if (m_blocks[next].nextPhysical != InvalidBlock)
+            m_blocks[m_blocks[next].nextPhysical].prevPhysical = block;
+        DestroyBlock(next);
+    }
+
+    return block;
+}
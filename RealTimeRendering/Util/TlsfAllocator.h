@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace RTR
+{
+    // Two level segregated fit allocator (Masmano et al. 2004) for offsets into an external memory range.
+    // Only bookkeeping lives here, so it works for gpu buffers and never touches the managed memory.
+    // Allocation and free are O(1) apart from the offset lookup. Free neighbours are always merged.
+    class TlsfAllocator
+    {
+        public:
+            // Second level subdivisions per power of two
+            static constexpr unsigned int SecondLevelLog2 = 4;
+            static constexpr unsigned int SecondLevelCount = 1 << SecondLevelLog2;
+            static constexpr unsigned int FirstLevelCount = 64 - SecondLevelLog2 + 1;
+
+            // One live allocation
+            struct Allocation
+            {
+                uint64_t offset;
+                uint64_t size;
+                uint64_t alignment;
+            };
+
+        public:
+            // Construct
+            TlsfAllocator(uint64_t size = 0);
+
+            // Reset to one free block of size bytes (all allocations are dropped)
+            void Reset(uint64_t size);
+
+            // Allocate size bytes at a multiple of alignment (any non zero value, e.g. a vertex stride). Size 0 is treated as 1.
+            bool Allocate(uint64_t size, uint64_t alignment, uint64_t* ptrOffsetOut);
+            // Free an allocation by its offset (false when offset is not allocated)
+            bool Free(uint64_t offset);
+            // Move an allocation to a lower offset if a fitting free block exists there (keeps size and alignment).
+            // On success both ranges are allocated: Free(offset) once the data was copied.
+            bool Relocate(uint64_t offset, uint64_t* ptrOffsetOut);
+
+            // All live allocations ordered by offset
+            void GetAllocations(std::vector<Allocation>& allocationsOut) const;
+
+            // Statistics
+            inline uint64_t GetSize() const
+            {
+                return m_size;
+            }
+            inline uint64_t GetUsedSize() const
+            {
+                return m_usedSize;
+            }
+            inline size_t GetAllocationCount() const
+            {
+                return m_allocations.size();
+            }
+            // Size of the largest free block
+            uint64_t GetLargestFreeBlock() const;
+            // Share of the free memory outside of the largest free block (0: one free block or none, towards 1: scattered holes)
+            double GetFragmentation() const;
+
+            // Verify the internal structure (debugging and fuzzing)
+            bool Validate() const;
+
+        private:
+            static constexpr uint32_t InvalidBlock = 0xFFFFFFFF;
+
+            // Physical block (free or used)
+            struct Block
+            {
+                uint64_t offset = 0;
+                uint64_t size = 0;
+                uint64_t alignment = 1;
+                uint32_t prevPhysical = InvalidBlock;
+                uint32_t nextPhysical = InvalidBlock;
+                uint32_t prevFree = InvalidBlock;
+                uint32_t nextFree = InvalidBlock;
+                bool isFree = false;
+            };
+
+            // Size class of a block
+            static void Mapping(uint64_t size, unsigned int* ptrFirst, unsigned int* ptrSecond);
+            // Smallest size class that only holds blocks of at least size bytes
+            static void MappingSearch(uint64_t size, unsigned int* ptrFirst, unsigned int* ptrSecond);
+
+            // Block pool
+            uint32_t CreateBlock();
+            void DestroyBlock(uint32_t block);
+
+            // Free lists
+            void InsertFree(uint32_t block);
+            void RemoveFree(uint32_t block);
+            uint32_t FindFree(uint64_t size);
+
+            // Split the tail of a block into a new free block (block must not be in a free list)
+            void SplitTail(uint32_t block, uint64_t size);
+            // Merge a free block with its free neighbours, returns the resulting block
+            uint32_t Merge(uint32_t block);
+
+        private:
+            // Managed size and currently allocated bytes
+            uint64_t m_size = 0;
+            uint64_t m_usedSize = 0;
+
+            // Blocks and unused slots of the pool
+            std::vector<Block> m_blocks;
+            std::vector<uint32_t> m_unusedBlocks;
+
+            // Free list heads and their occupancy bitmaps
+            uint32_t m_freeHeads[FirstLevelCount][SecondLevelCount];
+            uint64_t m_firstLevelBitmap = 0;
+            uint32_t m_secondLevelBitmap[FirstLevelCount] = {};
+
+            // Used block by offset
+            std::unordered_map<uint64_t, uint32_t> m_allocations;
+    };
+}
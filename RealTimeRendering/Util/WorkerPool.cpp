@@ -0,0 +1,112 @@
+#include "WorkerPool.h"
+
+RTR::WorkerPool::WorkerPool(unsigned int threadCount)
+{
+    // Default to hardware concurrency
+    if (!threadCount)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+
+    // Calling thread is the first worker
+    for (unsigned int i = 1; i < threadCount; i++)
+    {
+        m_workers.emplace_back(&WorkerPool::WorkerMain, this);
+    }
+}
+
+RTR::WorkerPool::~WorkerPool()
+{
+    // Signal shutdown
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_shutdown = true;
+    }
+    m_jobCv.notify_all();
+
+    // Join all workers
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void RTR::WorkerPool::ParallelFor(size_t count, const WorkFunction& func)
+{
+    // Run inline when there is nothing to split
+    if (m_workers.empty() || count <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            func(i);
+        return;
+    }
+
+    // One job at a time
+    std::lock_guard<std::mutex> dispatchLock(m_dispatchMutex);
+
+    // Publish job (wait for late workers of the previous job to leave first)
+    {
+        std::unique_lock<std::mutex> lock(m_jobMutex);
+        m_doneCv.wait(lock, [this]() { return m_jobActiveWorkers == 0; });
+
+        m_ptrJobFunc = &func;
+        m_jobCount = count;
+        m_jobNext = 0;
+        m_jobDone = 0;
+        m_jobGeneration++;
+    }
+    m_jobCv.notify_all();
+
+    // Work on the job ourself
+    ProcessJob();
+
+    // Wait for all indices to be processed
+    {
+        std::unique_lock<std::mutex> lock(m_jobMutex);
+        m_doneCv.wait(lock, [this]() { return m_jobDone >= m_jobCount && m_jobActiveWorkers == 0; });
+        m_ptrJobFunc = nullptr;
+    }
+}
+
+void RTR::WorkerPool::WorkerMain()
+{
+    unsigned long long lastGeneration = 0;
+
+    while (true)
+    {
+        // Wait for a new job or shutdown
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_jobCv.wait(lock, [&]() { return m_shutdown || m_jobGeneration != lastGeneration; });
+            if (m_shutdown)
+                return;
+
+            lastGeneration = m_jobGeneration;
+            m_jobActiveWorkers++;
+        }
+
+        // Work on job
+        ProcessJob();
+
+        // Leave job
+        {
+            std::lock_guard<std::mutex> lock(m_jobMutex);
+            m_jobActiveWorkers--;
+        }
+        m_doneCv.notify_all();
+    }
+}
+
+void RTR::WorkerPool::ProcessJob()
+{
+    // Snapshot is stable while we are counted as active (or are the dispatcher)
+    const WorkFunction* ptrFunc = m_ptrJobFunc;
+    const size_t count = m_jobCount;
+
+    // Pull indices until exhausted
+    for (size_t idx = m_jobNext++; idx < count; idx = m_jobNext++)
+    {
+        (*ptrFunc)(idx);
+        m_jobDone++;
+    }
+}
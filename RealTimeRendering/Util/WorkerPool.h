@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RTR
+{
+    // Pool of persistent worker threads for blocking parallel for loops
+    class WorkerPool
+    {
+        public:
+            // Work function (called once per index)
+            using WorkFunction = std::function<void(size_t idx)>;
+
+        public:
+            // Construct (threadCount = 0 will use the hardware concurrency)
+            WorkerPool(unsigned int threadCount = 0);
+            WorkerPool(const WorkerPool&) = delete;
+
+            // Destruct (joins all workers)
+            ~WorkerPool();
+
+            // Assign
+            WorkerPool& operator=(const WorkerPool&) = delete;
+
+            // Run func for every index in [0, count) and block until all are done. The calling thread participates.
+            // Must not be called from inside a work function of the same pool!
+            void ParallelFor(size_t count, const WorkFunction& func);
+
+            // Count of threads working on a ParallelFor (including the calling thread)
+            inline unsigned int GetThreadCount() const noexcept
+            {
+                return (unsigned int)m_workers.size() + 1;
+            }
+
+        private:
+            // Worker thread entry point
+            void WorkerMain();
+            // Pull and process indices of the current job until it is exhausted
+            void ProcessJob();
+
+        private:
+            // Worker threads
+            std::vector<std::thread> m_workers;
+
+            // Job dispatching (only one ParallelFor at a time)
+            std::mutex m_dispatchMutex;
+
+            // Job state
+            std::mutex m_jobMutex;
+            std::condition_variable m_jobCv;
+            std::condition_variable m_doneCv;
+            const WorkFunction* m_ptrJobFunc = nullptr;
+            size_t m_jobCount = 0;
+            std::atomic<size_t> m_jobNext = 0;
+            std::atomic<size_t> m_jobDone = 0;
+            unsigned int m_jobActiveWorkers = 0;
+            unsigned long long m_jobGeneration = 0;
+            bool m_shutdown = false;
+    };
+}
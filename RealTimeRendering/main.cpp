@@ -5,12 +5,20 @@
 #include <D3DCommon/D3DCmdList.h>
 #include <D3DCommon/D3DDescriptorHeap.h>
 #include <D3DMemory/D3DUploadBuffer.h>
+#include <D3DMemory/D3DConstantRing.h>
+#include <D3DMemory/D3DArgumentBuffer.h>
 #include <RTR/3DModells/ModelContext.h>
+#include <RTR/3DModells/ModelStreamUploader.h>
 #include <RTR/3DModells/MatrixBuffer.h>
+#include <RTR/3DModells/InstanceBatcher.h>
+#include <RTR/3DModells/IndirectDrawBuilder.h>
+#include <RTR/Culling/FrustumCuller.h>
+#include <RTR/Culling/IndirectCulling.h>
 #include <imgui/ImGuiManager.h>
 #include <Util/DirWatcher.h>
 
 
+#include <algorithm>
 #include <exception>
 
 using namespace RTR;
@@ -24,36 +32,41 @@ class BasicRendering : public D3DPipelineState
             float px, py, pz, pw;
         };
 
+        // Layout of Vertex (assembled by the model loader, also identifies it for the mesh cache)
+        struct VertexLayout
+        {
+            static constexpr VertexAttribute Attributes[] = {
+                { "SV_POSITION", 0, VertexFormat::Float4, VertexSource::Position },
+            };
+        };
+        static_assert(VertexLayoutStride<VertexLayout>() == sizeof(Vertex), "VertexLayout does not match Vertex");
+
+        // Per object constants (matches Object in Basic.hlsli)
+        struct ObjectConstants
+        {
+            DirectX::XMFLOAT4X4 modelViewProjection;
+            float world[12];
+        };
+
+        // Vertical field of view in degrees
+        static constexpr float FieldOfView = 120.0f;
+
     public:
         // Constructor that load shaders
-        BasicRendering(MatrixBuffer& matBuffer, D3DDescriptorHandle handle) :
+        BasicRendering(MatrixBuffer& matBuffer) :
             // Shaders
             m_vs(L"shaders/BasicVS.hlsl", RTR_SHADER_VS_6_0, L"BasicVS"),
             m_ps(L"shaders/BasicPS.hlsl", RTR_SHADER_PS_6_0, L"BasicPS"),
             D3DPipelineState(PipelineStateType::Graffics),
 
-            // Matrices
-            m_matProj(matBuffer.GetMatrix()),
-            m_matView(matBuffer.GetMatrix()),
+            // World matrix
             m_matModel(matBuffer.GetMatrix()),
 
-            // Configuration for the root signature
+            // Configuration for the root signature (object constants are placed by PushConstants)
             m_rc(PipelineStateType::Graffics, 1,
-                RootConfigurationEntry::MakeDescriptorTable(handle)
+                RootConfigurationEntry::MakeConstantBufferView(0)
             )
-        {
-            D3D12_CONSTANT_BUFFER_VIEW_DESC cbv;
-            cbv.BufferLocation = matBuffer.GetAddress() + (m_matProj.offset * sizeof(DirectX::XMMATRIX));
-            cbv.SizeInBytes = sizeof(DirectX::XMMATRIX) * 4;
-            GetD3D12DevicePtr()->CreateConstantBufferView(&cbv, handle);
-        } 
-
-        // Vertex creation callback
-        static void CbVertexCreate(Vertex* ptrVtx, size_t vtxIdx, const aiMesh* ptrMesh)
-        {
-            memcpy(ptrVtx, &ptrMesh->mVertices[vtxIdx], sizeof(aiVector3D));
-            ptrVtx->pw = 1.0f;
-        }
+        {} 
 
         // Easy bind
         bool Bind(D3DCommandList& cmdList)
@@ -70,13 +83,11 @@ class BasicRendering : public D3DPipelineState
         void UpdateMatrices(MatrixBuffer& matBuffer, float aspectRatio)
         {
             // Projection
-            m_matProj.M = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(120.f), aspectRatio, 0.1f, 10.0f);
-            matBuffer.UpdateCPU(m_matProj);
+            m_matProj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(FieldOfView), aspectRatio, 0.1f, 10.0f);
 
             // View
-            m_matView.M = DirectX::XMMatrixTranslation(m_camPosition[0], m_camPosition[1], m_camPosition[2]);
-            m_matView.M = DirectX::XMMatrixInverse(nullptr, m_matView.M);
-            matBuffer.UpdateCPU(m_matView);
+            m_matView = DirectX::XMMatrixTranslation(m_camPosition[0], m_camPosition[1], m_camPosition[2]);
+            m_matView = DirectX::XMMatrixInverse(nullptr, m_matView);
 
             // Model
             m_matModel.M = DirectX::XMMatrixRotationRollPitchYaw(
@@ -85,10 +96,70 @@ class BasicRendering : public D3DPipelineState
                 DirectX::XMConvertToRadians(m_modelRotation[2])
             );
             matBuffer.UpdateCPU(m_matModel);
+
+            // Model view projection (once per object instead of per vertex)
+            matBuffer.ConcatenateCPU(DirectX::XMMatrixMultiply(m_matView, m_matProj), &m_matModel.offset, 1, &m_mvp);
+        }
+
+        // Write the object constants of this frame to the ring and bind them (returns the address, 0 on failure)
+        D3D12_GPU_VIRTUAL_ADDRESS PushConstants(const MatrixBuffer& matBuffer, D3DConstantRing& constantRing)
+        {
+            ObjectConstants constants;
+            constants.modelViewProjection = m_mvp;
+            memcpy(constants.world, matBuffer.GetCPUMatrix(m_matModel.offset), sizeof(constants.world));
+
+            m_rc[0].ConstantBufferView.dataAddress = constantRing.Push(constants);
+            return m_rc[0].ConstantBufferView.dataAddress;
+        }
+
+        // View projection of the last UpdateMatrices
+        inline DirectX::XMMATRIX GetViewProjection() const
+        {
+            return DirectX::XMMatrixMultiply(m_matView, m_matProj);
+        }
+        // Model rotation as quaternion
+        inline DirectX::XMVECTOR GetModelRotation() const
+        {
+            return DirectX::XMQuaternionRotationRollPitchYaw(
+                DirectX::XMConvertToRadians(m_modelRotation[0]),
+                DirectX::XMConvertToRadians(m_modelRotation[1]),
+                DirectX::XMConvertToRadians(m_modelRotation[2])
+            );
+        }
+
+        // Pick the level of detail of a mesh at the model origin
+        size_t SelectLod(const MeshInfo& mesh, float viewportHeight)
+        {
+            const float distance = sqrtf(m_camPosition[0] * m_camPosition[0] + m_camPosition[1] * m_camPosition[1] + m_camPosition[2] * m_camPosition[2]);
+            const float projectionScale = viewportHeight / (2.0f * tanf(DirectX::XMConvertToRadians(FieldOfView) * 0.5f));
+            m_lod = mesh.SelectLod(distance, projectionScale, m_lodPixelError);
+            m_lodTriangles = mesh.lods[m_lod].indexCount / 3;
+            return m_lod;
+        }
+
+        // Test the model against the camera frustum
+        bool IsVisible(const MeshInfo& mesh, FrustumCuller& culler)
+        {
+            DirectX::XMFLOAT4X4 viewProjection, model;
+            DirectX::XMStoreFloat4x4(&viewProjection, DirectX::XMMatrixMultiply(m_matView, m_matProj));
+            DirectX::XMStoreFloat4x4(&model, m_matModel.M);
+
+            m_cullSpheres.Clear();
+            m_cullSpheres.Add(TransformBoundingSphere(mesh.bounds.sphere, &model._11));
+            m_culled = culler.Cull(FrustumFromViewProjection(&viewProjection._11), m_cullSpheres, m_cullVisible).visible == 0;
+            return !m_culled;
+        }
+
+        // Camera position in model space (for culling)
+        void GetModelSpaceCamera(float* ptrPositionOut)
+        {
+            DirectX::XMVECTOR position = DirectX::XMVectorSet(m_camPosition[0], m_camPosition[1], m_camPosition[2], 1.0f);
+            position = DirectX::XMVector3Transform(position, DirectX::XMMatrixInverse(nullptr, m_matModel.M));
+            DirectX::XMStoreFloat3((DirectX::XMFLOAT3*)ptrPositionOut, position);
         }
 
         // Makes ImGui calls
-        void UpdateImgui()
+        void UpdateImgui(const D3DConstantRing& constantRing, D3DUploadBuffer& uploadBuffer)
         {
             ImGui::Begin("Basic Rendering");
 
@@ -96,6 +167,15 @@ class BasicRendering : public D3DPipelineState
             ImGui::DragFloat3("Camera Position", m_camPosition, 0.1f);
             // Model rotation
             ImGui::DragFloat3("Model Rotation", m_modelRotation, 5.0f);
+            // Level of detail
+            ImGui::DragFloat("LOD Pixel Error", &m_lodPixelError, 0.1f, 0.0f, 100.0f);
+            ImGui::Text("LOD %zu (%u triangles)", m_lod, m_lodTriangles);
+            ImGui::Text(m_culled ? "Frustum culled" : "Visible");
+            // Constant memory of the frames in flight
+            const RingAllocator& constants = constantRing.GetAllocator();
+            ImGui::Text("Constant ring: %llu / %llu bytes (%zu frames pending)", constants.GetUsedSize(), constants.GetSize(), constants.GetPendingFrameCount());
+            // Upload copies saved by coalescing
+            ImGui::Text("Upload copies merged: %llu", uploadBuffer.GetMergedCopyCount());
 
             ImGui::End();
         }
@@ -119,7 +199,7 @@ class BasicRendering : public D3DPipelineState
             pso->OMSetRenderTargetFormat(0, DXGI_FORMAT_R8G8B8A8_UNORM);
 
             // Setup the input layout
-            pso->IAAddElement("SV_POSITION", DXGI_FORMAT_R32G32B32A32_FLOAT);
+            VertexLayoutAddInputElements<VertexLayout>(pso);
 
             return true;
         }
@@ -130,15 +210,572 @@ class BasicRendering : public D3DPipelineState
         RootConfiguration m_rc;
 
         // Projection
-        Matrix m_matProj;
+        DirectX::XMMATRIX m_matProj;
 
         // View
-        Matrix m_matView;
+        DirectX::XMMATRIX m_matView;
         float m_camPosition[3] = {0.0f, 0.0f, -10.f};
 
         // Model
         Matrix m_matModel;
         float m_modelRotation[3] = { 0.0f, 0.0f, 0.0f };
+
+        // Model view projection of the last UpdateMatrices
+        DirectX::XMFLOAT4X4 m_mvp = {};
+
+        // Level of detail selection
+        float m_lodPixelError = 1.0f;
+        size_t m_lod = 0;
+        UINT m_lodTriangles = 0;
+
+        // Frustum culling
+        CullingSpheres m_cullSpheres;
+        std::vector<uint32_t> m_cullVisible;
+        bool m_culled = false;
+};
+
+class MeshletRendering : public D3DPipelineState
+{
+    public:
+        // Constants for the amplification shader (matches Meshlet.hlsli)
+        struct Constants
+        {
+            UINT meshletCount;
+            float cameraPosition[3];
+        };
+
+        // Thread group size of the amplification shader
+        static constexpr UINT AsGroupSize = 32;
+
+    public:
+        // Constructor that load shaders
+        MeshletRendering() :
+            // Shaders
+            m_as(L"shaders/BasicAS.hlsl", RTR_SHADER_AS_6_5, L"BasicAS"),
+            m_ms(L"shaders/BasicMS.hlsl", RTR_SHADER_MS_6_5, L"BasicMS"),
+            m_ps(L"shaders/BasicMeshletPS.hlsl", RTR_SHADER_PS_6_5, L"BasicMeshletPS"),
+            D3DPipelineState(PipelineStateType::Graffics),
+
+            // Configuration for the root signature
+            m_rc(PipelineStateType::Graffics, 7,
+                RootConfigurationEntry::MakeConstantBufferView(0),
+                RootConfigurationEntry::MakeRootConstant(sizeof(Constants) / 4, &m_constants),
+                RootConfigurationEntry::MakeShaderResourceView(0),
+                RootConfigurationEntry::MakeShaderResourceView(0),
+                RootConfigurationEntry::MakeShaderResourceView(0),
+                RootConfigurationEntry::MakeShaderResourceView(0),
+                RootConfigurationEntry::MakeShaderResourceView(0)
+            )
+        {}
+
+        // Set mesh, camera and object constants (see BasicRendering::PushConstants) for the next draw
+        void SetMesh(const MeshInfo& mesh, const float* ptrCameraPosition, D3D12_GPU_VIRTUAL_ADDRESS objectConstants)
+        {
+            m_rc[0].ConstantBufferView.dataAddress = objectConstants;
+            m_constants.meshletCount = mesh.meshletCount;
+            memcpy(m_constants.cameraPosition, ptrCameraPosition, sizeof(float) * 3);
+
+            m_rc[2].ShaderResourceView.dataAddress = mesh.vertexBuffer.ptrBuffer->GetAddress() + mesh.vertexBuffer.Offset;
+            m_rc[3].ShaderResourceView.dataAddress = mesh.meshletBuffer.ptrBuffer->GetAddress() + mesh.meshletBuffer.Offset;
+            m_rc[4].ShaderResourceView.dataAddress = mesh.meshletBoundsBuffer.ptrBuffer->GetAddress() + mesh.meshletBoundsBuffer.Offset;
+            m_rc[5].ShaderResourceView.dataAddress = mesh.meshletVertexBuffer.ptrBuffer->GetAddress() + mesh.meshletVertexBuffer.Offset;
+            m_rc[6].ShaderResourceView.dataAddress = mesh.meshletPrimitiveBuffer.ptrBuffer->GetAddress() + mesh.meshletPrimitiveBuffer.Offset;
+        }
+
+        // Easy bind
+        bool Bind(D3DCommandList& cmdList)
+        {
+            bool bound = cmdList.BindPipelineState(*this);
+            if (bound)
+            {
+                cmdList.BindRootConfiguration(m_rc);
+            }
+            return bound;
+        }
+
+        // Draw all meshlets of the last mesh (culling happens on the gpu)
+        void Draw(D3DCommandList& cmdList)
+        {
+            cmdList.DispatchMesh((m_constants.meshletCount + AsGroupSize - 1) / AsGroupSize);
+        }
+
+        // Makes ImGui calls
+        void UpdateImgui(bool supported)
+        {
+            ImGui::Begin("Meshlet Rendering");
+
+            if (supported)
+            {
+                ImGui::Checkbox("Use mesh shaders", &m_enabled);
+                ImGui::Text("Meshlets: %u", m_constants.meshletCount);
+            }
+            else
+            {
+                ImGui::Text("Mesh shaders are not supported by this device");
+            }
+
+            ImGui::End();
+        }
+
+        // Checks if the meshlet path should be used
+        inline bool IsEnabled() const noexcept
+        {
+            return m_enabled;
+        }
+
+    protected:
+        // Construct the pipeline state
+        bool __internal_ConstructPso(IPsoManipulator* ptrManipulator) override
+        {
+            // Check the type
+            if (ptrManipulator->GetType() != PipelineStateType::Graffics)
+                throw std::exception("Unexpected pipeline state manipulator type");
+
+            // Case to gfx manipulator
+            GfxPsoManipulator* pso = (GfxPsoManipulator*)ptrManipulator;
+
+            // Set shaders
+            pso->BindShader(ShaderType::AS, &m_as);
+            pso->BindShader(ShaderType::MS, &m_ms);
+            pso->BindShader(ShaderType::PS, &m_ps);
+
+            // Setup render target
+            pso->OMSetRenderTargetFormat(0, DXGI_FORMAT_R8G8B8A8_UNORM);
+
+            return true;
+        }
+
+    private:
+        // My shaders
+        Shader m_as, m_ms, m_ps;
+        RootConfiguration m_rc;
+
+        // Root constants
+        Constants m_constants = {};
+
+        // Path selection
+        bool m_enabled = false;
+};
+
+class InstancedRendering : public D3DPipelineState
+{
+    public:
+        // Instances of the grid and distance between them
+        static constexpr UINT MaxInstances = 1024;
+        static constexpr float Spacing = 2.5f;
+        // Materials the instances cycle through (colors in BasicInstancedPS)
+        static constexpr UINT MaterialCount = 4;
+
+        // Per frame constants (matches Frame in Instanced.hlsli)
+        struct FrameConstants
+        {
+            DirectX::XMFLOAT4X4 viewProjection;
+        };
+
+    public:
+        // Constructor that load shaders and allocates the instance matrices
+        InstancedRendering(MatrixBuffer& matBuffer) :
+            // Shaders
+            m_vs(L"shaders/BasicInstancedVS.hlsl", RTR_SHADER_VS_6_0, L"BasicInstancedVS"),
+            m_ps(L"shaders/BasicInstancedPS.hlsl", RTR_SHADER_PS_6_0, L"BasicInstancedPS"),
+            D3DPipelineState(PipelineStateType::Graffics),
+
+            // Configuration for the root signature (addresses are placed by Prepare and Bind)
+            m_rc(PipelineStateType::Graffics, 3,
+                RootConfigurationEntry::MakeConstantBufferView(0),
+                RootConfigurationEntry::MakeShaderResourceView(0),
+                RootConfigurationEntry::MakeRootConstant(1, &m_firstInstance)
+            ),
+
+            // Indirect commands set the first instance (root parameter 2) per draw
+            m_indirectDraws(1),
+            m_signature(2, 1)
+        {
+            // Square grid around the origin (rotation is set every frame)
+            const UINT side = (UINT)ceilf(sqrtf((float)MaxInstances));
+            for (auto& component : m_position)
+                component.resize(MaxInstances);
+            for (auto& component : m_rotation)
+                component.resize(MaxInstances);
+            for (auto& component : m_scale)
+                component.resize(MaxInstances, 1.0f);
+            for (UINT i = 0; i < MaxInstances; i++)
+            {
+                Matrix matrix = matBuffer.GetMatrix();
+                if (!matrix.handle)
+                    throw std::exception("Matrix buffer is too small for the instances");
+                m_offsets.push_back(matrix.offset);
+
+                m_position[0][i] = ((float)(i % side) - side * 0.5f) * Spacing;
+                m_position[1][i] = ((float)(i / side) - side * 0.5f) * Spacing;
+                m_position[2][i] = 0.0f;
+            }
+        }
+
+        // Compose the instance transforms, batch the instances of this frame and write them with the frame constants to the ring
+        bool Prepare(MatrixBuffer& matBuffer, D3DConstantRing& constantRing, DirectX::FXMMATRIX viewProjection, DirectX::FXMVECTOR rotation, UINT64 meshKey)
+        {
+            // Same rotation for all instances
+            DirectX::XMFLOAT4 quaternion;
+            DirectX::XMStoreFloat4(&quaternion, rotation);
+            std::fill_n(m_rotation[0].begin(), m_count, quaternion.x);
+            std::fill_n(m_rotation[1].begin(), m_count, quaternion.y);
+            std::fill_n(m_rotation[2].begin(), m_count, quaternion.z);
+            std::fill_n(m_rotation[3].begin(), m_count, quaternion.w);
+
+            TransformBatch transforms;
+            transforms.ptrPositionX = m_position[0].data();
+            transforms.ptrPositionY = m_position[1].data();
+            transforms.ptrPositionZ = m_position[2].data();
+            transforms.ptrRotationX = m_rotation[0].data();
+            transforms.ptrRotationY = m_rotation[1].data();
+            transforms.ptrRotationZ = m_rotation[2].data();
+            transforms.ptrRotationW = m_rotation[3].data();
+            transforms.ptrScaleX = m_scale[0].data();
+            transforms.ptrScaleY = m_scale[1].data();
+            transforms.ptrScaleZ = m_scale[2].data();
+            matBuffer.UpdateCPU(transforms, m_offsets.data(), m_count);
+
+            // One batch per mesh
+            m_batcher.Clear();
+            for (UINT i = 0; i < m_count; i++)
+                m_batcher.Add(meshKey, m_offsets[i], i % MaterialCount);
+
+            // Per frame data
+            FrameConstants frame;
+            DirectX::XMStoreFloat4x4(&frame.viewProjection, DirectX::XMMatrixTranspose(viewProjection));
+            m_rc[0].ConstantBufferView.dataAddress = constantRing.Push(frame);
+            D3DConstantAllocation stream = constantRing.Allocate(m_batcher.GetInstanceCount() * sizeof(InstanceData));
+            if (!m_rc[0].ConstantBufferView.dataAddress || !stream.ptrData)
+                return false;
+
+            // Pack the instances straight into the ring (every instance is written as one contiguous record)
+            m_sources.resize(m_batcher.GetInstanceCount());
+            m_batcher.Build(matBuffer.GetCPUMatrix(0), matBuffer.GetMatrixSize() / sizeof(float), (InstanceData*)stream.ptrData, m_sources.data());
+            m_streamAddress = stream.address;
+            return true;
+        }
+
+        // One indirect draw and culling sphere per instance of the last Prepare (false without any). All commands share the
+        // bound index buffer: meshes with another index size than the first ready one are skipped.
+        bool PrepareIndirect(ModelContext& mdlCtx, const MatrixBuffer& matBuffer)
+        {
+            // One drawable and one sphere per instance (same index)
+            m_indirectDraws.Clear();
+            m_cullSpheres.Clear();
+            m_indirectIndexSize = 0;
+            for (const InstanceBatch& batch : m_batcher.GetBatches())
+            {
+                ModelInfo model;
+                if (!mdlCtx.IsModelReady(batch.meshKey, &model))
+                    continue;
+                MeshInfo mesh = mdlCtx.GetMeshInfo(model);
+                if (!m_indirectIndexSize)
+                    m_indirectIndexSize = mesh.indexSize;
+                if (mesh.indexSize != m_indirectIndexSize)
+                    continue;
+
+                const MeshLod& lod = mesh.lods[0];
+                IndirectDrawArguments draw = { lod.indexCount, 1, lod.GetStartIndex(mesh.indexSize), mesh.GetBaseVertex(), 0 };
+                for (UINT32 slot = batch.firstInstance; slot < batch.firstInstance + batch.instanceCount; slot++)
+                {
+                    m_indirectDraws.Add(draw, &slot);
+                    m_cullSpheres.Add(TransformBoundingSphereTransposed(mesh.bounds.sphere, matBuffer.GetCPUMatrix(m_offsets[m_sources[slot]])));
+                }
+            }
+
+            m_indirectCount = 0;
+            return m_indirectDraws.GetDrawCount() != 0;
+        }
+
+        // Cull the drawables of PrepareIndirect on the cpu and write one command per visible instance to the ring
+        bool CullIndirect(FrustumCuller& culler, D3DConstantRing& constantRing, DirectX::FXMMATRIX viewProjection)
+        {
+            // Visible instances
+            DirectX::XMFLOAT4X4 frustumMatrix;
+            DirectX::XMStoreFloat4x4(&frustumMatrix, viewProjection);
+            culler.Cull(FrustumFromViewProjection(&frustumMatrix._11), m_cullSpheres, m_cullVisible);
+            m_indirectCount = (UINT)m_cullVisible.size();
+            if (!m_indirectCount)
+                return true;
+
+            // Commands of the visible instances (read by ExecuteIndirect straight from the upload heap)
+            D3DConstantAllocation commands = constantRing.Allocate(m_indirectCount * m_indirectDraws.GetStride());
+            if (!commands.ptrData)
+            {
+                m_indirectCount = 0;
+                return false;
+            }
+            m_indirectDraws.Build(m_cullVisible.data(), m_cullVisible.size(), commands.ptrData);
+            m_indirectOffset = commands.address - constantRing.GetAddress();
+            return true;
+        }
+
+        // Bind for one batch of the last Prepare (draw batch.instanceCount instances afterwards)
+        bool Bind(D3DCommandList& cmdList, const InstanceBatch& batch)
+        {
+            bool bound = cmdList.BindPipelineState(*this);
+            if (bound)
+            {
+                m_rc[1].ShaderResourceView.dataAddress = m_streamAddress + batch.firstInstance * sizeof(InstanceData);
+                cmdList.BindRootConfiguration(m_rc);
+            }
+            return bound;
+        }
+
+        // Bind the whole instance stream for the commands of the last PrepareIndirect (bind geometry of GetIndirectIndexSize() afterwards)
+        bool BindIndirect(D3DCommandList& cmdList)
+        {
+            bool bound = m_indirectDraws.GetDrawCount() && cmdList.BindPipelineState(*this) && m_signature.Prepare(GetRootSignature());
+            if (bound)
+            {
+                m_rc[1].ShaderResourceView.dataAddress = m_streamAddress;
+                cmdList.BindRootConfiguration(m_rc);
+            }
+            return bound;
+        }
+
+        // Draw the instances culled by CullIndirect with one ExecuteIndirect
+        void DrawIndirect(D3DCommandList& cmdList, D3DConstantRing& constantRing)
+        {
+            if (m_indirectCount)
+                cmdList.ExecuteIndirect(m_signature, m_indirectCount, constantRing, m_indirectOffset);
+        }
+        // Draw the instances culled on the gpu (commands and count written by IndirectCulling)
+        void DrawIndirect(D3DCommandList& cmdList, D3DArgumentBuffer& arguments)
+        {
+            cmdList.ExecuteIndirect(m_signature, (UINT)m_indirectDraws.GetDrawCount(), arguments, 0, arguments, arguments.GetCountOffset());
+        }
+
+        // Drawables and their spheres of the last PrepareIndirect
+        inline const IndirectDrawBuilder& GetIndirectDraws() const
+        {
+            return m_indirectDraws;
+        }
+        inline const CullingSpheres& GetCullSpheres() const
+        {
+            return m_cullSpheres;
+        }
+
+        // Index size of the indirect commands
+        inline UINT GetIndirectIndexSize() const noexcept
+        {
+            return m_indirectIndexSize;
+        }
+
+        // Batches of the last Prepare
+        inline const std::vector<InstanceBatch>& GetBatches() const
+        {
+            return m_batcher.GetBatches();
+        }
+
+        // Makes ImGui calls
+        void UpdateImgui()
+        {
+            ImGui::Begin("Instanced Rendering");
+
+            ImGui::Checkbox("Draw instanced grid", &m_enabled);
+            ImGui::SliderInt("Instances", (int*)&m_count, 1, MaxInstances);
+            ImGui::Checkbox("Draw indirect (culled per instance)", &m_indirect);
+            if (m_indirect)
+                ImGui::Checkbox("Cull on the gpu", &m_gpuCulling);
+            if (m_indirect && m_gpuCulling)
+                ImGui::Text("%zu instances culled on the gpu for one ExecuteIndirect", m_indirectDraws.GetDrawCount());
+            else if (m_indirect)
+                ImGui::Text("%u of %zu instances visible in one ExecuteIndirect", m_indirectCount, m_batcher.GetInstanceCount());
+            else
+                ImGui::Text("%zu draws for %zu instances", m_batcher.GetBatches().size(), m_batcher.GetInstanceCount());
+
+            ImGui::End();
+        }
+
+        // Checks if the instanced path should be used
+        inline bool IsEnabled() const noexcept
+        {
+            return m_enabled;
+        }
+        // Checks if the instances should be culled and drawn indirect
+        inline bool IsIndirect() const noexcept
+        {
+            return m_indirect;
+        }
+        // Checks if the indirect draws should be culled by IndirectCulling
+        inline bool IsGpuCulling() const noexcept
+        {
+            return m_indirect && m_gpuCulling;
+        }
+
+    protected:
+        // Construct the pipeline state
+        bool __internal_ConstructPso(IPsoManipulator* ptrManipulator) override
+        {
+            // Check the type
+            if (ptrManipulator->GetType() != PipelineStateType::Graffics)
+                throw std::exception("Unexpected pipeline state manipulator type");
+
+            // Case to gfx manipulator
+            GfxPsoManipulator* pso = (GfxPsoManipulator*)ptrManipulator;
+
+            // Set shaders
+            pso->BindShader(ShaderType::VS, &m_vs);
+            pso->BindShader(ShaderType::PS, &m_ps);
+
+            // Setup render target
+            pso->OMSetRenderTargetFormat(0, DXGI_FORMAT_R8G8B8A8_UNORM);
+
+            // Setup the input layout (instance data comes from the SRV)
+            VertexLayoutAddInputElements<BasicRendering::VertexLayout>(pso);
+
+            return true;
+        }
+
+    private:
+        // My shaders
+        Shader m_vs, m_ps;
+        RootConfiguration m_rc;
+
+        // Instance transforms (SoA) and their matrices
+        std::vector<float> m_position[3], m_rotation[4], m_scale[3];
+        std::vector<UINT> m_offsets;
+        UINT m_count = 64;
+
+        // Instance stream of the current frame (and the queued instance of every packed one)
+        InstanceBatcher m_batcher;
+        std::vector<UINT32> m_sources;
+        D3D12_GPU_VIRTUAL_ADDRESS m_streamAddress = 0;
+        UINT32 m_firstInstance = 0;
+
+        // Indirect commands of the visible instances
+        IndirectDrawBuilder m_indirectDraws;
+        D3DCommandSignature m_signature;
+        CullingSpheres m_cullSpheres;
+        std::vector<UINT32> m_cullVisible;
+        UINT m_indirectCount = 0;
+        UINT m_indirectIndexSize = 0;
+        UINT64 m_indirectOffset = 0;
+
+        // Path selection
+        bool m_enabled = false;
+        bool m_indirect = false;
+        bool m_gpuCulling = false;
+};
+
+
+class IndirectCulling : public D3DPipelineState
+{
+    public:
+        // Threads per group (CULLING_GROUP_SIZE in Culling.hlsli)
+        static constexpr UINT GroupSize = 64;
+
+    public:
+        // Constructor that loads the shader and allocates the argument buffer for maxCommands commands of commandStride bytes
+        IndirectCulling(UINT maxCommands, UINT commandStride) :
+            // Shader
+            m_cs(L"shaders/CullIndirectCS.hlsl", RTR_SHADER_CS_6_0, L"CullIndirectCS"),
+            D3DPipelineState(PipelineStateType::Compute),
+
+            // Configuration for the root signature (addresses are placed by Cull)
+            m_rc(PipelineStateType::Compute, 6,
+                RootConfigurationEntry::MakeConstantBufferView(0),
+                RootConfigurationEntry::MakeShaderResourceView(0),
+                RootConfigurationEntry::MakeShaderResourceView(0),
+                RootConfigurationEntry::MakeShaderResourceView(0),
+                RootConfigurationEntry::MakeUnorderedAccessView(0),
+                RootConfigurationEntry::MakeUnorderedAccessView(0)
+            ),
+
+            // Visible commands and their count
+            m_arguments((UINT64)maxCommands * commandStride)
+        {
+            // The renderer has no depth buffer yet: a single texel at the far plane keeps the occlusion test running on the gpu
+            // every frame without ever rejecting a drawable the frustum kept
+            const float farPlane = 1.0f;
+            m_hiZ.Build(&farPlane, 1, 1);
+        }
+
+        // Upload the drawables and record the culling pass. Afterwards the argument buffer holds the visible commands and their count.
+        bool Cull(D3DCommandList& cmdList, D3DConstantRing& constantRing, const IndirectDrawBuilder& draws, const CullingSpheres& spheres, DirectX::FXMMATRIX viewProjection)
+        {
+            const UINT drawCount = (UINT)draws.GetDrawCount();
+            if (!drawCount || (UINT64)drawCount * draws.GetStride() > m_arguments.GetArgumentSize())
+                return false;
+
+            // Constants
+            DirectX::XMFLOAT4X4 matrix;
+            DirectX::XMStoreFloat4x4(&matrix, viewProjection);
+            m_rc[0].ConstantBufferView.dataAddress = constantRing.Push(MakeIndirectCullConstants(&matrix._11, drawCount, draws.GetStride() / sizeof(UINT32), &m_hiZ));
+
+            // Spheres (float4 each) and the commands of all drawables
+            D3DConstantAllocation sphereData = constantRing.Allocate(drawCount * sizeof(float) * 4);
+            D3DConstantAllocation commandData = constantRing.Allocate(drawCount * draws.GetStride());
+            D3DConstantAllocation hiZData = constantRing.Allocate(m_hiZ.GetDataSize());
+            if (!m_rc[0].ConstantBufferView.dataAddress || !sphereData.ptrData || !commandData.ptrData || !hiZData.ptrData)
+                return false;
+            float* ptrSphere = (float*)sphereData.ptrData;
+            for (UINT i = 0; i < drawCount; i++)
+            {
+                *ptrSphere++ = spheres.GetX()[i];
+                *ptrSphere++ = spheres.GetY()[i];
+                *ptrSphere++ = spheres.GetZ()[i];
+                *ptrSphere++ = spheres.GetRadius()[i];
+            }
+            draws.BuildAll(commandData.ptrData);
+            memcpy(hiZData.ptrData, m_hiZ.GetData(), m_hiZ.GetDataSize());
+
+            // Buffers
+            m_rc[1].ShaderResourceView.dataAddress = sphereData.address;
+            m_rc[2].ShaderResourceView.dataAddress = commandData.address;
+            m_rc[3].ShaderResourceView.dataAddress = hiZData.address;
+            m_rc[4].UnorderedAccessView.dataAddress = m_arguments.GetAddress();
+            m_rc[5].UnorderedAccessView.dataAddress = m_arguments.GetCountAddress();
+
+            // Zero the count and append the visible commands
+            if (!m_arguments.ResetCount(cmdList, constantRing))
+                return false;
+            m_arguments.EnsureResourceState(cmdList, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            cmdList.ResourceBarrierFlush();
+            if (!cmdList.BindPipelineState(*this))
+                return false;
+            cmdList.BindRootConfiguration(m_rc);
+            cmdList.Dispatch((drawCount + GroupSize - 1) / GroupSize);
+
+            // Ready for ExecuteIndirect
+            m_arguments.EnsureResourceState(cmdList, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+            cmdList.ResourceBarrierFlush();
+            return true;
+        }
+
+        // Commands and count of the last Cull
+        inline D3DArgumentBuffer& GetArguments()
+        {
+            return m_arguments;
+        }
+
+    protected:
+        // Construct the pipeline state
+        bool __internal_ConstructPso(IPsoManipulator* ptrManipulator) override
+        {
+            // Check the type
+            if (ptrManipulator->GetType() != PipelineStateType::Compute)
+                throw std::exception("Unexpected pipeline state manipulator type");
+
+            // Set shader
+            CsPsoManipulator* pso = (CsPsoManipulator*)ptrManipulator;
+            pso->BindShader(ShaderType::CS, &m_cs);
+
+            return true;
+        }
+
+    private:
+        // My shader
+        Shader m_cs;
+        RootConfiguration m_rc;
+
+        // Visible commands
+        D3DArgumentBuffer m_arguments;
+
+        // Depth pyramid of the occlusion test
+        HiZPyramid m_hiZ;
 };
 
 
@@ -150,70 +787,77 @@ INT wWinMain_safe(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR cmdArgs, I
     // Init D3D12 and run application
     if (InitD3D12())
     {
-        // Common
-        D3DQueue queue(D3D12_COMMAND_LIST_TYPE_DIRECT);
-        D3DCommandList list(queue);
-        D3DUploadBuffer uploadBuffer(MemMiB(128));
-        ModelContext mdlCtx(MemMiB(512));
-
-        // Matrix buffer
-        MatrixBuffer matBuffer(32);
-        D3DDescriptorHeap cbvSrvUavHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 32);
-
-        // Window
-        Window wnd(L"RTR Window", queue);
-        ImGuiManager::Init(&wnd);
-
-        // Assert copyable state
-        mdlCtx.GetGeometryBufferResource()->EnsureResourceState(list, D3D12_RESOURCE_STATE_COPY_DEST);
-        list.ResourceBarrierFlush();
-        list.ExecutSync();
-
-        // Custom rendering instance
-        BasicRendering renderingPso(matBuffer, cbvSrvUavHeap[0]);
-        ModelInfo suzanne = mdlCtx.LoadModel("models/Suzanne.fbx", uploadBuffer, sizeof(BasicRendering::Vertex), (FModelVertexCallback)&BasicRendering::CbVertexCreate);
-        if (!suzanne)
-            throw std::exception("Cannot load Suzanne!");
-
-        // Upload data and restore buffer state 
-        uploadBuffer.Execute();
-        uploadBuffer.Wait();
-        mdlCtx.GetGeometryBufferResource()->EnsureResourceState(list, 
-            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | D3D12_RESOURCE_STATE_INDEX_BUFFER);
-
-        // App loop
-        while (wnd.ProcessWindowEvents())
-        {
-            // Resize window if required
-            if (wnd.NeedsResize())
-            {
-                queue.Flush(2);
-                wnd.Resize();
-            }
-
-            // === UPDATE DATA ===
-            // Update suzanne
-            renderingPso.UpdateMatrices(matBuffer, (float)wnd.GetWidth() / wnd.GetHeight());
-
-            // Matrix copy
-            matBuffer.EnsureResourceState(list, D3D12_RESOURCE_STATE_COPY_DEST);
-            list.ExecutSync();
-            matBuffer.UpdateGPU(uploadBuffer);
-            uploadBuffer.ExecuteSync();
-            matBuffer.EnsureResourceState(list, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-
-            // === BEGIN DRAW ===
-            list.BeginRender(wnd.GetCurrentBackBuffer(), D3D12_RESOURCE_STATE_PRESENT, wnd.GetCurrentCPUHandle());
-            ImGuiManager::NewFrame();
-            
-            // Keeping the imgui demo
-            renderingPso.UpdateImgui();
-
-            // Render suzanne
-            list.BindDescriptorHeaps(cbvSrvUavHeap);
-            if (renderingPso.Bind(list))
+        {
+            // Common
+            D3DQueue queue(D3D12_COMMAND_LIST_TYPE_DIRECT);
+            D3DCommandList list(queue);
+            D3DUploadBuffer uploadBuffer(MemMiB(128), UploadBufferMode::Ring);
+            ModelContext mdlCtx(MemMiB(512));
+            WorkerPool cullWorkers;
+            FrustumCuller culler(cullWorkers);
+
+            // Matrix buffer (world matrices only, stored as 3x4) and per frame constants and instances (one region per frame in flight)
+            MatrixBuffer matBuffer(32 + InstancedRendering::MaxInstances, MatrixStorage::Float3x4);
+            D3DConstantRing constantRing(queue, MemMiB(1));
+            D3DDescriptorHeap cbvSrvUavHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 32);
+
+            // Window
+            Window wnd(L"RTR Window", queue);
+            ImGuiManager::Init(&wnd);
+
+            // Custom rendering instance
+            BasicRendering renderingPso(matBuffer);
+            MeshletRendering meshletPso;
+            InstancedRendering instancedPso(matBuffer);
+            IndirectCulling cullingPso(InstancedRendering::MaxInstances, sizeof(UINT32) + sizeof(IndirectDrawArguments));
+            const bool meshShadersSupported = D3D12SupportsMeshShaders();
+            ModelImportOptions importOptions;
+            importOptions.optimizeIndices = true;
+            importOptions.buildMeshlets = meshShadersSupported;
+            importOptions.lodCount = 4;
+            importOptions.shortIndices = true;
+            ModelStreamHandle suzanneHandle = mdlCtx.LoadModelAsync<BasicRendering::VertexLayout>("models/Suzanne.fbx", importOptions);
+
+            // Models stream in while rendering. The geometry buffer stays in COMMON: buffers are promoted implicitly on
+            // the copy and direct queue and decay after every execution, so streamed copies need no barriers.
+            ModelStreamUploader streamUploader(uploadBuffer);
+            ModelStreamBudget streamBudget;
+            streamBudget.bytesPerFrame = MemMiB(4);
+            streamBudget.msPerFrame = 1.0f;
+
+            // App loop
+            while (wnd.ProcessWindowEvents())
             {
-                // Bind viewport
+                // Resize window if required
+                if (wnd.NeedsResize())
+                {
+                    queue.Flush(2);
+                    wnd.Resize();
+                }
+
+                // === UPDATE DATA ===
+                // Update suzanne
+                renderingPso.UpdateMatrices(matBuffer, (float)wnd.GetWidth() / wnd.GetHeight());
+
+                // Model streaming (constants are written to the constant ring while drawing, no copy required).
+                // The copies run while the frame is recorded, the streamer waits for their execution to finish before using them.
+                mdlCtx.UpdateStreaming(streamUploader, streamBudget);
+                uploadBuffer.Execute();
+
+                // Compact geometry memory a little per frame after unloads left it fragmented (executes with the frame before the next uploads)
+                if (mdlCtx.NeedsDefragment())
+                    mdlCtx.Defragment(list, MemMiB(1));
+
+                // === BEGIN DRAW ===
+                list.BeginRender(wnd.GetCurrentBackBuffer(), D3D12_RESOURCE_STATE_PRESENT, wnd.GetCurrentCPUHandle());
+                ImGuiManager::NewFrame();
+
+                // Keeping the imgui demo
+                renderingPso.UpdateImgui(constantRing, uploadBuffer);
+                meshletPso.UpdateImgui(meshShadersSupported);
+                instancedPso.UpdateImgui();
+
+                // Viewport
                 D3D12_VIEWPORT vp;
                 vp.TopLeftX = 0;
                 vp.TopLeftY = 0;
@@ -221,47 +865,123 @@ INT wWinMain_safe(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR cmdArgs, I
                 vp.Height = wnd.GetHeight();
                 vp.MinDepth = 1.0f;
                 vp.MaxDepth = 0.0f;
-                list.RSPrepare(vp);
 
-                // Bind mesh
-                MeshInfo mesh = mdlCtx.GetMeshInfo(suzanne);
-                list.IAPrepare(
-                    mesh.vertexBuffer.CreateVertexBufferView(sizeof(BasicRendering::Vertex)),
-                    mesh.indexBuffer.CreateIndexBufferView(sizeof(unsigned int))
-                );
-
-                // Draw indexed
-                list.Draw(mesh.indexCount);
+                // Render suzanne (once resident and inside the frustum)
+                list.BindDescriptorHeaps(cbvSrvUavHeap);
+                ModelInfo suzanne;
+                if (mdlCtx.GetModelStreamState(suzanneHandle) == ModelStreamState::Failed)
+                    throw std::exception("Cannot load Suzanne!");
+                if (instancedPso.IsEnabled())
+                {
+                    // Grid of suzannes (repeated meshes collapse into one instanced draw per batch)
+                    instancedPso.Prepare(matBuffer, constantRing, renderingPso.GetViewProjection(), renderingPso.GetModelRotation(), suzanneHandle);
+                    if (instancedPso.IsIndirect())
+                    {
+                        // Visible instances as one indirect draw each, submitted with a single ExecuteIndirect (culled by a compute pass
+                        // that writes the commands and their count, or on the cpu)
+                        const bool gpuCulling = instancedPso.IsGpuCulling();
+                        bool culled = instancedPso.PrepareIndirect(mdlCtx, matBuffer);
+                        if (culled && gpuCulling)
+                            culled = cullingPso.Cull(list, constantRing, instancedPso.GetIndirectDraws(), instancedPso.GetCullSpheres(), renderingPso.GetViewProjection());
+                        else if (culled)
+                            culled = instancedPso.CullIndirect(culler, constantRing, renderingPso.GetViewProjection());
+                        if (culled && instancedPso.BindIndirect(list))
+                        {
+                            list.RSPrepare(vp);
+                            list.IAPrepare(
+                                mdlCtx.CreateSharedVertexBufferView(sizeof(BasicRendering::Vertex)),
+                                mdlCtx.CreateSharedIndexBufferView(instancedPso.GetIndirectIndexSize())
+                            );
+                            if (gpuCulling)
+                                instancedPso.DrawIndirect(list, cullingPso.GetArguments());
+                            else
+                                instancedPso.DrawIndirect(list, constantRing);
+                        }
+                    }
+                    else
+                    {
+                        UINT boundIndexSize = 0;
+                        for (const InstanceBatch& batch : instancedPso.GetBatches())
+                        {
+                            ModelInfo batchModel;
+                            if (mdlCtx.IsModelReady(batch.meshKey, &batchModel) && instancedPso.Bind(list, batch))
+                            {
+                                list.RSPrepare(vp);
+
+                                // Geometry is bound once (again only when the index size changes)
+                                MeshInfo batchMesh = mdlCtx.GetMeshInfo(batchModel);
+                                if (batchMesh.indexSize != boundIndexSize)
+                                {
+                                    list.IAPrepare(
+                                        mdlCtx.CreateSharedVertexBufferView(sizeof(BasicRendering::Vertex)),
+                                        mdlCtx.CreateSharedIndexBufferView(batchMesh.indexSize)
+                                    );
+                                    boundIndexSize = batchMesh.indexSize;
+                                }
+
+                                // Draw indexed instanced at full detail
+                                const MeshLod& lod = batchMesh.lods[0];
+                                list.Draw(lod.indexCount, batch.instanceCount, lod.GetStartIndex(batchMesh.indexSize), batchMesh.GetBaseVertex());
+                            }
+                        }
+                    }
+                }
+                else if (mdlCtx.IsModelReady(suzanneHandle, &suzanne) && renderingPso.IsVisible(mdlCtx.GetMeshInfo(suzanne), culler))
+                {
+                    MeshInfo mesh = mdlCtx.GetMeshInfo(suzanne);
+                    const D3D12_GPU_VIRTUAL_ADDRESS objectConstants = renderingPso.PushConstants(matBuffer, constantRing);
+                    const bool useMeshlets = meshShadersSupported && meshletPso.IsEnabled() && mesh.meshletCount;
+                    if (useMeshlets)
+                    {
+                        float cameraPosition[3];
+                        renderingPso.GetModelSpaceCamera(cameraPosition);
+                        meshletPso.SetMesh(mesh, cameraPosition, objectConstants);
+                    }
+                    if (objectConstants && (useMeshlets ? meshletPso.Bind(list) : renderingPso.Bind(list)))
+                    {
+                        // Bind viewport
+                        list.RSPrepare(vp);
+
+                        if (useMeshlets)
+                        {
+                            // Draw meshlets (cone culled in the amplification shader)
+                            meshletPso.Draw(list);
+                        }
+                        else
+                        {
+                            // Bind the shared geometry
+                            list.IAPrepare(
+                                mdlCtx.CreateSharedVertexBufferView(sizeof(BasicRendering::Vertex)),
+                                mdlCtx.CreateSharedIndexBufferView(mesh.indexSize)
+                            );
+
+                            // Draw indexed at the level of detail for the current distance
+                            const MeshLod& lod = mesh.lods[renderingPso.SelectLod(mesh, vp.Height)];
+                            list.Draw(lod.indexCount, 1, lod.GetStartIndex(mesh.indexSize), mesh.GetBaseVertex());
+                        }
+                    }
+                }
+
+                // === END DRAW ===
+                ImGuiManager::Render(list);
+                list.EndRender();
+
+                // Present frame (constants of this frame are released once the queue passed it)
+                list.ExecutSync();
+                constantRing.EndFrame();
+                wnd.Present(true);
+
+                // Check for file change events
+                DirWatchRefresh();
             }
 
-            // === END DRAW ===
-            ImGuiManager::Render(list);
-            list.EndRender();
-
-            // Present frame
-            list.ExecutSync();
-            wnd.Present(true);
+            // Destroy imgui
+            ImGuiManager::Shutdown();
 
-            // Check for file change events
-            DirWatchRefresh();
+            // Objects of this scope are destroyed in reverse order when it ends (before the device goes away)
+            queue.Flush(2);
         }
 
-        // Destroy imgui
-        ImGuiManager::Shutdown();
-
-        queue.Flush(2);
-        list.~D3DCommandList();
-
-        // Destroy custom instances
-        cbvSrvUavHeap.~D3DDescriptorHeap();
-        matBuffer.~MatrixBuffer();
-        mdlCtx.~ModelContext();
-        renderingPso.~BasicRendering();
-
-        uploadBuffer.~D3DUploadBuffer();
-        wnd.~Window();
-        queue.~D3DQueue();
-
         // Shutdown D3D12
         ShutdownD3D12();
     }
@@ -1,16 +1,15 @@
 #define BasicRootSignature "" \
 "RootFlags( ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT)," \
-"DescriptorTable(" \
-"   CBV(b0)" /* Matricies */ \
-")"
+"CBV(b0)" /* Object constants */
 
-// Matrix constant buffer
+#include "Transform.hlsli"
+
+// Per object constants (written to the constant ring every frame, model view projection concatenated on the cpu)
 struct
 {
-    float4x4 Projection;
-    float4x4 View;
-    float4x4 Model;
-} Matrix : register(b0);
+    float4x4 ModelViewProjection;
+    WorldMatrix World;
+} Object : register(b0);
 
 // Vertex layout
 struct Vertex
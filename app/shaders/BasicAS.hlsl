@@ -0,0 +1,34 @@
+#include "Meshlet.hlsli"
+
+groupshared MeshletPayload s_payload;
+groupshared uint s_visibleCount;
+
+[RootSignature(MeshletRootSignature)]
+[numthreads(MESHLET_AS_GROUP_SIZE, 1, 1)]
+void BasicAS(uint dtid : SV_DispatchThreadID, uint gtid : SV_GroupIndex)
+{
+    if (gtid == 0)
+    {
+        s_visibleCount = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // Cone culling per meshlet
+    bool visible = false;
+    if (dtid < MeshletConstants.MeshletCount)
+    {
+        visible = !IsMeshletBackfacing(MeshletBoundsBuffer[dtid], MeshletConstants.CameraPosition);
+    }
+
+    // Compact visible meshlets into the payload (group wide counter, the group may span several waves)
+    if (visible)
+    {
+        uint slot;
+        InterlockedAdd(s_visibleCount, 1, slot);
+        s_payload.MeshletIndices[slot] = dtid;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // One mesh shader group per visible meshlet
+    DispatchMesh(s_visibleCount, 1, 1, s_payload);
+}
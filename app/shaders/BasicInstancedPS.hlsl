@@ -0,0 +1,15 @@
+#include "Instanced.hlsli"
+
+// Colors by material index
+static const float3 MaterialColors[4] = {
+    float3(1.0f, 1.0f, 1.0f),
+    float3(1.0f, 0.5f, 0.3f),
+    float3(0.3f, 0.8f, 0.4f),
+    float3(0.3f, 0.5f, 1.0f),
+};
+
+[RootSignature(InstancedRootSignature)]
+float4 BasicInstancedPS(in InstancedVertex vtx) : SV_Target
+{
+    return float4(MaterialColors[vtx.material % 4], 1.0f);
+}
@@ -0,0 +1,12 @@
+#include "Instanced.hlsli"
+
+[RootSignature(InstancedRootSignature)]
+InstancedVertex BasicInstancedVS(in float4 position : SV_POSITION, in uint instanceId : SV_InstanceID)
+{
+    Instance instance = Instances[Draw.FirstInstance + instanceId];
+
+    InstancedVertex vtx;
+    vtx.position = mul(TransformWorld(instance.World, position), Frame.ViewProjection);
+    vtx.material = instance.MaterialIndex;
+    return vtx;
+}
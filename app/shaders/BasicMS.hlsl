@@ -0,0 +1,25 @@
+#include "Meshlet.hlsli"
+
+[RootSignature(MeshletRootSignature)]
+[outputtopology("triangle")]
+[numthreads(MESHLET_MS_GROUP_SIZE, 1, 1)]
+void BasicMS(
+    uint gtid : SV_GroupThreadID, uint gid : SV_GroupID, in payload MeshletPayload payload,
+    out indices uint3 triangles[MESHLET_MAX_PRIMITIVES], out vertices Vertex vertices[MESHLET_MAX_VERTICES]
+)
+{
+    Meshlet meshlet = Meshlets[payload.MeshletIndices[gid]];
+    SetMeshOutputCounts(meshlet.VertexCount, meshlet.PrimitiveCount);
+
+    // Primitives
+    for (uint p = gtid; p < meshlet.PrimitiveCount; p += MESHLET_MS_GROUP_SIZE)
+    {
+        triangles[p] = UnpackPrimitive(MeshletPrimitives[meshlet.PrimitiveOffset + p]);
+    }
+
+    // Vertices
+    for (uint v = gtid; v < meshlet.VertexCount; v += MESHLET_MS_GROUP_SIZE)
+    {
+        vertices[v].position = mul(Vertices[MeshletVertices[meshlet.VertexOffset + v]], Object.ModelViewProjection);
+    }
+}
@@ -0,0 +1,7 @@
+#include "Meshlet.hlsli"
+
+[RootSignature(MeshletRootSignature)]
+float4 BasicMeshletPS(in Vertex vtx) : SV_Target
+{
+    return float4(1.0f, 1.0f, 1.0f, 1.0f);
+}
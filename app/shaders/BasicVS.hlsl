@@ -3,8 +3,6 @@
 [RootSignature(BasicRootSignature)]
 Vertex BasicVS(in Vertex vtx)
 {
-    float4x4 mvpMatrix = mul(Matrix.Model, Matrix.View);
-    mvpMatrix = mul(mvpMatrix, Matrix.Projection);
-    vtx.position = mul(vtx.position, mvpMatrix);
+    vtx.position = mul(vtx.position, Object.ModelViewProjection);
     return vtx;
 }
@@ -0,0 +1,35 @@
+#include "Culling.hlsli"
+
+[RootSignature(CullingRootSignature)]
+[numthreads(CULLING_GROUP_SIZE, 1, 1)]
+void CullIndirectCS(uint dtid : SV_DispatchThreadID)
+{
+    // Frustum and occlusion test per drawable
+    bool visible = false;
+    float4 sphere = 0.0f;
+    if (dtid < Cull.DrawCount)
+    {
+        sphere = Spheres[dtid];
+        visible = IsInFrustum(sphere) && (Cull.HiZLevels == 0 || !IsOccluded(sphere));
+    }
+
+    // One atomic per wave reserves the slots of all visible lanes (wave ops outside of the branches)
+    const uint waveCount = WaveActiveCountBits(visible);
+    const uint waveSlot = WavePrefixCountBits(visible);
+    uint waveFirst = 0;
+    if (WaveIsFirstLane())
+    {
+        ArgumentCount.InterlockedAdd(0, waveCount, waveFirst);
+    }
+    waveFirst = WaveReadLaneFirst(waveFirst);
+
+    // Append the command
+    if (visible)
+    {
+        const uint slot = waveFirst + waveSlot;
+        for (uint i = 0; i < Cull.CommandValues; i++)
+        {
+            Arguments.Store((slot * Cull.CommandValues + i) * 4, Commands.Load((dtid * Cull.CommandValues + i) * 4));
+        }
+    }
+}
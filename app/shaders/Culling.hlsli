@@ -0,0 +1,109 @@
+#define CullingRootSignature "" \
+"CBV(b0)," /* Cull constants */ \
+"SRV(t0)," /* Spheres */ \
+"SRV(t1)," /* Commands of all drawables */ \
+"SRV(t2)," /* Hi-Z pyramid */ \
+"UAV(u0)," /* Commands of the visible drawables */ \
+"UAV(u1)"  /* Count of the visible drawables */
+
+// Thread group size
+#define CULLING_GROUP_SIZE 64
+
+// Cull constants (RTR::IndirectCullConstants)
+struct
+{
+    float4x4 ViewProjection;
+    float4 Planes[6];
+    uint DrawCount;
+    uint CommandValues;
+    uint HiZWidth;
+    uint HiZHeight;
+    uint HiZLevels;
+    uint ReversedDepth;
+} Cull : register(b0);
+
+// World space sphere of every drawable (center, radius)
+StructuredBuffer<float4> Spheres : register(t0);
+// Commands of all drawables (RTR::IndirectDrawBuilder, Cull.CommandValues 32 bit values each)
+ByteAddressBuffer Commands : register(t1);
+// Packed levels of the farthest depth (RTR::HiZPyramid)
+StructuredBuffer<float> HiZ : register(t2);
+
+// ExecuteIndirect arguments and count
+RWByteAddressBuffer Arguments : register(u0);
+RWByteAddressBuffer ArgumentCount : register(u1);
+
+// Size of a pyramid level (RTR::HiZPyramid::GetLevelSize)
+uint GetLevelSize(uint size, uint level)
+{
+    for (uint i = 0; i < level; i++)
+        size = max(1, (size + 1) / 2);
+    return size;
+}
+
+// First value of a pyramid level (RTR::HiZPyramid::GetLevelOffset)
+uint GetLevelOffset(uint level)
+{
+    uint offset = 0;
+    for (uint i = 0; i < level; i++)
+        offset += GetLevelSize(Cull.HiZWidth, i) * GetLevelSize(Cull.HiZHeight, i);
+    return offset;
+}
+
+// Sphere is inside all planes
+bool IsInFrustum(float4 sphere)
+{
+    for (uint i = 0; i < 6; i++)
+    {
+        if (dot(Cull.Planes[i].xyz, sphere.xyz) + Cull.Planes[i].w < -sphere.w)
+            return false;
+    }
+    return true;
+}
+
+// Sphere is behind the depth of the pyramid (same steps as the cpu reference in IndirectCulling.cpp)
+bool IsOccluded(float4 sphere)
+{
+    // Screen rectangle and nearest depth of the corners of the sphere's box
+    float2 rectMin = 1.0f;
+    float2 rectMax = 0.0f;
+    float nearestZ = 1.0f;
+    for (uint corner = 0; corner < 8; corner++)
+    {
+        float3 p = sphere.xyz + float3(corner & 1 ? sphere.w : -sphere.w, corner & 2 ? sphere.w : -sphere.w, corner & 4 ? sphere.w : -sphere.w);
+        float4 clip = mul(float4(p, 1.0f), Cull.ViewProjection);
+
+        // Crossing the near plane (never occluded, the near plane is at z = w with reversed depth)
+        if (clip.w <= 0.0f || (Cull.ReversedDepth ? clip.z > clip.w : clip.z < 0.0f))
+            return false;
+
+        float2 uv = float2(clip.x / clip.w * 0.5f + 0.5f, 0.5f - clip.y / clip.w * 0.5f);
+        rectMin = min(rectMin, uv);
+        rectMax = max(rectMax, uv);
+        // Flipped like the pyramid's values
+        const float z = clip.z / clip.w;
+        nearestZ = min(nearestZ, Cull.ReversedDepth ? 1.0f - z : z);
+    }
+    const float2 size = float2(Cull.HiZWidth, Cull.HiZHeight);
+    rectMin = max(rectMin, 0.0f) * size;
+    rectMax = min(rectMax, 1.0f) * size;
+
+    // Level where the rectangle covers at most 2x2 texels
+    const float extent = max(rectMax.x - rectMin.x, rectMax.y - rectMin.y);
+    const uint level = min(extent > 1.0f ? (uint)ceil(log2(extent)) : 0, Cull.HiZLevels - 1);
+    const uint2 levelSize = uint2(GetLevelSize(Cull.HiZWidth, level), GetLevelSize(Cull.HiZHeight, level));
+    const uint levelOffset = GetLevelOffset(level);
+    const float scale = 1.0f / (float)(1u << level);
+
+    const uint2 texelMin = min((uint2)(rectMin * scale), levelSize - 1);
+    const uint2 texelMax = min((uint2)(rectMax * scale), levelSize - 1);
+
+    // Occluded when nearer than everything in front of it
+    float farthest = 0.0f;
+    for (uint y = texelMin.y; y <= texelMax.y; y++)
+    {
+        for (uint x = texelMin.x; x <= texelMax.x; x++)
+            farthest = max(farthest, HiZ[levelOffset + y * levelSize.x + x]);
+    }
+    return nearestZ > farthest;
+}
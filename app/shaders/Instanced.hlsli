@@ -0,0 +1,37 @@
+#define InstancedRootSignature "" \
+"RootFlags( ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT)," \
+"CBV(b0)," /* Frame constants */ \
+"SRV(t0),"  /* Instances of the draw */ \
+"RootConstants(num32BitConstants=1, b1)" /* Draw constants (written per command by ExecuteIndirect) */
+
+#include "Transform.hlsli"
+
+// Per frame constants
+struct
+{
+    float4x4 ViewProjection;
+} Frame : register(b0);
+
+// Per draw constants
+struct
+{
+    uint FirstInstance;
+} Draw : register(b1);
+
+// Instance (RTR::InstanceData)
+struct Instance
+{
+    WorldMatrix World;
+    uint MaterialIndex;
+    uint3 Padding;
+};
+
+// Instance stream of the current draw (Draw.FirstInstance is added to the instance id)
+StructuredBuffer<Instance> Instances : register(t0);
+
+// Vertex layout
+struct InstancedVertex
+{
+    float4 position : SV_POSITION;
+    nointerpolation uint material : MATERIAL;
+};
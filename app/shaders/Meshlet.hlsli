@@ -0,0 +1,83 @@
+#define MeshletRootSignature "" \
+"CBV(b0)," /* Object constants */ \
+"RootConstants(num32BitConstants=4, b1)," /* Meshlet constants */ \
+"SRV(t0)," /* Vertices */ \
+"SRV(t1)," /* Meshlets */ \
+"SRV(t2)," /* Meshlet bounds */ \
+"SRV(t3)," /* Meshlet vertices */ \
+"SRV(t4)"  /* Meshlet primitives */
+
+// Limits (must match the import options)
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_PRIMITIVES 124
+
+// Thread group sizes
+#define MESHLET_AS_GROUP_SIZE 32
+#define MESHLET_MS_GROUP_SIZE 128
+
+// Per object constants (same layout as in Basic.hlsli, only the model view projection is used)
+struct
+{
+    float4x4 ModelViewProjection;
+    float4 World[3];
+} Object : register(b0);
+
+// Per draw constants
+struct
+{
+    uint MeshletCount;
+    float3 CameraPosition; // Model space
+} MeshletConstants : register(b1);
+
+// Meshlet (RTR::Meshlet)
+struct Meshlet
+{
+    uint VertexOffset;
+    uint VertexCount;
+    uint PrimitiveOffset;
+    uint PrimitiveCount;
+};
+
+// Meshlet culling data (RTR::MeshletBounds)
+struct MeshletBounds
+{
+    float3 Center;
+    float Radius;
+    float3 ConeApex;
+    float ConeCutoff;
+    float3 ConeAxis;
+    float Padding;
+};
+
+// Buffers
+StructuredBuffer<float4> Vertices : register(t0);
+StructuredBuffer<Meshlet> Meshlets : register(t1);
+StructuredBuffer<MeshletBounds> MeshletBoundsBuffer : register(t2);
+StructuredBuffer<uint> MeshletVertices : register(t3);
+StructuredBuffer<uint> MeshletPrimitives : register(t4);
+
+// Amplification to mesh shader payload
+struct MeshletPayload
+{
+    uint MeshletIndices[MESHLET_AS_GROUP_SIZE];
+};
+
+// Vertex layout
+struct Vertex
+{
+    float4 position : SV_POSITION;
+};
+
+// Unpack a 10:10:10 primitive (RTR::MeshletUnpackPrimitive)
+uint3 UnpackPrimitive(uint primitive)
+{
+    return uint3(primitive & 0x3FF, (primitive >> 10) & 0x3FF, (primitive >> 20) & 0x3FF);
+}
+
+// Normal cone test (RTR::MeshletIsBackfacing)
+bool IsMeshletBackfacing(MeshletBounds bounds, float3 cameraPosition)
+{
+    float3 view = bounds.ConeApex - cameraPosition;
+    float viewLength = length(view);
+    return viewLength > 0.0f && dot(view, bounds.ConeAxis) >= bounds.ConeCutoff * viewLength;
+}
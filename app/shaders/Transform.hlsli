@@ -0,0 +1,11 @@
+// World matrix as stored by a 3x4 RTR::MatrixBuffer (transposed rows, the last row is 0, 0, 0, 1)
+struct WorldMatrix
+{
+    float4 Rows[3];
+};
+
+// Transform a position with a WorldMatrix
+float4 TransformWorld(WorldMatrix world, float4 position)
+{
+    return float4(dot(world.Rows[0], position), dot(world.Rows[1], position), dot(world.Rows[2], position), position.w);
+}
@@ -1,15 +1,33 @@
--- Include conan gennerate script
-include("conanbuildinfo.premake.lua")
+-- Include conan gennerate script (the renderer itself only builds on windows)
+if os.istarget("windows") then
+    include("conanbuildinfo.premake.lua")
+end
+
+-- Build the AVX2 code paths (premake5 --avx2 ...)
+newoption {
+    trigger = "avx2",
+    description = "Compile with AVX2 enabled"
+}
 
 -- Main Workspace
 workspace "RealTimeRendering"
     -- Import conan gennerate config
-    conan_basic_setup()
+    if os.istarget("windows") then
+        conan_basic_setup()
+    else
+        configurations { "Debug", "Release" }
+    end
+
+    filter "options:avx2"
+    vectorextensions "AVX2"
+    filter {}
 
     -- Project
+    if os.istarget("windows") then
     project "RealTimeRendering"
         kind "WindowedApp"
         language "C++"
+        cppdialect "C++17"
         targetdir "bin/%{cfg.buildcfg}"
         objdir "bin/%{cfg.buildcfg}/obj/"
         location "RealTimeRendering"
@@ -23,6 +41,62 @@ workspace "RealTimeRendering"
         linkoptions { conan_exelinkflags }
 
         files { "**.h", "**.cpp" }
+        removefiles { "tests/**" }
+
+        filter "configurations:Debug"
+        defines { "DEBUG", "RTR_DEBUG" }
+        symbols "On"
+
+        filter "configurations:Release"
+        defines { "NDEBUG", "RTR_RELEASE" }
+        optimize "On"
+
+        filter {}
+    end
+
+    -- Headless tests and benchmarks of the platform independent modules (run with --bench for the benchmarks)
+    project "RealTimeRenderingTests"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++17"
+        targetdir "bin/%{cfg.buildcfg}"
+        objdir "bin/%{cfg.buildcfg}/obj/tests/"
+        location "tests"
+
+        includedirs { "RealTimeRendering" }
+
+        files {
+            "tests/**.h",
+            "tests/**.cpp",
+            "RealTimeRendering/Util/AtomicBumpAllocator.*",
+            "RealTimeRendering/Util/CopyCoalescing.*",
+            "RealTimeRendering/Util/DirtyRanges.*",
+            "RealTimeRendering/Util/MappedFile.*",
+            "RealTimeRendering/Util/RingAllocator.*",
+            "RealTimeRendering/Util/StreamChunking.*",
+            "RealTimeRendering/Util/StreamCopy.*",
+            "RealTimeRendering/Util/TlsfAllocator.*",
+            "RealTimeRendering/Util/WorkerPool.*",
+            "RealTimeRendering/RTR/3DModells/IndirectDrawBuilder.*",
+            "RealTimeRendering/RTR/3DModells/InstanceBatcher.*",
+            "RealTimeRendering/RTR/3DModells/MeshCache.*",
+            "RealTimeRendering/RTR/3DModells/MeshOptimizer.*",
+            "RealTimeRendering/RTR/3DModells/MeshShareTable.*",
+            "RealTimeRendering/RTR/3DModells/MeshletBuilder.*",
+            "RealTimeRendering/RTR/3DModells/MeshSimplifier.*",
+            "RealTimeRendering/RTR/3DModells/ModelHandleTable.*",
+            "RealTimeRendering/RTR/3DModells/ModelStreamer.*",
+            "RealTimeRendering/RTR/3DModells/SlotHandleTable.*",
+            "RealTimeRendering/RTR/3DModells/TransformBatch.*",
+            "RealTimeRendering/RTR/3DModells/VertexQuantization.*",
+            "RealTimeRendering/RTR/Culling/Bounds.*",
+            "RealTimeRendering/RTR/Culling/FrustumCuller.*",
+            "RealTimeRendering/RTR/Culling/HiZPyramid.*",
+            "RealTimeRendering/RTR/Culling/IndirectCulling.*",
+        }
+
+        filter "system:linux"
+        links { "pthread" }
 
         filter "configurations:Debug"
         defines { "DEBUG", "RTR_DEBUG" }
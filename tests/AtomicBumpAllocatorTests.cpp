@@ -0,0 +1,165 @@
+#include "Test.h"
+
+#include <Util/AtomicBumpAllocator.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Size and alignment of the k-th allocation of a thread
+    inline uint64_t AllocationSize(size_t k)
+    {
+        return 64 + (k & 63);
+    }
+    inline uint64_t AllocationAlignment(size_t k)
+    {
+        return k & 1 ? 1 : 16;
+    }
+
+    // Run func(threadIndex) on threadCount threads at once
+    template<typename F>
+    void RunThreads(unsigned int threadCount, F&& func)
+    {
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < threadCount; i++)
+            threads.emplace_back([&func, i]() { func(i); });
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    // The single threaded bump behind a mutex (what the reservation path would be without the atomic allocator)
+    struct LockedBumpAllocator
+    {
+        std::mutex mutex;
+        uint64_t size = 0, usage = 0;
+
+        bool Allocate(uint64_t bytes, uint64_t alignment, uint64_t* ptrOffsetOut)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const uint64_t offset = (usage + alignment - 1) / alignment * alignment;
+            if (offset > size || size - offset < bytes)
+                return false;
+            *ptrOffsetOut = offset;
+            usage = offset + bytes;
+            return true;
+        }
+    };
+}
+
+RTR_TEST(AtomicBumpAllocatorSingleThread)
+{
+    RTR::AtomicBumpAllocator bump(1000);
+    uint64_t offset;
+    RTR_EXPECT(bump.Allocate(100, 1, &offset) && offset == 0);
+    RTR_EXPECT(bump.Allocate(10, 64, &offset) && offset == 128);
+    RTR_EXPECT(bump.GetUsedSize() == 128 + 10);
+
+    // Invalid requests
+    RTR_EXPECT(!bump.Allocate(1, 0, &offset));
+    RTR_EXPECT(!bump.Allocate(1001, 1, &offset));
+
+    // A failed allocation leaves the range untouched, smaller ones still fit
+    RTR_EXPECT(!bump.Allocate(900, 1, &offset));
+    RTR_EXPECT(bump.GetFreeSize() == 1000 - 138);
+    RTR_EXPECT(bump.Allocate(12, 1, &offset) && offset == 138);
+
+    // So does an allocation that only fails because of its alignment
+    RTR_EXPECT(!bump.Allocate(100, 1024, &offset) && bump.GetUsedSize() == 150);
+    RTR_EXPECT(bump.Allocate(850, 1, &offset) && offset == 150 && bump.GetFreeSize() == 0);
+    RTR_EXPECT(!bump.Allocate(1, 1, &offset));
+    bump.Reset();
+    RTR_EXPECT(bump.GetFreeSize() == 1000);
+    RTR_EXPECT(bump.Allocate(1000, 1, &offset) && offset == 0);
+    RTR_EXPECT(!bump.Allocate(1, 1, &offset));
+
+    bump.Reset(10);
+    RTR_EXPECT(bump.GetSize() == 10 && bump.Allocate(10, 1, &offset) && offset == 0);
+}
+
+RTR_TEST(AtomicBumpAllocatorConcurrentRangesAreDisjoint)
+{
+    const unsigned int threadCount = 8;
+    const size_t perThread = 20000;
+
+    // Large enough for everything, then small enough to run out while all threads allocate
+    for (uint64_t size : { 1ULL << 32, 1ULL << 20 })
+    {
+        RTR::AtomicBumpAllocator bump(size);
+        std::vector<std::vector<std::pair<uint64_t, uint64_t>>> ranges(threadCount);
+        std::vector<char> aligned(threadCount, 1);
+        RunThreads(threadCount, [&](unsigned int thread)
+            {
+                uint64_t offset;
+                for (size_t k = 0; k < perThread; k++)
+                {
+                    if (bump.Allocate(AllocationSize(k), AllocationAlignment(k), &offset))
+                    {
+                        ranges[thread].push_back({ offset, AllocationSize(k) });
+                        aligned[thread] = aligned[thread] && offset % AllocationAlignment(k) == 0;
+                    }
+                }
+            });
+
+        std::vector<std::pair<uint64_t, uint64_t>> all;
+        for (unsigned int thread = 0; thread < threadCount; thread++)
+        {
+            RTR_EXPECT(aligned[thread]);
+            all.insert(all.end(), ranges[thread].begin(), ranges[thread].end());
+        }
+        std::sort(all.begin(), all.end());
+
+        bool disjoint = true;
+        for (size_t i = 1; i < all.size(); i++)
+            disjoint = disjoint && all[i - 1].first + all[i - 1].second <= all[i].first;
+        RTR_EXPECT(disjoint);
+        RTR_EXPECT(all.empty() || all.back().first + all.back().second <= size);
+
+        // Everything fits into the large range, the small one runs full (up to less than the largest request and its alignment)
+        if (size == 1ULL << 32)
+            RTR_EXPECT(all.size() == threadCount * perThread);
+        else
+            RTR_EXPECT(all.size() < threadCount * perThread && bump.GetFreeSize() < AllocationSize(63) + 15);
+    }
+}
+
+RTR_BENCHMARK(AtomicBumpAllocatorContention)
+{
+    // Reservations per thread with mixed sizes and alignments, the atomic allocator against a locked bump
+    const size_t perThread = 1 << 18;
+    printf("  threads  atomic ns/op  mutex ns/op\n");
+    for (unsigned int threadCount : { 1u, 2u, 4u, 8u, 16u, 32u })
+    {
+        RTR::AtomicBumpAllocator bump;
+        const double atomicSeconds = RTR::Test::MeasureSeconds([&]()
+            {
+                bump.Reset(1ULL << 40);
+                RunThreads(threadCount, [&](unsigned int)
+                    {
+                        uint64_t offset;
+                        for (size_t k = 0; k < perThread; k++)
+                            bump.Allocate(AllocationSize(k), AllocationAlignment(k), &offset);
+                    });
+            }, 3);
+
+        LockedBumpAllocator locked;
+        const double mutexSeconds = RTR::Test::MeasureSeconds([&]()
+            {
+                locked.size = 1ULL << 40;
+                locked.usage = 0;
+                RunThreads(threadCount, [&](unsigned int)
+                    {
+                        uint64_t offset;
+                        for (size_t k = 0; k < perThread; k++)
+                            locked.Allocate(AllocationSize(k), AllocationAlignment(k), &offset);
+                    });
+            }, 3);
+
+        const double operations = (double)perThread * threadCount;
+        printf("  %7u  %12.2f  %11.2f\n", threadCount, atomicSeconds * 1e9 / operations, mutexSeconds * 1e9 / operations);
+    }
+}
@@ -0,0 +1,125 @@
+#include "Test.h"
+
+#include <Util/CopyCoalescing.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Staging buffer and targets of a simulated upload
+    struct CopyScene
+    {
+        std::vector<unsigned char> source;
+        std::vector<std::vector<unsigned char>> targets;
+        std::vector<RTR::BufferCopy> copies;
+
+        // meshCount meshes split into 4 to 32 chunk copies each, staged one after the other and committed in shuffled order
+        // (the interleaving of several loader threads)
+        CopyScene(size_t meshCount, size_t targetCount, unsigned int seed) :
+            targets(targetCount)
+        {
+            std::mt19937 rng(seed);
+            std::vector<uint64_t> targetUsage(targetCount, 0);
+            for (size_t mesh = 0; mesh < meshCount; mesh++)
+            {
+                const size_t target = rng() % targetCount;
+                const size_t chunks = 4 + rng() % 29;
+                for (size_t chunk = 0; chunk < chunks; chunk++)
+                {
+                    const uint64_t size = 64 + rng() % 512;
+                    copies.push_back({ &targets[target], targetUsage[target], source.size(), size });
+                    targetUsage[target] += size;
+                    for (uint64_t i = 0; i < size; i++)
+                        source.push_back((unsigned char)rng());
+                }
+
+                // Sometimes the next mesh skips a gap in the staging buffer (alignment), which breaks merging
+                if (rng() % 4 == 0)
+                    source.resize(source.size() + 16);
+            }
+            for (size_t target = 0; target < targetCount; target++)
+                targets[target].resize(targetUsage[target]);
+            std::shuffle(copies.begin(), copies.end(), rng);
+        }
+
+        // Targets after executing the copies in order
+        std::vector<std::vector<unsigned char>> Execute(const std::vector<RTR::BufferCopy>& list) const
+        {
+            std::vector<std::vector<unsigned char>> result = targets;
+            for (const RTR::BufferCopy& copy : list)
+            {
+                auto& target = result[(const std::vector<unsigned char>*)copy.ptrTarget - targets.data()];
+                std::copy_n(source.begin() + copy.sourceOffset, copy.size, target.begin() + copy.targetOffset);
+            }
+            return result;
+        }
+    };
+}
+
+RTR_TEST(CopyCoalescingKeepsContent)
+{
+    const CopyScene scene(200, 5, 1);
+    std::vector<RTR::BufferCopy> coalesced = scene.copies;
+    const size_t merged = RTR::CoalesceBufferCopies(coalesced);
+
+    // Fewer copies, same bytes
+    RTR_EXPECT(merged > 0 && coalesced.size() + merged == scene.copies.size());
+    RTR_EXPECT(scene.Execute(coalesced) == scene.Execute(scene.copies));
+
+    // Sorted by target and offset, no two neighbours left that could be merged
+    bool sortedAndMaximal = true;
+    for (size_t i = 1; i < coalesced.size(); i++)
+    {
+        const RTR::BufferCopy& a = coalesced[i - 1];
+        const RTR::BufferCopy& b = coalesced[i];
+        if (a.ptrTarget == b.ptrTarget)
+            sortedAndMaximal = sortedAndMaximal && a.targetOffset < b.targetOffset && !(b.targetOffset == a.targetOffset + a.size && b.sourceOffset == a.sourceOffset + a.size);
+    }
+    RTR_EXPECT(sortedAndMaximal);
+
+    // Nothing to merge in an empty list
+    std::vector<RTR::BufferCopy> empty;
+    RTR_EXPECT(RTR::CoalesceBufferCopies(empty) == 0 && empty.empty());
+}
+
+RTR_TEST(CopyCoalescingKeepsOrderOfOverlappingCopies)
+{
+    // Two copies to the same target bytes: the later commit has to stay last
+    int target = 0, other = 0;
+    std::vector<RTR::BufferCopy> copies = {
+        { &target, 100, 0, 50 },
+        { &other, 0, 500, 10 },
+        { &target, 100, 200, 50 },
+        { &target, 150, 250, 50 },
+    };
+    RTR_EXPECT(RTR::CoalesceBufferCopies(copies) == 1);
+
+    // The first copy to offset 100 is kept as is, the second one is merged with its continuation after it
+    std::vector<size_t> toTarget;
+    for (size_t i = 0; i < copies.size(); i++)
+        if (copies[i].ptrTarget == &target)
+            toTarget.push_back(i);
+    RTR_EXPECT(toTarget.size() == 2);
+    RTR_EXPECT(toTarget.size() == 2 && copies[toTarget[0]].sourceOffset == 0 && copies[toTarget[0]].size == 50);
+    RTR_EXPECT(toTarget.size() == 2 && copies[toTarget[1]].sourceOffset == 200 && copies[toTarget[1]].size == 100);
+}
+
+RTR_BENCHMARK(CopyCoalescingMeshUpload)
+{
+    for (size_t meshCount : { 100u, 2000u, 20000u })
+    {
+        const CopyScene scene(meshCount, 8, 2);
+        std::vector<RTR::BufferCopy> copies;
+        size_t merged = 0;
+        const double seconds = RTR::Test::MeasureSeconds([&]()
+            {
+                copies = scene.copies;
+                merged = RTR::CoalesceBufferCopies(copies);
+            }, 10);
+        printf("  %6zu meshes  %7zu commits -> %6zu CopyBufferRegion calls (%zu merged)  %8.3f ms\n",
+            meshCount, scene.copies.size(), copies.size(), merged, seconds * 1e3);
+    }
+}
@@ -0,0 +1,128 @@
+#include "Test.h"
+
+#include <Util/DirtyRanges.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t MergeGap = 4;
+
+    std::vector<uint64_t> MakeBits(uint32_t count, std::initializer_list<uint32_t> dirty)
+    {
+        std::vector<uint64_t> bits((count + 63) / 64, 0);
+        for (uint32_t idx : dirty)
+            bits[idx / 64] |= 1ULL << (idx % 64);
+        return bits;
+    }
+
+    // The upload loop of MatrixBuffer::UpdateGPU: walk [from, end) range by range, clearing what was uploaded.
+    // uploadLimit ranges are uploaded, the next one fails and stays dirty (like a full upload buffer).
+    std::vector<RTR::DirtyRange> Upload(std::vector<uint64_t>& bits, uint32_t from, uint32_t end, size_t uploadLimit = ~(size_t)0, uint32_t* ptrClearedOut = nullptr)
+    {
+        std::vector<RTR::DirtyRange> ranges;
+        uint32_t cleared = 0;
+        for (uint32_t idx = from; idx < end;)
+        {
+            const RTR::DirtyRange range = RTR::FindDirtyRange(bits.data(), idx, end, MergeGap);
+            if (range.begin == range.end || ranges.size() == uploadLimit)
+                break;
+            ranges.push_back(range);
+            cleared += RTR::ClearDirtyRange(bits.data(), range);
+            idx = range.end;
+        }
+        if (ptrClearedOut)
+            *ptrClearedOut = cleared;
+        return ranges;
+    }
+
+    bool IsClean(const std::vector<uint64_t>& bits)
+    {
+        for (uint64_t word : bits)
+        {
+            if (word)
+                return false;
+        }
+        return true;
+    }
+
+    bool SameRanges(const std::vector<RTR::DirtyRange>& ranges, std::initializer_list<RTR::DirtyRange> expected)
+    {
+        if (ranges.size() != expected.size())
+            return false;
+        size_t i = 0;
+        for (const RTR::DirtyRange& range : expected)
+        {
+            if (ranges[i].begin != range.begin || ranges[i].end != range.end)
+                return false;
+            i++;
+        }
+        return true;
+    }
+}
+
+RTR_TEST(DirtyRangesSingleSlots)
+{
+    // Nothing dirty is an empty range at end
+    std::vector<uint64_t> bits = MakeBits(256, {});
+    RTR::DirtyRange range = RTR::FindDirtyRange(bits.data(), 0, 256, MergeGap);
+    RTR_EXPECT(range.begin == 256 && range.end == 256);
+
+    // Single slots at word starts and ends, including after whole clean words
+    for (uint32_t idx : { 0u, 1u, 63u, 64u, 127u, 200u, 255u })
+    {
+        bits = MakeBits(256, { idx });
+        range = RTR::FindDirtyRange(bits.data(), 0, 256, MergeGap);
+        RTR_EXPECT(range.begin == idx && range.end == idx + 1);
+    }
+
+    // The search starts at from and never passes end
+    bits = MakeBits(256, { 10, 100 });
+    range = RTR::FindDirtyRange(bits.data(), 11, 256, MergeGap);
+    RTR_EXPECT(range.begin == 100 && range.end == 101);
+    range = RTR::FindDirtyRange(bits.data(), 11, 100, MergeGap);
+    RTR_EXPECT(range.begin == 100 && range.end == 100);
+}
+
+RTR_TEST(DirtyRangesMerges)
+{
+    // Adjacent slots are one range, also across a word boundary
+    std::vector<uint64_t> bits = MakeBits(256, { 5, 6, 7, 62, 63, 64, 65 });
+    RTR_EXPECT(SameRanges(Upload(bits, 0, 256), { { 5, 8 }, { 62, 66 } }));
+
+    // A gap of MergeGap clean slots merges, one more splits
+    bits = MakeBits(256, { 10, 10 + MergeGap + 1, 100, 100 + MergeGap + 2 });
+    RTR_EXPECT(SameRanges(Upload(bits, 0, 256), { { 10, 10 + MergeGap + 2 }, { 100, 101 }, { 100 + MergeGap + 2, 100 + MergeGap + 3 } }));
+
+    // Merging chains over several gaps and ends after the last dirty slot, not after the gap
+    bits = MakeBits(256, { 20, 23, 26, 29 });
+    RTR_EXPECT(SameRanges(Upload(bits, 0, 256), { { 20, 30 } }));
+
+    // A range never grows past end even when the gap continues
+    bits = MakeBits(256, { 40, 42, 44 });
+    RTR_EXPECT(SameRanges(Upload(bits, 0, 43), { { 40, 43 } }));
+    RTR_EXPECT(!IsClean(bits) && RTR::FindDirtyRange(bits.data(), 0, 256, MergeGap).begin == 44);
+}
+
+RTR_TEST(DirtyRangesClearAfterUpload)
+{
+    // Every uploaded slot is cleared and counted once, gap slots are not counted
+    std::vector<uint64_t> bits = MakeBits(1000, { 0, 2, 3, 64, 500, 501, 999 });
+    uint32_t cleared = 0;
+    RTR_EXPECT(SameRanges(Upload(bits, 0, 1000, ~(size_t)0, &cleared), { { 0, 4 }, { 64, 65 }, { 500, 502 }, { 999, 1000 } }));
+    RTR_EXPECT(cleared == 7 && IsClean(bits));
+    RTR_EXPECT(Upload(bits, 0, 1000).empty());
+
+    // A failed upload keeps its range and everything after it dirty, the next pass continues there
+    bits = MakeBits(1000, { 1, 300, 301, 700 });
+    RTR_EXPECT(SameRanges(Upload(bits, 0, 1000, 1, &cleared), { { 1, 2 } }));
+    RTR_EXPECT(cleared == 1);
+    RTR_EXPECT(SameRanges(Upload(bits, 0, 1000, ~(size_t)0, &cleared), { { 300, 302 }, { 700, 701 } }));
+    RTR_EXPECT(cleared == 3 && IsClean(bits));
+
+    // Clearing a range with clean slots only reports the set ones
+    bits = MakeBits(128, { 60, 70 });
+    RTR_EXPECT(RTR::ClearDirtyRange(bits.data(), { 0, 128 }) == 2 && IsClean(bits));
+    RTR_EXPECT(RTR::ClearDirtyRange(bits.data(), { 5, 5 }) == 0);
+}
@@ -0,0 +1,138 @@
+#include "Test.h"
+#include "TestCamera.h"
+
+#include <RTR/Culling/FrustumCuller.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    // Camera at the origin looking along +z (fov 90, near 0.1, far 100)
+    RTR::Frustum MakeTestFrustum(float yaw = 0.0f)
+    {
+        const RTR::Test::Matrix viewProjection = RTR::Test::Multiply(RTR::Test::MakeView(0.0f, 0.0f, 0.0f, yaw), RTR::Test::MakePerspective(1.5707963f, 1.0f, 0.1f, 100.0f));
+        return RTR::FrustumFromViewProjection(viewProjection.m);
+    }
+
+    // Random spheres in a cube around the camera
+    RTR::CullingSpheres MakeRandomSpheres(size_t count, unsigned int seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> position(-120.0f, 120.0f), radius(0.01f, 4.0f);
+        RTR::CullingSpheres spheres;
+        for (size_t i = 0; i < count; i++)
+        {
+            RTR::BoundingSphere sphere;
+            sphere.center[0] = position(rng);
+            sphere.center[1] = position(rng);
+            sphere.center[2] = position(rng);
+            sphere.radius = radius(rng);
+            spheres.Add(sphere);
+        }
+        return spheres;
+    }
+
+    std::vector<uint32_t> CullScalar(const RTR::Frustum& frustum, const RTR::CullingSpheres& spheres, size_t begin, size_t end)
+    {
+        std::vector<uint32_t> visible(end - begin);
+        visible.resize(RTR::FrustumCuller::CullRangeScalar(frustum, spheres, begin, end, visible.data()));
+        return visible;
+    }
+}
+
+RTR_TEST(FrustumCullerKnownSpheres)
+{
+    const RTR::Frustum frustum = MakeTestFrustum();
+    RTR::CullingSpheres spheres;
+    auto add = [&](float x, float y, float z, float radius)
+    {
+        RTR::BoundingSphere sphere;
+        sphere.center[0] = x;
+        sphere.center[1] = y;
+        sphere.center[2] = z;
+        sphere.radius = radius;
+        return (uint32_t)spheres.Add(sphere);
+    };
+    const uint32_t front = add(0.0f, 0.0f, 10.0f, 1.0f);
+    add(0.0f, 0.0f, -10.0f, 1.0f);                                  // Behind
+    const uint32_t straddlingLeft = add(-10.5f, 0.0f, 10.0f, 1.0f); // Center outside, touches the left plane
+    add(-12.0f, 0.0f, 10.0f, 1.0f);                                 // Left of the frustum
+    add(0.0f, 0.0f, 102.0f, 1.0f);                                  // Beyond far
+    const uint32_t straddlingNear = add(0.0f, 0.0f, -0.5f, 1.0f);   // Contains the camera
+
+    std::vector<uint32_t> expected = { front, straddlingLeft, straddlingNear };
+    RTR_EXPECT(CullScalar(frustum, spheres, 0, spheres.GetCount()) == expected);
+
+    std::vector<uint32_t> visible(spheres.GetCount());
+    visible.resize(RTR::FrustumCuller::CullRange(frustum, spheres, 0, spheres.GetCount(), visible.data()));
+    RTR_EXPECT(visible == expected);
+}
+
+RTR_TEST(FrustumCullerSimdMatchesScalar)
+{
+    // Odd counts leave padding in the last batch, which must never show up
+    for (size_t count : { 0, 1, 7, 8, 9, 1000, 4099 })
+    {
+        const RTR::CullingSpheres spheres = MakeRandomSpheres(count, (unsigned int)count);
+        for (float yaw : { 0.0f, 0.8f, 3.0f })
+        {
+            const RTR::Frustum frustum = MakeTestFrustum(yaw);
+
+            // Whole set and a sub range
+            std::vector<uint32_t> visible(count);
+            visible.resize(RTR::FrustumCuller::CullRange(frustum, spheres, 0, count, visible.data()));
+            RTR_EXPECT(visible == CullScalar(frustum, spheres, 0, count));
+            if (count > 16)
+            {
+                visible.resize(count);
+                visible.resize(RTR::FrustumCuller::CullRange(frustum, spheres, 8, count - 3, visible.data()));
+                RTR_EXPECT(visible == CullScalar(frustum, spheres, 8, count - 3));
+            }
+        }
+    }
+}
+
+RTR_TEST(FrustumCullerParallelMatchesScalar)
+{
+    RTR::WorkerPool workers(4);
+    RTR::FrustumCuller culler(workers, 512);
+    const RTR::CullingSpheres spheres = MakeRandomSpheres(20000, 3);
+    std::vector<uint32_t> visible;
+    for (float yaw : { 0.0f, 1.6f, 4.0f })
+    {
+        const RTR::Frustum frustum = MakeTestFrustum(yaw);
+        const RTR::CullingStats stats = culler.Cull(frustum, spheres, visible);
+        const std::vector<uint32_t> expected = CullScalar(frustum, spheres, 0, spheres.GetCount());
+        RTR_EXPECT(visible == expected);
+        RTR_EXPECT(stats.tested == spheres.GetCount() && stats.visible == expected.size() && stats.chunks > 1);
+        RTR_EXPECT(!expected.empty() && expected.size() < spheres.GetCount() / 2);
+    }
+}
+
+RTR_BENCHMARK(FrustumCullerThroughput)
+{
+    const RTR::CullingSpheres spheres = MakeRandomSpheres(100000, 1);
+    const RTR::Frustum frustum = MakeTestFrustum();
+    std::vector<uint32_t> visible(spheres.GetCount());
+
+    const double scalar = RTR::Test::MeasureSeconds([&]() { RTR::FrustumCuller::CullRangeScalar(frustum, spheres, 0, spheres.GetCount(), visible.data()); }, 100);
+    const double simd = RTR::Test::MeasureSeconds([&]() { RTR::FrustumCuller::CullRange(frustum, spheres, 0, spheres.GetCount(), visible.data()); }, 100);
+    #if defined(__AVX2__)
+    const char* simdName = "AVX2";
+    #elif defined(RTR_CULLING_SSE)
+    const char* simdName = "SSE";
+    #else
+    const char* simdName = "none";
+    #endif
+    printf("  100k spheres  scalar %7.1f us  SIMD (%s) %7.1f us  (%.1fx)\n", scalar * 1e6, simdName, simd * 1e6, scalar / simd);
+
+    for (unsigned int threads : { 1u, 2u, 4u, 8u })
+    {
+        RTR::WorkerPool workers(threads);
+        RTR::FrustumCuller culler(workers);
+        const double parallel = RTR::Test::MeasureSeconds([&]() { culler.Cull(frustum, spheres, visible); }, 100);
+        printf("  %u threads %7.1f us\n", threads, parallel * 1e6);
+    }
+}
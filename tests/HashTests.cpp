@@ -0,0 +1,49 @@
+#include "Test.h"
+
+#include <Util/Hash.h>
+
+#include <random>
+#include <set>
+#include <vector>
+
+RTR_TEST(HashWideVariantsCoverEveryByte)
+{
+    std::vector<unsigned char> data(61);
+    std::mt19937 rng(5);
+    for (auto& byte : data)
+        byte = (unsigned char)rng();
+
+    // Flipping any bit (also in the tail after the last full word) changes both wide hashes
+    const uint64_t fnv = RTR::HashFnv1aWide(data.data(), data.size());
+    const uint64_t mix = RTR::HashMixWide(data.data(), data.size());
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        for (unsigned int bit = 0; bit < 8; bit++)
+        {
+            data[i] ^= (unsigned char)(1 << bit);
+            RTR_EXPECT(RTR::HashFnv1aWide(data.data(), data.size()) != fnv);
+            RTR_EXPECT(RTR::HashMixWide(data.data(), data.size()) != mix);
+            data[i] ^= (unsigned char)(1 << bit);
+        }
+    }
+
+    // Trailing zeros are part of the length
+    const unsigned char zeros[16] = {};
+    RTR_EXPECT(RTR::HashMixWide(zeros, 8) != RTR::HashMixWide(zeros, 16));
+}
+
+RTR_TEST(HashChainsBySeed)
+{
+    const char text[] = "real time rendering";
+    RTR_EXPECT(RTR::HashFnv1a(text + 4, sizeof(text) - 4, RTR::HashFnv1a(text, 4)) == RTR::HashFnv1a(text, sizeof(text)));
+    RTR_EXPECT(RTR::HashMixWide(text, sizeof(text), 1) != RTR::HashMixWide(text, sizeof(text), 2));
+}
+
+RTR_TEST(HashMixWideDistinctForSmallKeys)
+{
+    // No collisions among 100k consecutive integers
+    std::set<uint64_t> hashes;
+    for (uint32_t i = 0; i < 100000; i++)
+        hashes.insert(RTR::HashMixWide(&i, sizeof(i)));
+    RTR_EXPECT(hashes.size() == 100000);
+}
@@ -0,0 +1,197 @@
+#include "Test.h"
+#include "TestCamera.h"
+
+#include <RTR/Culling/FrustumCuller.h>
+#include <RTR/Culling/HiZPyramid.h>
+#include <RTR/Culling/IndirectCulling.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Depth buffer size and camera (at the origin looking along +z, so view z is world z)
+    constexpr uint32_t Width = 64, Height = 48;
+    constexpr float NearZ = 0.5f, FarZ = 100.0f;
+    // View z of the wall that covers the left half of the screen (the right half is empty)
+    constexpr float WallZ = 20.0f;
+
+    RTR::Test::Matrix MakeViewProjection(bool reversedDepth)
+    {
+        // Swapping near and far maps the near plane to 1
+        const RTR::Test::Matrix projection = reversedDepth ?
+            RTR::Test::MakePerspective(1.5707963f, (float)Width / Height, FarZ, NearZ) :
+            RTR::Test::MakePerspective(1.5707963f, (float)Width / Height, NearZ, FarZ);
+        return RTR::Test::Multiply(RTR::Test::MakeView(0.0f, 0.0f, 0.0f, 0.0f), projection);
+    }
+
+    // Standard depth (0 near, 1 far) of a view z
+    float StandardDepth(float z)
+    {
+        return FarZ / (FarZ - NearZ) * (z - NearZ) / z;
+    }
+
+    std::vector<float> MakeWallDepth(bool reversedDepth)
+    {
+        std::vector<float> depth((size_t)Width * Height);
+        for (uint32_t y = 0; y < Height; y++)
+        {
+            for (uint32_t x = 0; x < Width; x++)
+            {
+                const float standard = x < Width / 2 ? StandardDepth(WallZ) : 1.0f;
+                depth[(size_t)y * Width + x] = reversedDepth ? 1.0f - standard : standard;
+            }
+        }
+        return depth;
+    }
+
+    // Random float4 spheres around the wall
+    std::vector<float> MakeSpheres(size_t count, unsigned int seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> x(-40.0f, 40.0f), y(-25.0f, 25.0f), z(-2.0f, 60.0f), radius(0.1f, 3.0f);
+        std::vector<float> spheres;
+        for (size_t i = 0; i < count; i++)
+            spheres.insert(spheres.end(), { x(rng), y(rng), z(rng), radius(rng) });
+        return spheres;
+    }
+
+    // Command i is { i, i + 1, i + 2 }
+    constexpr uint32_t CommandValues = 3;
+    std::vector<uint32_t> MakeCommands(size_t count)
+    {
+        std::vector<uint32_t> commands(count * CommandValues);
+        for (size_t i = 0; i < commands.size(); i++)
+            commands[i] = (uint32_t)(i / CommandValues + i % CommandValues);
+        return commands;
+    }
+
+    // Indices of the drawables in the culling output
+    std::vector<uint32_t> Cull(const RTR::IndirectCullConstants& constants, const std::vector<float>& spheres, const float* ptrHiZ)
+    {
+        const std::vector<uint32_t> commands = MakeCommands(constants.drawCount);
+        std::vector<uint32_t> arguments(commands.size());
+        const uint32_t count = RTR::CullIndirectReference(constants, spheres.data(), commands.data(), ptrHiZ, arguments.data());
+
+        std::vector<uint32_t> visible;
+        for (uint32_t i = 0; i < count; i++)
+            visible.push_back(arguments[(size_t)i * CommandValues]);
+        return visible;
+    }
+
+    // A point of the sphere's surface is in front of the depth buffer (brute force of what occlusion culling must keep)
+    bool HasVisiblePoint(const float* sphere, const RTR::Test::Matrix& viewProjection, const std::vector<float>& depth)
+    {
+        const size_t samples = 400;
+        for (size_t i = 0; i < samples; i++)
+        {
+            // Fibonacci sphere
+            const float y = 1.0f - 2.0f * (i + 0.5f) / samples;
+            const float ring = std::sqrt(1.0f - y * y);
+            const float angle = 2.39996323f * i;
+            const float p[3] = { sphere[0] + sphere[3] * ring * std::cos(angle), sphere[1] + sphere[3] * y, sphere[2] + sphere[3] * ring * std::sin(angle) };
+
+            float clip[4];
+            for (int c = 0; c < 4; c++)
+                clip[c] = p[0] * viewProjection.m[c] + p[1] * viewProjection.m[4 + c] + p[2] * viewProjection.m[8 + c] + viewProjection.m[12 + c];
+            if (clip[3] <= 0.0f)
+                continue;
+            const float u = clip[0] / clip[3] * 0.5f + 0.5f, v = 0.5f - clip[1] / clip[3] * 0.5f, z = clip[2] / clip[3];
+            if (u < 0.0f || u >= 1.0f || v < 0.0f || v >= 1.0f || z < 0.0f || z > 1.0f)
+                continue;
+            if (z < depth[(size_t)(v * Height) * Width + (size_t)(u * Width)])
+                return true;
+        }
+        return false;
+    }
+}
+
+RTR_TEST(IndirectCullingFrustumMatchesFrustumCuller)
+{
+    const RTR::Test::Matrix viewProjection = MakeViewProjection(false);
+    const std::vector<float> spheres = MakeSpheres(2000, 1);
+    const uint32_t count = (uint32_t)spheres.size() / 4;
+
+    RTR::CullingSpheres culling;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        RTR::BoundingSphere sphere;
+        sphere.center[0] = spheres[i * 4];
+        sphere.center[1] = spheres[i * 4 + 1];
+        sphere.center[2] = spheres[i * 4 + 2];
+        sphere.radius = spheres[i * 4 + 3];
+        culling.Add(sphere);
+    }
+    std::vector<uint32_t> expected(count);
+    expected.resize(RTR::FrustumCuller::CullRangeScalar(RTR::FrustumFromViewProjection(viewProjection.m), culling, 0, count, expected.data()));
+
+    // Without a pyramid only the frustum is tested, the commands are copied in drawable order
+    const std::vector<uint32_t> visible = Cull(RTR::MakeIndirectCullConstants(viewProjection.m, count, CommandValues), spheres, nullptr);
+    RTR_EXPECT(!expected.empty() && expected.size() < count);
+    RTR_EXPECT(visible == expected);
+
+    // Whole commands are copied
+    const std::vector<uint32_t> commands = MakeCommands(count);
+    std::vector<uint32_t> arguments(commands.size());
+    const uint32_t written = RTR::CullIndirectReference(RTR::MakeIndirectCullConstants(viewProjection.m, count, CommandValues), spheres.data(), commands.data(), nullptr, arguments.data());
+    for (uint32_t i = 0; i < written; i++)
+        for (uint32_t k = 0; k < CommandValues; k++)
+            RTR_EXPECT(arguments[i * CommandValues + k] == expected[i] + k);
+}
+
+RTR_TEST(IndirectCullingHiZIsConservative)
+{
+    const RTR::Test::Matrix viewProjection = MakeViewProjection(false);
+    const std::vector<float> depth = MakeWallDepth(false);
+    RTR::HiZPyramid hiZ;
+    hiZ.Build(depth.data(), Width, Height);
+
+    const std::vector<float> spheres = MakeSpheres(2000, 2);
+    const uint32_t count = (uint32_t)spheres.size() / 4;
+    const std::vector<uint32_t> frustumVisible = Cull(RTR::MakeIndirectCullConstants(viewProjection.m, count, CommandValues), spheres, nullptr);
+    const std::vector<uint32_t> visible = Cull(RTR::MakeIndirectCullConstants(viewProjection.m, count, CommandValues, &hiZ), spheres, hiZ.GetData());
+
+    // Every sphere the frustum kept but the pyramid rejected must be hidden by the wall
+    size_t occluded = 0, next = 0;
+    for (uint32_t i : frustumVisible)
+    {
+        if (next < visible.size() && visible[next] == i)
+        {
+            next++;
+            continue;
+        }
+        occluded++;
+        RTR_EXPECT(!HasVisiblePoint(&spheres[(size_t)i * 4], viewProjection, depth));
+        RTR_EXPECT(spheres[(size_t)i * 4 + 2] - spheres[(size_t)i * 4 + 3] > WallZ);
+    }
+    RTR_EXPECT(next == visible.size());
+    RTR_EXPECT(occluded > 0);
+
+    // A sphere straight behind the middle of the wall is culled, one in front of it and one that contains the camera are not
+    const std::vector<float> known = { -10.0f, 0.0f, 40.0f, 2.0f, -10.0f, 0.0f, 10.0f, 2.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    const std::vector<uint32_t> expected = { 1, 2 };
+    RTR_EXPECT(Cull(RTR::MakeIndirectCullConstants(viewProjection.m, 3, CommandValues, &hiZ), known, hiZ.GetData()) == expected);
+}
+
+RTR_TEST(IndirectCullingReversedDepthMatchesStandard)
+{
+    // Same scene, once with standard and once with reversed depth
+    const std::vector<float> spheres = MakeSpheres(2000, 3);
+    const uint32_t count = (uint32_t)spheres.size() / 4;
+    std::vector<uint32_t> visible[2];
+    for (int reversed = 0; reversed < 2; reversed++)
+    {
+        const RTR::Test::Matrix viewProjection = MakeViewProjection(reversed != 0);
+        const std::vector<float> depth = MakeWallDepth(reversed != 0);
+        RTR::HiZPyramid hiZ;
+        hiZ.Build(depth.data(), Width, Height, reversed != 0);
+        RTR_EXPECT(hiZ.IsReversedDepth() == (reversed != 0));
+
+        const RTR::IndirectCullConstants constants = RTR::MakeIndirectCullConstants(viewProjection.m, count, CommandValues, &hiZ);
+        RTR_EXPECT(constants.reversedDepth == (uint32_t)reversed);
+        visible[reversed] = Cull(constants, spheres, hiZ.GetData());
+    }
+    RTR_EXPECT(visible[0].size() < count);
+    RTR_EXPECT(visible[0] == visible[1]);
+}
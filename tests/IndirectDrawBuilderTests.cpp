@@ -0,0 +1,129 @@
+#include "Test.h"
+
+#include <RTR/3DModells/IndirectDrawBuilder.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Distinct arguments and root constants per drawable
+    RTR::IndirectDrawArguments MakeDraw(uint32_t i)
+    {
+        RTR::IndirectDrawArguments draw;
+        draw.indexCountPerInstance = 36 + i;
+        draw.instanceCount = 1;
+        draw.startIndexLocation = i * 100;
+        draw.baseVertexLocation = -(int32_t)i;
+        draw.startInstanceLocation = i * 7;
+        return draw;
+    }
+
+    void FillBuilder(RTR::IndirectDrawBuilder& builder, uint32_t rootConstantCount, uint32_t count)
+    {
+        std::vector<uint32_t> constants(rootConstantCount);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (uint32_t k = 0; k < rootConstantCount; k++)
+                constants[k] = i * 1000 + k;
+            const uint32_t index = builder.Add(MakeDraw(i), constants.data());
+            RTR_EXPECT(index == i);
+        }
+    }
+
+    // Command at ptrCommand must be drawable i
+    bool CommandMatches(const unsigned char* ptrCommand, uint32_t rootConstantCount, uint32_t i)
+    {
+        for (uint32_t k = 0; k < rootConstantCount; k++)
+        {
+            uint32_t value;
+            memcpy(&value, ptrCommand + k * sizeof(uint32_t), sizeof(value));
+            if (value != i * 1000 + k)
+                return false;
+        }
+
+        RTR::IndirectDrawArguments draw;
+        memcpy(&draw, ptrCommand + rootConstantCount * sizeof(uint32_t), sizeof(draw));
+        const RTR::IndirectDrawArguments expected = MakeDraw(i);
+        return memcmp(&draw, &expected, sizeof(draw)) == 0;
+    }
+}
+
+RTR_TEST(IndirectDrawBuilderLayout)
+{
+    for (uint32_t rootConstantCount : { 0u, 1u, 4u })
+    {
+        RTR::IndirectDrawBuilder builder(rootConstantCount);
+        RTR_EXPECT(builder.GetStride() == (rootConstantCount + 5) * sizeof(uint32_t));
+        FillBuilder(builder, rootConstantCount, 10);
+        RTR_EXPECT(builder.GetDrawCount() == 10);
+
+        // Root constants first, arguments after them
+        for (uint32_t i = 0; i < 10; i++)
+            RTR_EXPECT(CommandMatches((const unsigned char*)builder.GetCommands() + i * builder.GetStride(), rootConstantCount, i));
+
+        // Clear drops the drawables, indices start over
+        builder.Clear();
+        RTR_EXPECT(builder.GetDrawCount() == 0);
+        RTR_EXPECT(builder.Add(MakeDraw(0), std::vector<uint32_t>(rootConstantCount, 0).data()) == 0);
+    }
+}
+
+RTR_TEST(IndirectDrawBuilderGathersVisible)
+{
+    const uint32_t rootConstantCount = 2, count = 1000;
+    RTR::IndirectDrawBuilder builder(rootConstantCount);
+    FillBuilder(builder, rootConstantCount, count);
+
+    // Random visibility in random order (the builder keeps the list order)
+    std::mt19937 rng(1);
+    std::vector<uint32_t> visible;
+    for (uint32_t i = 0; i < count; i++)
+        if (rng() % 3)
+            visible.push_back(i);
+    std::shuffle(visible.begin(), visible.end(), rng);
+
+    // Guard bytes after the last command must stay untouched
+    const size_t stride = builder.GetStride();
+    std::vector<unsigned char> out(visible.size() * stride + 64, 0xCD);
+    RTR_EXPECT(builder.Build(visible.data(), visible.size(), out.data()) == visible.size() * stride);
+    for (size_t i = 0; i < visible.size(); i++)
+        RTR_EXPECT(CommandMatches(&out[i * stride], rootConstantCount, visible[i]));
+    for (size_t i = visible.size() * stride; i < out.size(); i++)
+        RTR_EXPECT(out[i] == 0xCD);
+
+    // Nothing visible writes nothing
+    RTR_EXPECT(builder.Build(visible.data(), 0, out.data()) == 0);
+
+    // BuildAll is the whole table
+    std::vector<unsigned char> all(count * stride);
+    RTR_EXPECT(builder.BuildAll(all.data()) == all.size());
+    RTR_EXPECT(memcmp(all.data(), builder.GetCommands(), all.size()) == 0);
+}
+
+RTR_BENCHMARK(IndirectDrawBuilderPacking)
+{
+    // Typical scene sizes with one root constant (the draw id) like the demo
+    for (uint32_t count : { 1000u, 10000u, 100000u })
+    {
+        RTR::IndirectDrawBuilder builder(1);
+        FillBuilder(builder, 1, count);
+
+        std::vector<uint32_t> visible;
+        for (uint32_t i = 0; i < count; i += 2)
+            visible.push_back(i);
+        std::vector<uint32_t> all(count);
+        std::iota(all.begin(), all.end(), 0);
+        std::vector<unsigned char> out(count * builder.GetStride());
+
+        const double half = RTR::Test::MeasureSeconds([&]() { builder.Build(visible.data(), visible.size(), out.data()); }, 20);
+        const double gatherAll = RTR::Test::MeasureSeconds([&]() { builder.Build(all.data(), all.size(), out.data()); }, 20);
+        const double streamAll = RTR::Test::MeasureSeconds([&]() { builder.BuildAll(out.data()); }, 20);
+        printf("  %6u draws  half visible %8.3f ms  all gathered %8.3f ms  all streamed %8.3f ms  (%.1f ns per gathered draw)\n",
+            count, half * 1e3, gatherAll * 1e3, streamAll * 1e3, gatherAll * 1e9 / count);
+    }
+}
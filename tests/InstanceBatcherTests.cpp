@@ -0,0 +1,119 @@
+#include "Test.h"
+
+#include <RTR/3DModells/InstanceBatcher.h>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Matrix m has the values m * 100 + 0..floats-1
+    std::vector<float> MakeMatrices(size_t count, size_t matrixFloats)
+    {
+        std::vector<float> matrices(count * matrixFloats);
+        for (size_t i = 0; i < matrices.size(); i++)
+            matrices[i] = (float)((i / matrixFloats) * 100 + i % matrixFloats);
+        return matrices;
+    }
+
+    // Packed instance holds the first 12 floats of matrix m, the material and zero padding
+    bool InstanceMatches(const RTR::InstanceData& instance, uint32_t matrix, uint32_t material)
+    {
+        for (uint32_t k = 0; k < 12; k++)
+        {
+            if (instance.world[k] != (float)(matrix * 100 + k))
+                return false;
+        }
+        return instance.materialIndex == material && !instance.padding[0] && !instance.padding[1] && !instance.padding[2];
+    }
+}
+
+RTR_TEST(InstanceBatcherGroupsByMesh)
+{
+    // Interleaved meshes: a b a c b a (matrix i, material i + 50)
+    const uint64_t meshes[] = { 7, 3, 7, 9, 3, 7 };
+    for (size_t matrixFloats : { 12u, 16u })
+    {
+        RTR::InstanceBatcher batcher;
+        for (uint32_t i = 0; i < 6; i++)
+            batcher.Add(meshes[i], i, i + 50);
+        RTR_EXPECT(batcher.GetInstanceCount() == 6);
+
+        const std::vector<float> matrices = MakeMatrices(6, matrixFloats);
+        std::vector<RTR::InstanceData> stream(6);
+        std::vector<uint32_t> sources(6);
+        batcher.Build(matrices.data(), matrixFloats, stream.data(), sources.data());
+
+        // One batch per mesh in first added order, consecutive ranges
+        const std::vector<RTR::InstanceBatch>& batches = batcher.GetBatches();
+        RTR_EXPECT(batches.size() == 3);
+        if (batches.size() == 3)
+        {
+            RTR_EXPECT(batches[0].meshKey == 7 && batches[0].firstInstance == 0 && batches[0].instanceCount == 3);
+            RTR_EXPECT(batches[1].meshKey == 3 && batches[1].firstInstance == 3 && batches[1].instanceCount == 2);
+            RTR_EXPECT(batches[2].meshKey == 9 && batches[2].firstInstance == 5 && batches[2].instanceCount == 1);
+        }
+
+        // Instances keep their order inside a batch, the stream carries transform and material
+        const std::vector<uint32_t> expected = { 0, 2, 5, 1, 4, 3 };
+        RTR_EXPECT(sources == expected);
+        for (size_t slot = 0; slot < 6; slot++)
+            RTR_EXPECT(InstanceMatches(stream[slot], expected[slot], expected[slot] + 50));
+    }
+}
+
+RTR_TEST(InstanceBatcherMatrixOffsetsAndClear)
+{
+    // Instances can point at any matrix, several at the same one
+    RTR::InstanceBatcher batcher;
+    batcher.Add(1, 4, 0);
+    batcher.Add(1, 4, 1);
+    batcher.Add(2, 0, 2);
+    const std::vector<float> matrices = MakeMatrices(5, 12);
+    RTR::InstanceData stream[3];
+    batcher.Build(matrices.data(), 12, stream);
+    RTR_EXPECT(InstanceMatches(stream[0], 4, 0) && InstanceMatches(stream[1], 4, 1) && InstanceMatches(stream[2], 0, 2));
+
+    // Clear starts over with new batches
+    batcher.Clear();
+    RTR_EXPECT(batcher.GetInstanceCount() == 0 && batcher.GetBatches().empty());
+    batcher.Add(2, 1, 9);
+    batcher.Build(matrices.data(), 12, stream);
+    RTR_EXPECT(batcher.GetBatches().size() == 1 && batcher.GetBatches()[0].meshKey == 2 && batcher.GetBatches()[0].instanceCount == 1);
+    RTR_EXPECT(InstanceMatches(stream[0], 1, 9));
+
+    // Nothing queued builds nothing
+    batcher.Clear();
+    batcher.Build(matrices.data(), 12, nullptr);
+    RTR_EXPECT(batcher.GetBatches().empty());
+}
+
+RTR_BENCHMARK(InstanceBatcherPacking)
+{
+    // 100k instances with 3x4 matrices, in runs of one mesh (a sorted scene) and shuffled over the meshes
+    const uint32_t instanceCount = 100000;
+    const std::vector<float> matrices = MakeMatrices(instanceCount, 12);
+    std::vector<RTR::InstanceData> stream(instanceCount);
+    for (uint32_t meshCount : { 1u, 100u, 10000u })
+    {
+        for (int shuffled = 0; shuffled < 2; shuffled++)
+        {
+            std::mt19937 rng(meshCount);
+            std::vector<uint64_t> keys(instanceCount);
+            for (uint32_t i = 0; i < instanceCount; i++)
+                keys[i] = shuffled ? rng() % meshCount : (uint64_t)i * meshCount / instanceCount;
+
+            RTR::InstanceBatcher batcher;
+            const double addSeconds = RTR::Test::MeasureSeconds([&]()
+                {
+                    batcher.Clear();
+                    for (uint32_t i = 0; i < instanceCount; i++)
+                        batcher.Add(keys[i], i, i);
+                }, 10);
+            const double buildSeconds = RTR::Test::MeasureSeconds([&]() { batcher.Build(matrices.data(), 12, stream.data()); }, 10);
+            printf("  %5u meshes %-8s  add %7.3f ms  build %7.3f ms  (%.1f ns per instance, %zu draws)\n", meshCount, shuffled ? "shuffled" : "sorted",
+                addSeconds * 1e3, buildSeconds * 1e3, (addSeconds + buildSeconds) * 1e9 / instanceCount, batcher.GetBatches().size());
+        }
+    }
+}
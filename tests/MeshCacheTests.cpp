@@ -0,0 +1,225 @@
+#include "Test.h"
+#include "TestMeshes.h"
+
+#include <RTR/3DModells/MeshCache.h>
+#include <RTR/3DModells/MeshOptimizer.h>
+#include <RTR/3DModells/MeshletBuilder.h>
+#include <RTR/3DModells/MeshSimplifier.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    // CPU blobs of one mesh, produced the way the importer does
+    struct BakedMesh
+    {
+        std::string name;
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        RTR::MeshletData meshlets;
+        std::vector<uint32_t> lodIndices;
+        std::vector<RTR::MeshLodRange> lods;
+        RTR::MeshCacheMeshDesc desc;
+    };
+
+    void BakeMesh(BakedMesh& baked, const char* name, const RTR::Test::TestMesh& mesh)
+    {
+        baked.name = name;
+        const size_t vertexCount = mesh.GetVertexCount();
+
+        // Cache and fetch order
+        baked.desc.cacheStatsBefore = RTR::MeshAnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount);
+        baked.indices.resize(mesh.indices.size());
+        RTR::MeshOptimizeVertexCache(baked.indices.data(), mesh.indices.data(), mesh.indices.size(), vertexCount);
+        std::vector<uint32_t> remap(vertexCount);
+        RTR::MeshOptimizeVertexFetch(remap.data(), baked.indices.data(), baked.indices.size(), vertexCount);
+        baked.vertices.resize(mesh.positions.size());
+        for (size_t v = 0; v < vertexCount; v++)
+            memcpy(&baked.vertices[v * 3], &mesh.positions[remap[v] * 3], sizeof(float) * 3);
+
+        // Meshlets and one coarser level
+        RTR::MeshBuildMeshlets(baked.meshlets, baked.indices.data(), baked.indices.size(), baked.vertices.data(), sizeof(float) * 3, vertexCount);
+        baked.lodIndices.resize(baked.indices.size());
+        float error = 0.0f;
+        const size_t lodCount = RTR::MeshSimplify(baked.lodIndices.data(), baked.indices.data(), baked.indices.size(), baked.vertices.data(), sizeof(float) * 3, vertexCount,
+            nullptr, 0, nullptr, 0, baked.indices.size() / 2, 1.0f, &error);
+        baked.lodIndices.resize(lodCount);
+        baked.lods.push_back({ 0, (uint32_t)lodCount, error, 0 });
+
+        RTR::MeshCacheMeshDesc& desc = baked.desc;
+        desc.name = name;
+        desc.vertexCount = (uint32_t)vertexCount;
+        desc.indexCount = (uint32_t)baked.indices.size();
+        desc.meshletCount = (uint32_t)baked.meshlets.meshlets.size();
+        desc.indexSize = sizeof(uint32_t);
+        desc.bounds = RTR::ComputeMeshBounds(baked.vertices.data(), sizeof(float) * 3, vertexCount);
+        desc.cacheStatsAfter = RTR::MeshAnalyzeVertexCache(baked.indices.data(), baked.indices.size(), vertexCount);
+        auto set = [&desc](RTR::MeshCacheBlob blob, const auto& data)
+        {
+            desc.blobData[(uint32_t)blob] = data.data();
+            desc.blobBytes[(uint32_t)blob] = data.size() * sizeof(data[0]);
+        };
+        set(RTR::MeshCacheBlob::Vertices, baked.vertices);
+        set(RTR::MeshCacheBlob::Indices, baked.indices);
+        set(RTR::MeshCacheBlob::Meshlets, baked.meshlets.meshlets);
+        set(RTR::MeshCacheBlob::MeshletBounds, baked.meshlets.bounds);
+        set(RTR::MeshCacheBlob::MeshletVertices, baked.meshlets.vertices);
+        set(RTR::MeshCacheBlob::MeshletPrimitives, baked.meshlets.primitives);
+        set(RTR::MeshCacheBlob::LodIndices, baked.lodIndices);
+        set(RTR::MeshCacheBlob::Lods, baked.lods);
+        desc.contentHash = 0x1234 + desc.indexCount;
+        desc.contentCheck = 0x5678 + desc.vertexCount;
+    }
+
+    RTR::MeshCacheKey MakeKey()
+    {
+        RTR::MeshCacheKey key;
+        key.sourceSize = 4096;
+        key.sourceWriteTime = 1234567;
+        key.sourceHash = 0xABCDEF;
+        key.vertexLayout = 7;
+        key.importOptions = 3;
+        key.importFlags = 0x10;
+        key.vertexSize = sizeof(float) * 3;
+        return key;
+    }
+
+    std::string TempPath(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+}
+
+RTR_TEST(MeshCacheRoundTripIsByteIdentical)
+{
+    BakedMesh meshes[2];
+    BakeMesh(meshes[0], "Sphere", RTR::Test::MakeSphereMesh(24, 48));
+    BakeMesh(meshes[1], "Grid", RTR::Test::MakeGridMesh(40, 30));
+
+    const std::string path = TempPath("RtrMeshCacheRoundTrip.rtrmesh");
+    RTR::MeshCacheWriter writer;
+    for (auto& mesh : meshes)
+        writer.AddMesh(mesh.desc);
+    RTR_EXPECT(writer.Write(path.c_str(), MakeKey()));
+
+    // Every field and blob comes back exactly as the import produced it
+    {
+        RTR::MeshCacheFile cache;
+        RTR_EXPECT(cache.Open(path.c_str(), MakeKey()));
+        RTR_EXPECT(cache.GetMeshCount() == 2);
+        for (uint32_t i = 0; i < cache.GetMeshCount() && i < 2; i++)
+        {
+            const RTR::MeshCacheMeshDesc& desc = meshes[i].desc;
+            const RTR::MeshCacheEntry& entry = cache.GetEntry(i);
+            RTR_EXPECT(cache.GetName(i) == desc.name);
+            RTR_EXPECT(entry.vertexCount == desc.vertexCount && entry.indexCount == desc.indexCount && entry.meshletCount == desc.meshletCount);
+            RTR_EXPECT(entry.indexSize == desc.indexSize && entry.contentHash == desc.contentHash && entry.contentCheck == desc.contentCheck);
+            RTR_EXPECT(!memcmp(&entry.bounds, &desc.bounds, sizeof(desc.bounds)));
+            RTR_EXPECT(!memcmp(&entry.cacheStatsBefore, &desc.cacheStatsBefore, sizeof(desc.cacheStatsBefore)));
+            RTR_EXPECT(!memcmp(&entry.cacheStatsAfter, &desc.cacheStatsAfter, sizeof(desc.cacheStatsAfter)));
+            for (uint32_t b = 0; b < (uint32_t)RTR::MeshCacheBlob::Count; b++)
+            {
+                RTR_EXPECT(cache.GetBlobSize(i, (RTR::MeshCacheBlob)b) == desc.blobBytes[b]);
+                RTR_EXPECT(!desc.blobBytes[b] || !memcmp(cache.GetBlob(i, (RTR::MeshCacheBlob)b), desc.blobData[b], (size_t)desc.blobBytes[b]));
+                RTR_EXPECT(entry.blobOffset[b] % 16 == 0);
+            }
+        }
+    }
+
+    // Any key difference invalidates the file
+    RTR::MeshCacheKey key = MakeKey();
+    key.vertexLayout++;
+    RTR::MeshCacheFile stale;
+    RTR_EXPECT(!stale.Open(path.c_str(), key));
+
+    std::filesystem::remove(path);
+}
+
+RTR_TEST(MeshCacheRejectsTruncatedFiles)
+{
+    BakedMesh mesh;
+    BakeMesh(mesh, "Sphere", RTR::Test::MakeSphereMesh(16, 32));
+    const std::string path = TempPath("RtrMeshCacheTruncated.rtrmesh");
+    RTR::MeshCacheWriter writer;
+    writer.AddMesh(mesh.desc);
+    RTR_EXPECT(writer.Write(path.c_str(), MakeKey()));
+
+    // Cut the file at several points (a crashed copy or a partial download must never be read past its end)
+    const uint64_t size = std::filesystem::file_size(path);
+    for (uint64_t cut : { size - 1, size / 2, (uint64_t)sizeof(RTR::MeshCacheHeader) + 8, (uint64_t)4 })
+    {
+        std::filesystem::resize_file(path, cut);
+        RTR::MeshCacheFile cache;
+        RTR_EXPECT(!cache.Open(path.c_str(), MakeKey()));
+    }
+
+    std::filesystem::remove(path);
+}
+
+RTR_TEST(MappedFileMapsWholeFile)
+{
+    const std::string path = TempPath("RtrMappedFile.bin");
+    std::vector<unsigned char> bytes(100000);
+    for (size_t i = 0; i < bytes.size(); i++)
+        bytes[i] = (unsigned char)(i * 31);
+    std::ofstream(path, std::ios::binary).write((const char*)bytes.data(), bytes.size());
+
+    RTR::MappedFile file(path.c_str());
+    RTR_EXPECT(file);
+    RTR_EXPECT(file.GetSize() == bytes.size());
+    RTR_EXPECT(file && !memcmp(file.GetData(), bytes.data(), bytes.size()));
+    file.Close();
+    RTR_EXPECT(!file);
+
+    // Missing and empty files do not map
+    RTR_EXPECT(!file.Open(TempPath("RtrMappedFileMissing.bin").c_str()));
+    std::ofstream(path, std::ios::binary | std::ios::trunc).close();
+    RTR_EXPECT(!file.Open(path.c_str()));
+
+    std::filesystem::remove(path);
+}
+
+RTR_TEST(MeshCacheSourceMatchesByStampOrHash)
+{
+    BakedMesh mesh;
+    BakeMesh(mesh, "Grid", RTR::Test::MakeGridMesh(8, 8));
+    const std::string path = TempPath("RtrMeshCacheStamp.rtrmesh");
+    RTR::MeshCacheWriter writer;
+    writer.AddMesh(mesh.desc);
+    RTR_EXPECT(writer.Write(path.c_str(), MakeKey()));
+
+    // Same size and write time: the hash is not needed
+    RTR::MeshCacheFile cache;
+    RTR::MeshCacheKey key = MakeKey();
+    key.sourceHash = 0;
+    RTR_EXPECT(cache.Open(path.c_str(), key));
+
+    // Touched source: only a matching hash accepts the file
+    key.sourceWriteTime++;
+    RTR_EXPECT(!cache.Open(path.c_str(), key));
+    key.sourceHash = MakeKey().sourceHash + 1;
+    RTR_EXPECT(!cache.Open(path.c_str(), key));
+    key.sourceHash = MakeKey().sourceHash;
+    RTR_EXPECT(cache.Open(path.c_str(), key));
+
+    // Restamping makes the new write time match without a hash
+    cache.Close();
+    RTR_EXPECT(RTR::MeshCacheFile::RestampFile(path.c_str(), key));
+    key.sourceHash = 0;
+    RTR_EXPECT(cache.Open(path.c_str(), key));
+    RTR_EXPECT(cache.GetMeshCount() == 1 && cache.GetName(0) == "Grid");
+    cache.Close();
+
+    // Stamp and hash of a real file
+    RTR::MeshCacheKey sourceKey;
+    uint64_t hash = 0;
+    RTR_EXPECT(RTR::MeshCacheFile::StampSourceFile(path.c_str(), &sourceKey));
+    RTR_EXPECT(sourceKey.sourceSize == std::filesystem::file_size(path));
+    RTR_EXPECT(RTR::MeshCacheFile::HashSourceFile(path.c_str(), &hash) && hash != 0);
+    RTR_EXPECT(!RTR::MeshCacheFile::StampSourceFile(TempPath("RtrMeshCacheMissing.bin").c_str(), &sourceKey));
+
+    std::filesystem::remove(path);
+}
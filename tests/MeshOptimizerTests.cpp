@@ -0,0 +1,174 @@
+#include "Test.h"
+#include "TestMeshes.h"
+
+#include <RTR/3DModells/MeshOptimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    // Triangle list in random order (the worst case assimp can hand over)
+    std::vector<uint32_t> ShuffleTriangles(const std::vector<uint32_t>& indices, unsigned int seed)
+    {
+        std::vector<size_t> order(indices.size() / 3);
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::shuffle(order.begin(), order.end(), std::mt19937(seed));
+
+        std::vector<uint32_t> shuffled;
+        shuffled.reserve(indices.size());
+        for (size_t t : order)
+            shuffled.insert(shuffled.end(), { indices[t * 3 + 0], indices[t * 3 + 1], indices[t * 3 + 2] });
+        return shuffled;
+    }
+
+    // Sorted triangles with a canonical rotation (keeps the winding)
+    std::vector<std::array<uint32_t, 3>> CanonicalTriangles(const std::vector<uint32_t>& indices, const uint32_t* remap = nullptr)
+    {
+        std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+        for (size_t t = 0; t < triangles.size(); t++)
+        {
+            auto& tri = triangles[t];
+            for (size_t k = 0; k < 3; k++)
+                tri[k] = remap ? remap[indices[t * 3 + k]] : indices[t * 3 + k];
+            std::rotate(tri.begin(), std::min_element(tri.begin(), tri.end()), tri.end());
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
+
+RTR_TEST(MeshAnalyzeVertexCacheKnownValues)
+{
+    // One triangle: three misses for three vertices
+    const uint32_t single[] = { 0, 1, 2 };
+    RTR::VertexCacheStats stats = RTR::MeshAnalyzeVertexCache(single, 3, 3);
+    RTR_EXPECT(stats.acmr == 3.0f && stats.atvr == 1.0f);
+
+    // Quad: the second triangle hits twice
+    const uint32_t quad[] = { 0, 1, 2, 2, 1, 3 };
+    stats = RTR::MeshAnalyzeVertexCache(quad, 6, 4);
+    RTR_EXPECT(stats.acmr == 2.0f && stats.atvr == 1.0f);
+
+    // A cache of 3 entries evicts vertex 0 before it is used again
+    const uint32_t evict[] = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+    stats = RTR::MeshAnalyzeVertexCache(evict, 9, 6, 3);
+    RTR_EXPECT(stats.acmr == 3.0f && stats.atvr == 1.5f);
+}
+
+RTR_TEST(MeshOptimizerKeepsTriangles)
+{
+    for (const RTR::Test::TestMesh& mesh : { RTR::Test::MakeGridMesh(64, 48), RTR::Test::MakeSphereMesh(32, 64) })
+    {
+        const size_t vertexCount = mesh.GetVertexCount();
+        const std::vector<uint32_t> shuffled = ShuffleTriangles(mesh.indices, 7);
+
+        // Cache order
+        std::vector<uint32_t> indices(shuffled.size());
+        std::vector<uint32_t> clusters;
+        RTR::MeshOptimizeVertexCache(indices.data(), shuffled.data(), shuffled.size(), vertexCount, 16, &clusters);
+        RTR_EXPECT(CanonicalTriangles(indices) == CanonicalTriangles(shuffled));
+        RTR_EXPECT(!clusters.empty() && clusters[0] == 0);
+        RTR_EXPECT(std::is_sorted(clusters.begin(), clusters.end()) && clusters.back() < indices.size() / 3);
+
+        // Overdraw order (in place)
+        RTR::MeshOptimizeOverdraw(indices.data(), indices.data(), indices.size(), mesh.positions.data(), sizeof(float) * 3, vertexCount, clusters);
+        RTR_EXPECT(CanonicalTriangles(indices) == CanonicalTriangles(shuffled));
+
+        // Fetch order: remap[new] = old, so mapping the new indices back gives the input triangles
+        std::vector<uint32_t> remap(vertexCount);
+        const size_t referenced = RTR::MeshOptimizeVertexFetch(remap.data(), indices.data(), indices.size(), vertexCount);
+        RTR_EXPECT(referenced == vertexCount);
+        RTR_EXPECT(CanonicalTriangles(indices, remap.data()) == CanonicalTriangles(shuffled));
+
+        // Remap is a permutation and vertices appear in first use order
+        std::vector<uint32_t> sortedRemap = remap;
+        std::sort(sortedRemap.begin(), sortedRemap.end());
+        for (size_t v = 0; v < vertexCount; v++)
+            RTR_EXPECT(sortedRemap[v] == v);
+        uint32_t nextNew = 0;
+        for (uint32_t index : indices)
+        {
+            RTR_EXPECT(index <= nextNew);
+            nextNew = std::max(nextNew, index + 1);
+        }
+    }
+}
+
+RTR_TEST(MeshOptimizerImprovesCacheEfficiency)
+{
+    const RTR::Test::TestMesh mesh = RTR::Test::MakeGridMesh(100, 100);
+    const size_t vertexCount = mesh.GetVertexCount();
+    const std::vector<uint32_t> shuffled = ShuffleTriangles(mesh.indices, 3);
+
+    std::vector<uint32_t> indices(shuffled.size());
+    RTR::MeshOptimizeVertexCache(indices.data(), shuffled.data(), shuffled.size(), vertexCount);
+    const RTR::VertexCacheStats before = RTR::MeshAnalyzeVertexCache(shuffled.data(), shuffled.size(), vertexCount);
+    const RTR::VertexCacheStats after = RTR::MeshAnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+    // A random grid order misses almost every vertex, Tipsify gets well below one miss per triangle
+    RTR_EXPECT(before.acmr > 2.0f);
+    RTR_EXPECT(after.acmr < 0.8f);
+    RTR_EXPECT(after.atvr < before.atvr);
+}
+
+RTR_TEST(MeshOptimizeVertexFetchKeepsUnreferencedVertices)
+{
+    // Vertex 1 and 4 are never used
+    uint32_t indices[] = { 5, 3, 0, 0, 3, 2 };
+    uint32_t remap[6] = {};
+    const size_t referenced = RTR::MeshOptimizeVertexFetch(remap, indices, 6, 6);
+    RTR_EXPECT(referenced == 4);
+    RTR_EXPECT(remap[0] == 5 && remap[1] == 3 && remap[2] == 0 && remap[3] == 2);
+    RTR_EXPECT((remap[4] == 1 && remap[5] == 4) || (remap[4] == 4 && remap[5] == 1));
+    const uint32_t expected[] = { 0, 1, 2, 2, 1, 3 };
+    RTR_EXPECT(std::equal(indices, indices + 6, expected));
+}
+
+RTR_BENCHMARK(MeshOptimizerThroughput)
+{
+    struct Input
+    {
+        const char* name;
+        RTR::Test::TestMesh mesh;
+    };
+    const Input inputs[] = {
+        { "Sphere 64x128", RTR::Test::MakeSphereMesh(64, 128) },
+        { "Grid 500x500", RTR::Test::MakeGridMesh(500, 500) },
+    };
+
+    for (const Input& input : inputs)
+    {
+        const size_t vertexCount = input.mesh.GetVertexCount();
+        const std::vector<uint32_t> shuffled = ShuffleTriangles(input.mesh.indices, 1);
+        std::vector<uint32_t> indices(shuffled.size());
+        std::vector<uint32_t> sorted(shuffled.size());
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<uint32_t> clusters;
+
+        const double cacheSeconds = RTR::Test::MeasureSeconds([&]()
+            {
+                clusters.clear();
+                RTR::MeshOptimizeVertexCache(indices.data(), shuffled.data(), shuffled.size(), vertexCount, 16, &clusters);
+            }, 5);
+        const RTR::VertexCacheStats cacheStats = RTR::MeshAnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+        const double overdrawSeconds = RTR::Test::MeasureSeconds([&]()
+            {
+                RTR::MeshOptimizeOverdraw(sorted.data(), indices.data(), indices.size(), input.mesh.positions.data(), sizeof(float) * 3, vertexCount, clusters);
+            }, 5);
+        const RTR::VertexCacheStats overdrawStats = RTR::MeshAnalyzeVertexCache(sorted.data(), sorted.size(), vertexCount);
+        const double fetchSeconds = RTR::Test::MeasureSeconds([&]()
+            {
+                // Remaps in place, every pass after the first sees first use order already
+                RTR::MeshOptimizeVertexFetch(remap.data(), sorted.data(), sorted.size(), vertexCount);
+            }, 5);
+
+        const RTR::VertexCacheStats inputStats = RTR::MeshAnalyzeVertexCache(shuffled.data(), shuffled.size(), vertexCount);
+        printf("  %-14s %8zu tris  cache %7.2f ms  overdraw %7.2f ms  fetch %6.2f ms  ACMR %.3f -> %.3f -> %.3f\n",
+            input.name, shuffled.size() / 3, cacheSeconds * 1000.0, overdrawSeconds * 1000.0, fetchSeconds * 1000.0,
+            inputStats.acmr, cacheStats.acmr, overdrawStats.acmr);
+    }
+}
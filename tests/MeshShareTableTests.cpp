@@ -0,0 +1,120 @@
+#include "Test.h"
+
+#include <RTR/3DModells/MeshShareTable.h>
+
+#include <vector>
+
+namespace
+{
+    // Gpu data stand in: where the mesh was allocated
+    struct FakeAllocation
+    {
+        int allocation = -1;
+    };
+
+    RTR::MeshShareKey MakeKey(uint64_t contentHash, size_t vertexCount)
+    {
+        RTR::MeshShareKey key;
+        key.contentHash = contentHash;
+        key.contentCheck = contentHash * 31 + vertexCount;
+        key.vertexCount = vertexCount;
+        key.indexCount = vertexCount * 3;
+        key.indexSize = 2;
+        key.blobBytes[(size_t)RTR::MeshCacheBlob::Vertices] = vertexCount * 16;
+        key.blobBytes[(size_t)RTR::MeshCacheBlob::Indices] = vertexCount * 6;
+        return key;
+    }
+
+    // The allocation path of ModelContext::AllocateMesh: share or allocate and register
+    struct FakeContext
+    {
+        RTR::MeshShareTable<FakeAllocation> table;
+        int allocations = 0, frees = 0;
+
+        // Content hash the mesh keeps (0 when unshared) and its allocation
+        struct Mesh
+        {
+            uint64_t contentHash;
+            int allocation;
+        };
+
+        Mesh Allocate(RTR::MeshShareKey key)
+        {
+            bool collision = false;
+            if (const FakeAllocation* ptrShared = table.Acquire(key, &collision))
+                return { key.contentHash, ptrShared->allocation };
+            if (collision)
+                key.contentHash = 0;
+
+            const int allocation = allocations++;
+            if (key.contentHash)
+                table.Insert(key).allocation = allocation;
+            return { key.contentHash, allocation };
+        }
+        void Release(const Mesh& mesh)
+        {
+            if (table.Release(mesh.contentHash))
+                frees++;
+        }
+    };
+}
+
+RTR_TEST(MeshShareTableSharesAcrossModels)
+{
+    // Two models with a common mesh, each with one mesh of its own
+    FakeContext context;
+    std::vector<FakeContext::Mesh> first = { context.Allocate(MakeKey(10, 100)), context.Allocate(MakeKey(11, 200)) };
+    std::vector<FakeContext::Mesh> second = { context.Allocate(MakeKey(10, 100)), context.Allocate(MakeKey(12, 300)) };
+    RTR_EXPECT(context.allocations == 3);
+    RTR_EXPECT(first[0].allocation == second[0].allocation);
+    RTR_EXPECT(context.table.GetRefCount(10) == 2 && context.table.GetRefCount(11) == 1 && context.table.GetCount() == 3);
+
+    // Unloading the first model frees only its own mesh, the common one lives on with the second
+    for (const auto& mesh : first)
+        context.Release(mesh);
+    RTR_EXPECT(context.frees == 1);
+    RTR_EXPECT(context.table.GetRefCount(10) == 1 && context.table.Find(11) == nullptr);
+    RTR_EXPECT(context.table.Find(10) && context.table.Find(10)->allocation == second[0].allocation);
+
+    // The last user frees it
+    for (const auto& mesh : second)
+        context.Release(mesh);
+    RTR_EXPECT(context.frees == 3 && context.table.GetCount() == 0);
+
+    // Loading it again allocates fresh memory
+    RTR_EXPECT(context.Allocate(MakeKey(10, 100)).allocation == 3);
+}
+
+RTR_TEST(MeshShareTableCollisionsStayUnshared)
+{
+    FakeContext context;
+    const FakeContext::Mesh original = context.Allocate(MakeKey(10, 100));
+
+    // Same hash, different content: a count, a blob size or the check hash differ
+    RTR::MeshShareKey differentCount = MakeKey(10, 100);
+    differentCount.meshletCount = 4;
+    RTR::MeshShareKey differentBlob = MakeKey(10, 100);
+    differentBlob.blobBytes[(size_t)RTR::MeshCacheBlob::LodIndices] = 64;
+    RTR::MeshShareKey differentCheck = MakeKey(10, 100);
+    differentCheck.contentCheck++;
+    std::vector<FakeContext::Mesh> colliding;
+    for (const RTR::MeshShareKey& key : { differentCount, differentBlob, differentCheck })
+    {
+        bool collision = false;
+        RTR_EXPECT(context.table.Acquire(key, &collision) == nullptr && collision);
+        colliding.push_back(context.Allocate(key));
+        RTR_EXPECT(colliding.back().contentHash == 0 && colliding.back().allocation != original.allocation);
+    }
+    RTR_EXPECT(context.table.GetRefCount(10) == 1);
+
+    // Releasing them never touches the entry of the original
+    for (const auto& mesh : colliding)
+        context.Release(mesh);
+    RTR_EXPECT(context.frees == 3 && context.table.GetRefCount(10) == 1);
+    context.Release(original);
+    RTR_EXPECT(context.frees == 4 && context.table.GetCount() == 0);
+
+    // Hash 0 never shares
+    RTR_EXPECT(context.Allocate(MakeKey(0, 100)).allocation != context.Allocate(MakeKey(0, 100)).allocation);
+    RTR_EXPECT(context.table.GetCount() == 0);
+}
@@ -0,0 +1,213 @@
+#include "Test.h"
+#include "TestMeshes.h"
+
+#include <RTR/3DModells/MeshSimplifier.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <set>
+
+namespace
+{
+    // Sphere with radial noise (a stand in for a scanned surface)
+    RTR::Test::TestMesh MakeNoisySphere(uint32_t rings, uint32_t segments, float noise, unsigned int seed)
+    {
+        RTR::Test::TestMesh mesh = RTR::Test::MakeSphereMesh(rings, segments);
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> distribution(1.0f - noise, 1.0f + noise);
+        for (size_t v = 0; v < mesh.GetVertexCount(); v++)
+        {
+            const float scale = distribution(rng);
+            for (size_t k = 0; k < 3; k++)
+                mesh.positions[v * 3 + k] *= scale;
+        }
+        return mesh;
+    }
+
+    // Checks of a simplified closed sphere: valid indices, no degenerate or flipped triangles, surface close to the reported error
+    void ExpectValidSphereLod(const RTR::Test::TestMesh& mesh, const std::vector<uint32_t>& lod, float error)
+    {
+        for (size_t t = 0; t < lod.size(); t += 3)
+        {
+            const uint32_t i0 = lod[t + 0], i1 = lod[t + 1], i2 = lod[t + 2];
+            RTR_EXPECT(i0 < mesh.GetVertexCount() && i1 < mesh.GetVertexCount() && i2 < mesh.GetVertexCount());
+            RTR_EXPECT(i0 != i1 && i1 != i2 && i0 != i2);
+
+            const float* a = &mesh.positions[i0 * 3];
+            const float* b = &mesh.positions[i1 * 3];
+            const float* c = &mesh.positions[i2 * 3];
+            const float center[3] = { (a[0] + b[0] + c[0]) / 3.0f, (a[1] + b[1] + c[1]) / 3.0f, (a[2] + b[2] + c[2]) / 3.0f };
+            const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+
+            // Sphere triangles face outwards (a flipped triangle would face the center)
+            RTR_EXPECT(n[0] * center[0] + n[1] * center[1] + n[2] * center[2] > 0.0f);
+            const float distance = std::sqrt(center[0] * center[0] + center[1] * center[1] + center[2] * center[2]);
+            // The error is measured against the original planes, the center of a large flat triangle sinks a bit further
+            RTR_EXPECT(1.0f - distance <= error * 2.0f + 0.005f);
+        }
+    }
+}
+
+RTR_TEST(MeshSimplifierReachesTargets)
+{
+    const RTR::Test::TestMesh mesh = RTR::Test::MakeSphereMesh(48, 96);
+    std::vector<uint32_t> lod(mesh.indices.size());
+
+    float previousError = 0.0f;
+    for (float ratio : { 0.5f, 0.25f, 0.1f, 0.02f })
+    {
+        const size_t target = (size_t)(mesh.indices.size() * ratio) / 3 * 3;
+        float error = 0.0f;
+        const size_t count = RTR::MeshSimplify(lod.data(), mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount(),
+            nullptr, 0, nullptr, 0, target, 1.0f, &error);
+        RTR_EXPECT(count % 3 == 0 && count <= target && count > target * 3 / 4);
+
+        // Coarser levels report larger errors
+        RTR_EXPECT(error > previousError);
+        previousError = error;
+
+        ExpectValidSphereLod(mesh, std::vector<uint32_t>(lod.begin(), lod.begin() + count), error);
+    }
+}
+
+RTR_TEST(MeshSimplifierRespectsErrorLimit)
+{
+    const RTR::Test::TestMesh mesh = RTR::Test::MakeSphereMesh(32, 64);
+    std::vector<uint32_t> lod(mesh.indices.size());
+
+    // Every collapse on a curved surface has an error, so a zero budget keeps the mesh
+    float error = 1.0f;
+    size_t count = RTR::MeshSimplify(lod.data(), mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount(),
+        nullptr, 0, nullptr, 0, 0, 0.0f, &error);
+    RTR_EXPECT(count == mesh.indices.size() && error == 0.0f);
+
+    // A small budget stops early and stays below it
+    count = RTR::MeshSimplify(lod.data(), mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount(),
+        nullptr, 0, nullptr, 0, 0, 0.01f, &error);
+    RTR_EXPECT(count < mesh.indices.size() && count > 3 * 50);
+    RTR_EXPECT(error <= 0.01f);
+}
+
+RTR_TEST(MeshSimplifierKeepsFlatBorders)
+{
+    // A flat grid collapses to a few triangles without error while keeping its outline and area
+    const RTR::Test::TestMesh mesh = RTR::Test::MakeGridMesh(30, 20);
+    std::vector<uint32_t> lod(mesh.indices.size());
+    float error = 1.0f;
+    const size_t count = RTR::MeshSimplify(lod.data(), mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount(),
+        nullptr, 0, nullptr, 0, 0, 1e-4f, &error);
+    RTR_EXPECT(count < mesh.indices.size() / 10);
+    RTR_EXPECT(error <= 1e-4f);
+
+    double area = 0.0;
+    for (size_t t = 0; t < count; t += 3)
+    {
+        const float* a = &mesh.positions[lod[t + 0] * 3];
+        const float* b = &mesh.positions[lod[t + 1] * 3];
+        const float* c = &mesh.positions[lod[t + 2] * 3];
+        area += 0.5 * ((c[0] - a[0]) * (b[2] - a[2]) - (c[2] - a[2]) * (b[0] - a[0]));
+    }
+    RTR_EXPECT(std::abs(area - 30.0 * 20.0) < 1e-3);
+
+    // The four corners survive
+    std::set<uint32_t> used(lod.begin(), lod.begin() + count);
+    for (uint32_t corner : { 0u, 30u, 20u * 31u, 20u * 31u + 30u })
+        RTR_EXPECT(used.count(corner) == 1);
+}
+
+RTR_TEST(MeshSimplifierKeepsSeamsAndAttributes)
+{
+    // Grid with a duplicated vertex column (an attribute seam at x = 10) and a color step at x = 15
+    RTR::Test::TestMesh mesh = RTR::Test::MakeGridMesh(30, 20);
+    const uint32_t width = 31;
+    std::vector<uint32_t> seam;
+    for (uint32_t z = 0; z <= 20; z++)
+    {
+        seam.push_back((uint32_t)mesh.GetVertexCount());
+        mesh.positions.insert(mesh.positions.end(), { 10.0f, 0.0f, (float)z });
+    }
+    for (size_t t = 0; t < mesh.indices.size(); t += 3)
+    {
+        // Triangles right of the seam use the duplicates
+        const float* a = &mesh.positions[mesh.indices[t] * 3];
+        const float* b = &mesh.positions[mesh.indices[t + 1] * 3];
+        const float* c = &mesh.positions[mesh.indices[t + 2] * 3];
+        if (a[0] + b[0] + c[0] > 30.0f)
+        {
+            for (size_t k = 0; k < 3; k++)
+            {
+                const uint32_t index = mesh.indices[t + k];
+                if (index % width == 10 && index < width * 21)
+                    mesh.indices[t + k] = seam[index / width];
+            }
+        }
+    }
+    std::vector<float> colors(mesh.GetVertexCount());
+    for (size_t v = 0; v < colors.size(); v++)
+        colors[v] = mesh.positions[v * 3] > 15.0f ? 1.0f : 0.0f;
+
+    std::vector<uint32_t> plain(mesh.indices.size()), weighted(mesh.indices.size());
+    const float weight = 1.0f;
+    const size_t plainCount = RTR::MeshSimplify(plain.data(), mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount(),
+        nullptr, 0, nullptr, 0, 0, 1e-3f);
+    const size_t weightedCount = RTR::MeshSimplify(weighted.data(), mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount(),
+        colors.data(), sizeof(float), &weight, 1, 0, 1e-3f);
+
+    // Seam vertices are never collapsed away (on both sides)
+    for (const std::vector<uint32_t>* ptrLod : { &plain, &weighted })
+    {
+        const size_t count = ptrLod == &plain ? plainCount : weightedCount;
+        std::set<uint32_t> used(ptrLod->begin(), ptrLod->begin() + count);
+        for (uint32_t z = 0; z <= 20; z++)
+            RTR_EXPECT(used.count(z * width + 10) == 1 && used.count(seam[z]) == 1);
+    }
+
+    // The color step costs extra triangles once attributes are weighted
+    RTR_EXPECT(weightedCount > plainCount);
+}
+
+RTR_TEST(MeshProjectErrorScales)
+{
+    RTR_EXPECT(RTR::MeshProjectError(0.01f, 10.0f, 1000.0f) == 1.0f);
+    RTR_EXPECT(RTR::MeshProjectError(0.01f, 20.0f, 1000.0f) == 0.5f);
+    RTR_EXPECT(RTR::MeshProjectError(0.01f, 0.0f, 1000.0f) > 1e30f);
+
+    const RTR::Test::TestMesh mesh = RTR::Test::MakeGridMesh(30, 20);
+    RTR_EXPECT(RTR::MeshComputeExtent(mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount()) == 30.0f);
+}
+
+RTR_BENCHMARK(MeshSimplifierThroughput)
+{
+    // Suzanne sized model (~1k triangles) and a dense noisy scan (~1M triangles)
+    struct Input
+    {
+        const char* name;
+        RTR::Test::TestMesh mesh;
+    };
+    const Input inputs[] = {
+        { "Suzanne size", MakeNoisySphere(22, 24, 0.02f, 1) },
+        { "Scan 1M", MakeNoisySphere(708, 708, 0.002f, 2) },
+    };
+
+    for (const Input& input : inputs)
+    {
+        std::vector<uint32_t> lod(input.mesh.indices.size());
+        for (float ratio : { 0.5f, 0.1f, 0.01f })
+        {
+            size_t count = 0;
+            float error = 0.0f;
+            const size_t target = (size_t)(input.mesh.indices.size() * ratio) / 3 * 3;
+            const double seconds = RTR::Test::MeasureSeconds([&]()
+                {
+                    count = RTR::MeshSimplify(lod.data(), input.mesh.indices.data(), input.mesh.indices.size(), input.mesh.positions.data(), sizeof(float) * 3,
+                        input.mesh.GetVertexCount(), nullptr, 0, nullptr, 0, target, 1.0f, &error);
+                }, input.mesh.indices.size() > 100000 ? 1 : 20);
+
+            printf("  %-12s %8zu -> %8zu tris  %9.2f ms  error %.5f\n", input.name, input.mesh.indices.size() / 3, count / 3, seconds * 1000.0, error);
+        }
+    }
+}
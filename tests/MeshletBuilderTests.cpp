@@ -0,0 +1,165 @@
+#include "Test.h"
+#include "TestMeshes.h"
+
+#include <RTR/3DModells/MeshletBuilder.h>
+#include <RTR/3DModells/MeshOptimizer.h>
+
+#include <cmath>
+#include <cstdio>
+#include <set>
+
+namespace
+{
+    // Cache optimized copy of a mesh (the order the importer hands to the builder)
+    RTR::Test::TestMesh OptimizeMesh(RTR::Test::TestMesh mesh)
+    {
+        std::vector<uint32_t> indices(mesh.indices.size());
+        RTR::MeshOptimizeVertexCache(indices.data(), mesh.indices.data(), mesh.indices.size(), mesh.GetVertexCount());
+        mesh.indices = std::move(indices);
+        return mesh;
+    }
+
+    // Mesh index of a meshlet primitive corner
+    uint32_t MeshletIndex(const RTR::MeshletData& data, const RTR::Meshlet& meshlet, uint32_t primitive, uint32_t corner)
+    {
+        uint32_t local[3];
+        RTR::MeshletUnpackPrimitive(data.primitives[meshlet.primitiveOffset + primitive], local);
+        return data.vertices[meshlet.vertexOffset + local[corner]];
+    }
+
+    // True when the triangle faces the camera
+    bool IsFrontFacing(const float* a, const float* b, const float* c, const float* camera)
+    {
+        const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        return (a[0] - camera[0]) * n[0] + (a[1] - camera[1]) * n[1] + (a[2] - camera[2]) * n[2] < -1e-6f;
+    }
+}
+
+RTR_TEST(MeshletPrimitivePacking)
+{
+    for (uint32_t i : { 0u, 1u, 255u, 1023u })
+    {
+        uint32_t local[3];
+        RTR::MeshletUnpackPrimitive(RTR::MeshletPackPrimitive(i, 1023 - i, i / 2), local);
+        RTR_EXPECT(local[0] == i && local[1] == 1023 - i && local[2] == i / 2);
+    }
+}
+
+RTR_TEST(MeshletBuilderInvariants)
+{
+    struct Limits { unsigned int vertices, primitives; };
+    for (const RTR::Test::TestMesh& mesh : { OptimizeMesh(RTR::Test::MakeSphereMesh(32, 64)), RTR::Test::MakeGridMesh(50, 40) })
+    {
+        for (Limits limits : { Limits{ 64, 124 }, Limits{ 32, 32 }, Limits{ 256, 256 }, Limits{ 3, 1 } })
+        {
+            RTR::MeshletData data;
+            RTR::MeshBuildMeshlets(data, mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount(), limits.vertices, limits.primitives);
+            RTR_EXPECT(data.meshlets.size() == data.bounds.size());
+
+            // Meshlets are contiguous, in limits and reproduce the input triangles in order
+            size_t triangle = 0;
+            uint32_t vertexOffset = 0, primitiveOffset = 0;
+            for (size_t m = 0; m < data.meshlets.size(); m++)
+            {
+                const RTR::Meshlet& meshlet = data.meshlets[m];
+                RTR_EXPECT(meshlet.vertexOffset == vertexOffset && meshlet.primitiveOffset == primitiveOffset);
+                RTR_EXPECT(meshlet.vertexCount <= limits.vertices && meshlet.primitiveCount > 0 && meshlet.primitiveCount <= limits.primitives);
+                vertexOffset += meshlet.vertexCount;
+                primitiveOffset += meshlet.primitiveCount;
+
+                // Unique vertices per meshlet
+                std::set<uint32_t> unique(data.vertices.begin() + meshlet.vertexOffset, data.vertices.begin() + meshlet.vertexOffset + meshlet.vertexCount);
+                RTR_EXPECT(unique.size() == meshlet.vertexCount);
+
+                const RTR::MeshletBounds& bounds = data.bounds[m];
+                for (uint32_t p = 0; p < meshlet.primitiveCount; p++, triangle++)
+                {
+                    uint32_t local[3];
+                    RTR::MeshletUnpackPrimitive(data.primitives[meshlet.primitiveOffset + p], local);
+                    for (uint32_t k = 0; k < 3; k++)
+                    {
+                        RTR_EXPECT(local[k] < meshlet.vertexCount);
+                        const uint32_t index = MeshletIndex(data, meshlet, p, k);
+                        RTR_EXPECT(triangle * 3 + k < mesh.indices.size() && index == mesh.indices[triangle * 3 + k]);
+
+                        // Bounding sphere contains every vertex
+                        const float* position = &mesh.positions[index * 3];
+                        const float dx = position[0] - bounds.center[0], dy = position[1] - bounds.center[1], dz = position[2] - bounds.center[2];
+                        RTR_EXPECT(std::sqrt(dx * dx + dy * dy + dz * dz) <= bounds.radius * 1.0001f + 1e-5f);
+                    }
+                }
+            }
+            RTR_EXPECT(triangle * 3 == mesh.indices.size());
+            RTR_EXPECT(vertexOffset == data.vertices.size() && primitiveOffset == data.primitives.size());
+        }
+    }
+}
+
+RTR_TEST(MeshletConesAreConservative)
+{
+    const RTR::Test::TestMesh mesh = OptimizeMesh(RTR::Test::MakeSphereMesh(48, 96));
+    RTR::MeshletData data;
+    RTR::MeshBuildMeshlets(data, mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount());
+
+    // Cameras all around the sphere, near and far
+    size_t culled = 0, tested = 0;
+    for (int c = 0; c < 64; c++)
+    {
+        const float phi = c * 2.39996f, y = 1.0f - 2.0f * (c + 0.5f) / 64.0f, r = std::sqrt(1.0f - y * y);
+        const float distance = (c % 2) ? 1.5f : 20.0f;
+        const float camera[3] = { r * std::cos(phi) * distance, y * distance, r * std::sin(phi) * distance };
+
+        for (size_t m = 0; m < data.meshlets.size(); m++, tested++)
+        {
+            if (!RTR::MeshletIsBackfacing(data.bounds[m], camera))
+                continue;
+
+            // A culled meshlet must not hold a single front facing triangle
+            culled++;
+            const RTR::Meshlet& meshlet = data.meshlets[m];
+            for (uint32_t p = 0; p < meshlet.primitiveCount; p++)
+            {
+                RTR_EXPECT(!IsFrontFacing(&mesh.positions[MeshletIndex(data, meshlet, p, 0) * 3], &mesh.positions[MeshletIndex(data, meshlet, p, 1) * 3],
+                    &mesh.positions[MeshletIndex(data, meshlet, p, 2) * 3], camera));
+            }
+        }
+    }
+
+    // The cones must also be useful (a closed sphere shows about half of its surface)
+    RTR_EXPECT(culled > tested / 5 && culled < tested * 3 / 5);
+}
+
+RTR_TEST(MeshletFlatClusterCone)
+{
+    // All triangles of a grid share one normal: the cone is a ray, the far side is culled and the near side never
+    const RTR::Test::TestMesh mesh = RTR::Test::MakeGridMesh(4, 4);
+    const RTR::MeshletBounds bounds = RTR::MeshComputeClusterBounds(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3);
+    RTR_EXPECT(bounds.coneCutoff < 1e-3f);
+
+    // Grid triangles face +y (see MakeGridMesh)
+    const float above[3] = { 2.0f, 5.0f, 2.0f };
+    const float below[3] = { 2.0f, -5.0f, 2.0f };
+    RTR_EXPECT(IsFrontFacing(&mesh.positions[mesh.indices[0] * 3], &mesh.positions[mesh.indices[1] * 3], &mesh.positions[mesh.indices[2] * 3], above));
+    RTR_EXPECT(!RTR::MeshletIsBackfacing(bounds, above));
+    RTR_EXPECT(RTR::MeshletIsBackfacing(bounds, below));
+
+    // Degenerate clusters are never culled
+    const uint32_t degenerate[] = { 0, 1, 2 };
+    const float line[] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 2.0f, 0.0f, 0.0f };
+    RTR_EXPECT(!RTR::MeshletIsBackfacing(RTR::MeshComputeClusterBounds(degenerate, 3, line, sizeof(float) * 3), below));
+}
+
+RTR_BENCHMARK(MeshletBuilderThroughput)
+{
+    const RTR::Test::TestMesh mesh = OptimizeMesh(RTR::Test::MakeSphereMesh(256, 512));
+    RTR::MeshletData data;
+    const double seconds = RTR::Test::MeasureSeconds([&]()
+        {
+            RTR::MeshBuildMeshlets(data, mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), sizeof(float) * 3, mesh.GetVertexCount());
+        }, 5);
+
+    printf("  %zu tris -> %zu meshlets in %.2f ms (%.1f M tris/s, %.1f vertices per meshlet)\n", mesh.indices.size() / 3, data.meshlets.size(),
+        seconds * 1000.0, mesh.indices.size() / 3 / seconds / 1e6, (double)data.vertices.size() / data.meshlets.size());
+}
@@ -0,0 +1,89 @@
+#include "Test.h"
+
+#include <RTR/3DModells/ModelHandleTable.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+RTR_TEST(ModelHandleTableNormalizesPaths)
+{
+    // "./" and duplicate separators are dropped, a leading separator and ".." are kept
+    RTR_EXPECT(RTR::NormalizeModelPath("./models/cube.obj") == "models/cube.obj");
+    RTR_EXPECT(RTR::NormalizeModelPath("models//./cube.obj") == "models/cube.obj");
+    RTR_EXPECT(RTR::NormalizeModelPath("models/././/cube.obj") == "models/cube.obj");
+    RTR_EXPECT(RTR::NormalizeModelPath("/data//models/cube.obj") == "/data/models/cube.obj");
+    RTR_EXPECT(RTR::NormalizeModelPath("../models/cube.obj") == "../models/cube.obj");
+    RTR_EXPECT(RTR::NormalizeModelPath("models/.hidden/cube.obj") == "models/.hidden/cube.obj");
+    RTR_EXPECT(RTR::NormalizeModelPath("models/.") == "models/");
+    RTR_EXPECT(RTR::NormalizeModelPath("") == "");
+
+    // Case and backslashes only matter outside of windows
+    #ifdef _WIN32
+    RTR_EXPECT(RTR::NormalizeModelPath(".\\Models\\Cube.OBJ") == "models/cube.obj");
+    #else
+    RTR_EXPECT(RTR::NormalizeModelPath("Models/Cube.OBJ") == "Models/Cube.OBJ");
+    RTR_EXPECT(RTR::NormalizeModelPath("models\\cube.obj") == "models\\cube.obj");
+    #endif
+}
+
+RTR_TEST(ModelHandleTableRefCounts)
+{
+    RTR::ModelHandleTable table;
+    RTR_EXPECT(table.Acquire("a") == 0);
+
+    // The same key returns the same handle with one more reference
+    const uint64_t a = table.Insert("a", false);
+    const uint64_t b = table.Insert("b", false);
+    RTR_EXPECT(a && b && a != b);
+    RTR_EXPECT(table.Acquire("a") == a && table.GetRefCount(a) == 2);
+    table.AddRef(a);
+    RTR_EXPECT(table.GetRefCount(a) == 3 && table.GetCount() == 2);
+
+    // Only the last release reports the entry for removal
+    RTR_EXPECT(!table.Release(a) && !table.Release(a));
+    RTR_EXPECT(table.Release(a) && table.GetRefCount(a) == 0);
+    table.Remove(a);
+    RTR_EXPECT(table.GetCount() == 1 && table.Acquire("a") == 0);
+
+    // Unknown and removed handles are ignored
+    RTR_EXPECT(!table.Release(a) && !table.Release(12345));
+    table.AddRef(a);
+    RTR_EXPECT(table.GetRefCount(a) == 0);
+    table.Remove(a);
+
+    // A key loaded again gets a new handle (stale handles never alias it)
+    const uint64_t a2 = table.Insert("a", false);
+    RTR_EXPECT(a2 != a && table.GetRefCount(a2) == 1 && table.GetRefCount(b) == 1);
+}
+
+RTR_TEST(ModelHandleTableDefersPendingRelease)
+{
+    RTR::ModelHandleTable table;
+    const uint64_t loading = table.Insert("loading", true);
+    const uint64_t revived = table.Insert("revived", true);
+    const uint64_t loaded = table.Insert("loaded", false);
+    RTR_EXPECT(table.IsPending(loading) && !table.IsPending(loaded));
+    std::vector<uint64_t> pending = table.GetPending();
+    std::sort(pending.begin(), pending.end());
+    RTR_EXPECT(pending == std::vector<uint64_t>({ loading, revived }));
+
+    // The last release of a pending entry does not remove it
+    RTR_EXPECT(!table.Release(loading) && !table.Release(revived));
+    RTR_EXPECT(table.GetRefCount(loading) == 0 && table.GetCount() == 3);
+    RTR_EXPECT(table.GetReleased().empty());
+
+    // Acquiring a released entry before it resolved keeps it
+    RTR_EXPECT(table.Acquire("revived") == revived);
+
+    // Once resolved (the registry's Update), only the unreferenced one is reported for removal
+    table.Resolve(loading);
+    table.Resolve(revived);
+    RTR_EXPECT(table.GetPending().empty());
+    RTR_EXPECT(table.GetReleased() == std::vector<uint64_t>({ loading }));
+    table.Remove(loading);
+    RTR_EXPECT(table.GetReleased().empty() && table.GetCount() == 2);
+
+    // Resolved entries are released right away
+    RTR_EXPECT(table.Release(revived));
+}
@@ -0,0 +1,195 @@
+#include "Test.h"
+
+#include <RTR/3DModells/ModelStreamer.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Uploader that copies straight into cpu memory. Targets are std::vector<unsigned char> passed as ID3D12Resource*.
+    class FakeUploader : public RTR::IModelStreamUploader
+    {
+        public:
+            struct Upload
+            {
+                const void* ptrData;
+                uint64_t size;
+                ID3D12Resource* ptrTarget;
+                uint64_t targetOffset;
+                uint64_t batch;
+            };
+
+            uint64_t freeMemory = ~0ULL;
+            uint64_t batch = 1;
+            uint64_t finishedBatches = 0;
+            // Time every upload takes
+            std::chrono::milliseconds delay{ 0 };
+            std::vector<Upload> uploads;
+
+            uint64_t GetFreeMemory() override
+            {
+                return freeMemory;
+            }
+            bool UploadBufferData(const void* ptrData, uint64_t size, ID3D12Resource* ptrTarget, uint64_t targetOffset) override
+            {
+                if (size > freeMemory)
+                    return false;
+                freeMemory -= size;
+                if (delay.count())
+                    std::this_thread::sleep_for(delay);
+
+                std::vector<unsigned char>& target = *(std::vector<unsigned char>*)ptrTarget;
+                memcpy(target.data() + targetOffset, ptrData, (size_t)size);
+                uploads.push_back({ ptrData, size, ptrTarget, targetOffset, batch });
+                return true;
+            }
+            uint64_t GetRecordingBatch() override
+            {
+                return batch;
+            }
+            uint64_t GetFinishedBatchCount() override
+            {
+                return finishedBatches;
+            }
+    };
+
+    std::vector<unsigned char> MakeBytes(size_t size, unsigned char seed)
+    {
+        std::vector<unsigned char> bytes(size);
+        for (size_t i = 0; i < size; i++)
+            bytes[i] = (unsigned char)(seed + i * 31);
+        return bytes;
+    }
+
+    ID3D12Resource* AsTarget(std::vector<unsigned char>& target)
+    {
+        return (ID3D12Resource*)&target;
+    }
+
+    RTR::ModelStreamBudget MakeBudget(uint64_t bytesPerFrame, float msPerFrame = 1000.0f)
+    {
+        RTR::ModelStreamBudget budget;
+        budget.bytesPerFrame = bytesPerFrame;
+        budget.msPerFrame = msPerFrame;
+        return budget;
+    }
+}
+
+RTR_TEST(ModelStreamerByteBudgetSplitsCopies)
+{
+    const std::vector<unsigned char> a = MakeBytes(1000, 1), b = MakeBytes(300, 2);
+    std::vector<unsigned char> target(2000, 0);
+    RTR::ModelStreamer streamer;
+    streamer.Enqueue(1, a.data(), a.size(), AsTarget(target), 100);
+    streamer.Enqueue(2, b.data(), b.size(), AsTarget(target), 1500);
+    streamer.Enqueue(3, b.data(), 0, AsTarget(target), 0);
+    RTR_EXPECT(streamer.GetPendingCopyCount() == 2);
+
+    // 400 bytes per frame: a is split into 400 / 400 / 200, b into 200 / 100
+    FakeUploader uploader;
+    const uint64_t expectedBytes[] = { 400, 400, 400, 100 };
+    const size_t expectedPending[] = { 2, 2, 1, 0 };
+    for (int frame = 0; frame < 4; frame++)
+    {
+        const RTR::ModelStreamStats stats = streamer.Update(uploader, MakeBudget(400));
+        RTR_EXPECT(stats.bytesUploaded == expectedBytes[frame]);
+        RTR_EXPECT(stats.pendingCopies == expectedPending[frame]);
+        uploader.batch++;
+    }
+
+    // Parts continue where the previous frame stopped
+    RTR_EXPECT(uploader.uploads.size() == 5);
+    const uint64_t offsets[] = { 100, 500, 900, 1500, 1700 };
+    const uint64_t sizes[] = { 400, 400, 200, 200, 100 };
+    for (size_t i = 0; i < uploader.uploads.size() && i < 5; i++)
+        RTR_EXPECT(uploader.uploads[i].targetOffset == offsets[i] && uploader.uploads[i].size == sizes[i]);
+    RTR_EXPECT(memcmp(&target[100], a.data(), a.size()) == 0);
+    RTR_EXPECT(memcmp(&target[1500], b.data(), b.size()) == 0);
+    RTR_EXPECT(target[99] == 0 && target[1100] == 0 && target[1800] == 0);
+
+    // Nothing left to issue
+    RTR_EXPECT(streamer.Update(uploader, MakeBudget(400)).copyCount == 0);
+}
+
+RTR_TEST(ModelStreamerSplitsAtFreeUploadMemory)
+{
+    const std::vector<unsigned char> a = MakeBytes(1000, 3);
+    std::vector<unsigned char> target(1000, 0);
+    RTR::ModelStreamer streamer;
+    streamer.Enqueue(1, a.data(), a.size(), AsTarget(target), 0);
+
+    // The upload buffer limits the copy below the byte budget, a full upload buffer issues nothing
+    FakeUploader uploader;
+    uploader.freeMemory = 300;
+    RTR_EXPECT(streamer.Update(uploader, MakeBudget(1000)).bytesUploaded == 300);
+    RTR_EXPECT(streamer.Update(uploader, MakeBudget(1000)).bytesUploaded == 0);
+    RTR_EXPECT(streamer.GetPendingCopyCount() == 1);
+
+    uploader.freeMemory = 10000;
+    const RTR::ModelStreamStats stats = streamer.Update(uploader, MakeBudget(1000));
+    RTR_EXPECT(stats.bytesUploaded == 700 && stats.pendingCopies == 0);
+    RTR_EXPECT(target == a);
+}
+
+RTR_TEST(ModelStreamerTimeBudget)
+{
+    std::vector<std::vector<unsigned char>> sources;
+    std::vector<unsigned char> target(64 * 10, 0);
+    RTR::ModelStreamer streamer;
+    for (int i = 0; i < 10; i++)
+    {
+        sources.push_back(MakeBytes(64, (unsigned char)i));
+        streamer.Enqueue(i, sources.back().data(), 64, AsTarget(target), i * 64);
+    }
+
+    // A spent time budget still issues one copy per update, so streaming always progresses
+    FakeUploader uploader;
+    RTR_EXPECT(streamer.Update(uploader, MakeBudget(~0ULL, 0.0f)).copyCount == 1);
+
+    // Copies of at least 2 ms stop a 5 ms budget after the third one
+    uploader.delay = std::chrono::milliseconds(2);
+    const RTR::ModelStreamStats stats = streamer.Update(uploader, MakeBudget(~0ULL, 5.0f));
+    RTR_EXPECT(stats.copyCount >= 1 && stats.copyCount <= 3);
+    RTR_EXPECT(stats.pendingCopies == 9 - stats.copyCount);
+}
+
+RTR_TEST(ModelStreamerCompletion)
+{
+    const std::vector<unsigned char> a = MakeBytes(500, 4), b = MakeBytes(100, 5);
+    std::vector<unsigned char> target(1000, 0);
+    RTR::ModelStreamer streamer;
+    streamer.Enqueue(1, a.data(), a.size(), AsTarget(target), 0);
+    streamer.Enqueue(2, b.data(), b.size(), AsTarget(target), 500);
+
+    // Owners without copies are complete
+    FakeUploader uploader;
+    RTR_EXPECT(streamer.IsComplete(7, uploader));
+
+    // 250 bytes per batch: a is issued in batches 1 and 2, b in batch 3
+    uploader.batch = 1;
+    streamer.Update(uploader, MakeBudget(250));
+    uploader.batch = 2;
+    streamer.Update(uploader, MakeBudget(250));
+    uploader.batch = 3;
+    streamer.Update(uploader, MakeBudget(250));
+    RTR_EXPECT(streamer.GetPendingCopyCount() == 0);
+
+    // Issued is not complete, the owner waits for the batch of its last part (a: 2, b: 3)
+    RTR_EXPECT(!streamer.IsComplete(1, uploader) && !streamer.IsComplete(2, uploader));
+    uploader.finishedBatches = 2;
+    RTR_EXPECT(streamer.IsComplete(1, uploader) && !streamer.IsComplete(2, uploader));
+    uploader.finishedBatches = 3;
+    RTR_EXPECT(streamer.IsComplete(2, uploader));
+
+    // Complete owners are forgotten, so a new copy of the same owner waits for its own batch
+    streamer.Enqueue(1, b.data(), b.size(), AsTarget(target), 600);
+    RTR_EXPECT(!streamer.IsComplete(1, uploader));
+    uploader.batch = 4;
+    streamer.Update(uploader, MakeBudget(250));
+    RTR_EXPECT(!streamer.IsComplete(1, uploader));
+    uploader.finishedBatches = 4;
+    RTR_EXPECT(streamer.IsComplete(1, uploader));
+}
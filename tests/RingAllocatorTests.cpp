@@ -0,0 +1,165 @@
+#include "Test.h"
+
+#include <Util/RingAllocator.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+RTR_TEST(RingAllocatorRetiresFramesInFenceOrder)
+{
+    RTR::RingAllocator ring(1024);
+    uint64_t offset;
+
+    // Three frames of 256 bytes
+    for (uint64_t fence = 1; fence <= 3; fence++)
+    {
+        RTR_EXPECT(ring.Allocate(256, 1, &offset) && offset == (fence - 1) * 256);
+        ring.FinishFrame(fence);
+    }
+    RTR_EXPECT(ring.GetPendingFrameCount() == 3 && ring.GetUsedSize() == 768);
+
+    uint64_t oldest;
+    RTR_EXPECT(ring.GetOldestFence(&oldest) && oldest == 1);
+
+    // Nothing completed yet
+    RTR_EXPECT(ring.Retire(0) == 0 && ring.GetUsedSize() == 768);
+    // Frames retire in order up to the completed value
+    RTR_EXPECT(ring.Retire(2) == 2 && ring.GetPendingFrameCount() == 1 && ring.GetUsedSize() == 256);
+    RTR_EXPECT(ring.GetOldestFence(&oldest) && oldest == 3);
+    RTR_EXPECT(ring.Retire(2) == 0);
+    RTR_EXPECT(ring.Retire(10) == 1 && ring.GetUsedSize() == 0 && !ring.GetOldestFence(&oldest));
+
+    // Empty frames are dropped right away
+    ring.FinishFrame(11);
+    RTR_EXPECT(ring.GetPendingFrameCount() == 0);
+}
+
+RTR_TEST(RingAllocatorWrapsAndChargesSkippedTail)
+{
+    RTR::RingAllocator ring(1000);
+    uint64_t offset;
+    RTR_EXPECT(ring.Allocate(600, 1, &offset) && offset == 0);
+    ring.FinishFrame(1);
+    RTR_EXPECT(ring.Allocate(300, 1, &offset) && offset == 600);
+    ring.FinishFrame(2);
+
+    // 100 bytes left at the end and frame 1 still in flight: 200 bytes fit nowhere
+    RTR_EXPECT(!ring.Allocate(200, 1, &offset));
+
+    // Once frame 1 retired the allocation wraps to the start and the skipped tail belongs to the open frame
+    ring.Retire(1);
+    RTR_EXPECT(ring.Allocate(200, 1, &offset) && offset == 0);
+    RTR_EXPECT(ring.GetOpenFrameSize() == 300 && ring.GetUsedSize() == 600);
+    ring.FinishFrame(3);
+
+    ring.Retire(2);
+    RTR_EXPECT(ring.GetUsedSize() == 300);
+    ring.Retire(3);
+    RTR_EXPECT(ring.GetUsedSize() == 0);
+
+    // Alignment and oversized requests
+    RTR_EXPECT(ring.Allocate(10, 256, &offset) && offset % 256 == 0);
+    RTR_EXPECT(!ring.Allocate(1001, 1, &offset));
+}
+
+RTR_TEST(RingAllocatorFuzz)
+{
+    // Random allocate / finish / retire steps against a byte ownership model
+    std::mt19937 rng(7);
+    for (int run = 0; run < 100; run++)
+    {
+        const uint64_t size = 256 + rng() % 8192;
+        RTR::RingAllocator ring(size);
+        std::vector<bool> owned(size, false);
+        std::deque<std::pair<uint64_t, std::vector<std::pair<uint64_t, uint64_t>>>> frames;
+        std::vector<std::pair<uint64_t, uint64_t>> open;
+        uint64_t fence = 0, completed = 0;
+        bool valid = true;
+
+        for (int step = 0; step < 3000 && valid; step++)
+        {
+            const unsigned int operation = rng() % 10;
+            if (operation < 6)
+            {
+                const uint64_t bytes = 1 + rng() % (size / 3), alignment = 1ULL << (rng() % 9);
+                uint64_t offset;
+                if (ring.Allocate(bytes, alignment, &offset))
+                {
+                    valid = offset % alignment == 0 && offset + bytes <= size;
+                    for (uint64_t i = offset; valid && i < offset + bytes; i++)
+                    {
+                        valid = !owned[i];
+                        owned[i] = true;
+                    }
+                    open.push_back({ offset, bytes });
+                }
+                else
+                {
+                    // An empty ring always has room for anything up to its size
+                    valid = ring.GetUsedSize() != 0 || bytes + alignment - 1 > size;
+                }
+            }
+            else if (operation < 8)
+            {
+                ring.FinishFrame(++fence);
+                if (!open.empty())
+                    frames.push_back({ fence, std::move(open) });
+                open.clear();
+            }
+            else
+            {
+                completed = std::min<uint64_t>(completed + rng() % 3, fence);
+                ring.Retire(completed);
+                while (!frames.empty() && frames.front().first <= completed)
+                {
+                    for (const auto& range : frames.front().second)
+                        for (uint64_t i = range.first; i < range.first + range.second; i++)
+                            owned[i] = false;
+                    frames.pop_front();
+                }
+            }
+
+            valid = valid && ring.GetPendingFrameCount() == frames.size();
+            valid = valid && (!frames.empty() || !open.empty() || ring.GetUsedSize() == 0);
+        }
+        RTR_EXPECT(valid);
+    }
+}
+
+RTR_TEST(RingAllocatorContiguousFreeSizeIsExact)
+{
+    // In every state exactly GetContiguousFreeSize() bytes fit and one more byte does not (checked on copies of the ring)
+    std::mt19937 rng(11);
+    for (int run = 0; run < 100; run++)
+    {
+        const uint64_t size = 64 + rng() % 4000;
+        RTR::RingAllocator ring(size);
+        uint64_t fence = 0, completed = 0, offset;
+        bool exact = true;
+
+        for (int step = 0; step < 1000 && exact; step++)
+        {
+            const unsigned int operation = rng() % 10;
+            if (operation < 6)
+            {
+                const uint64_t free = ring.GetContiguousFreeSize();
+                RTR::RingAllocator fits = ring, overflows = ring;
+                exact = (free == 0 || fits.Allocate(free, 1, &offset)) && (free == size || !overflows.Allocate(free + 1, 1, &offset));
+                ring.Allocate(1 + rng() % (size / 3), 1 + rng() % 8, &offset);
+            }
+            else if (operation < 8)
+            {
+                ring.FinishFrame(++fence);
+            }
+            else
+            {
+                completed = std::min<uint64_t>(completed + rng() % 3, fence);
+                ring.Retire(completed);
+            }
+        }
+        RTR_EXPECT(exact);
+    }
+}
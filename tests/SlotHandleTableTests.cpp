@@ -0,0 +1,113 @@
+#include "Test.h"
+
+#include <RTR/3DModells/SlotHandleTable.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+RTR_TEST(SlotHandleTableStaleAfterReuse)
+{
+    RTR::SlotHandleTable<> table(4);
+    uint32_t a = 0, b = 0, c = 0;
+    const uint64_t handleA = table.Allocate(&a);
+    const uint64_t handleB = table.Allocate(&b);
+    RTR_EXPECT(handleA && handleB && handleA != handleB);
+    RTR_EXPECT(a == 0 && b == 1 && table.GetOffset(handleB) == 1);
+
+    // A freed handle is stale, also after its slot and offset were handed out again
+    RTR_EXPECT(table.Free(handleA));
+    RTR_EXPECT(!table.IsValid(handleA) && table.GetOffset(handleA) == table.InvalidOffset);
+    const uint64_t handleC = table.Allocate(&c);
+    RTR_EXPECT(c == a && (uint32_t)handleC == (uint32_t)handleA && handleC != handleA);
+    RTR_EXPECT(!table.IsValid(handleA) && table.IsValid(handleC) && table.GetOffset(handleC) == c);
+    RTR_EXPECT(!table.Free(handleA) && table.IsValid(handleC));
+
+    // Handles that were never issued are stale too
+    RTR_EXPECT(!table.IsValid(0) && !table.IsValid(12345) && !table.Free(0));
+    RTR_EXPECT(table.GetLiveCount() == 2 && table.GetUsage() == 2);
+}
+
+RTR_TEST(SlotHandleTableReusesLowestOffset)
+{
+    RTR::SlotHandleTable<> table(4);
+    uint64_t handles[4];
+    uint32_t offset;
+    for (uint64_t& handle : handles)
+        handle = table.Allocate(&offset);
+
+    // Full until something is freed, then the lowest freed offset comes first
+    RTR_EXPECT(table.Allocate(&offset) == 0);
+    table.Free(handles[3]);
+    table.Free(handles[1]);
+    RTR_EXPECT(table.Allocate(&offset) && offset == 1);
+    RTR_EXPECT(table.Allocate(&offset) && offset == 3);
+    RTR_EXPECT(table.Allocate(&offset) == 0 && table.GetLiveCount() == 4);
+}
+
+RTR_TEST(SlotHandleTableGenerationWraparound)
+{
+    // 8 bit generations wrap after 255 frees of a slot
+    RTR::SlotHandleTable<uint8_t> table(1);
+    uint32_t offset;
+    uint64_t first = table.Allocate(&offset);
+    uint64_t previous = first;
+    bool neverZero = first != 0, previousStale = true;
+    for (int i = 0; i < 300; i++)
+    {
+        table.Free(previous);
+        const uint64_t handle = table.Allocate(&offset);
+        neverZero &= handle != 0;
+        previousStale &= !table.IsValid(previous) && table.IsValid(handle);
+        previous = handle;
+    }
+    RTR_EXPECT(neverZero && previousStale);
+
+    // Generation 0 is skipped: after 255 frees the slot is back at generation 1
+    RTR::SlotHandleTable<uint8_t> wrapped(1);
+    uint64_t handle = wrapped.Allocate(&offset);
+    RTR_EXPECT(handle >> 32 == 1);
+    for (int i = 0; i < 254; i++)
+    {
+        wrapped.Free(handle);
+        handle = wrapped.Allocate(&offset);
+    }
+    RTR_EXPECT(handle >> 32 == 255);
+    wrapped.Free(handle);
+    handle = wrapped.Allocate(&offset);
+    RTR_EXPECT(handle >> 32 == 1 && wrapped.IsValid(handle));
+
+    // Generations beyond the range of the type never alias a valid one
+    RTR_EXPECT(!wrapped.IsValid(handle + (256ULL << 32)));
+}
+
+RTR_TEST(SlotHandleTableCompactRemapsHandles)
+{
+    RTR::SlotHandleTable<> table(10);
+    std::vector<uint64_t> handles;
+    uint32_t offset;
+    for (int i = 0; i < 10; i++)
+        handles.push_back(table.Allocate(&offset));
+    for (int freed : { 2, 5, 7 })
+        RTR_EXPECT(table.Free(handles[freed]));
+
+    // Live offsets slide down in order, offsets below the first hole stay
+    std::vector<std::pair<uint32_t, uint32_t>> moves;
+    const uint32_t moved = table.Compact([&](uint32_t from, uint32_t to) { moves.push_back({ from, to }); });
+    const std::vector<std::pair<uint32_t, uint32_t>> expectedMoves = { { 3, 2 }, { 4, 3 }, { 6, 4 }, { 8, 5 }, { 9, 6 } };
+    RTR_EXPECT(moved == 5 && moves == expectedMoves);
+    RTR_EXPECT(table.GetUsage() == 7 && table.GetLiveCount() == 7);
+
+    // Live handles resolve to their new offsets, freed handles stay stale
+    const int live[] = { 0, 1, 3, 4, 6, 8, 9 };
+    for (uint32_t i = 0; i < 7; i++)
+        RTR_EXPECT(table.GetOffset(handles[live[i]]) == i);
+    for (int freed : { 2, 5, 7 })
+        RTR_EXPECT(!table.IsValid(handles[freed]));
+
+    // Freed offsets are gone, allocation continues above the live range
+    RTR_EXPECT(table.Allocate(&offset) && offset == 7);
+
+    // Nothing to move the second time
+    RTR_EXPECT(table.Compact([](uint32_t, uint32_t) {}) == 0);
+}
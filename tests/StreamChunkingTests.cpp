@@ -0,0 +1,210 @@
+#include "Test.h"
+
+#include <Util/StreamChunking.h>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace
+{
+    // Linear staging buffer that copies to the target on flush (a D3DUploadBuffer in linear mode)
+    struct FakeStaging
+    {
+        std::vector<unsigned char> memory;
+        uint64_t used = 0;
+        uint64_t openReservations = 0;
+        size_t flushes = 0;
+
+        // Committed copies waiting for the next flush
+        struct Copy
+        {
+            uint64_t stagingOffset;
+            uint64_t size;
+            uint64_t targetOffset;
+        };
+        std::vector<Copy> pending;
+        std::vector<unsigned char>* ptrTarget = nullptr;
+
+        explicit FakeStaging(uint64_t size) :
+            memory((size_t)size)
+        {
+        }
+
+        void Flush()
+        {
+            for (const Copy& copy : pending)
+                memcpy(ptrTarget->data() + copy.targetOffset, memory.data() + copy.stagingOffset, (size_t)copy.size);
+            pending.clear();
+            used = 0;
+            openReservations = 0;
+            flushes++;
+        }
+    };
+
+    // The linear mode loop of D3DUploadBuffer::StreamBufferData
+    bool Stream(FakeStaging& staging, uint64_t size, uint64_t chunkSize, const std::function<bool(unsigned char*, uint64_t, uint64_t)>& producer,
+        std::vector<uint64_t>* ptrChunkSizesOut = nullptr)
+    {
+        uint64_t streamed = 0;
+        while (streamed < size)
+        {
+            const RTR::StreamChunk chunk = RTR::PlanStreamChunk(size, streamed, chunkSize, staging.memory.size(), staging.memory.size() - staging.used, staging.openReservations, false);
+            if (!chunk.size)
+                return false;
+            if (chunk.flushBefore)
+                staging.Flush();
+
+            unsigned char* ptrChunk = staging.memory.data() + staging.used;
+            staging.used += chunk.size;
+            staging.openReservations++;
+            if (!producer(ptrChunk, chunk.offset, chunk.size))
+            {
+                staging.openReservations--;
+                return false;
+            }
+            staging.pending.push_back({ (uint64_t)(ptrChunk - staging.memory.data()), chunk.size, chunk.offset });
+            staging.openReservations--;
+            streamed += chunk.size;
+            if (ptrChunkSizesOut)
+                ptrChunkSizesOut->push_back(chunk.size);
+        }
+        return true;
+    }
+
+    std::vector<unsigned char> MakeSource(size_t size)
+    {
+        std::vector<unsigned char> source(size);
+        for (size_t i = 0; i < size; i++)
+            source[i] = (unsigned char)(i * 7 + 3);
+        return source;
+    }
+}
+
+RTR_TEST(StreamChunkingPlansLinear)
+{
+    // 1000 bytes in chunks of 300 through an empty 1024 byte buffer: offsets continue, the last chunk is the remainder
+    RTR::StreamChunk chunk = RTR::PlanStreamChunk(1000, 0, 300, 1024, 1024, 0, false);
+    RTR_EXPECT(chunk.offset == 0 && chunk.size == 300 && !chunk.flushBefore && !chunk.executeAfter);
+    chunk = RTR::PlanStreamChunk(1000, 900, 300, 1024, 124, 0, false);
+    RTR_EXPECT(chunk.offset == 900 && chunk.size == 100 && !chunk.flushBefore);
+
+    // The chunk is cut to what is left of the buffer, a full buffer is flushed first and then offers all of it
+    chunk = RTR::PlanStreamChunk(1000, 300, 300, 1024, 50, 0, false);
+    RTR_EXPECT(chunk.size == 50 && !chunk.flushBefore);
+    chunk = RTR::PlanStreamChunk(1000, 350, 300, 1024, 0, 0, false);
+    RTR_EXPECT(chunk.size == 300 && chunk.flushBefore);
+
+    // A full buffer with reservations of other threads stops instead of flushing them away
+    chunk = RTR::PlanStreamChunk(1000, 350, 300, 1024, 0, 1, false);
+    RTR_EXPECT(chunk.size == 0);
+    chunk = RTR::PlanStreamChunk(1000, 350, 300, 1024, 100, 1, false);
+    RTR_EXPECT(chunk.size == 100 && !chunk.flushBefore);
+
+    // Chunk size 0 is a quarter of the buffer, a complete stream plans nothing
+    RTR_EXPECT(RTR::PlanStreamChunk(1000, 0, 0, 1024, 1024, 0, false).size == 256);
+    RTR_EXPECT(RTR::PlanStreamChunk(1000, 0, 0, 2, 2, 0, false).size == 1);
+    RTR_EXPECT(RTR::PlanStreamChunk(1000, 1000, 300, 1024, 1024, 0, false).size == 0);
+}
+
+RTR_TEST(StreamChunkingPlansRing)
+{
+    // Full chunks regardless of the free memory (the ring waits for room), executed between chunks but not after the last one
+    RTR::StreamChunk chunk = RTR::PlanStreamChunk(1000, 0, 300, 1024, 0, 2, true);
+    RTR_EXPECT(chunk.size == 300 && !chunk.flushBefore && chunk.executeAfter);
+    chunk = RTR::PlanStreamChunk(1000, 600, 300, 1024, 0, 0, true);
+    RTR_EXPECT(chunk.size == 300 && chunk.executeAfter);
+    chunk = RTR::PlanStreamChunk(1000, 900, 300, 1024, 0, 0, true);
+    RTR_EXPECT(chunk.offset == 900 && chunk.size == 100 && !chunk.executeAfter);
+}
+
+RTR_TEST(StreamChunkingOddSizes)
+{
+    // Sizes that are no multiple of the chunk or the buffer arrive complete and in order
+    for (uint64_t size : { 1ULL, 255ULL, 257ULL, 1000ULL, 4097ULL, 10007ULL })
+    {
+        for (uint64_t chunkSize : { 0ULL, 1ULL, 100ULL, 333ULL })
+        {
+            const std::vector<unsigned char> source = MakeSource((size_t)size);
+            std::vector<unsigned char> target((size_t)size, 0);
+            FakeStaging staging(1024);
+            staging.ptrTarget = &target;
+
+            // Leave the buffer partially used so chunks get cut at its end
+            staging.used = 1000;
+
+            std::vector<uint64_t> chunkSizes;
+            const bool streamed = Stream(staging, size, chunkSize, [&](unsigned char* ptrChunk, uint64_t offset, uint64_t chunk)
+                {
+                    memcpy(ptrChunk, source.data() + offset, (size_t)chunk);
+                    return true;
+                }, &chunkSizes);
+            staging.Flush();
+
+            uint64_t total = 0;
+            bool withinLimits = true;
+            for (uint64_t chunk : chunkSizes)
+            {
+                total += chunk;
+                withinLimits &= chunk && chunk <= (chunkSize ? chunkSize : 256);
+            }
+            RTR_EXPECT(streamed && total == size && withinLimits && target == source);
+            RTR_EXPECT(staging.openReservations == 0);
+        }
+    }
+}
+
+RTR_TEST(StreamChunkingProducerFailure)
+{
+    const std::vector<unsigned char> source = MakeSource(2000);
+    std::vector<unsigned char> target(2000, 0);
+    FakeStaging staging(1024);
+    staging.ptrTarget = &target;
+
+    // The third chunk fails: the stream stops, its reservation is released and nothing after it is produced
+    int calls = 0;
+    const bool streamed = Stream(staging, 2000, 300, [&](unsigned char* ptrChunk, uint64_t offset, uint64_t chunk)
+        {
+            if (++calls == 3)
+                return false;
+            memcpy(ptrChunk, source.data() + offset, (size_t)chunk);
+            return true;
+        });
+    RTR_EXPECT(!streamed && calls == 3);
+    RTR_EXPECT(staging.openReservations == 0 && staging.pending.size() == 2);
+
+    // The chunks before the failure still arrive
+    staging.Flush();
+    RTR_EXPECT(memcmp(target.data(), source.data(), 600) == 0 && target[600] == 0 && target[1999] == 0);
+}
+
+RTR_TEST(StreamChunkingKeepsOtherReservations)
+{
+    const std::vector<unsigned char> source = MakeSource(2000);
+    std::vector<unsigned char> target(2000, 0);
+    FakeStaging staging(1024);
+    staging.ptrTarget = &target;
+
+    // Another thread holds a reservation: the stream uses the free memory, then stops instead of flushing
+    staging.used = 24;
+    staging.openReservations = 1;
+    const bool streamed = Stream(staging, 2000, 300, [&](unsigned char* ptrChunk, uint64_t offset, uint64_t chunk)
+        {
+            memcpy(ptrChunk, source.data() + offset, (size_t)chunk);
+            return true;
+        });
+    RTR_EXPECT(!streamed && staging.flushes == 0 && staging.openReservations == 1 && staging.used == 1024);
+
+    // Without it the same stream flushes as often as needed
+    staging.openReservations = 0;
+    staging.Flush();
+    staging.flushes = 0;
+    RTR_EXPECT(Stream(staging, 2000, 300, [&](unsigned char* ptrChunk, uint64_t offset, uint64_t chunk)
+        {
+            memcpy(ptrChunk, source.data() + offset, (size_t)chunk);
+            return true;
+        }));
+    staging.Flush();
+    RTR_EXPECT(staging.flushes == 2 && target == source);
+}
@@ -0,0 +1,87 @@
+#include "Test.h"
+
+#include <Util/StreamCopy.h>
+#include <Util/WorkerPool.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Copy size bytes with the given misalignments and check the copy and the guard bytes around it
+    bool CopyMatches(const std::vector<unsigned char>& source, std::vector<unsigned char>& dest, size_t sourceOffset, size_t destOffset, size_t size, RTR::WorkerPool* ptrPool = nullptr)
+    {
+        std::fill(dest.begin(), dest.end(), 0xCD);
+        if (ptrPool)
+            RTR::StreamCopyParallel(*ptrPool, &dest[destOffset], &source[sourceOffset], size, 4096);
+        else
+            RTR::StreamCopy(&dest[destOffset], &source[sourceOffset], size);
+
+        return memcmp(&dest[destOffset], &source[sourceOffset], size) == 0 &&
+            (!destOffset || dest[destOffset - 1] == 0xCD) && dest[destOffset + size] == 0xCD;
+    }
+
+    std::vector<unsigned char> MakeBytes(size_t size, unsigned int seed)
+    {
+        std::vector<unsigned char> bytes(size);
+        std::mt19937 rng(seed);
+        for (auto& byte : bytes)
+            byte = (unsigned char)rng();
+        return bytes;
+    }
+}
+
+RTR_TEST(StreamCopyAllSizesAndAlignments)
+{
+    const std::vector<unsigned char> source = MakeBytes(1 << 16, 1);
+    std::vector<unsigned char> dest((1 << 16) + 128);
+
+    // Every size around the memcpy threshold and the SIMD block widths, with every misalignment of source and destination
+    bool correct = true;
+    for (size_t size = 0; size <= RTR::StreamCopyMinSize + 300 && correct; size++)
+        for (size_t sourceOffset = 0; sourceOffset < 64 && correct; sourceOffset += 7)
+            for (size_t destOffset = 0; destOffset < 64 && correct; destOffset += 5)
+                correct = CopyMatches(source, dest, sourceOffset, destOffset, size);
+    RTR_EXPECT(correct);
+
+    // Random large copies
+    std::mt19937 rng(2);
+    for (int i = 0; i < 2000 && correct; i++)
+        correct = CopyMatches(source, dest, rng() % 64, rng() % 64, rng() % 60000);
+    RTR_EXPECT(correct);
+}
+
+RTR_TEST(StreamCopyParallelMatches)
+{
+    RTR::WorkerPool pool(4);
+    const std::vector<unsigned char> source = MakeBytes(1 << 20, 3);
+    std::vector<unsigned char> dest((1 << 20) + 128);
+
+    // Below, at and above the block threshold, with uneven sizes and misaligned ends
+    for (size_t size : { 0, 100, 4095, 4096, 8191, 8192, 100000, (1 << 20) - 64 })
+        RTR_EXPECT(CopyMatches(source, dest, 3, 61, size, &pool));
+}
+
+RTR_BENCHMARK(StreamCopyBandwidth)
+{
+    RTR::WorkerPool pool(4);
+    const size_t maxSize = 64 << 20;
+    const std::vector<unsigned char> source = MakeBytes(maxSize, 4);
+    std::vector<unsigned char> dest(maxSize);
+
+    // GB/s of memcpy, the streaming copy and the parallel streaming copy (into regular memory here, upload heaps are write
+    // combined, where the streaming stores gain the most)
+    printf("  size KiB  memcpy GB/s  stream GB/s  parallel(4) GB/s\n");
+    for (size_t size : { (size_t)64 << 10, (size_t)1 << 20, (size_t)16 << 20, maxSize })
+    {
+        const size_t repetitions = std::max<size_t>(2, ((size_t)512 << 20) / size);
+        const double copied = (double)size / 1e9;
+        const double memcpySeconds = RTR::Test::MeasureSeconds([&]() { memcpy(dest.data(), source.data(), size); }, repetitions);
+        const double streamSeconds = RTR::Test::MeasureSeconds([&]() { RTR::StreamCopy(dest.data(), source.data(), size); }, repetitions);
+        const double parallelSeconds = RTR::Test::MeasureSeconds([&]() { RTR::StreamCopyParallel(pool, dest.data(), source.data(), size); }, repetitions);
+        printf("  %8zu  %11.1f  %11.1f  %16.1f\n", size >> 10, copied / memcpySeconds, copied / streamSeconds, copied / parallelSeconds);
+    }
+}
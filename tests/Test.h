@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace RTR
+{
+    namespace Test
+    {
+        // Registered test or benchmark (benchmarks only run with --bench)
+        struct Case
+        {
+            const char* name;
+            void(*func)();
+            bool isBenchmark;
+        };
+
+        // All cases in registration order
+        std::vector<Case>& GetCases();
+
+        // Registers a case at static initialization
+        struct Registrar
+        {
+            Registrar(const char* name, void(*func)(), bool isBenchmark);
+        };
+
+        // Record a failed expectation of the running case
+        void ReportFailure(const char* file, int line, const char* expression);
+
+        // Average seconds of one func() call over repetitions calls (after one warm up call)
+        template<typename F>
+        double MeasureSeconds(F&& func, size_t repetitions = 1)
+        {
+            func();
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < repetitions; i++)
+                func();
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / (double)repetitions;
+        }
+    }
+}
+
+// Define a test / benchmark case
+#define RTR_TEST(name) \
+    static void name(); \
+    static RTR::Test::Registrar name##Registrar(#name, &name, false); \
+    static void name()
+#define RTR_BENCHMARK(name) \
+    static void name(); \
+    static RTR::Test::Registrar name##Registrar(#name, &name, true); \
+    static void name()
+
+// Expectation (the case continues after a failure)
+#define RTR_EXPECT(expression) \
+    do { if (!(expression)) RTR::Test::ReportFailure(__FILE__, __LINE__, #expression); } while (0)
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cmath>
+
+namespace RTR
+{
+    namespace Test
+    {
+        // Row major 4x4 with row vectors (DirectXMath convention)
+        struct Matrix
+        {
+            float m[16];
+        };
+
+        // Left handed perspective projection (D3D clip space 0 <= z <= w)
+        inline Matrix MakePerspective(float fovY, float aspect, float nearZ, float farZ)
+        {
+            const float yScale = 1.0f / std::tan(fovY * 0.5f);
+            const float zScale = farZ / (farZ - nearZ);
+            return { {
+                yScale / aspect, 0.0f, 0.0f, 0.0f,
+                0.0f, yScale, 0.0f, 0.0f,
+                0.0f, 0.0f, zScale, 1.0f,
+                0.0f, 0.0f, -nearZ * zScale, 0.0f,
+            } };
+        }
+
+        // View of a camera at position looking along +z after a rotation of yaw radians around y
+        inline Matrix MakeView(float x, float y, float z, float yaw)
+        {
+            const float c = std::cos(yaw), s = std::sin(yaw);
+            return { {
+                c, 0.0f, s, 0.0f,
+                0.0f, 1.0f, 0.0f, 0.0f,
+                -s, 0.0f, c, 0.0f,
+                -(x * c - z * s), -y, -(x * s + z * c), 1.0f,
+            } };
+        }
+
+        // a * b
+        inline Matrix Multiply(const Matrix& a, const Matrix& b)
+        {
+            Matrix result = {};
+            for (int r = 0; r < 4; r++)
+                for (int c = 0; c < 4; c++)
+                    for (int k = 0; k < 4; k++)
+                        result.m[r * 4 + c] += a.m[r * 4 + k] * b.m[k * 4 + c];
+            return result;
+        }
+    }
+}
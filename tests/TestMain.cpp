@@ -0,0 +1,60 @@
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    size_t s_failures = 0;
+}
+
+std::vector<RTR::Test::Case>& RTR::Test::GetCases()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+RTR::Test::Registrar::Registrar(const char* name, void(*func)(), bool isBenchmark)
+{
+    GetCases().push_back({ name, func, isBenchmark });
+}
+
+void RTR::Test::ReportFailure(const char* file, int line, const char* expression)
+{
+    // Only the first failures of a case are interesting
+    if (s_failures++ < 16)
+        printf("    %s(%d): expected %s\n", file, line, expression);
+}
+
+// Usage: RealTimeRenderingTests [--bench] [name filter]
+int main(int argc, char** argv)
+{
+    bool runBenchmarks = false;
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--bench"))
+            runBenchmarks = true;
+        else
+            filter = argv[i];
+    }
+
+    size_t failedCases = 0;
+    size_t ranCases = 0;
+    for (const auto& testCase : RTR::Test::GetCases())
+    {
+        if (testCase.isBenchmark != runBenchmarks || (filter && !strstr(testCase.name, filter)))
+            continue;
+
+        printf("[ RUN  ] %s\n", testCase.name);
+        fflush(stdout);
+        s_failures = 0;
+        testCase.func();
+        printf(s_failures ? "[ FAIL ] %s\n" : "[  OK  ] %s\n", testCase.name);
+        failedCases += s_failures ? 1 : 0;
+        ranCases++;
+    }
+
+    printf("%zu of %zu cases passed\n", ranCases - failedCases, ranCases);
+    return failedCases ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace RTR
+{
+    namespace Test
+    {
+        // Indexed triangle list with xyz positions
+        struct TestMesh
+        {
+            std::vector<float> positions;
+            std::vector<uint32_t> indices;
+
+            inline size_t GetVertexCount() const
+            {
+                return positions.size() / 3;
+            }
+        };
+
+        // Flat grid of (width + 1) * (height + 1) vertices in the xz plane
+        inline TestMesh MakeGridMesh(uint32_t width, uint32_t height)
+        {
+            TestMesh mesh;
+            for (uint32_t z = 0; z <= height; z++)
+            {
+                for (uint32_t x = 0; x <= width; x++)
+                {
+                    mesh.positions.insert(mesh.positions.end(), { (float)x, 0.0f, (float)z });
+                }
+            }
+            for (uint32_t z = 0; z < height; z++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    const uint32_t i = z * (width + 1) + x;
+                    mesh.indices.insert(mesh.indices.end(), { i, i + width + 1, i + 1, i + 1, i + width + 1, i + width + 2 });
+                }
+            }
+            return mesh;
+        }
+
+        // Closed unit sphere (rings * segments quads, poles collapsed into single vertices)
+        inline TestMesh MakeSphereMesh(uint32_t rings, uint32_t segments)
+        {
+            TestMesh mesh;
+            const float pi = 3.14159265f;
+            mesh.positions.insert(mesh.positions.end(), { 0.0f, 1.0f, 0.0f });
+            for (uint32_t r = 1; r < rings; r++)
+            {
+                const float theta = pi * r / rings;
+                for (uint32_t s = 0; s < segments; s++)
+                {
+                    const float phi = 2.0f * pi * s / segments;
+                    mesh.positions.insert(mesh.positions.end(), { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+                }
+            }
+            mesh.positions.insert(mesh.positions.end(), { 0.0f, -1.0f, 0.0f });
+
+            const uint32_t bottom = (uint32_t)mesh.GetVertexCount() - 1;
+            auto ring = [segments](uint32_t r, uint32_t s) { return 1 + (r - 1) * segments + s % segments; };
+            for (uint32_t s = 0; s < segments; s++)
+            {
+                mesh.indices.insert(mesh.indices.end(), { 0, ring(1, s + 1), ring(1, s) });
+                mesh.indices.insert(mesh.indices.end(), { bottom, ring(rings - 1, s), ring(rings - 1, s + 1) });
+            }
+            for (uint32_t r = 1; r + 1 < rings; r++)
+            {
+                for (uint32_t s = 0; s < segments; s++)
+                {
+                    const uint32_t a = ring(r, s), b = ring(r, s + 1), c = ring(r + 1, s), d = ring(r + 1, s + 1);
+                    mesh.indices.insert(mesh.indices.end(), { a, b, c, b, d, c });
+                }
+            }
+            return mesh;
+        }
+    }
+}
@@ -0,0 +1,158 @@
+#include "Test.h"
+
+#include <Util/TlsfAllocator.h>
+
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <random>
+
+RTR_TEST(TlsfAllocatorBasics)
+{
+    RTR::TlsfAllocator allocator(1000);
+    RTR_EXPECT(allocator.Validate() && allocator.GetLargestFreeBlock() == 1000);
+
+    uint64_t a, b, c;
+    RTR_EXPECT(allocator.Allocate(100, 1, &a) && a == 0);
+    RTR_EXPECT(allocator.Allocate(10, 64, &b) && b % 64 == 0 && b >= 100);
+    RTR_EXPECT(allocator.Allocate(0, 1, &c));
+    RTR_EXPECT(allocator.GetAllocationCount() == 3 && allocator.GetUsedSize() == 111);
+    RTR_EXPECT(!allocator.Allocate(1000, 1, &c));
+    RTR_EXPECT(allocator.Validate());
+
+    // Unknown offsets are rejected, freeing merges everything back
+    RTR_EXPECT(!allocator.Free(a + 1));
+    RTR_EXPECT(allocator.Free(a) && allocator.Free(b) && allocator.Free(c));
+    RTR_EXPECT(!allocator.Free(a));
+    RTR_EXPECT(allocator.Validate() && allocator.GetUsedSize() == 0 && allocator.GetLargestFreeBlock() == 1000);
+}
+
+RTR_TEST(TlsfAllocatorRelocate)
+{
+    RTR::TlsfAllocator allocator(4096);
+    uint64_t low, mid, high;
+    // Unaligned so the hole is an exact fit (aligned requests search for size + alignment - 1 bytes)
+    RTR_EXPECT(allocator.Allocate(256, 1, &low) && allocator.Allocate(256, 1, &mid) && allocator.Allocate(256, 1, &high));
+    RTR_EXPECT(allocator.Free(low));
+
+    // The highest allocation moves into the hole, both ranges stay allocated until the old one is freed
+    uint64_t moved;
+    RTR_EXPECT(allocator.Relocate(high, &moved) && moved == low);
+    RTR_EXPECT(allocator.GetAllocationCount() == 3 && allocator.Validate());
+    RTR_EXPECT(allocator.Free(high) && allocator.Validate());
+
+    // Nothing lower fits anymore
+    RTR_EXPECT(!allocator.Relocate(mid, &moved));
+    RTR_EXPECT(!allocator.Relocate(12345, &moved));
+}
+
+RTR_TEST(TlsfAllocatorFuzz)
+{
+    // Random allocate / free / relocate against a reference map of live ranges
+    std::mt19937_64 rng(1);
+    for (int run = 0; run < 40; run++)
+    {
+        const uint64_t size = 1 + rng() % (run < 10 ? 1000 : 1 << 24);
+        RTR::TlsfAllocator allocator(size);
+        std::map<uint64_t, uint64_t> live;
+        bool valid = true;
+
+        for (int step = 0; step < 10000 && valid; step++)
+        {
+            const unsigned int operation = rng() % 10;
+            if (operation < 5)
+            {
+                const uint64_t bytes = rng() % (size / 8 + 1);
+                const uint64_t alignment = rng() % 3 ? 1ULL << (rng() % 8) : 1 + rng() % 40;
+                uint64_t offset;
+                if (allocator.Allocate(bytes, alignment, &offset))
+                {
+                    // Aligned, inside the range and not overlapping a live allocation
+                    const uint64_t used = bytes ? bytes : 1;
+                    auto next = live.lower_bound(offset);
+                    valid = offset % alignment == 0 && offset + used <= size &&
+                        (next == live.end() || next->first >= offset + used) &&
+                        (next == live.begin() || std::prev(next)->first + std::prev(next)->second <= offset);
+                    live[offset] = used;
+                }
+            }
+            else if (operation < 9 && !live.empty())
+            {
+                auto it = live.begin();
+                std::advance(it, rng() % live.size());
+                valid = allocator.Free(it->first);
+                live.erase(it);
+            }
+            else if (!live.empty())
+            {
+                // Relocate the highest allocation like ModelContext::Defragment
+                auto it = std::prev(live.end());
+                uint64_t offset;
+                if (allocator.Relocate(it->first, &offset))
+                {
+                    const uint64_t used = it->second;
+                    valid = offset < it->first && allocator.Free(it->first);
+                    live.erase(it);
+                    live[offset] = used;
+                }
+            }
+
+            if (step % 499 == 0)
+                valid = valid && allocator.Validate();
+        }
+        RTR_EXPECT(valid && allocator.Validate());
+        RTR_EXPECT(allocator.GetAllocationCount() == live.size());
+
+        // Everything merges back into one block
+        for (const auto& entry : live)
+            allocator.Free(entry.first);
+        RTR_EXPECT(allocator.Validate() && allocator.GetUsedSize() == 0 && allocator.GetLargestFreeBlock() == size);
+    }
+}
+
+RTR_BENCHMARK(TlsfAllocatorThroughput)
+{
+    RTR::TlsfAllocator allocator(1ULL << 32);
+    std::vector<uint64_t> offsets(100000);
+    std::mt19937 rng(2);
+    std::vector<uint64_t> sizes(offsets.size());
+    for (auto& size : sizes)
+        size = 16 + rng() % 4096;
+
+    const double seconds = RTR::Test::MeasureSeconds([&]()
+        {
+            for (size_t i = 0; i < offsets.size(); i++)
+                allocator.Allocate(sizes[i], 4, &offsets[i]);
+            for (uint64_t offset : offsets)
+                allocator.Free(offset);
+        }, 10);
+
+    printf("  %.1f ns per allocate + free\n", seconds * 1e9 / offsets.size());
+}
+
+RTR_TEST(TlsfAllocatorFragmentation)
+{
+    // One free block (or none) is not fragmented
+    RTR::TlsfAllocator allocator(1000);
+    RTR_EXPECT(allocator.GetFragmentation() == 0.0);
+    uint64_t offsets[10];
+    for (uint64_t& offset : offsets)
+        RTR_EXPECT(allocator.Allocate(100, 1, &offset));
+    RTR_EXPECT(allocator.GetFragmentation() == 0.0);
+
+    // Freeing the top merges into one block, holes below it scatter the free memory
+    allocator.Free(offsets[9]);
+    RTR_EXPECT(allocator.GetFragmentation() == 0.0);
+    allocator.Free(offsets[1]);
+    allocator.Free(offsets[3]);
+    allocator.Free(offsets[5]);
+    RTR_EXPECT(allocator.GetFragmentation() == 0.75);
+
+    // Merging neighbours grows the largest block (300 of 500 free bytes), freeing everything makes it one block again
+    allocator.Free(offsets[4]);
+    RTR_EXPECT(std::abs(allocator.GetFragmentation() - 0.4) < 1e-9);
+    for (int i : { 0, 2, 6, 7, 8 })
+        allocator.Free(offsets[i]);
+    RTR_EXPECT(allocator.GetFragmentation() == 0.0 && allocator.Validate());
+}
@@ -0,0 +1,205 @@
+#include "Test.h"
+#include "TestCamera.h"
+
+#include <RTR/3DModells/TransformBatch.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // SoA transforms with random unit quaternions
+    struct TestTransforms
+    {
+        std::vector<float> position[3], rotation[4], scale[3];
+
+        TestTransforms(size_t count, unsigned int seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> position01(-50.0f, 50.0f), unit(-1.0f, 1.0f), scale01(0.1f, 4.0f);
+            for (size_t i = 0; i < count; i++)
+            {
+                float q[4] = { unit(rng), unit(rng), unit(rng), unit(rng) };
+                const float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]) + 1e-6f;
+                for (size_t k = 0; k < 4; k++)
+                    rotation[k].push_back(q[k] / length);
+                for (size_t k = 0; k < 3; k++)
+                {
+                    position[k].push_back(position01(rng));
+                    scale[k].push_back(scale01(rng));
+                }
+            }
+        }
+
+        RTR::TransformBatch GetBatch() const
+        {
+            RTR::TransformBatch batch;
+            batch.ptrPositionX = position[0].data();
+            batch.ptrPositionY = position[1].data();
+            batch.ptrPositionZ = position[2].data();
+            batch.ptrRotationX = rotation[0].data();
+            batch.ptrRotationY = rotation[1].data();
+            batch.ptrRotationZ = rotation[2].data();
+            batch.ptrRotationW = rotation[3].data();
+            batch.ptrScaleX = scale[0].data();
+            batch.ptrScaleY = scale[1].data();
+            batch.ptrScaleZ = scale[2].data();
+            return batch;
+        }
+
+        // XMMatrixScaling * XMMatrixRotationQuaternion * XMMatrixTranslation in double precision (row major, row vectors)
+        void GetWorld(size_t i, double* ptrOut) const
+        {
+            const double x = rotation[0][i], y = rotation[1][i], z = rotation[2][i], w = rotation[3][i];
+            const double r[3][3] = {
+                { 1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y + z * w), 2.0 * (x * z - y * w) },
+                { 2.0 * (x * y - z * w), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z + x * w) },
+                { 2.0 * (x * z + y * w), 2.0 * (y * z - x * w), 1.0 - 2.0 * (x * x + y * y) },
+            };
+            for (size_t row = 0; row < 3; row++)
+            {
+                for (size_t c = 0; c < 3; c++)
+                    ptrOut[row * 4 + c] = r[row][c] * scale[row][i];
+                ptrOut[row * 4 + 3] = 0.0;
+            }
+            for (size_t c = 0; c < 3; c++)
+                ptrOut[12 + c] = position[c][i];
+            ptrOut[15] = 1.0;
+        }
+    };
+
+    // Largest absolute difference relative to the magnitude of the expected values
+    double MaxRelativeError(const float* actual, const double* expected, size_t count)
+    {
+        double magnitude = 1.0, error = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            magnitude = std::max(magnitude, std::abs(expected[i]));
+            error = std::max(error, std::abs(actual[i] - expected[i]));
+        }
+        return error / magnitude;
+    }
+
+    // Offsets that scatter the output (every transform goes somewhere else)
+    std::vector<uint32_t> MakeOffsets(size_t count, unsigned int seed)
+    {
+        std::vector<uint32_t> offsets(count);
+        std::iota(offsets.begin(), offsets.end(), 0);
+        std::shuffle(offsets.begin(), offsets.end(), std::mt19937(seed));
+        return offsets;
+    }
+}
+
+RTR_TEST(TransformBatchComposeMatchesReference)
+{
+    const size_t count = 1003;
+    const TestTransforms transforms(count, 1);
+    const RTR::TransformBatch batch = transforms.GetBatch();
+    const std::vector<uint32_t> offsets = MakeOffsets(count, 2);
+
+    for (size_t matrixFloats : { 16, 12 })
+    {
+        // A range that starts and ends off the SIMD width
+        const size_t begin = 3, end = count - 2;
+        std::vector<float> simd(count * matrixFloats, -1.0f), scalar(count * matrixFloats, -1.0f);
+        RTR::TransformBatchCompose(batch, begin, end, offsets.data(), simd.data(), matrixFloats);
+        RTR::TransformBatchComposeScalar(batch, begin, end, offsets.data(), scalar.data(), matrixFloats);
+
+        double worstSimd = 0.0, worstScalar = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const float* ptrSimd = &simd[offsets[i] * matrixFloats];
+            const float* ptrScalar = &scalar[offsets[i] * matrixFloats];
+            if (i < begin || i >= end)
+            {
+                // Untouched outside the range
+                RTR_EXPECT(ptrSimd[0] == -1.0f && ptrScalar[0] == -1.0f);
+                continue;
+            }
+
+            // Stored transposed
+            double world[16], expected[16];
+            transforms.GetWorld(i, world);
+            for (size_t r = 0; r < 4; r++)
+                for (size_t c = 0; c < 4; c++)
+                    expected[r * 4 + c] = world[c * 4 + r];
+            worstSimd = std::max(worstSimd, MaxRelativeError(ptrSimd, expected, matrixFloats));
+            worstScalar = std::max(worstScalar, MaxRelativeError(ptrScalar, expected, matrixFloats));
+        }
+        RTR_EXPECT(worstSimd < 1e-5);
+        RTR_EXPECT(worstScalar < 1e-5);
+    }
+}
+
+RTR_TEST(TransformBatchConcatenateMatchesReference)
+{
+    const size_t count = 517;
+    const TestTransforms transforms(count, 3);
+    const std::vector<uint32_t> offsets = MakeOffsets(count, 4);
+    const RTR::Test::Matrix viewProjection = RTR::Test::Multiply(RTR::Test::MakeView(1.0f, 2.0f, -30.0f, 0.3f), RTR::Test::MakePerspective(1.0f, 16.0f / 9.0f, 0.1f, 500.0f));
+
+    for (size_t matrixFloats : { 16, 12 })
+    {
+        // Transposed world matrices as stored by MatrixBuffer
+        std::vector<float> worlds(count * matrixFloats);
+        RTR::TransformBatchComposeScalar(transforms.GetBatch(), 0, count, offsets.data(), worlds.data(), matrixFloats);
+
+        std::vector<float> simd(count * 16), scalar(count * 16);
+        RTR::TransformBatchConcatenate(worlds.data(), matrixFloats, offsets.data(), 1, count, viewProjection.m, simd.data());
+        RTR::TransformBatchConcatenateScalar(worlds.data(), matrixFloats, offsets.data(), 1, count, viewProjection.m, scalar.data());
+
+        double worstSimd = 0.0, worstScalar = 0.0;
+        for (size_t i = 1; i < count; i++)
+        {
+            // transpose(world * viewProjection) in double precision
+            double world[16], expected[16];
+            transforms.GetWorld(i, world);
+            for (size_t r = 0; r < 4; r++)
+            {
+                for (size_t c = 0; c < 4; c++)
+                {
+                    double sum = 0.0;
+                    for (size_t k = 0; k < 4; k++)
+                        sum += world[r * 4 + k] * viewProjection.m[k * 4 + c];
+                    expected[c * 4 + r] = sum;
+                }
+            }
+            worstSimd = std::max(worstSimd, MaxRelativeError(&simd[i * 16], expected, 16));
+            worstScalar = std::max(worstScalar, MaxRelativeError(&scalar[i * 16], expected, 16));
+        }
+        RTR_EXPECT(worstSimd < 1e-5);
+        RTR_EXPECT(worstScalar < 1e-5);
+    }
+}
+
+RTR_BENCHMARK(TransformBatchThroughput)
+{
+    const size_t count = 100000;
+    const TestTransforms transforms(count, 5);
+    const RTR::TransformBatch batch = transforms.GetBatch();
+    std::vector<uint32_t> offsets(count);
+    std::iota(offsets.begin(), offsets.end(), 0);
+    std::vector<float> worlds(count * 16), mvp(count * 16);
+    const RTR::Test::Matrix viewProjection = RTR::Test::MakePerspective(1.0f, 1.0f, 0.1f, 100.0f);
+
+    for (size_t matrixFloats : { 16, 12 })
+    {
+        // One call per object like the old per matrix path, then the batched scalar and SIMD versions
+        const double perObject = RTR::Test::MeasureSeconds([&]()
+            {
+                for (size_t i = 0; i < count; i++)
+                    RTR::TransformBatchComposeScalar(batch, i, i + 1, offsets.data(), worlds.data(), matrixFloats);
+            }, 10);
+        const double scalar = RTR::Test::MeasureSeconds([&]() { RTR::TransformBatchComposeScalar(batch, 0, count, offsets.data(), worlds.data(), matrixFloats); }, 10);
+        const double simd = RTR::Test::MeasureSeconds([&]() { RTR::TransformBatchCompose(batch, 0, count, offsets.data(), worlds.data(), matrixFloats); }, 10);
+        printf("  compose %zu floats      per object %6.2f ms  scalar %6.2f ms  SIMD %6.2f ms\n", matrixFloats, perObject * 1e3, scalar * 1e3, simd * 1e3);
+
+        const double concatScalar = RTR::Test::MeasureSeconds([&]() { RTR::TransformBatchConcatenateScalar(worlds.data(), matrixFloats, offsets.data(), 0, count, viewProjection.m, mvp.data()); }, 10);
+        const double concatSimd = RTR::Test::MeasureSeconds([&]() { RTR::TransformBatchConcatenate(worlds.data(), matrixFloats, offsets.data(), 0, count, viewProjection.m, mvp.data()); }, 10);
+        printf("  concatenate %zu floats  scalar %6.2f ms  SIMD %6.2f ms\n", matrixFloats, concatScalar * 1e3, concatSimd * 1e3);
+    }
+}
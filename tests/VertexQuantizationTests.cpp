@@ -0,0 +1,224 @@
+#include "Test.h"
+
+#include <RTR/3DModells/VertexQuantization.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Largest angle between a unit vector and its 16 bit octahedral round trip (radians)
+    constexpr float OctahedralMaxError = 1e-4f;
+
+    float Length(const float* v)
+    {
+        return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    }
+
+    void Normalize(float* v)
+    {
+        const float length = Length(v);
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+
+    // Angle between two unit vectors (atan2 keeps small angles precise where acos of the dot product does not)
+    float Angle(const float* a, const float* b)
+    {
+        const float c[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+        return std::atan2(Length(c), a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+    }
+
+    // Encode, store as two snorm16 and decode like the vertex shader
+    void OctahedralRoundTrip(const float* ptrVector, float* ptrVectorOut)
+    {
+        float encoded[2];
+        RTR::OctahedralEncode(ptrVector, encoded);
+        const float stored[2] = { RTR::DequantizeSnorm16(RTR::QuantizeSnorm16(encoded[0])), RTR::DequantizeSnorm16(RTR::QuantizeSnorm16(encoded[1])) };
+        RTR::OctahedralDecode(stored, ptrVectorOut);
+    }
+
+    // Unit vectors that stress the encoding: poles, axes, the equator and both sides of the lower hemisphere fold
+    std::vector<std::vector<float>> MakeEdgeVectors()
+    {
+        std::vector<std::vector<float>> vectors = {
+            { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+            { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+            { 1.0f, 1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { -1.0f, -1.0f, 0.0f },
+            { 0.3f, 0.2f, -0.9f }, { -0.3f, 0.2f, -0.9f }, { 0.3f, -0.2f, -0.9f }, { -0.3f, -0.2f, -0.9f },
+            { 0.0f, 0.7f, -0.7f }, { -0.7f, 0.0f, -0.7f }, { 1.0f, 1.0f, -1.0f }, { -1.0f, -1.0f, -1.0f },
+            { 1e-4f, -1e-4f, -1.0f }, { -1e-4f, 1e-4f, 1.0f }, { 0.6f, -0.8f, -1e-5f }, { -0.6f, 0.8f, 1e-5f },
+        };
+        for (auto& v : vectors)
+            Normalize(v.data());
+        return vectors;
+    }
+}
+
+RTR_TEST(VertexQuantizationPositions)
+{
+    // Random positions in an off center box with one flat axis
+    std::mt19937 rng(6);
+    std::uniform_real_distribution<float> x(-3.0f, 5.0f), y(100.0f, 100.5f);
+    std::vector<float> positions;
+    for (int i = 0; i < 10000; i++)
+    {
+        positions.push_back(x(rng));
+        positions.push_back(y(rng));
+        positions.push_back(-2.0f);
+    }
+    const RTR::VertexDequantization dequantization = RTR::ComputeVertexDequantization(positions.data(), sizeof(float) * 3, positions.size() / 3);
+    RTR_EXPECT(dequantization.positionScale[2] == 1.0f && dequantization.positionOffset[2] == -2.0f);
+
+    // Half a snorm step of the axis extent (plus float rounding of the scale and offset)
+    float maxError[3];
+    for (unsigned int k = 0; k < 3; k++)
+        maxError[k] = dequantization.positionScale[k] * (0.5f / 32767.0f) * 1.01f + std::fabs(dequantization.positionOffset[k]) * 1e-6f;
+
+    int16_t minimum[3] = { 32767, 32767, 32767 }, maximum[3] = { -32767, -32767, -32767 };
+    bool withinBound = true;
+    for (size_t v = 0; v < positions.size() / 3; v++)
+    {
+        RTR::QuantizedVertex vertex;
+        RTR::QuantizeVertex(&vertex, dequantization, &positions[v * 3], nullptr, nullptr, nullptr, nullptr);
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            const float restored = RTR::DequantizeSnorm16(vertex.position[k]) * dequantization.positionScale[k] + dequantization.positionOffset[k];
+            withinBound &= std::fabs(restored - positions[v * 3 + k]) <= maxError[k];
+            minimum[k] = std::min(minimum[k], vertex.position[k]);
+            maximum[k] = std::max(maximum[k], vertex.position[k]);
+        }
+        withinBound &= vertex.position[3] == 32767;
+    }
+    RTR_EXPECT(withinBound);
+
+    // The bounds use the full snorm range
+    RTR_EXPECT(minimum[0] == -32767 && maximum[0] == 32767 && minimum[1] == -32767 && maximum[1] == 32767);
+    RTR_EXPECT(minimum[2] == 0 && maximum[2] == 0);
+
+    // Snorm conversion clamps and keeps -32768 out
+    RTR_EXPECT(RTR::QuantizeSnorm16(-2.0f) == -32767 && RTR::QuantizeSnorm16(2.0f) == 32767);
+    RTR_EXPECT(RTR::DequantizeSnorm16(-32768) == -1.0f && RTR::DequantizeSnorm16(0) == 0.0f);
+}
+
+RTR_TEST(VertexQuantizationOctahedral)
+{
+    // The poles survive exactly (the negative one folds to a corner of the square)
+    float encoded[2], decoded[3];
+    const float up[3] = { 0.0f, 0.0f, 1.0f }, down[3] = { 0.0f, 0.0f, -1.0f };
+    RTR::OctahedralEncode(up, encoded);
+    RTR_EXPECT(encoded[0] == 0.0f && encoded[1] == 0.0f);
+    OctahedralRoundTrip(up, decoded);
+    RTR_EXPECT(decoded[0] == 0.0f && decoded[1] == 0.0f && decoded[2] == 1.0f);
+    RTR::OctahedralEncode(down, encoded);
+    RTR_EXPECT(encoded[0] == 1.0f && encoded[1] == 1.0f);
+    OctahedralRoundTrip(down, decoded);
+    RTR_EXPECT(decoded[0] == 0.0f && decoded[1] == 0.0f && decoded[2] == -1.0f);
+
+    // Edge cases stay in their hemisphere and within the error bound
+    for (const auto& v : MakeEdgeVectors())
+    {
+        OctahedralRoundTrip(v.data(), decoded);
+        RTR_EXPECT(Angle(v.data(), decoded) <= OctahedralMaxError);
+        RTR_EXPECT(std::fabs(Length(decoded) - 1.0f) <= 1e-6f);
+        RTR_EXPECT(std::fabs(v[2]) < 1e-4f || (v[2] < 0.0f) == (decoded[2] < 0.0f));
+    }
+
+    // Random directions over the whole sphere
+    std::mt19937 rng(7);
+    std::normal_distribution<float> gaussian;
+    float worst = 0.0f;
+    for (int i = 0; i < 100000; i++)
+    {
+        float v[3] = { gaussian(rng), gaussian(rng), gaussian(rng) };
+        Normalize(v);
+        OctahedralRoundTrip(v, decoded);
+        worst = std::max(worst, Angle(v, decoded));
+    }
+    RTR_EXPECT(worst <= OctahedralMaxError);
+
+    // A zero vector encodes to the center instead of dividing by zero
+    const float zero[3] = { 0.0f, 0.0f, 0.0f };
+    RTR::OctahedralEncode(zero, encoded);
+    RTR_EXPECT(encoded[0] == 0.0f && encoded[1] == 0.0f);
+}
+
+RTR_TEST(VertexQuantizationTangentFrame)
+{
+    const RTR::VertexDequantization dequantization;
+    const float position[3] = { 0.0f, 0.0f, 0.0f };
+    for (const auto& normal : MakeEdgeVectors())
+    {
+        // Tangent perpendicular to the normal, both handednesses
+        const float helper[3] = { std::fabs(normal[0]) < 0.9f ? 1.0f : 0.0f, std::fabs(normal[0]) < 0.9f ? 0.0f : 1.0f, 0.0f };
+        float tangent[3] = { normal[1] * helper[2] - normal[2] * helper[1], normal[2] * helper[0] - normal[0] * helper[2], normal[0] * helper[1] - normal[1] * helper[0] };
+        Normalize(tangent);
+        const float bitangent[3] = { normal[1] * tangent[2] - normal[2] * tangent[1], normal[2] * tangent[0] - normal[0] * tangent[2], normal[0] * tangent[1] - normal[1] * tangent[0] };
+        const float mirrored[3] = { -bitangent[0], -bitangent[1], -bitangent[2] };
+
+        RTR::QuantizedVertex vertex, mirroredVertex;
+        RTR::QuantizeVertex(&vertex, dequantization, position, normal.data(), tangent, bitangent, nullptr);
+        RTR::QuantizeVertex(&mirroredVertex, dequantization, position, normal.data(), tangent, mirrored, nullptr);
+        RTR_EXPECT(vertex.position[3] == 32767 && mirroredVertex.position[3] == -32767);
+
+        float stored[2], decoded[3];
+        stored[0] = RTR::DequantizeSnorm16(vertex.normal[0]);
+        stored[1] = RTR::DequantizeSnorm16(vertex.normal[1]);
+        RTR::OctahedralDecode(stored, decoded);
+        RTR_EXPECT(Angle(normal.data(), decoded) <= OctahedralMaxError);
+        stored[0] = RTR::DequantizeSnorm16(vertex.tangent[0]);
+        stored[1] = RTR::DequantizeSnorm16(vertex.tangent[1]);
+        RTR::OctahedralDecode(stored, decoded);
+        RTR_EXPECT(Angle(tangent, decoded) <= OctahedralMaxError);
+    }
+}
+
+RTR_TEST(VertexQuantizationHalfUvs)
+{
+    // Every finite half survives a round trip through float exactly
+    bool exact = true;
+    for (uint32_t h = 0; h <= 0xFFFF; h++)
+    {
+        if ((h & 0x7C00) != 0x7C00)
+            exact &= RTR::FloatToHalf(RTR::HalfToFloat((uint16_t)h)) == h;
+    }
+    RTR_EXPECT(exact);
+
+    // Tiled uvs keep the relative half precision (2^-11), subnormals an absolute one (2^-25)
+    std::mt19937 rng(8);
+    std::uniform_real_distribution<float> uv(-8.0f, 8.0f);
+    bool withinBound = true;
+    for (int i = 0; i < 100000; i++)
+    {
+        const float value = uv(rng) * (i % 4 == 0 ? 1e-5f : 1.0f);
+        const float restored = RTR::HalfToFloat(RTR::FloatToHalf(value));
+        withinBound &= std::fabs(restored - value) <= std::max(std::fabs(value) * (1.0f / 2048.0f), 1.0f / 33554432.0f);
+    }
+    RTR_EXPECT(withinBound);
+
+    // Through QuantizeVertex, with a missing uv stream stored as zero
+    const RTR::VertexDequantization dequantization;
+    const float position[3] = { 0.0f, 0.0f, 0.0f }, uvs[2] = { 0.25f, 1.75f };
+    RTR::QuantizedVertex vertex;
+    RTR::QuantizeVertex(&vertex, dequantization, position, nullptr, nullptr, nullptr, uvs);
+    RTR_EXPECT(RTR::HalfToFloat(vertex.uv[0]) == 0.25f && RTR::HalfToFloat(vertex.uv[1]) == 1.75f);
+    RTR::QuantizeVertex(&vertex, dequantization, position, nullptr, nullptr, nullptr, nullptr);
+    RTR_EXPECT(vertex.uv[0] == 0 && vertex.uv[1] == 0);
+
+    // Out of range values saturate to infinity, rounding is to nearest even
+    RTR_EXPECT(RTR::FloatToHalf(70000.0f) == 0x7C00 && RTR::FloatToHalf(-70000.0f) == 0xFC00);
+    RTR_EXPECT(RTR::FloatToHalf(1.0f + 1.0f / 2048.0f) == 0x3C00 && RTR::FloatToHalf(1.0f + 3.0f / 2048.0f) == 0x3C02);
+}
+
+RTR_TEST(VertexQuantizationShortIndexCutover)
+{
+    // The largest mesh with 16 bit indices still leaves the strip cut value 0xFFFF unused
+    RTR_EXPECT(RTR::ShortIndicesFit(0) && RTR::ShortIndicesFit(1));
+    RTR_EXPECT(RTR::ShortIndicesFit(65535));
+    RTR_EXPECT(!RTR::ShortIndicesFit(65536) && !RTR::ShortIndicesFit(1000000));
+    RTR_EXPECT((uint16_t)(RTR::ShortIndexMaxVertices - 1) != 0xFFFF);
+}
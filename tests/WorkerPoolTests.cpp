@@ -0,0 +1,129 @@
+#include "Test.h"
+#include "TestMeshes.h"
+
+#include <Util/WorkerPool.h>
+#include <RTR/3DModells/MeshOptimizer.h>
+#include <RTR/3DModells/MeshletBuilder.h>
+#include <RTR/3DModells/MeshSimplifier.h>
+#include <RTR/Culling/Bounds.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // The work of ModelContext::PrepareMesh with the default options plus meshlets and four levels of detail, in the same order.
+    // PrepareMesh itself reads an aiMesh and is compiled with the d3d sources, so it can not run in the headless project.
+    void PrepareTestMesh(const RTR::Test::TestMesh& mesh)
+    {
+        const size_t indexCount = mesh.indices.size(), vertexCount = mesh.GetVertexCount();
+        const size_t stride = sizeof(float) * 3;
+        RTR::MeshAnalyzeVertexCache(mesh.indices.data(), indexCount, vertexCount);
+
+        // Post transform cache, overdraw and vertex fetch
+        std::vector<uint32_t> indices(indexCount), clusters;
+        RTR::MeshOptimizeVertexCache(indices.data(), mesh.indices.data(), indexCount, vertexCount, 16, &clusters);
+        RTR::MeshOptimizeOverdraw(indices.data(), indices.data(), indexCount, mesh.positions.data(), stride, vertexCount, clusters);
+        std::vector<uint32_t> remap(vertexCount);
+        RTR::MeshOptimizeVertexFetch(remap.data(), indices.data(), indexCount, vertexCount);
+        RTR::MeshAnalyzeVertexCache(indices.data(), indexCount, vertexCount);
+
+        // Meshlets in output vertex order
+        std::vector<float> positions(vertexCount * 3);
+        for (size_t i = 0; i < vertexCount; i++)
+            memcpy(&positions[i * 3], &mesh.positions[remap[i] * 3], stride);
+        RTR::MeshletData meshlets;
+        RTR::MeshBuildMeshlets(meshlets, indices.data(), indexCount, positions.data(), stride, vertexCount);
+
+        // Levels of detail (normals of a unit sphere are its positions)
+        const float weights[3] = { 0.5f, 0.5f, 0.5f };
+        const float maxError = 0.05f * RTR::MeshComputeExtent(positions.data(), stride, vertexCount);
+        std::vector<uint32_t> source = indices, simplified(indexCount), lodIndices;
+        float error = 0.0f;
+        for (int level = 1; level < 4; level++)
+        {
+            float levelError = 0.0f;
+            const size_t count = RTR::MeshSimplify(simplified.data(), source.data(), source.size(), positions.data(), stride, vertexCount,
+                positions.data(), stride, weights, 3, source.size() / 2 / 3 * 3, maxError - error, &levelError);
+            if (!count || count >= source.size())
+                break;
+            error += levelError;
+            const size_t offset = lodIndices.size();
+            lodIndices.resize(offset + count);
+            RTR::MeshOptimizeVertexCache(&lodIndices[offset], simplified.data(), count, vertexCount);
+            source.assign(simplified.begin(), simplified.begin() + count);
+        }
+
+        RTR::ComputeMeshBounds(mesh.positions.data(), stride, vertexCount);
+    }
+}
+
+RTR_TEST(WorkerPoolRunsEveryIndexOnce)
+{
+    RTR::WorkerPool pool(8);
+    for (size_t count : { 0, 1, 2, 7, 1000 })
+    {
+        std::vector<std::atomic<int>> hits(count);
+        for (auto& hit : hits)
+            hit = 0;
+        pool.ParallelFor(count, [&](size_t idx) { hits[idx]++; });
+
+        for (auto& hit : hits)
+            RTR_EXPECT(hit == 1);
+    }
+}
+
+RTR_TEST(WorkerPoolBackToBackJobs)
+{
+    // Late workers of one job must never run indices of the next
+    RTR::WorkerPool pool(4);
+    for (int job = 0; job < 2000; job++)
+    {
+        std::atomic<size_t> sum = 0;
+        pool.ParallelFor(100, [&](size_t idx) { sum += idx; });
+        RTR_EXPECT(sum == 4950);
+    }
+}
+
+RTR_TEST(WorkerPoolConcurrentDispatchers)
+{
+    // ParallelFor from two threads is serialized by the pool
+    RTR::WorkerPool pool(4);
+    std::atomic<size_t> sums[2] = { 0, 0 };
+    auto dispatch = [&](size_t slot)
+    {
+        for (int job = 0; job < 200; job++)
+            pool.ParallelFor(64, [&](size_t idx) { sums[slot] += idx; });
+    };
+    std::thread other(dispatch, 1);
+    dispatch(0);
+    other.join();
+
+    RTR_EXPECT(sums[0] == 200 * 2016);
+    RTR_EXPECT(sums[1] == 200 * 2016);
+}
+
+RTR_BENCHMARK(WorkerPoolPrepareMeshScaling)
+{
+    // The ParallelFor over PrepareMesh in ModelContext::LoadModel with N meshes of mixed size at 1 ... N threads
+    const unsigned int meshCount = 16;
+    std::vector<RTR::Test::TestMesh> meshes;
+    for (unsigned int i = 0; i < meshCount; i++)
+        meshes.push_back(RTR::Test::MakeSphereMesh(32 + 8 * (i % 8), 64 + 16 * (i % 4)));
+
+    double singleThread = 0.0;
+    for (unsigned int threads = 1; threads <= meshCount; threads++)
+    {
+        RTR::WorkerPool pool(threads);
+        const double seconds = RTR::Test::MeasureSeconds([&]()
+            {
+                pool.ParallelFor(meshes.size(), [&](size_t idx) { PrepareTestMesh(meshes[idx]); });
+            }, 2
+        );
+        singleThread = threads == 1 ? seconds : singleThread;
+        printf("    %2u threads: %7.2f ms (%.2fx)\n", threads, seconds * 1000.0, singleThread / seconds);
+    }
+}